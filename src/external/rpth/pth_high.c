@@ -138,6 +138,38 @@ unsigned int pth_sleep(unsigned int sec)
 int pth_sigmask(int how, const sigset_t *set, sigset_t *oset)
 {
     int rv;
+#if PTH_MCTX_MTH(asm)
+    sigset_t *mask;
+    int sig;
+
+    /* the asm mctx method never loads the signal mask on a switch, so
+       the per-thread mask only exists in user space (Shadow emulates
+       signal delivery) and we must not touch the real one */
+    mask = &(pth_gctx_get()->pth_current->mctx.sigs);
+    if (oset != NULL)
+        *oset = *mask;
+    if (set != NULL) {
+        switch (how) {
+            case SIG_SETMASK:
+                *mask = *set;
+                break;
+            case SIG_BLOCK:
+            case SIG_UNBLOCK:
+                for (sig = 1; sig < PTH_NSIG; sig++) {
+                    if (sigismember(set, sig)) {
+                        if (how == SIG_BLOCK)
+                            sigaddset(mask, sig);
+                        else
+                            sigdelset(mask, sig);
+                    }
+                }
+                break;
+            default:
+                return pth_error(-1, EINVAL);
+        }
+    }
+    rv = 0;
+#else
 
     /* change the explicitly remembered signal mask copy for the scheduler */
     if (set != NULL)
@@ -145,6 +177,7 @@ int pth_sigmask(int how, const sigset_t *set, sigset_t *oset)
 
     /* change the real (per-thread saved/restored) signal mask */
     rv = pth_sc(sigprocmask)(how, set, oset);
+#endif
 
     return rv;
 }
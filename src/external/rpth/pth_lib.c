@@ -62,6 +62,8 @@ struct pth_gctx_st {
 
     int main_efd; // epoll fd
 
+    pth_stackstats_t pth_stackstats; /* stacks of this context's threads */
+
     struct pth_keytab_st pth_keytab[PTH_KEY_MAX];
     pth_key_t ev_key_join;
     pth_key_t ev_key_nap;
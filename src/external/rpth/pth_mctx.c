@@ -50,6 +50,8 @@ struct pth_mctx_st {
     int restored;
 #elif PTH_MCTX_MTH(sjlj)
     pth_sigjmpbuf jb;
+#elif PTH_MCTX_MTH(asm)
+    void *sp;
 #else
 #error "unknown mctx method"
 #endif
@@ -64,6 +66,19 @@ struct pth_mctx_st {
 ** ____ MACHINE STATE SWITCHING ______________________________________
 */
 
+#if PTH_MCTX_MTH(asm)
+/*
+ * the asm method keeps everything it needs on the thread's own stack:
+ * pth_mctx_asm_switch pushes the callee-saved registers (and the SSE/x87
+ * control words, which the ABI also requires to be preserved), stores
+ * the stack pointer in *old_sp, loads new_sp and pops the other thread's
+ * registers. pth_mctx_asm_jump does the same without saving anything.
+ * Neither touches the signal mask, which is only kept in `sigs'.
+ */
+extern void pth_mctx_asm_switch(void **old_sp, void *new_sp);
+extern void pth_mctx_asm_jump(void *new_sp);
+#endif
+
 /*
  * save the current machine context
  */
@@ -82,6 +97,8 @@ struct pth_mctx_st {
 #define pth_mctx_save(mctx) \
         ( (mctx)->error = errno, \
           pth_sigsetjmp((mctx)->jb) )
+#elif PTH_MCTX_MTH(asm)
+/* there is no separate save step: pth_mctx_switch saves as it switches */
 #else
 #error "unknown mctx method"
 #endif
@@ -99,6 +116,10 @@ struct pth_mctx_st {
 #define pth_mctx_restore(mctx) \
         ( errno = (mctx)->error, \
           (void)pth_siglongjmp((mctx)->jb, 1) )
+#elif PTH_MCTX_MTH(asm)
+#define pth_mctx_restore(mctx) \
+        ( errno = (mctx)->error, \
+          pth_mctx_asm_jump((mctx)->sp) )
 #else
 #error "unknown mctx method"
 #endif
@@ -135,6 +156,12 @@ struct pth_mctx_st {
     if (pth_mctx_save(old) == 0) \
         pth_mctx_restore(new); \
     pth_mctx_restored(old);
+#elif PTH_MCTX_MTH(asm)
+#define pth_mctx_switch(old,new) \
+    _pth_mctx_switch_debug \
+    (old)->error = errno; \
+    pth_mctx_asm_switch(&((old)->sp), (new)->sp); \
+    errno = (old)->error;
 #else
 #error "unknown mctx method"
 #endif
@@ -538,6 +565,98 @@ pth_mctx_set(pth_mctx_t *mctx, void (*func)(void),
     return TRUE;
 }
 
+#elif PTH_MCTX_MTH(asm) && defined(__x86_64__)
+
+/*
+ * VARIANT 6: HAND-WRITTEN X86_64 REGISTER SWITCH
+ *
+ * Both of the portable variants save and restore the signal mask with
+ * a rt_sigprocmask(2) syscall on every switch. Shadow emulates signals
+ * for its plugins anyway, so here we only swap what the System V ABI
+ * requires a callee to preserve (rbx, rbp, r12-r15, the MXCSR and x87
+ * control words, and rsp) and keep the signal mask purely in user
+ * space. A switch therefore never enters the kernel.
+ *
+ * A saved context is a pointer into the thread's stack, which holds
+ * from low to high addresses: the control words (8 bytes), r15, r14,
+ * r13, r12, rbx, rbp and the return address.
+ */
+
+__asm__ (
+    ".pushsection .text\n"
+    ".p2align 4\n"
+    ".globl pth_mctx_asm_switch\n"
+    ".type pth_mctx_asm_switch,@function\n"
+    "pth_mctx_asm_switch:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $8, %rsp\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rdi\n"
+    /* fall through */
+    ".globl pth_mctx_asm_jump\n"
+    ".type pth_mctx_asm_jump,@function\n"
+    "pth_mctx_asm_jump:\n"
+    "    movq %rdi, %rsp\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $8, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".size pth_mctx_asm_switch,.-pth_mctx_asm_switch\n"
+    ".size pth_mctx_asm_jump,.-pth_mctx_asm_jump\n"
+    ".popsection\n"
+);
+
+/* a thread start function must never return, there is no caller to go back to */
+static void pth_mctx_asm_returned(void)
+{
+    abort();
+}
+
+intern int pth_mctx_set(
+    pth_mctx_t *mctx, void (*func)(void), char *sk_addr_lo, char *sk_addr_hi)
+{
+    unsigned long *sp;
+    unsigned int mxcsr;
+    unsigned short fpucw;
+
+    /* inherit the caller's floating point control state */
+    __asm__ __volatile__ ("stmxcsr %0" : "=m" (mxcsr));
+    __asm__ __volatile__ ("fnstcw %0" : "=m" (fpucw));
+
+    /* align the top of the stack to 16 bytes */
+    sp = (unsigned long *)((unsigned long)sk_addr_hi & ~((unsigned long)15));
+
+    /* after the final `ret' into func, rsp must be 8 bytes below a
+       16 byte boundary, as if func had just been called */
+    *--sp = (unsigned long)pth_mctx_asm_returned;
+    *--sp = (unsigned long)func;
+    *--sp = 0; /* rbp */
+    *--sp = 0; /* rbx */
+    *--sp = 0; /* r12 */
+    *--sp = 0; /* r13 */
+    *--sp = 0; /* r14 */
+    *--sp = 0; /* r15 */
+    *--sp = (unsigned long)mxcsr | ((unsigned long)fpucw << 32);
+
+    mctx->sp = (void *)sp;
+    sigemptyset(&mctx->sigs);
+    mctx->error = 0;
+    return TRUE;
+}
+
 /*
  * VARIANT X: JMP_BUF FIDDLING FOR ONE MORE ESOTERIC OS
  * Add the jmp_buf fiddling for your esoteric OS here...
@@ -353,7 +353,13 @@ intern void *pth_scheduler(void *dummy)
 
     /* block all signals in the scheduler thread */
     sigfillset(&sigs);
+#if PTH_MCTX_MTH(asm)
+    /* with the asm mctx method the mask is never restored on a switch,
+       so only record it for the scheduler instead of changing the real one */
+    pth_gctx_get()->pth_sched->mctx.sigs = sigs;
+#else
     pth_sc(sigprocmask)(SIG_SETMASK, &sigs, NULL);
+#endif
 
     /* initialize the snapshot time for bootstrapping the loop */
     pth_time_set(&snapshot, PTH_TIME_NOW);
@@ -824,7 +830,9 @@ intern void pth_sched_eventmanager(pth_time_t *now, int dopoll)
     /* allow some signals to be delivered: Either to our
        catching handler or directly to the configured
        handler for signals not catched by events */
+#if !PTH_MCTX_MTH(asm)
     pth_sc(sigprocmask)(SIG_SETMASK, &pth_gctx_get()->pth_sigblock, &oss);
+#endif
 
     /* now decide how and do the polling for fd I/O and timers
        WHEN THE SCHEDULER SLEEPS AT ALL, THEN HERE!! */
@@ -834,7 +842,9 @@ intern void pth_sched_eventmanager(pth_time_t *now, int dopoll)
                && errno == EINTR) ;
 
     /* restore signal mask and actions and handle signals */
+#if !PTH_MCTX_MTH(asm)
     pth_sc(sigprocmask)(SIG_SETMASK, &oss, NULL);
+#endif
     for (sig = 1; sig < PTH_NSIG; sig++)
         if (sigismember(&pth_gctx_get()->pth_sigcatch, sig))
             sigaction(sig, &osa[sig], NULL);
@@ -108,13 +108,259 @@ intern const char *pth_state_names[] = {
 #endif
 #endif
 
+/*
+ * Thread stacks come from mmap instead of the heap. Each stack has a
+ * PROT_NONE guard page at the end it grows towards, so an overflow faults
+ * right away instead of silently corrupting whatever malloc placed next to
+ * it. Released stacks get their pages dropped with MADV_DONTNEED (so they
+ * come back zero-filled and cost no RSS while idle) and are cached per OS
+ * thread by size. All pth contexts created on the same OS thread share
+ * that cache, so short-lived threads rarely need a new mapping.
+ */
+#include <sys/mman.h>
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+#ifndef MAP_STACK
+#define MAP_STACK 0
+#endif
+
+#define PTH_STACKPOOL_CLASSES 8
+#define PTH_STACKPOOL_DEFAULT_CACHED 64
+
+struct pth_stackpool_class_st {
+    size_t        size;    /* usable bytes of each stack in this class */
+    char         *head;    /* most recently released stack             */
+    unsigned int  count;   /* number of cached stacks                  */
+};
+
+struct pth_stackpool_st {
+    int           initialized;
+    size_t        pagesize;
+    unsigned int  maxcached;  /* cached stacks kept per size class     */
+    int           hugepages;  /* ask for transparent huge pages        */
+    struct pth_stackpool_class_st classes[PTH_STACKPOOL_CLASSES];
+};
+
+/* see the comment on __pth_current_gctx about TLS access */
+static __thread struct pth_stackpool_st pth_stackpool_tls;
+
+static struct pth_stackpool_st *pth_stackpool_get(void)
+{
+    struct pth_stackpool_st *pool = &pth_stackpool_tls;
+    if (!pool->initialized) {
+        pool->pagesize = (size_t)getpagesize();
+        pool->maxcached = PTH_STACKPOOL_DEFAULT_CACHED;
+        pool->initialized = TRUE;
+    }
+    return pool;
+}
+
+/* a cached stack stores the link to the next one in its topmost word */
+#define pth_stack_link(stack, size) \
+    ((char **)((stack) + (size) - sizeof(char *)))
+
+static char *pth_stack_map(struct pth_stackpool_st *pool, size_t size)
+{
+    size_t total = size + pool->pagesize;
+    char *base, *stack, *guard;
+
+    base = (char *)mmap(NULL, total, PROT_READ|PROT_WRITE,
+                        MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE|MAP_STACK, -1, 0);
+    if (base == (char *)MAP_FAILED)
+        return NULL;
+#if PTH_STACKGROWTH < 0
+    guard = base;
+    stack = base + pool->pagesize;
+#else
+    guard = base + size;
+    stack = base;
+#endif
+    if (mprotect(guard, pool->pagesize, PROT_NONE) != 0) {
+        pth_shield { munmap(base, total); }
+        return NULL;
+    }
+#ifdef MADV_HUGEPAGE
+    if (pool->hugepages)
+        madvise(stack, size, MADV_HUGEPAGE);
+#endif
+    return stack;
+}
+
+static void pth_stack_unmap(struct pth_stackpool_st *pool, char *stack, size_t size)
+{
+#if PTH_STACKGROWTH < 0
+    munmap(stack - pool->pagesize, size + pool->pagesize);
+#else
+    munmap(stack, size + pool->pagesize);
+#endif
+}
+
+/* number of bytes of the stack the thread actually touched, measured as the
+   distance from the start of the stack to the furthest resident page. the
+   page holding the 0xDEAD stack guard word is always resident, so it is
+   not considered. */
+static size_t pth_stack_touched(struct pth_stackpool_st *pool, char *stack, size_t size)
+{
+    unsigned char vec[256];
+    size_t npages = size / pool->pagesize;
+    size_t i, n, chunk;
+
+#if PTH_STACKGROWTH < 0
+    /* grows down: scan up from the lowest page for the first resident one */
+    for (i = 1; i < npages; i += chunk) {
+        chunk = npages - i < sizeof(vec) ? npages - i : sizeof(vec);
+        if (mincore(stack + i * pool->pagesize, chunk * pool->pagesize, vec) != 0)
+            return 0;
+        for (n = 0; n < chunk; n++)
+            if (vec[n] & 1)
+                return size - (i + n) * pool->pagesize;
+    }
+#else
+    /* grows up: scan down from the highest page for the first resident one */
+    for (i = npages - 1; i > 0; i -= chunk) {
+        chunk = i < sizeof(vec) ? i : sizeof(vec);
+        if (mincore(stack + (i - chunk) * pool->pagesize, chunk * pool->pagesize, vec) != 0)
+            return 0;
+        for (n = chunk; n > 0; n--)
+            if (vec[n - 1] & 1)
+                return (i - chunk + n) * pool->pagesize;
+    }
+#endif
+    return 0;
+}
+
+static struct pth_stackpool_class_st *pth_stackpool_class(struct pth_stackpool_st *pool, size_t size, int create)
+{
+    int i;
+    for (i = 0; i < PTH_STACKPOOL_CLASSES; i++) {
+        if (pool->classes[i].size == size)
+            return &pool->classes[i];
+        if (pool->classes[i].size == 0) {
+            if (!create)
+                return NULL;
+            pool->classes[i].size = size;
+            return &pool->classes[i];
+        }
+    }
+    return NULL;
+}
+
+/* get a zero-filled stack of the given page-multiple size */
+static char *pth_stack_get(size_t size, int *reused)
+{
+    struct pth_stackpool_st *pool = pth_stackpool_get();
+    struct pth_stackpool_class_st *c = pth_stackpool_class(pool, size, FALSE);
+    char *stack;
+
+    if (c != NULL && c->head != NULL) {
+        stack = c->head;
+        c->head = *pth_stack_link(stack, size);
+        *pth_stack_link(stack, size) = NULL;
+        c->count--;
+        *reused = TRUE;
+        return stack;
+    }
+    *reused = FALSE;
+    return pth_stack_map(pool, size);
+}
+
+/* drop the pages of a stack and cache it, or unmap it if the cache is full */
+static void pth_stack_put(char *stack, size_t size)
+{
+    struct pth_stackpool_st *pool = pth_stackpool_get();
+    struct pth_stackpool_class_st *c = pth_stackpool_class(pool, size, TRUE);
+
+    if (c == NULL || c->count >= pool->maxcached) {
+        pth_stack_unmap(pool, stack, size);
+        return;
+    }
+    madvise(stack, size, MADV_DONTNEED);
+    *pth_stack_link(stack, size) = c->head;
+    c->head = stack;
+    c->count++;
+}
+
+/* configure the stack cache of the calling OS thread */
+int pth_stackpool_config(unsigned int maxcached, int hugepages)
+{
+    struct pth_stackpool_st *pool = pth_stackpool_get();
+    pool->maxcached = maxcached;
+    pool->hugepages = hugepages;
+    return TRUE;
+}
+
+/* unmap all stacks cached by the calling OS thread */
+void pth_stackpool_flush(void)
+{
+    struct pth_stackpool_st *pool = pth_stackpool_get();
+    struct pth_stackpool_class_st *c;
+    char *stack;
+    int i;
+
+    for (i = 0; i < PTH_STACKPOOL_CLASSES; i++) {
+        c = &pool->classes[i];
+        while ((stack = c->head) != NULL) {
+            c->head = *pth_stack_link(stack, c->size);
+            pth_stack_unmap(pool, stack, c->size);
+        }
+        c->count = 0;
+        c->size = 0;
+    }
+}
+
+static void pth_stackstats_measure(pth_stackstats_t *stats, pth_t t)
+{
+    size_t touched;
+    if (t == NULL || t->stack == NULL || t->stackloan || t->stacksize == 0)
+        return;
+    touched = pth_stack_touched(pth_stackpool_get(), t->stack, t->stacksize);
+    if (touched > stats->highwater)
+        stats->highwater = touched;
+}
+
+/* fill in the stack statistics of a context, including the stacks of
+   threads that are still alive */
+int pth_gctx_get_stackstats(pth_gctx_t gctx, pth_stackstats_t *stats)
+{
+    pth_pqueue_t *queues[5];
+    pth_t t;
+    int i;
+
+    if (gctx == NULL || stats == NULL)
+        return pth_error(FALSE, EINVAL);
+
+    *stats = gctx->pth_stackstats;
+
+    queues[0] = &gctx->pth_NQ;
+    queues[1] = &gctx->pth_RQ;
+    queues[2] = &gctx->pth_WQ;
+    queues[3] = &gctx->pth_SQ;
+    queues[4] = &gctx->pth_DQ;
+    for (i = 0; i < 5; i++)
+        for (t = pth_pqueue_head(queues[i]); t != NULL;
+             t = pth_pqueue_walk(queues[i], t, PTH_WALK_NEXT))
+            pth_stackstats_measure(stats, t);
+    pth_stackstats_measure(stats, gctx->pth_current);
+
+    return TRUE;
+}
+
 /* allocate a thread control block */
 intern pth_t pth_tcb_alloc(unsigned int stacksize, void *stackaddr)
 {
+    pth_gctx_t gctx = pth_gctx_get();
+    size_t pagesize;
     pth_t t;
+    int reused;
 
     if (stacksize > 0 && stacksize < SIGSTKSZ)
         stacksize = SIGSTKSZ;
+    if (stacksize > 0 && stackaddr == NULL) {
+        pagesize = pth_stackpool_get()->pagesize;
+        stacksize = (unsigned int)((stacksize + pagesize - 1) & ~(pagesize - 1));
+    }
     if ((t = (pth_t)calloc(1, sizeof(struct pth_st))) == NULL)
         return NULL;
 
@@ -128,9 +374,15 @@ intern pth_t pth_tcb_alloc(unsigned int stacksize, void *stackaddr)
         if (stackaddr != NULL)
             t->stack = (char *)(stackaddr);
         else {
-            if ((t->stack = (char *)calloc(1, stacksize)) == NULL) {
+            if ((t->stack = pth_stack_get(stacksize, &reused)) == NULL) {
                 pth_shield { free(t); }
-                return NULL;
+                return pth_error((pth_t)NULL, ENOMEM);
+            }
+            if (gctx != NULL) {
+                gctx->pth_stackstats.spawned++;
+                gctx->pth_stackstats.inuse++;
+                if (reused)
+                    gctx->pth_stackstats.reused++;
             }
         }
 
@@ -158,6 +410,8 @@ intern pth_t pth_tcb_alloc(unsigned int stacksize, void *stackaddr)
 /* free a thread control block */
 intern void pth_tcb_free(pth_t t)
 {
+    pth_gctx_t gctx = pth_gctx_get();
+
     if (t == NULL || t->stackguard == NULL)
         return;
     if (t->stack != NULL && !t->stackloan) {
@@ -168,9 +422,12 @@ intern void pth_tcb_free(pth_t t)
               t->stacksize, t->stack, &t->stack[t->stacksize], t->valgrind_id);
 #endif
 #endif
-            memset(t->stack, 0, (size_t)t->stacksize);
+            if (gctx != NULL) {
+                pth_stackstats_measure(&gctx->pth_stackstats, t);
+                gctx->pth_stackstats.inuse--;
+            }
+            pth_stack_put(t->stack, (size_t)t->stacksize);
         }
-        free(t->stack);
     }
     if (t->data_value != NULL)
         free(t->data_value);
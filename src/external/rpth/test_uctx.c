@@ -29,6 +29,7 @@
                                                         -- Alan Cox */
 #include <stdio.h>
 #include <time.h>
+#include <sys/time.h>
 
 #include "rpth.h"
 
@@ -98,9 +99,9 @@ static void test_working(void)
 
 #define DO_SWITCHES 10000000
 
-time_t       stat_start;
-time_t       stat_end;
-volatile int stat_switched;
+struct timeval stat_start;
+struct timeval stat_end;
+volatile int   stat_switched;
 
 static void dummy(void *ctx)
 {
@@ -114,6 +115,7 @@ static void dummy(void *ctx)
 static void test_performance(void)
 {
     volatile int i;
+    double elapsed;
 
     pth_uctx_create((pth_uctx_t *)&uctx[0]);
     pth_uctx_create((pth_uctx_t *)&uctx[1]);
@@ -123,27 +125,36 @@ static void test_performance(void)
     fprintf(stderr, "Performing %d user-space context switches... "
             "be patient!\n", DO_SWITCHES);
 
-    stat_start = time(NULL);
+    gettimeofday(&stat_start, NULL);
     stat_switched = 0;
     for (i = 0; i < DO_SWITCHES; i++) {
         stat_switched++;
         pth_uctx_switch(uctx[0], uctx[1]);
     }
-    stat_end = time(NULL);
+    gettimeofday(&stat_end, NULL);
 
     pth_uctx_destroy(uctx[0]);
     pth_uctx_destroy(uctx[1]);
 
-    fprintf(stderr, "We required %d seconds for performing the test, "
-            "so this means we can\n", (int)(stat_end-stat_start));
-    fprintf(stderr, "perform %d user-space context switches per second "
-            "on this platform.\n", DO_SWITCHES/(int)(stat_end-stat_start));
+    /* the fast mctx methods finish well within a second, so measure in usec */
+    elapsed = (double)(stat_end.tv_sec - stat_start.tv_sec)
+              + ((double)(stat_end.tv_usec - stat_start.tv_usec) / 1000000.0);
+    if (elapsed <= 0.0)
+        elapsed = 0.000001;
+
+    fprintf(stderr, "We required %.3f seconds for performing the test, "
+            "so this means we can\n", elapsed);
+    fprintf(stderr, "perform %.0f user-space context switches per second "
+            "on this platform (%.1f ns per switch).\n",
+            (double)DO_SWITCHES/elapsed, (elapsed*1000000000.0)/(double)DO_SWITCHES);
     fprintf(stderr, "\n");
     return;
 }
 
 int main(int argc, char *argv[])
 {
+    /* the uctx functions use the global context */
+    pth_init();
     test_working();
     test_performance();
     return 0;
@@ -0,0 +1,862 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "shadow.h"
+
+/* every entry starts with the type byte and the total length of the entry */
+#define LOGENTRY_HEADER_LENGTH (sizeof(guint8) + sizeof(guint32))
+/* the length of a string that was NULL */
+#define LOGENTRY_NULL_STRING G_MAXUINT32
+
+/* the tags of the argument values stored in a record */
+#define LOGARG_TAG_INT 'i'
+#define LOGARG_TAG_INT64 'l'
+#define LOGARG_TAG_DOUBLE 'd'
+#define LOGARG_TAG_POINTER 'p'
+#define LOGARG_TAG_STRING 's'
+
+/* how to take each argument off of the va_list */
+typedef enum _LogArgumentType LogArgumentType;
+enum _LogArgumentType {
+    LOGARG_INT, LOGARG_LONG, LOGARG_LONGLONG, LOGARG_INTMAX, LOGARG_SIZE, LOGARG_PTRDIFF,
+    LOGARG_DOUBLE, LOGARG_LONGDOUBLE, LOGARG_POINTER, LOGARG_STRING, LOGARG_ERRNO,
+};
+
+/* a string precision given as an argument instead of in the format */
+#define LOGARG_PRECISION_STAR -2
+
+typedef struct _LogArgument LogArgument;
+struct _LogArgument {
+    LogArgumentType type;
+    /* for strings, the most bytes that will be printed, or -1 for all of them */
+    gint precision;
+};
+
+struct _LogCallSite {
+    /* the key, the arguments of the log call that never change for a call site */
+    const gchar* fileName;
+    const gchar* functionName;
+    gint lineNumber;
+    const gchar* format;
+
+    guint id;
+    gchar* callInfo;
+
+    /* FALSE if we can not capture the arguments, and so format eagerly */
+    gboolean isDeferrable;
+    LogArgument* arguments;
+    guint numArguments;
+
+    MAGIC_DECLARE;
+};
+
+struct _LogBuffer {
+    GByteArray* bytes;
+    /* where the buffer goes once the helper is done with it */
+    GAsyncQueue* returnQueue;
+    MAGIC_DECLARE;
+};
+
+typedef struct _LogDecoderCallSite LogDecoderCallSite;
+struct _LogDecoderCallSite {
+    gchar* callInfo;
+    gchar* format;
+};
+
+struct _LogDecoder {
+    /* call site id to LogDecoderCallSite */
+    GHashTable* callSites;
+    /* host id to host name */
+    GHashTable* hostNames;
+    MAGIC_DECLARE;
+};
+
+/* a cursor over the bytes of a single entry */
+typedef struct _LogReader LogReader;
+struct _LogReader {
+    const guint8* data;
+    gsize length;
+    gsize offset;
+};
+
+LogFormat logformat_fromStr(const gchar* formatStr) {
+    if(formatStr != NULL && g_ascii_strcasecmp(formatStr, "deferred") == 0) {
+        return LOGFORMAT_DEFERRED;
+    } else if(formatStr != NULL && g_ascii_strcasecmp(formatStr, "binary") == 0) {
+        return LOGFORMAT_BINARY;
+    } else {
+        return LOGFORMAT_TEXT;
+    }
+}
+
+/* figure out which arguments the format consumes, returning FALSE for any
+ * conversion we do not know how to capture (positional arguments, wide
+ * strings, %n) */
+static gboolean _logcallsite_parseFormat(LogCallSite* site, GArray* arguments) {
+    const gchar* p = site->format;
+
+    while((p = strchr(p, '%')) != NULL) {
+        p++;
+        if(*p == '%') {
+            p++;
+            continue;
+        }
+
+        while(*p && strchr("-+ #0'I", *p)) {
+            p++;
+        }
+
+        LogArgument star = {LOGARG_INT, -1};
+        if(*p == '*') {
+            g_array_append_val(arguments, star);
+            p++;
+        } else {
+            while(g_ascii_isdigit(*p)) {
+                p++;
+            }
+            if(*p == '$') {
+                return FALSE;
+            }
+        }
+
+        gint precision = -1;
+        if(*p == '.') {
+            p++;
+            if(*p == '*') {
+                g_array_append_val(arguments, star);
+                precision = LOGARG_PRECISION_STAR;
+                p++;
+            } else {
+                precision = 0;
+                while(g_ascii_isdigit(*p)) {
+                    precision = (precision * 10) + (*p - '0');
+                    p++;
+                }
+            }
+        }
+
+        /* the length modifier decides the argument type of integer conversions */
+        LogArgumentType integerType = LOGARG_INT;
+        gboolean isLong = FALSE;
+        gboolean isLongDouble = FALSE;
+        switch(*p) {
+            case 'h': {
+                p += (p[1] == 'h') ? 2 : 1;
+                break;
+            }
+            case 'l': {
+                if(p[1] == 'l') {
+                    integerType = LOGARG_LONGLONG;
+                    p += 2;
+                } else {
+                    integerType = LOGARG_LONG;
+                    isLong = TRUE;
+                    p++;
+                }
+                break;
+            }
+            case 'L':
+            case 'q': {
+                integerType = LOGARG_LONGLONG;
+                isLongDouble = TRUE;
+                p++;
+                break;
+            }
+            case 'j': {
+                integerType = LOGARG_INTMAX;
+                p++;
+                break;
+            }
+            case 'z':
+            case 'Z': {
+                integerType = LOGARG_SIZE;
+                p++;
+                break;
+            }
+            case 't': {
+                integerType = LOGARG_PTRDIFF;
+                p++;
+                break;
+            }
+            default:
+                break;
+        }
+
+        LogArgument argument = {LOGARG_INT, -1};
+        switch(*p) {
+            case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': {
+                argument.type = integerType;
+                break;
+            }
+            case 'c': {
+                /* we would print a wide character as a narrow one */
+                if(isLong) {
+                    return FALSE;
+                }
+                argument.type = LOGARG_INT;
+                break;
+            }
+            case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': {
+                argument.type = isLongDouble ? LOGARG_LONGDOUBLE : LOGARG_DOUBLE;
+                break;
+            }
+            case 's': {
+                if(isLong) {
+                    return FALSE;
+                }
+                argument.type = LOGARG_STRING;
+                argument.precision = precision;
+                break;
+            }
+            case 'p': {
+                argument.type = LOGARG_POINTER;
+                break;
+            }
+            case 'm': {
+                argument.type = LOGARG_ERRNO;
+                break;
+            }
+            default: {
+                /* includes %a, %n, %C, %S, and truncated formats */
+                return FALSE;
+            }
+        }
+        g_array_append_val(arguments, argument);
+        p++;
+    }
+
+    return TRUE;
+}
+
+LogCallSite* logcallsite_new(guint id, const gchar* fileName, const gchar* functionName,
+        const gint lineNumber, const gchar* format) {
+    LogCallSite* site = g_new0(LogCallSite, 1);
+    MAGIC_INIT(site);
+
+    site->fileName = fileName;
+    site->functionName = functionName;
+    site->lineNumber = lineNumber;
+    site->format = format;
+    site->id = id;
+
+    /* the same call info that a LogRecord would print */
+    gchar* baseName = (fileName != NULL) ? g_path_get_basename(fileName) : NULL;
+    site->callInfo = g_strdup_printf("[%s:%i] [%s]",
+            (baseName != NULL) ? baseName : "n/a", lineNumber, functionName ? functionName : "n/a");
+    if(baseName != NULL) {
+        g_free(baseName);
+    }
+
+    if(format != NULL) {
+        GArray* arguments = g_array_new(FALSE, FALSE, sizeof(LogArgument));
+        site->isDeferrable = _logcallsite_parseFormat(site, arguments);
+        site->numArguments = arguments->len;
+        site->arguments = (LogArgument*)g_array_free(arguments, FALSE);
+    }
+
+    return site;
+}
+
+void logcallsite_free(LogCallSite* site) {
+    MAGIC_ASSERT(site);
+
+    if(site->callInfo) {
+        g_free(site->callInfo);
+    }
+    if(site->arguments) {
+        g_free(site->arguments);
+    }
+
+    MAGIC_CLEAR(site);
+    g_free(site);
+}
+
+static guint _logcallsite_hash(const LogCallSite* site) {
+    return g_direct_hash(site->format) ^ g_direct_hash(site->fileName) ^ (guint)site->lineNumber;
+}
+
+static gboolean _logcallsite_isEqual(const LogCallSite* a, const LogCallSite* b) {
+    return (a->format == b->format && a->fileName == b->fileName &&
+            a->functionName == b->functionName && a->lineNumber == b->lineNumber) ? TRUE : FALSE;
+}
+
+GHashTable* logcallsite_newTable() {
+    return g_hash_table_new_full((GHashFunc)_logcallsite_hash, (GEqualFunc)_logcallsite_isEqual,
+            (GDestroyNotify)logcallsite_free, NULL);
+}
+
+LogCallSite* logcallsite_lookup(GHashTable* table, const gchar* fileName, const gchar* functionName,
+        const gint lineNumber, const gchar* format) {
+    LogCallSite key;
+    key.fileName = fileName;
+    key.functionName = functionName;
+    key.lineNumber = lineNumber;
+    key.format = format;
+    return g_hash_table_lookup(table, &key);
+}
+
+LogBuffer* logbuffer_new(GAsyncQueue* returnQueue) {
+    LogBuffer* buffer = g_new0(LogBuffer, 1);
+    MAGIC_INIT(buffer);
+
+    buffer->bytes = g_byte_array_sized_new(65536);
+    if(returnQueue) {
+        buffer->returnQueue = returnQueue;
+        g_async_queue_ref(returnQueue);
+    }
+
+    return buffer;
+}
+
+void logbuffer_free(LogBuffer* buffer) {
+    MAGIC_ASSERT(buffer);
+
+    g_byte_array_free(buffer->bytes, TRUE);
+    if(buffer->returnQueue) {
+        g_async_queue_unref(buffer->returnQueue);
+    }
+
+    MAGIC_CLEAR(buffer);
+    g_free(buffer);
+}
+
+gboolean logbuffer_isEmpty(LogBuffer* buffer) {
+    MAGIC_ASSERT(buffer);
+    return buffer->bytes->len == 0 ? TRUE : FALSE;
+}
+
+void logbuffer_release(LogBuffer* buffer) {
+    MAGIC_ASSERT(buffer);
+
+    /* keep the memory so the owner can reuse the buffer */
+    g_byte_array_set_size(buffer->bytes, 0);
+
+    if(buffer->returnQueue) {
+        g_async_queue_push(buffer->returnQueue, buffer);
+    } else {
+        logbuffer_free(buffer);
+    }
+}
+
+static inline void _logbuffer_append(LogBuffer* buffer, gconstpointer value, gsize length) {
+    g_byte_array_append(buffer->bytes, (const guint8*)value, (guint)length);
+}
+
+static inline void _logbuffer_appendU8(LogBuffer* buffer, guint8 value) {
+    _logbuffer_append(buffer, &value, sizeof(value));
+}
+
+static inline void _logbuffer_appendU32(LogBuffer* buffer, guint32 value) {
+    _logbuffer_append(buffer, &value, sizeof(value));
+}
+
+static void _logbuffer_appendString(LogBuffer* buffer, const gchar* string, gint precision) {
+    if(string == NULL) {
+        _logbuffer_appendU32(buffer, LOGENTRY_NULL_STRING);
+        return;
+    }
+
+    /* a string with a precision does not have to be terminated */
+    gsize length = (precision >= 0) ? strnlen(string, (gsize)precision) : strlen(string);
+    _logbuffer_appendU32(buffer, (guint32)length);
+    _logbuffer_append(buffer, string, length);
+}
+
+static guint _logbuffer_beginEntry(LogBuffer* buffer, LogEntryType type) {
+    guint start = buffer->bytes->len;
+    _logbuffer_appendU8(buffer, (guint8)type);
+    /* the length is filled in by _logbuffer_endEntry */
+    _logbuffer_appendU32(buffer, 0);
+    return start;
+}
+
+static void _logbuffer_endEntry(LogBuffer* buffer, guint start) {
+    guint32 length = (guint32)(buffer->bytes->len - start);
+    memcpy(&buffer->bytes->data[start + sizeof(guint8)], &length, sizeof(length));
+}
+
+void logbuffer_appendCallSite(LogBuffer* buffer, LogCallSite* site) {
+    MAGIC_ASSERT(buffer);
+    MAGIC_ASSERT(site);
+
+    guint start = _logbuffer_beginEntry(buffer, LOGENTRY_CALLSITE);
+    _logbuffer_appendU32(buffer, (guint32)site->id);
+    _logbuffer_appendString(buffer, site->callInfo, -1);
+    /* we format the messages of call sites we can't defer ourselves */
+    _logbuffer_appendString(buffer, site->format == NULL ? "NOMESSAGE" :
+            site->isDeferrable ? site->format : "%s", -1);
+    _logbuffer_endEntry(buffer, start);
+}
+
+void logbuffer_appendHost(LogBuffer* buffer, guint hostID, const gchar* hostName) {
+    MAGIC_ASSERT(buffer);
+
+    guint start = _logbuffer_beginEntry(buffer, LOGENTRY_HOST);
+    _logbuffer_appendU32(buffer, (guint32)hostID);
+    _logbuffer_appendString(buffer, hostName, -1);
+    _logbuffer_endEntry(buffer, start);
+}
+
+static void _logbuffer_appendArgumentsVA(LogBuffer* buffer, LogCallSite* site, va_list vargs) {
+    /* the errno of the caller, for %m */
+    gint savedErrno = errno;
+    gint lastInt = -1;
+
+    for(guint i = 0; i < site->numArguments; i++) {
+        LogArgument* argument = &site->arguments[i];
+
+        switch(argument->type) {
+            case LOGARG_INT: {
+                gint32 value = (gint32)va_arg(vargs, gint);
+                lastInt = value;
+                _logbuffer_appendU8(buffer, LOGARG_TAG_INT);
+                _logbuffer_append(buffer, &value, sizeof(value));
+                break;
+            }
+
+            case LOGARG_LONG:
+            case LOGARG_LONGLONG:
+            case LOGARG_INTMAX:
+            case LOGARG_SIZE:
+            case LOGARG_PTRDIFF: {
+                gint64 value = 0;
+                if(argument->type == LOGARG_LONG) {
+                    value = (gint64)va_arg(vargs, glong);
+                } else if(argument->type == LOGARG_LONGLONG) {
+                    value = (gint64)va_arg(vargs, long long);
+                } else if(argument->type == LOGARG_INTMAX) {
+                    value = (gint64)va_arg(vargs, intmax_t);
+                } else if(argument->type == LOGARG_SIZE) {
+                    value = (gint64)va_arg(vargs, gsize);
+                } else {
+                    value = (gint64)va_arg(vargs, ptrdiff_t);
+                }
+                _logbuffer_appendU8(buffer, LOGARG_TAG_INT64);
+                _logbuffer_append(buffer, &value, sizeof(value));
+                break;
+            }
+
+            case LOGARG_DOUBLE:
+            case LOGARG_LONGDOUBLE: {
+                gdouble value = (argument->type == LOGARG_DOUBLE) ?
+                        va_arg(vargs, gdouble) : (gdouble)va_arg(vargs, long double);
+                _logbuffer_appendU8(buffer, LOGARG_TAG_DOUBLE);
+                _logbuffer_append(buffer, &value, sizeof(value));
+                break;
+            }
+
+            case LOGARG_POINTER: {
+                guint64 value = (guint64)(guintptr)va_arg(vargs, gpointer);
+                _logbuffer_appendU8(buffer, LOGARG_TAG_POINTER);
+                _logbuffer_append(buffer, &value, sizeof(value));
+                break;
+            }
+
+            case LOGARG_STRING: {
+                const gchar* value = va_arg(vargs, const gchar*);
+                gint precision = (argument->precision == LOGARG_PRECISION_STAR) ? lastInt : argument->precision;
+                _logbuffer_appendU8(buffer, LOGARG_TAG_STRING);
+                _logbuffer_appendString(buffer, value, precision);
+                break;
+            }
+
+            case LOGARG_ERRNO: {
+                _logbuffer_appendU8(buffer, LOGARG_TAG_STRING);
+                _logbuffer_appendString(buffer, g_strerror(savedErrno), -1);
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+}
+
+void logbuffer_appendRecordVA(LogBuffer* buffer, LogCallSite* site, LogLevel level,
+        gdouble wallElapsedSeconds, SimulationTime simElapsedNanos, guint hostID, gint threadID,
+        va_list vargs) {
+    MAGIC_ASSERT(buffer);
+    MAGIC_ASSERT(site);
+
+    guint start = _logbuffer_beginEntry(buffer, LOGENTRY_RECORD);
+
+    guint64 simTime = (guint64)simElapsedNanos;
+    gint32 thread = (gint32)threadID;
+    _logbuffer_append(buffer, &wallElapsedSeconds, sizeof(wallElapsedSeconds));
+    _logbuffer_append(buffer, &simTime, sizeof(simTime));
+    _logbuffer_appendU32(buffer, (guint32)hostID);
+    _logbuffer_append(buffer, &thread, sizeof(thread));
+    _logbuffer_appendU8(buffer, (guint8)level);
+    _logbuffer_appendU32(buffer, (guint32)site->id);
+
+    if(site->isDeferrable) {
+        _logbuffer_appendArgumentsVA(buffer, site, vargs);
+    } else if(site->format != NULL) {
+        gchar* message = g_strdup_vprintf(site->format, vargs);
+        _logbuffer_appendU8(buffer, LOGARG_TAG_STRING);
+        _logbuffer_appendString(buffer, message, -1);
+        g_free(message);
+    }
+
+    _logbuffer_endEntry(buffer, start);
+}
+
+static inline gboolean _logreader_read(LogReader* reader, gpointer value, gsize length) {
+    if(reader->offset + length > reader->length) {
+        return FALSE;
+    }
+    memcpy(value, &reader->data[reader->offset], length);
+    reader->offset += length;
+    return TRUE;
+}
+
+/* sets *string to point into the entry, or to NULL for a NULL string */
+static gboolean _logreader_readString(LogReader* reader, const gchar** string, guint32* length) {
+    if(!_logreader_read(reader, length, sizeof(guint32))) {
+        return FALSE;
+    }
+    if(*length == LOGENTRY_NULL_STRING) {
+        *string = NULL;
+        *length = 0;
+        return TRUE;
+    }
+    if(reader->offset + *length > reader->length) {
+        return FALSE;
+    }
+    *string = (const gchar*)&reader->data[reader->offset];
+    reader->offset += *length;
+    return TRUE;
+}
+
+/* the offsets of the record header fields, after the type and length */
+#define LOGRECORD_WALLTIME_OFFSET (LOGENTRY_HEADER_LENGTH)
+#define LOGRECORD_LEVEL_OFFSET (LOGRECORD_WALLTIME_OFFSET + sizeof(gdouble) + sizeof(guint64) + sizeof(guint32) + sizeof(gint32))
+#define LOGRECORD_ARGUMENTS_OFFSET (LOGRECORD_LEVEL_OFFSET + sizeof(guint8) + sizeof(guint32))
+
+gboolean logbuffer_nextEntry(LogBuffer* buffer, gsize* offset, LogEntry* entry) {
+    MAGIC_ASSERT(buffer);
+    utility_assert(offset && entry);
+
+    if(*offset + LOGENTRY_HEADER_LENGTH > buffer->bytes->len) {
+        return FALSE;
+    }
+
+    const guint8* data = &buffer->bytes->data[*offset];
+    guint32 length = 0;
+    memcpy(&length, &data[sizeof(guint8)], sizeof(length));
+    utility_assert(length >= LOGENTRY_HEADER_LENGTH && *offset + length <= buffer->bytes->len);
+
+    entry->type = (LogEntryType)data[0];
+    entry->data = data;
+    entry->length = length;
+
+    if(entry->type == LOGENTRY_RECORD) {
+        memcpy(&entry->wallElapsedSeconds, &data[LOGRECORD_WALLTIME_OFFSET], sizeof(gdouble));
+        entry->level = (LogLevel)data[LOGRECORD_LEVEL_OFFSET];
+    } else {
+        entry->wallElapsedSeconds = 0;
+        entry->level = LOGLEVEL_UNSET;
+    }
+
+    *offset += length;
+    return TRUE;
+}
+
+static void _logdecodercallsite_free(LogDecoderCallSite* site) {
+    g_free(site->callInfo);
+    g_free(site->format);
+    g_free(site);
+}
+
+LogDecoder* logdecoder_new() {
+    LogDecoder* decoder = g_new0(LogDecoder, 1);
+    MAGIC_INIT(decoder);
+
+    decoder->callSites = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+            NULL, (GDestroyNotify)_logdecodercallsite_free);
+    decoder->hostNames = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+
+    return decoder;
+}
+
+void logdecoder_free(LogDecoder* decoder) {
+    MAGIC_ASSERT(decoder);
+
+    g_hash_table_destroy(decoder->callSites);
+    g_hash_table_destroy(decoder->hostNames);
+
+    MAGIC_CLEAR(decoder);
+    g_free(decoder);
+}
+
+void logdecoder_addDefinition(LogDecoder* decoder, const LogEntry* entry) {
+    MAGIC_ASSERT(decoder);
+    utility_assert(entry);
+
+    LogReader reader = {entry->data, entry->length, LOGENTRY_HEADER_LENGTH};
+    guint32 id = 0;
+    const gchar* first = NULL;
+    const gchar* second = NULL;
+    guint32 firstLength = 0, secondLength = 0;
+
+    if(entry->type == LOGENTRY_CALLSITE) {
+        if(_logreader_read(&reader, &id, sizeof(id)) &&
+                _logreader_readString(&reader, &first, &firstLength) &&
+                _logreader_readString(&reader, &second, &secondLength)) {
+            /* every thread defines the call sites it uses, but the ids are
+             * unique so all definitions of an id are the same */
+            if(!g_hash_table_contains(decoder->callSites, GUINT_TO_POINTER(id))) {
+                LogDecoderCallSite* site = g_new0(LogDecoderCallSite, 1);
+                site->callInfo = first ? g_strndup(first, firstLength) : NULL;
+                site->format = second ? g_strndup(second, secondLength) : NULL;
+                g_hash_table_replace(decoder->callSites, GUINT_TO_POINTER(id), site);
+            }
+        }
+    } else if(entry->type == LOGENTRY_HOST) {
+        if(_logreader_read(&reader, &id, sizeof(id)) &&
+                _logreader_readString(&reader, &first, &firstLength)) {
+            g_hash_table_replace(decoder->hostNames, GUINT_TO_POINTER(id),
+                    first ? g_strndup(first, firstLength) : g_strdup("n/a"));
+        }
+    }
+}
+
+/* format one conversion spec, given without its length modifier, with the
+ * next argument of the record */
+static gboolean _logdecoder_formatArgument(LogReader* reader, GString* spec, gchar conversion,
+        const gchar* intModifier, GString* output) {
+    guint8 tag = 0;
+    if(!_logreader_read(reader, &tag, sizeof(tag))) {
+        return FALSE;
+    }
+
+    switch(tag) {
+        case LOGARG_TAG_INT: {
+            gint32 value = 0;
+            if(!_logreader_read(reader, &value, sizeof(value))) {
+                return FALSE;
+            }
+            /* keep h and hh so the value is truncated as it would have been */
+            g_string_append(spec, intModifier);
+            g_string_append_c(spec, conversion);
+            g_string_append_printf(output, spec->str, (gint)value);
+            return TRUE;
+        }
+
+        case LOGARG_TAG_INT64: {
+            gint64 value = 0;
+            if(!_logreader_read(reader, &value, sizeof(value))) {
+                return FALSE;
+            }
+            g_string_append(spec, "ll");
+            g_string_append_c(spec, conversion);
+            g_string_append_printf(output, spec->str, (long long)value);
+            return TRUE;
+        }
+
+        case LOGARG_TAG_DOUBLE: {
+            gdouble value = 0;
+            if(!_logreader_read(reader, &value, sizeof(value))) {
+                return FALSE;
+            }
+            g_string_append_c(spec, conversion);
+            g_string_append_printf(output, spec->str, value);
+            return TRUE;
+        }
+
+        case LOGARG_TAG_POINTER: {
+            guint64 value = 0;
+            if(!_logreader_read(reader, &value, sizeof(value))) {
+                return FALSE;
+            }
+            g_string_append_c(spec, 'p');
+            g_string_append_printf(output, spec->str, (gpointer)(guintptr)value);
+            return TRUE;
+        }
+
+        case LOGARG_TAG_STRING: {
+            const gchar* value = NULL;
+            guint32 length = 0;
+            if(!_logreader_readString(reader, &value, &length)) {
+                return FALSE;
+            }
+            /* %m was captured as a string */
+            g_string_append_c(spec, 's');
+            if(value) {
+                gchar* string = g_strndup(value, length);
+                g_string_append_printf(output, spec->str, string);
+                g_free(string);
+            } else {
+                g_string_append_printf(output, spec->str, (const gchar*)NULL);
+            }
+            return TRUE;
+        }
+
+        default:
+            return FALSE;
+    }
+}
+
+/* reads a star width or precision argument */
+static gboolean _logdecoder_readStar(LogReader* reader, gint* value) {
+    guint8 tag = 0;
+    gint32 star = 0;
+    if(!_logreader_read(reader, &tag, sizeof(tag)) || tag != LOGARG_TAG_INT ||
+            !_logreader_read(reader, &star, sizeof(star))) {
+        return FALSE;
+    }
+    *value = (gint)star;
+    return TRUE;
+}
+
+/* walks the format exactly like _logcallsite_parseFormat, printing each
+ * conversion with the argument value that was captured for it */
+static void _logdecoder_formatMessage(const gchar* format, LogReader* reader, GString* output) {
+    GString* spec = g_string_sized_new(32);
+    const gchar* p = format;
+
+    while(*p) {
+        const gchar* percent = strchr(p, '%');
+        if(percent == NULL) {
+            g_string_append(output, p);
+            break;
+        }
+        g_string_append_len(output, p, percent - p);
+        p = percent + 1;
+
+        if(*p == '%') {
+            g_string_append_c(output, '%');
+            p++;
+            continue;
+        }
+
+        g_string_assign(spec, "%");
+        while(*p && strchr("-+ #0'I", *p)) {
+            g_string_append_c(spec, *p);
+            p++;
+        }
+
+        if(*p == '*') {
+            gint width = 0;
+            if(!_logdecoder_readStar(reader, &width)) {
+                break;
+            }
+            /* a negative width is a left-justified width, and so is its string */
+            g_string_append_printf(spec, "%i", width);
+            p++;
+        } else {
+            while(g_ascii_isdigit(*p)) {
+                g_string_append_c(spec, *p);
+                p++;
+            }
+        }
+
+        if(*p == '.') {
+            p++;
+            if(*p == '*') {
+                gint precision = 0;
+                if(!_logdecoder_readStar(reader, &precision)) {
+                    break;
+                }
+                /* a negative precision is taken as if it were omitted */
+                if(precision >= 0) {
+                    g_string_append_printf(spec, ".%i", precision);
+                }
+                p++;
+            } else {
+                g_string_append_c(spec, '.');
+                while(g_ascii_isdigit(*p)) {
+                    g_string_append_c(spec, *p);
+                    p++;
+                }
+            }
+        }
+
+        const gchar* intModifier = "";
+        if(*p == 'h') {
+            intModifier = (p[1] == 'h') ? "hh" : "h";
+        }
+        while(*p && strchr("hlLqjzZt", *p)) {
+            p++;
+        }
+
+        if(*p == '\0' || !_logdecoder_formatArgument(reader, spec, *p, intModifier, output)) {
+            break;
+        }
+        p++;
+    }
+
+    g_string_free(spec, TRUE);
+}
+
+static void _logdecoder_appendSimTime(GString* output, SimulationTime simElapsedNanos) {
+    SimulationTime remainder = simElapsedNanos;
+
+    SimulationTime hours = remainder / SIMTIME_ONE_HOUR;
+    remainder %= SIMTIME_ONE_HOUR;
+    SimulationTime minutes = remainder / SIMTIME_ONE_MINUTE;
+    remainder %= SIMTIME_ONE_MINUTE;
+    SimulationTime seconds = remainder / SIMTIME_ONE_SECOND;
+    remainder %= SIMTIME_ONE_SECOND;
+    SimulationTime nanoseconds = remainder;
+
+    g_string_append_printf(output, "%02"G_GUINT64_FORMAT":%02"G_GUINT64_FORMAT":%02"G_GUINT64_FORMAT".%09"G_GUINT64_FORMAT,
+            hours, minutes, seconds, nanoseconds);
+}
+
+static void _logdecoder_appendWallTime(GString* output, gdouble wallElapsedSeconds) {
+    guint64 remainder = (guint64)wallElapsedSeconds;
+    gdouble fraction = wallElapsedSeconds - ((gdouble)remainder);
+
+    guint64 hours = remainder/3600;
+    remainder %= 3600;
+    guint64 minutes = remainder/60;
+    remainder %= 60;
+    guint64 seconds = remainder;
+    guint64 microseconds = (guint64)(fraction * ((gdouble)1000000));
+
+    g_string_append_printf(output, "%02"G_GUINT64_FORMAT":%02"G_GUINT64_FORMAT":%02"G_GUINT64_FORMAT".%06"G_GUINT64_FORMAT,
+            hours, minutes, seconds, microseconds);
+}
+
+void logdecoder_formatRecord(LogDecoder* decoder, const LogEntry* entry, GString* output) {
+    MAGIC_ASSERT(decoder);
+    utility_assert(entry && entry->type == LOGENTRY_RECORD);
+
+    LogReader reader = {entry->data, entry->length, LOGRECORD_WALLTIME_OFFSET};
+    gdouble wallElapsedSeconds = 0;
+    guint64 simElapsedNanos = 0;
+    guint32 hostID = 0, callSiteID = 0;
+    gint32 threadID = 0;
+    guint8 level = 0;
+
+    _logreader_read(&reader, &wallElapsedSeconds, sizeof(wallElapsedSeconds));
+    _logreader_read(&reader, &simElapsedNanos, sizeof(simElapsedNanos));
+    _logreader_read(&reader, &hostID, sizeof(hostID));
+    _logreader_read(&reader, &threadID, sizeof(threadID));
+    _logreader_read(&reader, &level, sizeof(level));
+    _logreader_read(&reader, &callSiteID, sizeof(callSiteID));
+
+    LogDecoderCallSite* site = g_hash_table_lookup(decoder->callSites, GUINT_TO_POINTER(callSiteID));
+    const gchar* hostName = hostID ? g_hash_table_lookup(decoder->hostNames, GUINT_TO_POINTER(hostID)) : NULL;
+
+    /* this must produce the same line as logrecord_toString */
+    _logdecoder_appendWallTime(output, wallElapsedSeconds);
+    g_string_append_printf(output, " [thread-%i] ", (gint)threadID);
+    if(simElapsedNanos != (guint64)SIMTIME_INVALID) {
+        _logdecoder_appendSimTime(output, (SimulationTime)simElapsedNanos);
+    } else {
+        g_string_append(output, "n/a");
+    }
+    g_string_append_printf(output, " [%s] [%s] %s ", loglevel_toStr((LogLevel)level),
+            hostName ? hostName : "n/a", (site && site->callInfo) ? site->callInfo : "n/a");
+
+    if(site && site->format) {
+        _logdecoder_formatMessage(site->format, &reader, output);
+    } else {
+        g_string_append(output, "NOMESSAGE");
+    }
+    g_string_append_c(output, '\n');
+}
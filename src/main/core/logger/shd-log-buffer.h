@@ -0,0 +1,87 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_LOG_BUFFER_H_
+#define SHD_LOG_BUFFER_H_
+
+/**
+ * Compact binary log records whose messages are formatted after the fact.
+ *
+ * In the deferred and binary log formats, worker threads do not format their
+ * messages. A record holds a small fixed header (wall and simulation time,
+ * host id, thread id, level), the id of its call site, and the raw printf
+ * argument values, and is appended to a LogBuffer owned by the thread. The
+ * call site (call info string and format string) and the host name are
+ * written once per thread as definition entries the first time a record
+ * refers to them.
+ *
+ * Buffers are handed to the logger helper thread, which either formats the
+ * records into the usual text lines (deferred) or writes the entries as they
+ * are (binary) so that src/tools/decode-shadow-log.py can produce the text
+ * later. Format strings must be string literals, since they are only parsed
+ * once per call site.
+ */
+
+typedef enum _LogFormat LogFormat;
+enum _LogFormat {
+    /* format each message on the worker thread */
+    LOGFORMAT_TEXT,
+    /* format each message on the logger helper thread */
+    LOGFORMAT_DEFERRED,
+    /* write binary records to be formatted offline */
+    LOGFORMAT_BINARY,
+};
+
+LogFormat logformat_fromStr(const gchar* formatStr);
+
+/* the binary log stream starts with this string, followed by the entries */
+#define LOGBUFFER_MAGIC "shadow-binary-log-1\n"
+
+typedef enum _LogEntryType LogEntryType;
+enum _LogEntryType {
+    LOGENTRY_NONE, LOGENTRY_CALLSITE, LOGENTRY_HOST, LOGENTRY_RECORD,
+};
+
+typedef struct _LogCallSite LogCallSite;
+typedef struct _LogBuffer LogBuffer;
+typedef struct _LogDecoder LogDecoder;
+
+/* an entry found in a buffer; data points at the type byte of the entry */
+typedef struct _LogEntry LogEntry;
+struct _LogEntry {
+    LogEntryType type;
+    const guint8* data;
+    gsize length;
+    /* only valid for LOGENTRY_RECORD */
+    gdouble wallElapsedSeconds;
+    LogLevel level;
+};
+
+LogCallSite* logcallsite_new(guint id, const gchar* fileName, const gchar* functionName,
+        const gint lineNumber, const gchar* format);
+void logcallsite_free(LogCallSite* site);
+GHashTable* logcallsite_newTable();
+LogCallSite* logcallsite_lookup(GHashTable* table, const gchar* fileName, const gchar* functionName,
+        const gint lineNumber, const gchar* format);
+
+LogBuffer* logbuffer_new(GAsyncQueue* returnQueue);
+void logbuffer_free(LogBuffer* buffer);
+gboolean logbuffer_isEmpty(LogBuffer* buffer);
+void logbuffer_release(LogBuffer* buffer);
+
+void logbuffer_appendCallSite(LogBuffer* buffer, LogCallSite* site);
+void logbuffer_appendHost(LogBuffer* buffer, guint hostID, const gchar* hostName);
+void logbuffer_appendRecordVA(LogBuffer* buffer, LogCallSite* site, LogLevel level,
+        gdouble wallElapsedSeconds, SimulationTime simElapsedNanos, guint hostID, gint threadID,
+        va_list vargs);
+
+gboolean logbuffer_nextEntry(LogBuffer* buffer, gsize* offset, LogEntry* entry);
+
+LogDecoder* logdecoder_new();
+void logdecoder_free(LogDecoder* decoder);
+void logdecoder_addDefinition(LogDecoder* decoder, const LogEntry* entry);
+void logdecoder_formatRecord(LogDecoder* decoder, const LogEntry* entry, GString* output);
+
+#endif /* SHD_LOG_BUFFER_H_ */
@@ -130,7 +130,7 @@ void logrecord_formatMessage(LogRecord* record, const gchar *messageFormat, ...)
     va_end(vargs);
 }
 
-static gchar* _logrecord_getNewSimTimeStr(LogRecord* record) {
+static void _logrecord_appendSimTime(LogRecord* record, GString* output) {
     MAGIC_ASSERT(record);
 
     SimulationTime remainder = record->simElapsedNanos;
@@ -143,11 +143,11 @@ static gchar* _logrecord_getNewSimTimeStr(LogRecord* record) {
     remainder %= SIMTIME_ONE_SECOND;
     SimulationTime nanoseconds = remainder;
 
-    return g_strdup_printf("%02"G_GUINT64_FORMAT":%02"G_GUINT64_FORMAT":%02"G_GUINT64_FORMAT".%09"G_GUINT64_FORMAT,
+    g_string_append_printf(output, "%02"G_GUINT64_FORMAT":%02"G_GUINT64_FORMAT":%02"G_GUINT64_FORMAT".%09"G_GUINT64_FORMAT,
             hours, minutes, seconds, nanoseconds);
 }
 
-static gchar* _logrecord_getNewWallTimeStr(LogRecord* record) {
+static void _logrecord_appendWallTime(LogRecord* record, GString* output) {
     MAGIC_ASSERT(record);
 
     guint64 remainder = (guint64)record->wallElapsedSeconds;
@@ -160,34 +160,33 @@ static gchar* _logrecord_getNewWallTimeStr(LogRecord* record) {
     guint64 seconds = remainder;
     guint64 microseconds = (guint64)(fraction * ((gdouble)1000000));
 
-    return g_strdup_printf("%02"G_GUINT64_FORMAT":%02"G_GUINT64_FORMAT":%02"G_GUINT64_FORMAT".%06"G_GUINT64_FORMAT,
+    g_string_append_printf(output, "%02"G_GUINT64_FORMAT":%02"G_GUINT64_FORMAT":%02"G_GUINT64_FORMAT".%06"G_GUINT64_FORMAT,
             hours, minutes, seconds, microseconds);
 }
 
-
-gchar* logrecord_toString(LogRecord* record) {
+void logrecord_appendToString(LogRecord* record, GString* output) {
     MAGIC_ASSERT(record);
     utility_assert(record->callInfo);
-
-    gchar* wallTimeStr = _logrecord_getNewWallTimeStr(record);
-    gchar* simTimeStr = (record->simElapsedNanos != SIMTIME_INVALID) ? _logrecord_getNewSimTimeStr(record) : NULL;
-
-    gchar* recordStr = g_strdup_printf("%s [%s] %s [%s] [%s] %s %s\n",
-            (wallTimeStr != NULL) ? wallTimeStr : "n/a",
-            (record->threadName != NULL) ? record->threadName : "thread-0",
-            (simTimeStr != NULL) ? simTimeStr : "n/a",
+    utility_assert(output);
+
+    _logrecord_appendWallTime(record, output);
+    g_string_append_printf(output, " [%s] ",
+            (record->threadName != NULL) ? record->threadName : "thread-0");
+    if(record->simElapsedNanos != SIMTIME_INVALID) {
+        _logrecord_appendSimTime(record, output);
+    } else {
+        g_string_append(output, "n/a");
+    }
+    g_string_append_printf(output, " [%s] [%s] %s %s\n",
             loglevel_toStr(record->level),
             (record->hostName != NULL) ? record->hostName : "n/a",
             record->callInfo,
             (record->message != NULL) ? record->message : "NOMESSAGE");
+}
 
-
-    if(wallTimeStr != NULL) {
-        g_free(wallTimeStr);
-    }
-    if(simTimeStr != NULL) {
-        g_free(simTimeStr);
-    }
-
-    return recordStr;
+gchar* logrecord_toString(LogRecord* record) {
+    MAGIC_ASSERT(record);
+    GString* output = g_string_new(NULL);
+    logrecord_appendToString(record, output);
+    return g_string_free(output, FALSE);
 }
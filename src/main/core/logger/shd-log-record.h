@@ -20,5 +20,6 @@ void logrecord_formatMessageVA(LogRecord* record, const gchar *messageFormat, va
 void logrecord_formatMessage(LogRecord* record, const gchar *messageFormat, ...);
 
 gchar* logrecord_toString(LogRecord* record);
+void logrecord_appendToString(LogRecord* record, GString* output);
 
 #endif /* SHD_LOG_RECORD_H_ */
@@ -40,32 +40,296 @@ void loggerhelpercommand_unref(LoggerHelperCommand* command) {
     }
 }
 
-static void _loggerhelper_sort(GAsyncQueue* incomingRecords, PriorityQueue* sortedRecords) {
-    if(incomingRecords == NULL || sortedRecords == NULL) {
-        return;
+/* write output in chunks of about this many bytes */
+#define LOGGERHELPER_OUTPUT_CHUNK 1048576
+
+/* the records one thread sent us since the last flush. a thread creates its
+ * records in order, so each run is sorted and we only need to merge them. */
+typedef struct _LoggerHelperRun LoggerHelperRun;
+struct _LoggerHelperRun {
+    GAsyncQueue* mailbox;
+    /* LogRecords, for the text format */
+    GQueue* records;
+    /* LogEntrys pointing into the buffers, for the other formats */
+    GArray* entries;
+    guint nextEntry;
+};
+
+typedef struct _LoggerHelper LoggerHelper;
+struct _LoggerHelper {
+    LogFormat format;
+
+    /* one run for each registered thread */
+    GPtrArray* runs;
+
+    /* a winner tree over the heads of the runs. leaf i is at index
+     * numLeaves+i, and each inner node holds the index of the run with
+     * the earliest head of the two below it. */
+    guint* tree;
+    guint numLeaves;
+
+    /* for the deferred and binary formats */
+    LogDecoder* decoder;
+    GQueue* buffers;
+
+    /* formatted records waiting to be written */
+    GString* output;
+
+    /* where the output goes when the log is compressed */
+    Compressor* compressor;
+    CompressedStream* compressedOutput;
+};
+
+/* a run index for leaves with no run */
+#define LOGGERHELPER_NO_RUN G_MAXUINT
+
+static LoggerHelperRun* _loggerhelperrun_new(GAsyncQueue* mailbox) {
+    LoggerHelperRun* run = g_new0(LoggerHelperRun, 1);
+    run->mailbox = mailbox;
+    run->records = g_queue_new();
+    run->entries = g_array_new(FALSE, FALSE, sizeof(LogEntry));
+    return run;
+}
+
+static void _loggerhelperrun_free(LoggerHelperRun* run) {
+    LogRecord* record = NULL;
+    while((record = g_queue_pop_head(run->records)) != NULL) {
+        logrecord_unref(record);
     }
+    g_queue_free(run->records);
+    g_array_free(run->entries, TRUE);
+    g_async_queue_unref(run->mailbox);
+    g_free(run);
+}
 
+static gboolean _loggerhelperrun_isEmpty(LoggerHelperRun* run) {
+    return (g_queue_is_empty(run->records) && run->nextEntry >= run->entries->len) ? TRUE : FALSE;
+}
+
+static void _loggerhelper_writeOutput(LoggerHelper* helper) {
+    if(helper->output->len > 0) {
+        if(helper->compressedOutput) {
+            compressedstream_write(helper->compressedOutput, helper->output->str, helper->output->len);
+        } else {
+            fwrite(helper->output->str, 1, helper->output->len, stdout);
+        }
+        g_string_truncate(helper->output, 0);
+    }
+}
+
+static void _loggerhelper_collectRecords(LoggerHelper* helper, LoggerHelperRun* run) {
     GQueue* records = NULL;
-    while((records = g_async_queue_try_pop(incomingRecords)) != NULL) {
+    while((records = g_async_queue_try_pop(run->mailbox)) != NULL) {
         while(!g_queue_is_empty(records)) {
             LogRecord* record = g_queue_pop_head(records);
             if(record != NULL) {
-                priorityqueue_push(sortedRecords, record);
+                g_queue_push_tail(run->records, record);
             }
         }
         g_queue_free(records);
     }
 }
 
+static void _loggerhelper_collectBuffers(LoggerHelper* helper, LoggerHelperRun* run) {
+    LogBuffer* buffer = NULL;
+    while((buffer = g_async_queue_try_pop(run->mailbox)) != NULL) {
+        g_queue_push_tail(helper->buffers, buffer);
+
+        gsize offset = 0;
+        LogEntry entry;
+        while(logbuffer_nextEntry(buffer, &offset, &entry)) {
+            if(entry.type == LOGENTRY_RECORD) {
+                g_array_append_val(run->entries, entry);
+            } else {
+                /* definitions come before the records that use them */
+                logdecoder_addDefinition(helper->decoder, &entry);
+                if(helper->format == LOGFORMAT_BINARY) {
+                    g_string_append_len(helper->output, (const gchar*)entry.data, (gssize)entry.length);
+                }
+            }
+        }
+    }
+}
+
+/* TRUE if the head of run a should be written before the head of run b */
+static gboolean _loggerhelper_isBefore(LoggerHelper* helper, guint a, guint b) {
+    if(a == LOGGERHELPER_NO_RUN || b == LOGGERHELPER_NO_RUN) {
+        return (b == LOGGERHELPER_NO_RUN) ? TRUE : FALSE;
+    }
+
+    LoggerHelperRun* runA = g_ptr_array_index(helper->runs, a);
+    LoggerHelperRun* runB = g_ptr_array_index(helper->runs, b);
+    if(_loggerhelperrun_isEmpty(runA) || _loggerhelperrun_isEmpty(runB)) {
+        return _loggerhelperrun_isEmpty(runB);
+    }
+
+    gint result = 0;
+    if(helper->format == LOGFORMAT_TEXT) {
+        result = logrecord_compare(g_queue_peek_head(runA->records), g_queue_peek_head(runB->records), NULL);
+    } else {
+        gdouble timeA = g_array_index(runA->entries, LogEntry, runA->nextEntry).wallElapsedSeconds;
+        gdouble timeB = g_array_index(runB->entries, LogEntry, runB->nextEntry).wallElapsedSeconds;
+        result = timeA < timeB ? -1 : timeA > timeB ? 1 : 0;
+    }
+
+    /* break ties by registration order so the merge is deterministic */
+    return (result < 0 || (result == 0 && a < b)) ? TRUE : FALSE;
+}
+
+static inline void _loggerhelper_playMatch(LoggerHelper* helper, guint node) {
+    guint left = helper->tree[2*node];
+    guint right = helper->tree[(2*node)+1];
+    helper->tree[node] = _loggerhelper_isBefore(helper, left, right) ? left : right;
+}
+
+static void _loggerhelper_buildTree(LoggerHelper* helper) {
+    guint numRuns = helper->runs->len;
+    guint numLeaves = 1;
+    while(numLeaves < numRuns) {
+        numLeaves *= 2;
+    }
+
+    if(numLeaves != helper->numLeaves) {
+        helper->tree = g_renew(guint, helper->tree, 2*numLeaves);
+        helper->numLeaves = numLeaves;
+    }
+
+    for(guint i = 0; i < numLeaves; i++) {
+        helper->tree[numLeaves+i] = (i < numRuns) ? i : LOGGERHELPER_NO_RUN;
+    }
+    for(guint node = numLeaves - 1; node >= 1; node--) {
+        _loggerhelper_playMatch(helper, node);
+    }
+}
+
+/* the run at the leaf changed its head, so replay its matches up to the root */
+static void _loggerhelper_replay(LoggerHelper* helper, guint runIndex) {
+    for(guint node = (helper->numLeaves + runIndex) / 2; node >= 1; node /= 2) {
+        _loggerhelper_playMatch(helper, node);
+    }
+}
+
+static void _loggerhelper_writeHead(LoggerHelper* helper, LoggerHelperRun* run) {
+    if(helper->format == LOGFORMAT_TEXT) {
+        LogRecord* record = g_queue_pop_head(run->records);
+        logrecord_appendToString(record, helper->output);
+        logrecord_unref(record);
+    } else {
+        LogEntry* entry = &g_array_index(run->entries, LogEntry, run->nextEntry);
+        run->nextEntry++;
+        if(helper->format == LOGFORMAT_BINARY) {
+            g_string_append_len(helper->output, (const gchar*)entry->data, (gssize)entry->length);
+        } else {
+            logdecoder_formatRecord(helper->decoder, entry, helper->output);
+        }
+    }
+}
+
+static void _loggerhelper_flush(LoggerHelper* helper) {
+    if(helper->runs->len == 0) {
+        return;
+    }
+
+    for(guint i = 0; i < helper->runs->len; i++) {
+        LoggerHelperRun* run = g_ptr_array_index(helper->runs, i);
+        if(helper->format == LOGFORMAT_TEXT) {
+            _loggerhelper_collectRecords(helper, run);
+        } else {
+            _loggerhelper_collectBuffers(helper, run);
+        }
+    }
+
+    /* merge the runs, always writing the earliest head of any of them */
+    _loggerhelper_buildTree(helper);
+    while(TRUE) {
+        guint winner = helper->tree[1];
+        if(winner == LOGGERHELPER_NO_RUN) {
+            break;
+        }
+        LoggerHelperRun* run = g_ptr_array_index(helper->runs, winner);
+        if(_loggerhelperrun_isEmpty(run)) {
+            /* the earliest run is empty, so they all are */
+            break;
+        }
+
+        _loggerhelper_writeHead(helper, run);
+        _loggerhelper_replay(helper, winner);
+
+        if(helper->output->len >= LOGGERHELPER_OUTPUT_CHUNK) {
+            _loggerhelper_writeOutput(helper);
+        }
+    }
+    _loggerhelper_writeOutput(helper);
+    fflush(stdout);
+
+    /* the records are written, give the memory back to the workers */
+    for(guint i = 0; i < helper->runs->len; i++) {
+        LoggerHelperRun* run = g_ptr_array_index(helper->runs, i);
+        g_array_set_size(run->entries, 0);
+        run->nextEntry = 0;
+    }
+    if(helper->buffers) {
+        while(!g_queue_is_empty(helper->buffers)) {
+            logbuffer_release(g_queue_pop_head(helper->buffers));
+        }
+    }
+}
+
+static LoggerHelper* _loggerhelper_new(LogFormat format, Compressor* compressor) {
+    LoggerHelper* helper = g_new0(LoggerHelper, 1);
+
+    helper->format = format;
+    if(compressor) {
+        helper->compressor = compressor;
+        helper->compressedOutput = compressor_openStream(compressor, STDOUT_FILENO, FALSE, COMPRESSOR_LOG_FRAME_SIZE, TRUE);
+    }
+    helper->runs = g_ptr_array_new_with_free_func((GDestroyNotify)_loggerhelperrun_free);
+    helper->output = g_string_sized_new(LOGGERHELPER_OUTPUT_CHUNK + 4096);
+
+    if(format != LOGFORMAT_TEXT) {
+        helper->decoder = logdecoder_new();
+        helper->buffers = g_queue_new();
+    }
+
+    if(format == LOGFORMAT_BINARY) {
+        g_string_append(helper->output, LOGBUFFER_MAGIC);
+    }
+
+    return helper;
+}
+
+static void _loggerhelper_free(LoggerHelper* helper) {
+    _loggerhelper_writeOutput(helper);
+    fflush(stdout);
+
+    if(helper->compressedOutput) {
+        /* we may be stopping to abort, so wait until the log is on disk */
+        compressedstream_close(helper->compressedOutput);
+        compressor_sync(helper->compressor);
+    }
+
+    g_ptr_array_free(helper->runs, TRUE);
+    if(helper->tree) {
+        g_free(helper->tree);
+    }
+    if(helper->decoder) {
+        logdecoder_free(helper->decoder);
+    }
+    if(helper->buffers) {
+        g_queue_free(helper->buffers);
+    }
+    g_string_free(helper->output, TRUE);
+
+    g_free(helper);
+}
+
 gpointer loggerhelper_runHelperThread(LoggerHelperRunData* data) {
     GAsyncQueue* commands = data->commands;
     CountDownLatch* notifyDoneRunning = data->notifyDoneRunning;
+    LoggerHelper* helper = _loggerhelper_new(data->format, data->compressor);
     g_free(data);
     data = NULL;
 
-    GQueue* queues = g_queue_new();
-    PriorityQueue* sortedRecords = priorityqueue_new((GCompareDataFunc)logrecord_compare, NULL, NULL);
-
     LoggerHelperCommand* command = NULL;
     gboolean stop = FALSE;
 
@@ -74,21 +338,12 @@ gpointer loggerhelper_runHelperThread(LoggerHelperRunData* data) {
         switch(command->type) {
             case LHC_REGISTER: {
                 GAsyncQueue* incomingRecords = command->argument;
-                g_queue_push_tail(queues, incomingRecords);
+                g_ptr_array_add(helper->runs, _loggerhelperrun_new(incomingRecords));
                 break;
             }
 
             case LHC_FLUSH: {
-                g_queue_foreach(queues, (GFunc)_loggerhelper_sort, sortedRecords);
-                while(!priorityqueue_isEmpty(sortedRecords)) {
-                    LogRecord* record = priorityqueue_pop(sortedRecords);
-                    gchar* logRecordStr = logrecord_toString(record);
-                    utility_assert(logRecordStr);
-                    g_print("%s", logRecordStr);
-                    g_free(logRecordStr);
-                    logrecord_unref(record);
-                }
-                utility_assert(priorityqueue_isEmpty(sortedRecords));
+                _loggerhelper_flush(helper);
                 break;
             }
 
@@ -104,11 +359,7 @@ gpointer loggerhelper_runHelperThread(LoggerHelperRunData* data) {
         loggerhelpercommand_unref(command);
     }
 
-    while(!g_queue_is_empty(queues)) {
-        g_async_queue_unref(g_queue_pop_head(queues));
-    }
-    g_queue_free(queues);
-    priorityqueue_free(sortedRecords);
+    _loggerhelper_free(helper);
 
     countdownlatch_countDown(notifyDoneRunning);
     return NULL;
@@ -7,6 +7,7 @@
 #define SHD_LOGGER_HELPER_H_
 
 #include "utility/shd-count-down-latch.h"
+#include "utility/shd-compressor.h"
 
 typedef enum _LoggerHelperCommmandType LoggerHelperCommmandType;
 enum _LoggerHelperCommmandType {
@@ -23,6 +24,9 @@ typedef struct _LoggerHelperRunData LoggerHelperRunData;
 struct _LoggerHelperRunData {
     GAsyncQueue* commands;
     CountDownLatch* notifyDoneRunning;
+    LogFormat format;
+    /* if set, the log is compressed before it is written to stdout */
+    Compressor* compressor;
 };
 
 gpointer loggerhelper_runHelperThread(LoggerHelperRunData* data);
@@ -6,6 +6,9 @@
 #include <stdarg.h>
 #include "shadow.h"
 
+/* see the comment in shd-logger.h */
+__thread LogLevel loggerThreadFilterLevel = LOGLEVEL_UNSET;
+
 /* this stores thread-specific data for each "worker" thread (the threads that
  * are running the virtual nodes) */
 typedef struct _LoggerThreadData LoggerThreadData;
@@ -17,6 +20,15 @@ struct _LoggerThreadData {
     /* local temporary store for this threads log records */
     GQueue* localRecordBundle;
 
+    /* in the deferred and binary formats, records are appended here instead */
+    LogBuffer* localBuffer;
+    /* the helper gives our buffers back here after writing them */
+    GAsyncQueue* freeBuffers;
+    /* the call sites and hosts we already wrote definitions for */
+    GHashTable* callSites;
+    GHashTable* definedHosts;
+    guint lastHostID;
+
     /* remote queue over which to send helper thread messages */
     GAsyncQueue* remoteLogHelperMailbox;
     MAGIC_DECLARE;
@@ -29,6 +41,11 @@ struct _Logger {
     /* the level below which we filter messages */
     LogLevel filterLevel;
 
+    /* where log messages are formatted, and how they are written */
+    LogFormat format;
+    /* call site ids must be unique across all threads */
+    gint nextCallSiteID;
+
     /* if the logger should cache messages before writing for performance */
     gboolean shouldBuffer;
     gdouble lastTimespan;
@@ -48,7 +65,7 @@ struct _Logger {
 
 static Logger* defaultLogger = NULL;
 
-static LoggerThreadData* _loggerthreaddata_new(GTimer* loggerTimer) {
+static LoggerThreadData* _loggerthreaddata_new(GTimer* loggerTimer, LogFormat format) {
     LoggerThreadData* threadData = g_new0(LoggerThreadData, 1);
     MAGIC_INIT(threadData);
 
@@ -58,6 +75,13 @@ static LoggerThreadData* _loggerthreaddata_new(GTimer* loggerTimer) {
     threadData->localRecordBundle = g_queue_new();
     threadData->remoteLogHelperMailbox = g_async_queue_new();
 
+    if(format != LOGFORMAT_TEXT) {
+        threadData->freeBuffers = g_async_queue_new();
+        threadData->localBuffer = logbuffer_new(threadData->freeBuffers);
+        threadData->callSites = logcallsite_newTable();
+        threadData->definedHosts = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+
     return threadData;
 }
 
@@ -72,6 +96,18 @@ static void _loggerthreaddata_free(LoggerThreadData* threadData) {
     g_queue_free(threadData->localRecordBundle);
     g_async_queue_unref(threadData->remoteLogHelperMailbox);
 
+    if(threadData->freeBuffers) {
+        /* the helper has given back every buffer it wrote */
+        logbuffer_free(threadData->localBuffer);
+        LogBuffer* buffer = NULL;
+        while((buffer = g_async_queue_try_pop(threadData->freeBuffers)) != NULL) {
+            logbuffer_free(buffer);
+        }
+        g_async_queue_unref(threadData->freeBuffers);
+        g_hash_table_destroy(threadData->callSites);
+        g_hash_table_destroy(threadData->definedHosts);
+    }
+
     g_timer_destroy(threadData->runTimer);
 
     MAGIC_CLEAR(threadData);
@@ -98,11 +134,28 @@ Logger* logger_getDefault() {
 void logger_setFilterLevel(Logger* logger, LogLevel level) {
     MAGIC_ASSERT(logger);
     logger->filterLevel = level;
+    /* other threads pick up the new level the next time their host changes */
+    loggerThreadFilterLevel = LOGLEVEL_UNSET;
+}
+
+void logger_setThreadHostLevel(Logger* logger, LogLevel hostLevel) {
+    if(logger) {
+        MAGIC_ASSERT(logger);
+        /* the host filter level overrides the default logger level */
+        loggerThreadFilterLevel = (hostLevel != LOGLEVEL_UNSET) ? hostLevel : logger->filterLevel;
+    } else {
+        loggerThreadFilterLevel = LOGLEVEL_UNSET;
+    }
 }
 
 gboolean logger_shouldFilter(Logger* logger, LogLevel level) {
     MAGIC_ASSERT(logger);
 
+    /* workers keep the answer for their active host cached */
+    if(loggerThreadFilterLevel != LOGLEVEL_UNSET) {
+        return (level > loggerThreadFilterLevel) ? TRUE : FALSE;
+    }
+
     /* check if the message should be filtered */
     LogLevel nodeLevel = LOGLEVEL_UNSET;
 
@@ -152,6 +205,78 @@ static void _logger_stopHelper(Logger* logger) {
     countdownlatch_await(logger->helperLatch);
 }
 
+static void _logger_checkFlush(Logger* logger, LogLevel level, gdouble timespan) {
+    if(level == LOGLEVEL_ERROR || !logger->shouldBuffer || (timespan - logger->lastTimespan) >= 5) {
+        /* make sure we have logged everything */
+        logger_flushRecords(logger, pthread_self());
+        logger_syncToDisk(logger);
+        logger->lastTimespan = timespan;
+    }
+
+    if(level == LOGLEVEL_ERROR) {
+        /* tell the helper to stop, and join to make sure it finished flushing */
+        _logger_stopHelper(logger);
+
+        /* now abort, but get a backtrace */
+        utility_assert(FALSE && "failure due to error-level log message");
+    }
+}
+
+/* returns the id of the host for our records, writing its name the first
+ * time this thread logs for it, or 0 if it has no name yet */
+static guint _logger_defineHost(LoggerThreadData* threadData, Host* host) {
+    guint hostID = (guint)host_getID(host);
+
+    if(hostID != threadData->lastHostID &&
+            !g_hash_table_contains(threadData->definedHosts, GUINT_TO_POINTER(hostID))) {
+        Address* hostAddress = host_getDefaultAddress(host);
+        if(!hostAddress) {
+            return 0;
+        }
+
+        gchar* hostName = g_strdup_printf("%s~%s", host_getName(host), address_toHostIPString(hostAddress));
+        logbuffer_appendHost(threadData->localBuffer, hostID, hostName);
+        g_free(hostName);
+
+        g_hash_table_add(threadData->definedHosts, GUINT_TO_POINTER(hostID));
+    }
+
+    threadData->lastHostID = hostID;
+    return hostID;
+}
+
+static void _logger_appendRecordVA(Logger* logger, LoggerThreadData* threadData, LogLevel level,
+        gdouble timespan, const gchar* fileName, const gchar* functionName,
+        const gint lineNumber, const gchar *format, va_list vargs) {
+    /* keep the caller's errno for %m */
+    gint savedErrno = errno;
+
+    LogCallSite* site = logcallsite_lookup(threadData->callSites, fileName, functionName, lineNumber, format);
+    if(!site) {
+        guint id = (guint)g_atomic_int_add(&logger->nextCallSiteID, 1) + 1;
+        site = logcallsite_new(id, fileName, functionName, lineNumber, format);
+        g_hash_table_add(threadData->callSites, site);
+        logbuffer_appendCallSite(threadData->localBuffer, site);
+    }
+
+    SimulationTime simElapsedNanos = SIMTIME_INVALID;
+    guint hostID = 0;
+    gint threadID = 0;
+
+    if(worker_isAlive()) {
+        simElapsedNanos = worker_getCurrentTime();
+        threadID = worker_getThreadID();
+        Host* activeHost = worker_getActiveHost();
+        if(activeHost) {
+            hostID = _logger_defineHost(threadData, activeHost);
+        }
+    }
+
+    errno = savedErrno;
+    logbuffer_appendRecordVA(threadData->localBuffer, site, level, timespan,
+            simElapsedNanos, hostID, threadID, vargs);
+}
+
 void logger_logVA(Logger* logger, LogLevel level, const gchar* fileName, const gchar* functionName,
         const gint lineNumber, const gchar *format, va_list vargs) {
     if(!logger) {
@@ -170,6 +295,14 @@ void logger_logVA(Logger* logger, LogLevel level, const gchar* fileName, const g
 
     gdouble timespan = g_timer_elapsed(threadData->runTimer, NULL);
 
+    if(logger->format != LOGFORMAT_TEXT) {
+        /* leave all of the formatting to the helper thread */
+        _logger_appendRecordVA(logger, threadData, level, timespan,
+                fileName, functionName, lineNumber, format, vargs);
+        _logger_checkFlush(logger, level, timespan);
+        return;
+    }
+
     LogRecord* record = logrecord_new(level, timespan, fileName, functionName, lineNumber);
     logrecord_formatMessageVA(record, format, vargs);
 
@@ -199,20 +332,7 @@ void logger_logVA(Logger* logger, LogLevel level, const gchar* fileName, const g
 
     g_queue_push_tail(threadData->localRecordBundle, record);
 
-    if(level == LOGLEVEL_ERROR || !logger->shouldBuffer || (timespan - logger->lastTimespan) >= 5) {
-        /* make sure we have logged everything */
-        logger_flushRecords(logger, pthread_self());
-        logger_syncToDisk(logger);
-        logger->lastTimespan = timespan;
-    }
-
-    if(level == LOGLEVEL_ERROR) {
-        /* tell the helper to stop, and join to make sure it finished flushing */
-        _logger_stopHelper(logger);
-
-        /* now abort, but get a backtrace */
-        utility_assert(FALSE && "failure due to error-level log message");
-    }
+    _logger_checkFlush(logger, level, timespan);
 }
 
 void logger_log(Logger* logger, LogLevel level, const gchar* fileName, const gchar* functionName,
@@ -229,7 +349,7 @@ void logger_register(Logger* logger, pthread_t callerThread) {
     /* this must be called by main thread before the workers start accessing the logger! */
 
     if(g_hash_table_lookup(logger->threadToDataMap, GUINT_TO_POINTER(callerThread)) == NULL) {
-        LoggerThreadData* threadData = _loggerthreaddata_new(logger->runTimer);
+        LoggerThreadData* threadData = _loggerthreaddata_new(logger->runTimer, logger->format);
         g_hash_table_replace(logger->threadToDataMap, GUINT_TO_POINTER(callerThread), threadData);
         _logger_sendRegisterCommandToHelper(logger, threadData);
     }
@@ -245,7 +365,16 @@ void logger_flushRecords(Logger* logger, pthread_t callerThread) {
     LoggerThreadData* threadData = g_hash_table_lookup(logger->threadToDataMap, GUINT_TO_POINTER(callerThread));
     MAGIC_ASSERT(threadData);
     /* send log messages from this thread to the helper */
-    if(!g_queue_is_empty(threadData->localRecordBundle)) {
+    if(threadData->localBuffer) {
+        if(!logbuffer_isEmpty(threadData->localBuffer)) {
+            g_async_queue_push(threadData->remoteLogHelperMailbox, threadData->localBuffer);
+            /* reuse a buffer the helper is done with if we can */
+            threadData->localBuffer = g_async_queue_try_pop(threadData->freeBuffers);
+            if(!threadData->localBuffer) {
+                threadData->localBuffer = logbuffer_new(threadData->freeBuffers);
+            }
+        }
+    } else if(!g_queue_is_empty(threadData->localRecordBundle)) {
         g_async_queue_push(threadData->remoteLogHelperMailbox, threadData->localRecordBundle);
         threadData->localRecordBundle = g_queue_new();
     }
@@ -318,12 +447,13 @@ static void _logger_logShutdownMessage(Logger* logger) {
     }
 }
 
-Logger* logger_new(LogLevel filterLevel) {
+Logger* logger_new(LogLevel filterLevel, LogFormat format) {
     Logger* logger = g_new0(Logger, 1);
     MAGIC_INIT(logger);
 
     logger->runTimer = g_timer_new();
     logger->filterLevel = filterLevel;
+    logger->format = format;
     logger->shouldBuffer = TRUE;
     logger->referenceCount = 1;
     logger->threadToDataMap = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)_loggerthreaddata_free);
@@ -335,6 +465,8 @@ Logger* logger_new(LogLevel filterLevel) {
     LoggerHelperRunData* runArgs = g_new0(LoggerHelperRunData, 1);
     runArgs->commands = logger->helperCommands;
     runArgs->notifyDoneRunning = logger->helperLatch;
+    runArgs->format = format;
+    runArgs->compressor = compressor_getDefault();
 
     /* the thread will consume the reference to the runArgs struct, and will free it */
     gint returnVal = pthread_create(&(logger->helper), NULL, (void*(*)(void*))loggerhelper_runHelperThread, runArgs);
@@ -6,21 +6,50 @@
 #ifndef SHD_LOGGER_H_
 #define SHD_LOGGER_H_
 
+/* The level above which messages logged from this thread are filtered, or
+ * LOGLEVEL_UNSET if it is not known. Workers refresh it whenever their active
+ * host changes, so the log macros below can skip a filtered message with a
+ * single load, before any of its arguments are evaluated. */
+extern __thread LogLevel loggerThreadFilterLevel;
+
+/* false if a message at level would certainly be filtered; when the thread has
+ * no cached level, logger_logVA makes the full check */
+#define logger_isEnabled(level) \
+    ((level) <= LOGGER_MAX_LEVEL && \
+    (loggerThreadFilterLevel == LOGLEVEL_UNSET || (level) <= loggerThreadFilterLevel))
+
+#define _logger_logIfEnabled(level, ...) \
+do { \
+    if(logger_isEnabled(level)) { \
+        logger_log(logger_getDefault(), level, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__); \
+    } \
+} while (0)
+
 /* convenience macros for logging messages at various levels */
-#define error(...)      logger_log(logger_getDefault(), LOGLEVEL_ERROR, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
-#define critical(...)   logger_log(logger_getDefault(), LOGLEVEL_CRITICAL, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
-#define warning(...)    logger_log(logger_getDefault(), LOGLEVEL_WARNING, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
-#define message(...)    logger_log(logger_getDefault(), LOGLEVEL_MESSAGE, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
-#define info(...)       logger_log(logger_getDefault(), LOGLEVEL_INFO, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
-#ifdef DEBUG
-#define debug(...)      logger_log(logger_getDefault(), LOGLEVEL_DEBUG, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+#define error(...)      _logger_logIfEnabled(LOGLEVEL_ERROR, __VA_ARGS__)
+#define critical(...)   _logger_logIfEnabled(LOGLEVEL_CRITICAL, __VA_ARGS__)
+#define warning(...)    _logger_logIfEnabled(LOGLEVEL_WARNING, __VA_ARGS__)
+#define message(...)    _logger_logIfEnabled(LOGLEVEL_MESSAGE, __VA_ARGS__)
+#define info(...)       _logger_logIfEnabled(LOGLEVEL_INFO, __VA_ARGS__)
+
+/* debug call sites are only compiled into debug builds. building with
+ * SHADOW_ELIDE_DEBUG_LOGS also compiles out any code that checks
+ * logger_isEnabled(LOGLEVEL_DEBUG), in any build. */
+#ifdef SHADOW_ELIDE_DEBUG_LOGS
+#define LOGGER_MAX_LEVEL LOGLEVEL_INFO
+#else
+#define LOGGER_MAX_LEVEL LOGLEVEL_DEBUG
+#endif
+
+#if defined(DEBUG) && !defined(SHADOW_ELIDE_DEBUG_LOGS)
+#define debug(...)      _logger_logIfEnabled(LOGLEVEL_DEBUG, __VA_ARGS__)
 #else
 #define debug(...)
 #endif
 
 typedef struct _Logger Logger;
 
-Logger* logger_new(LogLevel filterLevel);
+Logger* logger_new(LogLevel filterLevel, LogFormat format);
 
 void logger_ref(Logger* logger);
 void logger_unref(Logger* logger);
@@ -34,6 +63,7 @@ Logger* logger_getDefault();
 
 void logger_setFilterLevel(Logger* logger, LogLevel level);
 gboolean logger_shouldFilter(Logger* logger, LogLevel level);
+void logger_setThreadHostLevel(Logger* logger, LogLevel hostLevel);
 
 void logger_setEnableBuffering(Logger* logger, gboolean enabled);
 
@@ -7,7 +7,7 @@
 
 typedef struct _GlobalSinglePolicyData GlobalSinglePolicyData;
 struct _GlobalSinglePolicyData {
-    PriorityQueue* pq;
+    EventQueue* pq;
     SimulationTime pushSequenceCounter;
     SimulationTime lastEventTime;
     gsize nPushed;
@@ -34,14 +34,14 @@ static void _schedulerpolicyglobalsingle_push(SchedulerPolicy* policy, Event* ev
     GlobalSinglePolicyData* data = policy->data;
 
     event_setSequence(event, ++(data->pushSequenceCounter));
-    priorityqueue_push(data->pq, event);
+    eventqueue_push(data->pq, event);
 }
 
 static Event* _schedulerpolicyglobalsingle_pop(SchedulerPolicy* policy, SimulationTime barrier) {
     MAGIC_ASSERT(policy);
     GlobalSinglePolicyData* data = policy->data;
 
-    Event* nextEvent = priorityqueue_peek(data->pq);
+    Event* nextEvent = eventqueue_peek(data->pq);
     if(!nextEvent) {
         return NULL;
     }
@@ -54,13 +54,13 @@ static Event* _schedulerpolicyglobalsingle_pop(SchedulerPolicy* policy, Simulati
     utility_assert(eventTime >= data->lastEventTime);
     data->lastEventTime = eventTime;
 
-    return priorityqueue_pop(data->pq);
+    return eventqueue_pop(data->pq);
 }
 
 static SimulationTime _schedulerpolicyglobalsingle_getNextTime(SchedulerPolicy* policy) {
     MAGIC_ASSERT(policy);
     GlobalSinglePolicyData* data = policy->data;
-    Event* nextEvent = priorityqueue_peek(data->pq);
+    Event* nextEvent = eventqueue_peek(data->pq);
     return (nextEvent != NULL) ? event_getTime(nextEvent) : SIMTIME_MAX;
 }
 
@@ -69,7 +69,7 @@ static void _schedulerpolicyglobalsingle_free(SchedulerPolicy* policy) {
     GlobalSinglePolicyData* data = policy->data;
 
     if(data->pq) {
-        priorityqueue_free(data->pq);
+        eventqueue_free(data->pq);
     }
     if(data->assignedHosts) {
         g_queue_free(data->assignedHosts);
@@ -82,7 +82,7 @@ static void _schedulerpolicyglobalsingle_free(SchedulerPolicy* policy) {
 
 SchedulerPolicy* schedulerpolicyglobalsingle_new() {
     GlobalSinglePolicyData* data = g_new0(GlobalSinglePolicyData, 1);
-    data->pq = priorityqueue_new((GCompareDataFunc)event_compare, NULL, (GDestroyNotify)event_unref);
+    data->pq = eventqueue_new();
     data->assignedHosts = g_queue_new();
 
     SchedulerPolicy* policy = g_new0(SchedulerPolicy, 1);
@@ -8,7 +8,7 @@
 typedef struct _HostSingleQueueData HostSingleQueueData;
 struct _HostSingleQueueData {
     GMutex lock;
-    PriorityQueue* pq;
+    EventQueue* pq;
     SimulationTime pushSequenceCounter;
     SimulationTime lastEventTime;
     gsize nPushed;
@@ -92,7 +92,7 @@ static HostSingleQueueData* _hostsinglequeuedata_new() {
     HostSingleQueueData* qdata = g_new0(HostSingleQueueData, 1);
 
     g_mutex_init(&(qdata->lock));
-    qdata->pq = priorityqueue_new((GCompareDataFunc)event_compare, NULL, (GDestroyNotify)event_unref);
+    qdata->pq = eventqueue_new();
 
     return qdata;
 }
@@ -100,7 +100,7 @@ static HostSingleQueueData* _hostsinglequeuedata_new() {
 static void _hostsinglequeuedata_free(HostSingleQueueData* qdata) {
     if(qdata) {
         if(qdata->pq) {
-            priorityqueue_free(qdata->pq);
+            eventqueue_free(qdata->pq);
         }
         g_mutex_clear(&(qdata->lock));
         g_free(qdata);
@@ -192,7 +192,7 @@ static void _schedulerpolicyhostsingle_push(SchedulerPolicy* policy, Event* even
 
     /* 'deliver' the event to the destination queue */
     event_setSequence(event, ++(qdata->pushSequenceCounter));
-    priorityqueue_push(qdata->pq, event);
+    eventqueue_push(qdata->pq, event);
     qdata->nPushed++;
 
     /* release the destination queue lock */
@@ -236,13 +236,13 @@ static Event* _schedulerpolicyhostsingle_pop(SchedulerPolicy* policy, Simulation
         g_mutex_lock(&(qdata->lock));
         g_timer_stop(tdata->popIdleTime);
 
-        Event* nextEvent = priorityqueue_peek(qdata->pq);
+        Event* nextEvent = eventqueue_peek(qdata->pq);
         SimulationTime eventTime = (nextEvent != NULL) ? event_getTime(nextEvent) : SIMTIME_INVALID;
 
         if(nextEvent != NULL && eventTime < barrier) {
             utility_assert(eventTime >= qdata->lastEventTime);
             qdata->lastEventTime = eventTime;
-            nextEvent = priorityqueue_pop(qdata->pq);
+            nextEvent = eventqueue_pop(qdata->pq);
             qdata->nPopped++;
         } else {
             nextEvent = NULL;
@@ -267,7 +267,7 @@ static void _schedulerpolicyhostsingle_findMinTime(Host* host, HostSingleSearchS
     utility_assert(qdata);
 
     g_mutex_lock(&(qdata->lock));
-    Event* event = priorityqueue_peek(qdata->pq);
+    Event* event = eventqueue_peek(qdata->pq);
     g_mutex_unlock(&(qdata->lock));
 
     if(event != NULL) {
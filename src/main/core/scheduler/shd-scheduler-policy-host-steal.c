@@ -5,14 +5,33 @@
 
 #include "shadow.h"
 
+/* an event delivered from another host, waiting in the destination's inbox */
+typedef struct _HostStealMail HostStealMail;
+struct _HostStealMail {
+    Event* event;
+    SimulationTime time;
+    /* the sending host and its send counter give a stable order for events
+     * that arrive at the same time, independent of thread interleaving */
+    GQuark srcHostID;
+    guint64 srcSequence;
+    HostStealMail* next;
+};
+
 typedef struct _HostStealQueueData HostStealQueueData;
 struct _HostStealQueueData {
-    GMutex lock;
-    PriorityQueue* pq;
+    /* the host's private queue. it is only touched by the thread that is running
+     * the host, or by the thread that holds the host in between rounds. */
+    EventQueue* pq;
     SimulationTime pushSequenceCounter;
     SimulationTime lastEventTime;
     gsize nPushed;
     gsize nPopped;
+    /* multi-producer single-consumer lock-free stack of events sent by other hosts */
+    HostStealMail* inbox;
+    /* mail taken from the inbox that is not due yet, owned like pq */
+    GArray* pendingMail;
+    /* counts events this host sends to other hosts, owned like pq */
+    guint64 sendSequenceCounter;
 };
 
 typedef struct _HostStealThreadData HostStealThreadData;
@@ -28,7 +47,6 @@ struct _HostStealThreadData {
     /* the host this worker is running; belongs to neither unprocessedHosts nor processedHosts */
     Host* runningHost;
     SimulationTime currentBarrier;
-    GTimer* pushIdleTime;
     GTimer* popIdleTime;
     /* which worker thread this is */
     guint tnumber;
@@ -58,12 +76,10 @@ static HostStealThreadData* _hoststealthreaddata_new() {
     tdata->unprocessedHosts = g_queue_new();
     tdata->processedHosts = g_queue_new();
 
-    /* Create new timers to track thread idle times. The timers start in a 'started' state,
-     * so we want to stop them immediately so we can continue/stop later around blocking code
+    /* Create a new timer to track thread idle times. The timer starts in a 'started' state,
+     * so we want to stop it immediately so we can continue/stop later around blocking code
      * to collect total elapsed idle time in the scheduling process throughout the entire
      * runtime of the program. */
-    tdata->pushIdleTime = g_timer_new();
-    g_timer_stop(tdata->pushIdleTime);
     tdata->popIdleTime = g_timer_new();
     g_timer_stop(tdata->popIdleTime);
     g_mutex_init(&(tdata->lock));
@@ -83,11 +99,6 @@ static void _hoststealthreaddata_free(HostStealThreadData* tdata) {
             g_queue_free(tdata->processedHosts);
         }
 
-        gdouble totalPushWaitTime = 0.0;
-        if(tdata->pushIdleTime) {
-            totalPushWaitTime = g_timer_elapsed(tdata->pushIdleTime, NULL);
-            g_timer_destroy(tdata->pushIdleTime);
-        }
         gdouble totalPopWaitTime = 0.0;
         if(tdata->popIdleTime) {
             totalPopWaitTime = g_timer_elapsed(tdata->popIdleTime, NULL);
@@ -95,30 +106,126 @@ static void _hoststealthreaddata_free(HostStealThreadData* tdata) {
         }
 
         g_free(tdata);
-        message("scheduler thread data destroyed, total push wait time was %f seconds, "
-                "total pop wait time was %f seconds", totalPushWaitTime, totalPopWaitTime);
+        message("scheduler thread data destroyed, total pop wait time was %f seconds",
+                totalPopWaitTime);
     }
 }
 
 static HostStealQueueData* _hoststealqueuedata_new() {
     HostStealQueueData* qdata = g_new0(HostStealQueueData, 1);
 
-    g_mutex_init(&(qdata->lock));
-    qdata->pq = priorityqueue_new((GCompareDataFunc)event_compare, NULL, (GDestroyNotify)event_unref);
+    qdata->pq = eventqueue_new();
+    qdata->pendingMail = g_array_new(FALSE, FALSE, sizeof(HostStealMail));
+    qdata->inbox = NULL;
 
     return qdata;
 }
 
+static HostStealMail* _hoststealqueuedata_takeInbox(HostStealQueueData* qdata) {
+    /* atomically take the whole inbox, leaving it empty for the producers */
+    HostStealMail* head = NULL;
+    do {
+        head = g_atomic_pointer_get(&qdata->inbox);
+    } while(!g_atomic_pointer_compare_and_exchange(&qdata->inbox, head, NULL));
+    return head;
+}
+
 static void _hoststealqueuedata_free(HostStealQueueData* qdata) {
     if(qdata) {
+        HostStealMail* mail = _hoststealqueuedata_takeInbox(qdata);
+        while(mail) {
+            HostStealMail* next = mail->next;
+            event_unref(mail->event);
+            g_free(mail);
+            mail = next;
+        }
+        if(qdata->pendingMail) {
+            for(guint i = 0; i < qdata->pendingMail->len; i++) {
+                event_unref(g_array_index(qdata->pendingMail, HostStealMail, i).event);
+            }
+            g_array_free(qdata->pendingMail, TRUE);
+        }
         if(qdata->pq) {
-            priorityqueue_free(qdata->pq);
+            eventqueue_free(qdata->pq);
         }
-        g_mutex_clear(&(qdata->lock));
         g_free(qdata);
     }
 }
 
+/* may be called concurrently by any number of threads, without locks */
+static void _hoststealqueuedata_sendMail(HostStealQueueData* qdata, HostStealMail* mail) {
+    HostStealMail* head = NULL;
+    do {
+        head = g_atomic_pointer_get(&qdata->inbox);
+        mail->next = head;
+    } while(!g_atomic_pointer_compare_and_exchange(&qdata->inbox, head, mail));
+}
+
+/* move everything from the lock-free inbox to the private pending array.
+ * only the thread that currently owns the host may call this. */
+static void _hoststealqueuedata_collectMail(HostStealQueueData* qdata) {
+    HostStealMail* mail = _hoststealqueuedata_takeInbox(qdata);
+    while(mail) {
+        HostStealMail* next = mail->next;
+        g_array_append_val(qdata->pendingMail, *mail);
+        g_free(mail);
+        mail = next;
+    }
+}
+
+static gint _hoststealmail_compare(const HostStealMail* a, const HostStealMail* b) {
+    return (a->time > b->time) ? +1 : (a->time < b->time) ? -1 :
+            (a->srcHostID > b->srcHostID) ? +1 : (a->srcHostID < b->srcHostID) ? -1 :
+            (a->srcSequence > b->srcSequence) ? +1 : (a->srcSequence < b->srcSequence) ? -1 : 0;
+}
+
+/* Move all mail that is due before the barrier into the private event queue.
+ * Inter-host events are always pushed at or after the barrier of the round in which
+ * they were sent, so the set of mail that is due before this round's barrier is
+ * complete by the time this round starts. Sorting that set by a key that does not
+ * depend on thread timing before assigning sequence numbers keeps the event order
+ * deterministic. Only the thread that currently owns the host may call this. */
+static void _hoststealqueuedata_deliverMail(HostStealQueueData* qdata, SimulationTime barrier) {
+    _hoststealqueuedata_collectMail(qdata);
+
+    if(qdata->pendingMail->len == 0) {
+        return;
+    }
+
+    g_array_sort(qdata->pendingMail, (GCompareFunc)_hoststealmail_compare);
+
+    guint nDue = 0;
+    while(nDue < qdata->pendingMail->len) {
+        HostStealMail* mail = &g_array_index(qdata->pendingMail, HostStealMail, nDue);
+        if(mail->time >= barrier) {
+            break;
+        }
+        event_setSequence(mail->event, ++(qdata->pushSequenceCounter));
+        eventqueue_push(qdata->pq, mail->event);
+        qdata->nPushed++;
+        nDue++;
+    }
+
+    if(nDue > 0) {
+        g_array_remove_range(qdata->pendingMail, 0, nDue);
+    }
+}
+
+static SimulationTime _hoststealqueuedata_getNextTime(HostStealQueueData* qdata) {
+    SimulationTime nextTime = SIMTIME_MAX;
+
+    Event* event = eventqueue_peek(qdata->pq);
+    if(event != NULL) {
+        nextTime = event_getTime(event);
+    }
+
+    for(guint i = 0; i < qdata->pendingMail->len; i++) {
+        nextTime = MIN(nextTime, g_array_index(qdata->pendingMail, HostStealMail, i).time);
+    }
+
+    return nextTime;
+}
+
 /* this must be run synchronously, or the thread must be protected by locks */
 static void _schedulerpolicyhoststeal_addHost(SchedulerPolicy* policy, Host* host, pthread_t randomThread) {
     MAGIC_ASSERT(policy);
@@ -217,6 +324,20 @@ static void _schedulerpolicyhoststeal_push(SchedulerPolicy* policy, Event* event
     MAGIC_ASSERT(policy);
     HostStealPolicyData* data = policy->data;
 
+    /* The host-to-queue map is only modified while hosts are assigned before the first
+     * round, so we can read it here without the policy lock. */
+    HostStealQueueData* qdata = g_hash_table_lookup(data->hostToQueueDataMap, dstHost);
+    utility_assert(qdata);
+
+    if(srcHost == dstHost) {
+        /* local events are pushed by the thread that is running the host, which is the
+         * only thread that may touch the host's private queue right now */
+        event_setSequence(event, ++(qdata->pushSequenceCounter));
+        eventqueue_push(qdata->pq, event);
+        qdata->nPushed++;
+        return;
+    }
+
     /* non-local events must be properly delayed so the event wont show up at another host
      * before the next scheduling interval. if the thread scheduler guaranteed to always run
      * the minimum time event accross all of its assigned hosts, then we would only need to
@@ -226,41 +347,27 @@ static void _schedulerpolicyhoststeal_push(SchedulerPolicy* policy, Event* event
      * dstHost are not the same. */
     SimulationTime eventTime = event_getTime(event);
 
-    if(srcHost != dstHost && eventTime < barrier) {
+    if(eventTime < barrier) {
         event_setTime(event, barrier);
         info("Inter-host event time %"G_GUINT64_FORMAT" changed to %"G_GUINT64_FORMAT" "
                 "to ensure event causality", eventTime, barrier);
     }
 
-    g_rw_lock_reader_lock(&data->lock);
-    /* we want to track how long this thread spends idle waiting to push the event */
-    HostStealThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(pthread_self()));
-
-    /* get the queue for the destination */
-    HostStealQueueData* qdata = g_hash_table_lookup(data->hostToQueueDataMap, dstHost);
-    g_rw_lock_reader_unlock(&data->lock);
-    utility_assert(qdata);
+    HostStealMail* mail = g_new0(HostStealMail, 1);
+    mail->event = event;
+    mail->time = event_getTime(event);
 
-    /* tracking idle time spent waiting for the destination queue lock */
-    if(tdata) {
-        g_timer_continue(tdata->pushIdleTime);
-        g_mutex_lock(&(tdata->lock));
-    }
-    g_mutex_lock(&(qdata->lock));
-    if(tdata) {
-        g_timer_stop(tdata->pushIdleTime);
+    if(srcHost) {
+        /* the sender is running on this thread, so its counter is ours to update */
+        HostStealQueueData* srcQdata = g_hash_table_lookup(data->hostToQueueDataMap, srcHost);
+        utility_assert(srcQdata);
+        mail->srcHostID = host_getID(srcHost);
+        mail->srcSequence = ++(srcQdata->sendSequenceCounter);
     }
 
-    /* 'deliver' the event to the destination queue */
-    event_setSequence(event, ++(qdata->pushSequenceCounter));
-    priorityqueue_push(qdata->pq, event);
-    qdata->nPushed++;
-
-    /* release the destination queue lock */
-    g_mutex_unlock(&(qdata->lock));
-    if(tdata) {
-        g_mutex_unlock(&(tdata->lock));
-    }
+    /* 'deliver' the event to the destination inbox, no locks required. the destination
+     * will sequence it into its queue before the round in which it is due. */
+    _hoststealqueuedata_sendMail(qdata, mail);
 }
 
 static Event* _schedulerpolicyhoststeal_popFromThread(SchedulerPolicy* policy, HostStealThreadData* tdata, GQueue* assignedHosts, SimulationTime barrier) {
@@ -273,23 +380,27 @@ static Event* _schedulerpolicyhoststeal_popFromThread(SchedulerPolicy* policy, H
 
     while(!g_queue_is_empty(assignedHosts) || tdata->runningHost) {
         /* if there's no running host, we completed the last assignment and need a new one */
+        gboolean isNewHost = FALSE;
         if(!tdata->runningHost) {
             tdata->runningHost = g_queue_pop_head(assignedHosts);
+            isNewHost = TRUE;
         }
         Host* host = tdata->runningHost;
-        g_rw_lock_reader_lock(&data->lock);
         HostStealQueueData* qdata = g_hash_table_lookup(data->hostToQueueDataMap, host);
-        g_rw_lock_reader_unlock(&data->lock);
         utility_assert(qdata);
 
-        g_mutex_lock(&(qdata->lock));
-        Event* nextEvent = priorityqueue_peek(qdata->pq);
+        /* we now own the host, so bring in the mail that is due this round */
+        if(isNewHost) {
+            _hoststealqueuedata_deliverMail(qdata, barrier);
+        }
+
+        Event* nextEvent = eventqueue_peek(qdata->pq);
         SimulationTime eventTime = (nextEvent != NULL) ? event_getTime(nextEvent) : SIMTIME_INVALID;
 
         if(nextEvent != NULL && eventTime < barrier) {
             utility_assert(eventTime >= qdata->lastEventTime);
             qdata->lastEventTime = eventTime;
-            nextEvent = priorityqueue_pop(qdata->pq);
+            nextEvent = eventqueue_pop(qdata->pq);
             qdata->nPopped++;
             /* migrate iff a migration is needed */
             _schedulerpolicyhoststeal_migrateHost(policy, host, pthread_self());
@@ -303,8 +414,6 @@ static Event* _schedulerpolicyhoststeal_popFromThread(SchedulerPolicy* policy, H
             tdata->runningHost = NULL;
         }
 
-        g_mutex_unlock(&(qdata->lock));
-
         if(nextEvent != NULL) {
             return nextEvent;
         }
@@ -410,18 +519,13 @@ static Event* _schedulerpolicyhoststeal_pop(SchedulerPolicy* policy, SimulationT
 }
 
 static void _schedulerpolicyhoststeal_findMinTime(Host* host, HostStealSearchState* state) {
-    g_rw_lock_reader_lock(&state->data->lock);
     HostStealQueueData* qdata = g_hash_table_lookup(state->data->hostToQueueDataMap, host);
-    g_rw_lock_reader_unlock(&state->data->lock);
     utility_assert(qdata);
 
-    g_mutex_lock(&(qdata->lock));
-    Event* event = priorityqueue_peek(qdata->pq);
-    g_mutex_unlock(&(qdata->lock));
+    /* no thread is running events between rounds, so the inbox is quiet and we own the host */
+    _hoststealqueuedata_collectMail(qdata);
 
-    if(event != NULL) {
-        state->nextEventTime = MIN(state->nextEventTime, event_getTime(event));
-    }
+    state->nextEventTime = MIN(state->nextEventTime, _hoststealqueuedata_getNextTime(qdata));
 }
 
 static SimulationTime _schedulerpolicyhoststeal_getNextTime(SchedulerPolicy* policy) {
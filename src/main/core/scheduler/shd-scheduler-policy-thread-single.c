@@ -9,7 +9,7 @@ typedef struct _ThreadSingleThreadData ThreadSingleThreadData;
 struct _ThreadSingleThreadData {
     GQueue* assignedHosts2;
     GMutex lock;
-    PriorityQueue* pq;
+    EventQueue* pq;
     SimulationTime pushSequenceCounter;
     SimulationTime lastEventTime;
     gsize nPushed;
@@ -26,7 +26,7 @@ struct _ThreadSinglePolicyData {
 static ThreadSingleThreadData* _threadsinglethreaddata_new() {
     ThreadSingleThreadData* tdata = g_new0(ThreadSingleThreadData, 1);
     g_mutex_init(&(tdata->lock));
-    tdata->pq = priorityqueue_new((GCompareDataFunc)event_compare, NULL, (GDestroyNotify)event_unref);
+    tdata->pq = eventqueue_new();
     tdata->assignedHosts2 = g_queue_new();
     return tdata;
 }
@@ -37,7 +37,7 @@ static void _threadsinglethreaddata_free(ThreadSingleThreadData* tdata) {
             g_queue_free(tdata->assignedHosts2);
         }
         if(tdata->pq) {
-            priorityqueue_free(tdata->pq);
+            eventqueue_free(tdata->pq);
         }
         g_mutex_clear(&(tdata->lock));
         g_free(tdata);
@@ -94,7 +94,7 @@ static void _schedulerpolicythreadsingle_push(SchedulerPolicy* policy, Event* ev
     /* 'deliver' the event there */
     g_mutex_lock(&(tdata->lock));
     event_setSequence(event, ++(tdata->pushSequenceCounter));
-    priorityqueue_push(tdata->pq, event);
+    eventqueue_push(tdata->pq, event);
     tdata->nPushed++;
     g_mutex_unlock(&(tdata->lock));
 }
@@ -113,13 +113,13 @@ static Event* _schedulerpolicythreadsingle_pop(SchedulerPolicy* policy, Simulati
 
     g_mutex_lock(&(tdata->lock));
 
-    Event* nextEvent = priorityqueue_peek(tdata->pq);
+    Event* nextEvent = eventqueue_peek(tdata->pq);
     SimulationTime eventTime = (nextEvent != NULL) ? event_getTime(nextEvent) : SIMTIME_INVALID;
 
     if(nextEvent && eventTime < barrier) {
         utility_assert(eventTime >= tdata->lastEventTime);
         tdata->lastEventTime = eventTime;
-        nextEvent = priorityqueue_pop(tdata->pq);
+        nextEvent = eventqueue_pop(tdata->pq);
         tdata->nPopped++;
     } else {
         /* if we make it here, all hosts for this thread have no more events before barrier */
@@ -140,7 +140,7 @@ static SimulationTime _schedulerpolicythreadsingle_getNextTime(SchedulerPolicy*
     ThreadSingleThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(pthread_self()));
     if(tdata) {
         g_mutex_lock(&(tdata->lock));
-        Event* event = priorityqueue_peek(tdata->pq);
+        Event* event = eventqueue_peek(tdata->pq);
         g_mutex_unlock(&(tdata->lock));
         if(event != NULL) {
             nextTime = MIN(nextTime, event_getTime(event));
@@ -24,6 +24,9 @@ struct _Scheduler {
     CountDownLatch* collectInfoBarrier;
     /* barrier to wait for main thread to finish updating for the next round */
     CountDownLatch* prepareRoundBarrier;
+    /* hosts attach to the topology as they boot, so all threads must finish
+     * booting before any of them can index or look up paths */
+    CountDownLatch* bootBarrier;
 
     /* holds a timer for each thread to track how long threads wait for execution barrier */
     GHashTable* threadToWaitTimerMap;
@@ -45,6 +48,38 @@ struct _Scheduler {
         SimulationTime endTime;
         SimulationTime minNextEventTime;
     } currentRound;
+    guint64 numRounds;
+
+    /* per-thread execution windows, only used with the thread-based policies where
+     * hosts stay on the thread to which they were assigned */
+    struct {
+        gboolean isEnabled;
+        /* TRUE once every thread filled in its row of minDelay */
+        gboolean isReady;
+        guint nThreads;
+        /* the index of the thread running each host, offset by one */
+        GHashTable* hostToThreadIndexMap;
+        /* nThreads*nThreads matrix of the minimum time it takes an event sent
+         * by a host on the row thread to reach a host on the column thread */
+        SimulationTime* minDelay;
+        /* the next event time of each thread as of the end of the last round */
+        SimulationTime* nextEventTime;
+        /* the barrier each thread runs to in the current round */
+        SimulationTime* windowEnd;
+    } lookahead;
+
+    /* all threads compute the paths between attached vertices together
+     * before the first round, instead of computing them on first use */
+    struct {
+        gboolean isEnabled;
+        guint nThreads;
+        /* TRUE if the paths were loaded from the path cache file */
+        gboolean isLoaded;
+        /* wait for the first thread to try the path cache file */
+        CountDownLatch* loadBarrier;
+        /* wait for all threads to finish computing before storing the cache file */
+        CountDownLatch* computeBarrier;
+    } routing;
 
     /* for memory management */
     gint referenceCount;
@@ -54,6 +89,7 @@ struct _Scheduler {
 typedef struct _SchedulerThreadItem SchedulerThreadItem;
 struct _SchedulerThreadItem {
     pthread_t thread;
+    guint threadID;
     CountDownLatch* notifyDoneRunning;
     CountDownLatch* notifyReadyToJoin;
     CountDownLatch* notifyJoined;
@@ -96,8 +132,270 @@ static void _scheduler_stopHosts(Scheduler* scheduler) {
     }
 }
 
+static SimulationTime _scheduler_addTime(SimulationTime time, SimulationTime delay) {
+    /* saturate so that unreachable threads never constrain anyone */
+    return (time >= SIMTIME_MAX - delay) ? SIMTIME_MAX : time + delay;
+}
+
+static void _scheduler_initLookahead(Scheduler* scheduler, guint nWorkers) {
+    MAGIC_ASSERT(scheduler);
+
+    /* hosts must not migrate between threads, and each thread must run the events
+     * of all of its hosts in time order, for the per-thread windows to be safe */
+    gboolean isThreadPolicy = (scheduler->policyType == SP_PARALLEL_THREAD_SINGLE ||
+            scheduler->policyType == SP_PARALLEL_THREAD_PERTHREAD ||
+            scheduler->policyType == SP_PARALLEL_THREAD_PERHOST) ? TRUE : FALSE;
+
+    if(!isThreadPolicy || nWorkers < 2) {
+        warning("lookahead windows require at least 2 workers and the 'thread', 'threadXthread', "
+                "or 'threadXhost' scheduler policy; falling back to the global execution window");
+        return;
+    }
+
+    guint n = nWorkers;
+    scheduler->lookahead.isEnabled = TRUE;
+    scheduler->lookahead.nThreads = n;
+    scheduler->lookahead.hostToThreadIndexMap = g_hash_table_new(g_direct_hash, g_direct_equal);
+    scheduler->lookahead.minDelay = g_new(SimulationTime, n*n);
+    scheduler->lookahead.nextEventTime = g_new(SimulationTime, n);
+    scheduler->lookahead.windowEnd = g_new(SimulationTime, n);
+
+    for(guint i = 0; i < n; i++) {
+        for(guint j = 0; j < n; j++) {
+            /* events between hosts on the same thread are always run in order */
+            scheduler->lookahead.minDelay[i*n+j] = (i == j) ? 0 : SIMTIME_MAX;
+        }
+        scheduler->lookahead.nextEventTime[i] = SIMTIME_MAX;
+        scheduler->lookahead.windowEnd[i] = scheduler->currentRound.endTime;
+    }
+}
+
+/* the path between two hosts only depends on the vertices they are attached
+ * to, so hosts are grouped by vertex and we look up one path per pair of
+ * vertices instead of one per pair of hosts. the key is unique per vertex,
+ * or per host for hosts that were attached without an index. */
+static gpointer _scheduler_getLookaheadVertexKey(Host* host) {
+    Address* address = host_getDefaultAddress(host);
+    gint attachmentIndex = address ? address_getAttachmentIndex(address) : -1;
+    if(attachmentIndex >= 0) {
+        return GINT_TO_POINTER(attachmentIndex);
+    } else {
+        return GINT_TO_POINTER(-((gint)host_getID(host)));
+    }
+}
+
+/* fills in the calling thread's row of the delay matrix from the path latency
+ * between each vertex its hosts are attached to and each vertex used by the
+ * hosts of another thread */
+static void _scheduler_computeLookahead(Scheduler* scheduler) {
+    MAGIC_ASSERT(scheduler);
+
+    GQueue* myHosts = scheduler->policy->getAssignedHosts(scheduler->policy);
+    if(!myHosts) {
+        return;
+    }
+
+    guint n = scheduler->lookahead.nThreads;
+    guint srcIndex = (guint) worker_getThreadID();
+    utility_assert(srcIndex < n);
+    SimulationTime* row = &(scheduler->lookahead.minDelay[srcIndex*n]);
+
+    GTimer* lookaheadTimer = g_timer_new();
+
+    /* one host on each vertex we send from */
+    GHashTable* srcVertices = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for(GList* item = g_queue_peek_head_link(myHosts); item != NULL; item = g_list_next(item)) {
+        Host* srcHost = item->data;
+        g_hash_table_insert(srcVertices, _scheduler_getLookaheadVertexKey(srcHost), srcHost);
+    }
+
+    /* for each vertex we send to, one host on it from each other thread using it */
+    GHashTable* dstVertices = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+            NULL, (GDestroyNotify)g_free);
+
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, scheduler->lookahead.hostToThreadIndexMap);
+    while(g_hash_table_iter_next(&iter, &key, &value)) {
+        Host* dstHost = key;
+        guint dstIndex = GPOINTER_TO_UINT(value) - 1;
+        if(dstIndex == srcIndex) {
+            continue;
+        }
+
+        gpointer vertexKey = _scheduler_getLookaheadVertexKey(dstHost);
+        Host** threadHosts = g_hash_table_lookup(dstVertices, vertexKey);
+        if(!threadHosts) {
+            threadHosts = g_new0(Host*, n);
+            g_hash_table_insert(dstVertices, vertexKey, threadHosts);
+        }
+        threadHosts[dstIndex] = dstHost;
+    }
+
+    GHashTableIter srcIter;
+    gpointer srcKey, srcValue;
+    g_hash_table_iter_init(&srcIter, srcVertices);
+    while(g_hash_table_iter_next(&srcIter, &srcKey, &srcValue)) {
+        Host* srcHost = srcValue;
+
+        g_hash_table_iter_init(&iter, dstVertices);
+        while(g_hash_table_iter_next(&iter, &key, &value)) {
+            Host** threadHosts = value;
+
+            /* any host on the vertex will do, the path is the same */
+            Host* dstHost = NULL;
+            for(guint dstIndex = 0; dstIndex < n && !dstHost; dstIndex++) {
+                dstHost = threadHosts[dstIndex];
+            }
+
+            gdouble latency = worker_getLatency(host_getID(srcHost), host_getID(dstHost));
+            if(latency < 0) {
+                /* no route, so no packets will ever be sent between these vertices */
+                continue;
+            }
+
+            /* this must match the delay computed in worker_sendPacket */
+            SimulationTime delay = (SimulationTime) ceil(latency * SIMTIME_ONE_MILLISECOND);
+            for(guint dstIndex = 0; dstIndex < n; dstIndex++) {
+                if(threadHosts[dstIndex]) {
+                    row[dstIndex] = MIN(row[dstIndex], delay);
+                }
+            }
+        }
+    }
+
+    gdouble elapsedSeconds = g_timer_elapsed(lookaheadTimer, NULL);
+    g_timer_destroy(lookaheadTimer);
+
+    message("computed lookahead for %u hosts on %u vertices to %u vertices on other threads in %f seconds",
+            g_queue_get_length(myHosts), g_hash_table_size(srcVertices),
+            g_hash_table_size(dstVertices), elapsedSeconds);
+
+    g_hash_table_destroy(srcVertices);
+    g_hash_table_destroy(dstVertices);
+}
+
+static void _scheduler_closeLookahead(Scheduler* scheduler) {
+    MAGIC_ASSERT(scheduler);
+
+    /* an event may reach a thread through a chain of other threads, each of which may
+     * forward it through its own hosts without delay, so the bound between two
+     * threads is the shortest such chain rather than the direct delay */
+    guint n = scheduler->lookahead.nThreads;
+    SimulationTime* d = scheduler->lookahead.minDelay;
+
+    for(guint k = 0; k < n; k++) {
+        for(guint i = 0; i < n; i++) {
+            for(guint j = 0; j < n; j++) {
+                SimulationTime viaK = _scheduler_addTime(d[i*n+k], d[k*n+j]);
+                if(viaK < d[i*n+j]) {
+                    d[i*n+j] = viaK;
+                }
+            }
+        }
+    }
+
+    for(guint i = 0; i < n; i++) {
+        for(guint j = 0; j < n; j++) {
+            if(i != j) {
+                info("lookahead from thread %u to thread %u is %"G_GUINT64_FORMAT" nanoseconds", i, j, d[i*n+j]);
+            }
+        }
+    }
+
+    scheduler->lookahead.isReady = TRUE;
+}
+
+static void _scheduler_updateLookaheadWindows(Scheduler* scheduler, SimulationTime windowEnd) {
+    MAGIC_ASSERT(scheduler);
+
+    guint n = scheduler->lookahead.nThreads;
+
+    for(guint dst = 0; dst < n; dst++) {
+        /* the global window bounds the runahead the user and topology already allow */
+        SimulationTime end = windowEnd;
+
+        if(scheduler->lookahead.isReady) {
+            /* nothing can arrive at this thread before the earliest next event on
+             * another thread plus the delay from that thread to this one */
+            SimulationTime safeEnd = SIMTIME_MAX;
+            for(guint src = 0; src < n; src++) {
+                if(src != dst) {
+                    SimulationTime arrival = _scheduler_addTime(scheduler->lookahead.nextEventTime[src],
+                            scheduler->lookahead.minDelay[src*n+dst]);
+                    safeEnd = MIN(safeEnd, arrival);
+                }
+            }
+            end = MAX(end, safeEnd);
+        }
+
+        scheduler->lookahead.windowEnd[dst] = MIN(end, scheduler->endTime);
+    }
+}
+
+static SimulationTime _scheduler_getThreadBarrier(Scheduler* scheduler) {
+    if(scheduler->lookahead.isEnabled) {
+        guint index = (guint) worker_getThreadID();
+        utility_assert(index < scheduler->lookahead.nThreads);
+        return scheduler->lookahead.windowEnd[index];
+    } else {
+        return scheduler->currentRound.endTime;
+    }
+}
+
+static SimulationTime _scheduler_getHostBarrier(Scheduler* scheduler, Host* host) {
+    if(scheduler->lookahead.isEnabled) {
+        guint index = GPOINTER_TO_UINT(g_hash_table_lookup(scheduler->lookahead.hostToThreadIndexMap, host));
+        utility_assert(index > 0 && index <= scheduler->lookahead.nThreads);
+        return scheduler->lookahead.windowEnd[index-1];
+    } else {
+        return scheduler->currentRound.endTime;
+    }
+}
+
+static void _scheduler_initRouting(Scheduler* scheduler, guint nWorkers) {
+    MAGIC_ASSERT(scheduler);
+
+    /* without workers, the main thread does all of the work */
+    guint n = MAX(nWorkers, 1);
+    scheduler->routing.isEnabled = TRUE;
+    scheduler->routing.nThreads = n;
+    scheduler->routing.loadBarrier = countdownlatch_new(n);
+    scheduler->routing.computeBarrier = countdownlatch_new(n);
+}
+
+static void _scheduler_precomputePaths(Scheduler* scheduler) {
+    MAGIC_ASSERT(scheduler);
+
+    Topology* topology = worker_getTopology();
+    const gchar* cacheDirPath = options_getPathCacheDirectory(worker_getOptions());
+    guint index = (guint) worker_getThreadID();
+    utility_assert(index < scheduler->routing.nThreads);
+
+    /* only the first thread reads the file, the others wait to see if it worked */
+    if(index == 0 && cacheDirPath) {
+        scheduler->routing.isLoaded = topology_loadPathCache(topology, cacheDirPath);
+    }
+    countdownlatch_countDownAwait(scheduler->routing.loadBarrier);
+
+    if(scheduler->routing.isLoaded) {
+        return;
+    }
+
+    GTimer* pathTimer = g_timer_new();
+    topology_precomputePaths(topology, index, scheduler->routing.nThreads);
+    countdownlatch_countDownAwait(scheduler->routing.computeBarrier);
+    message("all threads finished computing paths after %f seconds", g_timer_elapsed(pathTimer, NULL));
+    g_timer_destroy(pathTimer);
+
+    if(index == 0 && cacheDirPath) {
+        topology_storePathCache(topology, cacheDirPath);
+    }
+}
+
 Scheduler* scheduler_new(SchedulerPolicyType policyType, guint nWorkers, gpointer threadUserData,
-        guint schedulerSeed, SimulationTime endTime) {
+        guint schedulerSeed, SimulationTime endTime, gboolean useLookahead,
+        gboolean precomputePaths) {
     Scheduler* scheduler = g_new0(Scheduler, 1);
     MAGIC_INIT(scheduler);
 
@@ -158,6 +456,14 @@ Scheduler* scheduler_new(SchedulerPolicyType policyType, guint nWorkers, gpointe
     }
     utility_assert(scheduler->policy);
 
+    if(useLookahead) {
+        _scheduler_initLookahead(scheduler, nWorkers);
+    }
+    if(precomputePaths) {
+        _scheduler_initRouting(scheduler, nWorkers);
+    }
+    scheduler->bootBarrier = countdownlatch_new(MAX(nWorkers, 1));
+
     /* make sure our ref count is set before starting the threads */
     scheduler->referenceCount = 1;
 
@@ -170,6 +476,7 @@ Scheduler* scheduler_new(SchedulerPolicyType policyType, guint nWorkers, gpointe
         g_string_printf(name, "worker-%i", (i));
 
         SchedulerThreadItem* item = g_new0(SchedulerThreadItem, 1);
+        item->threadID = (guint)i;
         item->notifyDoneRunning = countdownlatch_new(1);
         item->notifyReadyToJoin = countdownlatch_new(1);
         item->notifyJoined = countdownlatch_new(1);
@@ -296,7 +603,21 @@ static void _scheduler_free(Scheduler* scheduler) {
 
     g_mutex_clear(&(scheduler->globalLock));
 
-    message("%i worker threads finished", nWorkers);
+    message("%i worker threads finished after %"G_GUINT64_FORMAT" rounds", nWorkers, scheduler->numRounds);
+
+    countdownlatch_free(scheduler->bootBarrier);
+    if(scheduler->routing.loadBarrier) {
+        countdownlatch_free(scheduler->routing.loadBarrier);
+    }
+    if(scheduler->routing.computeBarrier) {
+        countdownlatch_free(scheduler->routing.computeBarrier);
+    }
+    if(scheduler->lookahead.hostToThreadIndexMap) {
+        g_hash_table_destroy(scheduler->lookahead.hostToThreadIndexMap);
+    }
+    g_free(scheduler->lookahead.minDelay);
+    g_free(scheduler->lookahead.nextEventTime);
+    g_free(scheduler->lookahead.windowEnd);
 
     MAGIC_CLEAR(scheduler);
     g_free(scheduler);
@@ -336,8 +657,10 @@ gboolean scheduler_push(Scheduler* scheduler, Event* event, GQuark senderHostID,
     utility_assert(receiver);
     utility_assert(receiver == event_getHost(event));
 
-    /* push to a queue based on the policy */
-    scheduler->policy->push(scheduler->policy, event, sender, receiver, scheduler->currentRound.endTime);
+    /* push to a queue based on the policy, cross-thread events must not
+     * arrive before the barrier of the receiver's thread */
+    SimulationTime barrier = _scheduler_getHostBarrier(scheduler, receiver);
+    scheduler->policy->push(scheduler->policy, event, sender, receiver, barrier);
 
     return TRUE;
 }
@@ -350,7 +673,7 @@ Event* scheduler_pop(Scheduler* scheduler) {
 
     while(scheduler->isRunning) {
         /* pop from a queue based on the policy */
-        Event* nextEvent = scheduler->policy->pop(scheduler->policy, scheduler->currentRound.endTime);
+        Event* nextEvent = scheduler->policy->pop(scheduler->policy, _scheduler_getThreadBarrier(scheduler));
 
         if(nextEvent != NULL) {
             /* we have an event, let the worker run it */
@@ -380,6 +703,9 @@ Event* scheduler_pop(Scheduler* scheduler) {
                 SimulationTime nextTime = scheduler->policy->getNextTime(scheduler->policy);
                 g_mutex_lock(&(scheduler->globalLock));
                 scheduler->currentRound.minNextEventTime = MIN(scheduler->currentRound.minNextEventTime, nextTime);
+                if(scheduler->lookahead.isEnabled) {
+                    scheduler->lookahead.nextEventTime[worker_getThreadID()] = nextTime;
+                }
                 g_mutex_unlock(&(scheduler->globalLock));
             }
 
@@ -456,7 +782,8 @@ static void _scheduler_shuffleQueue(Scheduler* scheduler, GQueue* queue) {
     }
 }
 
-static void _scheduler_assignHostsToThread(Scheduler* scheduler, GQueue* hosts, pthread_t thread, uint maxAssignments) {
+static void _scheduler_assignHostsToThread(Scheduler* scheduler, GQueue* hosts, pthread_t thread,
+        guint threadID, uint maxAssignments) {
     MAGIC_ASSERT(scheduler);
     utility_assert(hosts);
     utility_assert(thread);
@@ -466,6 +793,9 @@ static void _scheduler_assignHostsToThread(Scheduler* scheduler, GQueue* hosts,
         Host* host = (Host*) g_queue_pop_head(hosts);
         utility_assert(host);
         scheduler->policy->addHost(scheduler->policy, host, thread);
+        if(scheduler->lookahead.isEnabled) {
+            g_hash_table_replace(scheduler->lookahead.hostToThreadIndexMap, host, GUINT_TO_POINTER(threadID+1));
+        }
         numAssignments++;
     }
 }
@@ -484,15 +814,17 @@ static void _scheduler_assignHosts(Scheduler* scheduler) {
     if(nThreads <= 1) {
         /* either the main thread or the single worker gets everything */
         pthread_t chosen;
+        guint chosenID = 0;
         if(nThreads == 0) {
             chosen = pthread_self();
         } else {
             SchedulerThreadItem* item = g_queue_peek_head(scheduler->threadItems);
             chosen = item->thread;
+            chosenID = item->threadID;
         }
 
         /* assign *all* of the hosts to the chosen thread */
-        _scheduler_assignHostsToThread(scheduler, hosts, chosen, 0);
+        _scheduler_assignHostsToThread(scheduler, hosts, chosen, chosenID, 0);
         utility_assert(g_queue_is_empty(hosts));
     } else {
         /* we need to shuffle the list of hosts to make sure they are randomly assigned */
@@ -503,7 +835,7 @@ static void _scheduler_assignHosts(Scheduler* scheduler) {
             SchedulerThreadItem* item = g_queue_pop_head(scheduler->threadItems);
             pthread_t nextThread = item->thread;
 
-            _scheduler_assignHostsToThread(scheduler, hosts, nextThread, 1);
+            _scheduler_assignHostsToThread(scheduler, hosts, nextThread, item->threadID, 1);
 
             g_queue_push_tail(scheduler->threadItems, item);
         }
@@ -570,6 +902,21 @@ void scheduler_awaitStart(Scheduler* scheduler) {
     /* each thread will boot their own hosts */
     _scheduler_startHosts(scheduler);
 
+    countdownlatch_countDownAwait(scheduler->bootBarrier);
+
+    /* every host is attached now, so the paths between them can be indexed */
+    topology_createPathIndex(worker_getTopology());
+
+    /* all threads share the work of computing paths, which the lookahead needs */
+    if(scheduler->routing.isEnabled) {
+        _scheduler_precomputePaths(scheduler);
+    }
+
+    /* each thread fills in the lookahead from its own hosts, in parallel */
+    if(scheduler->lookahead.isEnabled) {
+        _scheduler_computeLookahead(scheduler);
+    }
+
     /* everyone is waiting for the next round to be ready */
     countdownlatch_countDownAwait(scheduler->prepareRoundBarrier);
 }
@@ -603,6 +950,10 @@ void scheduler_continueNextRound(Scheduler* scheduler, SimulationTime windowStar
     g_mutex_lock(&scheduler->globalLock);
     scheduler->currentRound.endTime = windowEnd;
     scheduler->currentRound.minNextEventTime = SIMTIME_MAX;
+    if(scheduler->lookahead.isEnabled) {
+        _scheduler_updateLookaheadWindows(scheduler, windowEnd);
+    }
+    scheduler->numRounds++;
     g_mutex_unlock(&scheduler->globalLock);
 
     if(scheduler->policyType != SP_SERIAL_GLOBAL) {
@@ -625,6 +976,11 @@ SimulationTime scheduler_awaitNextRound(Scheduler* scheduler) {
         /* then they collect stats and wait at this barrier */
         countdownlatch_countDownAwait(scheduler->collectInfoBarrier);
         countdownlatch_reset(scheduler->collectInfoBarrier);
+
+        /* every thread has filled in its lookahead by the end of the first round */
+        if(scheduler->lookahead.isEnabled && !scheduler->lookahead.isReady) {
+            _scheduler_closeLookahead(scheduler);
+        }
     }
 
     SimulationTime minNextEventTime = SIMTIME_MAX;
@@ -12,7 +12,8 @@
 typedef struct _Scheduler Scheduler;
 
 Scheduler* scheduler_new(SchedulerPolicyType policyType, guint nWorkers, gpointer threadUserData,
-        guint schedulerSeed, SimulationTime endTime);
+        guint schedulerSeed, SimulationTime endTime, gboolean useLookahead,
+        gboolean precomputePaths);
 void scheduler_ref(Scheduler*);
 void scheduler_unref(Scheduler*);
 void scheduler_shutdown(Scheduler* scheduler);
@@ -646,6 +646,8 @@ static gint _main_helper(Options* options) {
             logger_setDefault(NULL);
             logger_unref(logger);
         }
+        /* finish the compressed log, the relaunched shadow appends to it */
+        compressor_setDefault(NULL);
 
         /* execvpe only returns if there is an error, otherwise the current process
          * image is replaced with a new process */
@@ -770,13 +772,23 @@ gint main_runShadow(gint argc, gchar* argv[]) {
         return EXIT_SUCCESS;
     }
 
+    /* the logger writes through the compressor, so it must exist first */
+    gint compressionLevel = options_getLogCompressionLevel(options);
+    if(compressionLevel != 0 && compressor_isSupported()) {
+        compressor_setDefault(compressor_new(compressionLevel));
+    }
+
     /* start up the logging subsystem to handle all future messages */
-    Logger* shadowLogger = logger_new(options_getLogLevel(options));
+    Logger* shadowLogger = logger_new(options_getLogLevel(options), options_getLogFormat(options));
     logger_setDefault(shadowLogger);
 
     /* disable buffering during startup so that we see every message immediately in the terminal */
     logger_setEnableBuffering(shadowLogger, FALSE);
 
+    if(compressionLevel != 0 && !compressor_isSupported()) {
+        warning("shadow was built without zstd, ignoring --compress-logs and writing uncompressed output");
+    }
+
     gint returnCode = _main_helper(options);
 
     options_free(options);
@@ -785,6 +797,7 @@ gint main_runShadow(gint argc, gchar* argv[]) {
         logger_setDefault(NULL);
         logger_unref(logger);
     }
+    compressor_setDefault(NULL);
 
     g_printerr("** Stopping Shadow, returning code %i (%s)\n", returnCode, (returnCode == 0) ? "success" : "error");
     return returnCode;
@@ -38,12 +38,21 @@ struct _Slave {
     /* global object counters, we collect counts from workers at end of sim */
     ObjectCounter* objectCounts;
 
+    /* object pools created by the workers, which may be used until everything is freed */
+    GQueue* objectPools;
+
+    /* collects the packet traces of the workers, if enabled */
+    PacketTrace* packetTrace;
+
     /* the parallel event/host/thread scheduler */
     Scheduler* scheduler;
 
     /* the meta data for each program */
     GHashTable* programMeta;
 
+    /* the number of hosts created so far, used to give each its index */
+    guint numHosts;
+
     GMutex lock;
     GMutex pluginInitLock;
 
@@ -152,6 +161,7 @@ Slave* slave_new(Master* master, Options* options, SimulationTime endTime, guint
     slave->options = options;
     slave->random = random_new(randomSeed);
     slave->objectCounts = objectcounter_new();
+    slave->objectPools = g_queue_new();
 
     slave->rawFrequencyKHz = utility_getRawCPUFrequency(CONFIG_CPU_MAX_FREQ_FILE);
     if(slave->rawFrequencyKHz == 0) {
@@ -166,7 +176,8 @@ Slave* slave_new(Master* master, Options* options, SimulationTime endTime, guint
     guint nWorkers = options_getNWorkerThreads(options);
     SchedulerPolicyType policy = _slave_getEventSchedulerPolicy(slave);
     guint schedulerSeed = slave_nextRandomUInt(slave);
-    slave->scheduler = scheduler_new(policy, nWorkers, slave, schedulerSeed, endTime);
+    slave->scheduler = scheduler_new(policy, nWorkers, slave, schedulerSeed, endTime,
+            options_doUseLookahead(options), options_doPrecomputePaths(options));
 
     slave->cwdPath = g_get_current_dir();
     slave->dataPath = g_build_filename(slave->cwdPath, options_getDataOutputPath(options), NULL);
@@ -187,6 +198,12 @@ Slave* slave_new(Master* master, Options* options, SimulationTime endTime, guint
     /* now make sure the hosts path exists, as it may not have been in the template */
     g_mkdir_with_parents(slave->hostsPath, 0775);
 
+    if(options_doTracePackets(options)) {
+        gchar* packetTracePath = g_build_filename(slave->dataPath, "packet-trace.bin", NULL);
+        slave->packetTrace = packettrace_new(packetTracePath);
+        g_free(packetTracePath);
+    }
+
     return slave;
 }
 
@@ -204,12 +221,23 @@ gint slave_free(Slave* slave) {
         scheduler_unref(slave->scheduler);
     }
 
+    /* the workers stored their traces before they stopped */
+    if(slave->packetTrace) {
+        packettrace_free(slave->packetTrace);
+        slave->packetTrace = NULL;
+    }
+
     if(slave->objectCounts != NULL) {
         message("%s", objectcounter_valuesToString(slave->objectCounts));
         message("%s", objectcounter_diffsToString(slave->objectCounts));
         objectcounter_free(slave->objectCounts);
     }
 
+    /* every object has been freed with the hosts and the scheduler */
+    if(slave->objectPools != NULL) {
+        g_queue_free_full(slave->objectPools, (GDestroyNotify)objectpool_free);
+    }
+
     g_hash_table_destroy(slave->programMeta);
 
     g_mutex_clear(&(slave->lock));
@@ -284,8 +312,13 @@ void slave_addNewVirtualHost(Slave* slave, HostParameters* params) {
 
     /* quarks are unique per slave process, so do the conversion here */
     params->id = g_quark_from_string(params->hostname);
+    params->index = ++(slave->numHosts);
     params->nodeSeed = slave_nextRandomUInt(slave);
 
+    if(slave->packetTrace) {
+        packettrace_addHost(slave->packetTrace, params->index, params->hostname);
+    }
+
     Host* host = host_new(params);
     scheduler_addHost(slave->scheduler, host);
 }
@@ -467,6 +500,18 @@ void slave_storeCounts(Slave* slave, ObjectCounter* objectCounter) {
     _slave_unlock(slave);
 }
 
+PacketTrace* slave_getPacketTrace(Slave* slave) {
+    MAGIC_ASSERT(slave);
+    return slave->packetTrace;
+}
+
+void slave_storeObjectPool(Slave* slave, ObjectPool* pool) {
+    MAGIC_ASSERT(slave);
+    _slave_lock(slave);
+    g_queue_push_tail(slave->objectPools, pool);
+    _slave_unlock(slave);
+}
+
 void slave_countObject(ObjectType otype, CounterType ctype) {
     if(globalSlave) {
         MAGIC_ASSERT(globalSlave);
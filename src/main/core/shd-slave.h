@@ -54,6 +54,8 @@ void slave_addNewVirtualProcess(Slave* slave, gchar* hostName, gchar* pluginName
         SimulationTime startTime, SimulationTime stopTime, gchar* arguments);
 
 void slave_storeCounts(Slave* slave, ObjectCounter* objectCounter);
+PacketTrace* slave_getPacketTrace(Slave* slave);
 void slave_countObject(ObjectType otype, CounterType ctype);
+void slave_storeObjectPool(Slave* slave, ObjectPool* pool);
 
 #endif /* SHD_SLAVE_H_ */
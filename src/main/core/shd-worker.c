@@ -4,8 +4,14 @@
  * See LICENSE for licensing information
  */
 
+#include <rpth.h>
+
 #include "shadow.h"
 
+/* payload pools hold objects of 256, 512, ..., 4096 bytes */
+#define WORKER_PAYLOAD_POOL_MIN_SIZE 256
+#define WORKER_PAYLOAD_POOL_CLASSES 5
+
 /* thread-level storage structure */
 struct _Worker {
     /* our thread and an id that is unique among all threads */
@@ -37,6 +43,22 @@ struct _Worker {
 
     ObjectCounter* objectCounts;
 
+    /* packets we sent on each path, indexed by path id, which we add to the
+     * paths when we are done so that workers never share a counter */
+    GArray* pathPacketCounts;
+
+    /* our packet status changes, if packets are traced */
+    PacketTraceBuffer* packetTrace;
+
+    /* free lists for the objects we create and destroy for every packet */
+    struct {
+        ObjectPool* task;
+        ObjectPool* event;
+        ObjectPool* packet;
+        /* payloads are pooled by size class */
+        ObjectPool* payload[WORKER_PAYLOAD_POOL_CLASSES];
+    } pools;
+
     MAGIC_DECLARE;
 };
 
@@ -54,6 +76,20 @@ static Worker* _worker_getPrivate() {
     return worker;
 }
 
+/* see the comment in shd-worker.h */
+__thread Process* workerEmulatedProcess = NULL;
+/* mirrors worker->active.process so context changes can update the above
+ * without a g_private_get */
+static __thread Process* workerActiveProcess = NULL;
+/* see the comment in shd-worker.h */
+__thread EmulatedTime workerEmulatedTime = 0;
+
+/* all changes to the clock go through here to keep the published time in sync */
+static void _worker_setClock(Worker* worker, SimulationTime now) {
+    worker->clock.now = now;
+    workerEmulatedTime = (now == SIMTIME_INVALID) ? 0 : (EmulatedTime)(now + EMULATED_TIME_OFFSET);
+}
+
 gboolean worker_isAlive() {
     return g_private_get(&workerKey) != NULL;
 }
@@ -68,10 +104,11 @@ static Worker* _worker_new(Slave* slave, guint threadID) {
     worker->slave = slave;
     worker->thread = pthread_self();
     worker->threadID = threadID;
-    worker->clock.now = SIMTIME_INVALID;
+    _worker_setClock(worker, SIMTIME_INVALID);
     worker->clock.last = SIMTIME_INVALID;
     worker->clock.barrier = SIMTIME_INVALID;
     worker->objectCounts = objectcounter_new();
+    worker->pathPacketCounts = g_array_new(FALSE, TRUE, sizeof(gsize));
 
     g_private_replace(&workerKey, worker);
 
@@ -84,6 +121,9 @@ static void _worker_free(Worker* worker) {
     if(worker->objectCounts != NULL) {
         objectcounter_free(worker->objectCounts);
     }
+    if(worker->pathPacketCounts != NULL) {
+        g_array_free(worker->pathPacketCounts, TRUE);
+    }
 
     g_private_set(&workerKey, NULL);
 
@@ -130,6 +170,17 @@ gpointer worker_run(WorkerRunData* data) {
     worker->scheduler = data->scheduler;
     scheduler_ref(worker->scheduler);
 
+    /* thread stacks released by any process we run are cached for reuse by
+     * the others we run, so size that cache for this thread */
+    Options* options = slave_getOptions(worker->slave);
+    pth_stackpool_config((guint)options_getPthStackCacheSize(options),
+            options_doUsePthStackHugePages(options));
+
+    PacketTrace* packetTrace = slave_getPacketTrace(worker->slave);
+    if(packetTrace) {
+        worker->packetTrace = packettrace_newBuffer(packetTrace, worker->threadID);
+    }
+
     /* wait until the slave is done with initialization */
     scheduler_awaitStart(worker->scheduler);
 
@@ -138,7 +189,7 @@ gpointer worker_run(WorkerRunData* data) {
     Event* event = NULL;
     while((event = scheduler_pop(worker->scheduler)) != NULL) {
         /* update cache, reset clocks */
-        worker->clock.now = event_getTime(event);
+        _worker_setClock(worker, event_getTime(event));
 
         /* process the local event */
         event_execute(event);
@@ -146,12 +197,15 @@ gpointer worker_run(WorkerRunData* data) {
 
         /* update times */
         worker->clock.last = worker->clock.now;
-        worker->clock.now = SIMTIME_INVALID;
+        _worker_setClock(worker, SIMTIME_INVALID);
     }
 
     /* this will free the host data that we have been managing */
     scheduler_awaitFinish(worker->scheduler);
 
+    /* all processes are gone, so nobody will use the cached stacks again */
+    pth_stackpool_flush();
+
     scheduler_unref(worker->scheduler);
 
     /* tell that we are done running */
@@ -167,6 +221,17 @@ gpointer worker_run(WorkerRunData* data) {
     /* cleanup is all done, send object counts to slave */
     slave_storeCounts(worker->slave, worker->objectCounts);
 
+    /* and our path packet counts to the topology, which prints them */
+    topology_addPathPacketCounts(slave_getTopology(worker->slave),
+            (const gsize*)worker->pathPacketCounts->data, worker->pathPacketCounts->len);
+    g_array_set_size(worker->pathPacketCounts, 0);
+
+    /* and the packet trace, to be merged with those of the other workers */
+    if(worker->packetTrace) {
+        packettrace_storeBuffer(slave_getPacketTrace(worker->slave), worker->packetTrace);
+        worker->packetTrace = NULL;
+    }
+
     /* synchronize thread join */
     CountDownLatch* notifyJoined = data->notifyJoined;
 
@@ -206,6 +271,50 @@ gboolean worker_scheduleTask(Task* task, SimulationTime nanoDelay) {
     }
 }
 
+gboolean worker_scheduleCallback(TaskCallbackFunc callback, gpointer callbackObject, gpointer callbackArgument,
+        TaskObjectFreeFunc objectFree, TaskArgumentFreeFunc argumentFree, SimulationTime nanoDelay) {
+    utility_assert(callback);
+
+    Worker* worker = _worker_getPrivate();
+
+    if(slave_schedulerIsRunning(worker->slave)) {
+        utility_assert(worker->clock.now != SIMTIME_INVALID);
+        utility_assert(worker->active.host != NULL);
+
+        Event* event = event_newCallback(callback, callbackObject, callbackArgument,
+                objectFree, argumentFree, worker->clock.now + nanoDelay, worker->active.host);
+        GQuark hostID = host_getID(worker->active.host);
+        return scheduler_push(worker->scheduler, event, hostID, hostID);
+    } else {
+        /* the event would have released these when it was freed */
+        if(objectFree && callbackObject) {
+            objectFree(callbackObject);
+        }
+        if(argumentFree && callbackArgument) {
+            argumentFree(callbackArgument);
+        }
+        return FALSE;
+    }
+}
+
+gboolean worker_rescheduleEvent(Event* event, SimulationTime nanoDelay) {
+    Worker* worker = _worker_getPrivate();
+
+    if(slave_schedulerIsRunning(worker->slave)) {
+        utility_assert(worker->clock.now != SIMTIME_INVALID);
+        utility_assert(worker->active.host != NULL);
+        utility_assert(event_getHost(event) == worker->active.host);
+
+        /* the scheduler takes its own reference, ours is released after execution */
+        event_ref(event);
+        event_setTime(event, worker->clock.now + nanoDelay);
+        GQuark hostID = host_getID(worker->active.host);
+        return scheduler_push(worker->scheduler, event, hostID, hostID);
+    } else {
+        return FALSE;
+    }
+}
+
 static void _worker_runDeliverPacketTask(Packet* packet, gpointer userData) {
     in_addr_t ip = packet_getDestinationIP(packet);
     NetworkInterface* interface = host_lookupInterface(_worker_getPrivate()->active.host, ip);
@@ -234,8 +343,16 @@ void worker_sendPacket(Packet* packet) {
         return;
     }
 
+    /* a single lookup gives us everything we need to know about the path */
+    Path* path = topology_getPath(worker_getTopology(), srcAddress, dstAddress);
+    if(!path) {
+        error("unable to find path between node %s and node %s",
+                address_toString(srcAddress), address_toString(dstAddress));
+        return;
+    }
+
     /* check if network reliability forces us to 'drop' the packet */
-    gdouble reliability = topology_getReliability(worker_getTopology(), srcAddress, dstAddress);
+    gdouble reliability = path_getReliability(path);
     Random* random = host_getRandom(worker_getActiveHost());
     gdouble chance = random_nextDouble(random);
 
@@ -243,11 +360,15 @@ void worker_sendPacket(Packet* packet) {
      * control has problems responding to packet loss */
     if(chance <= reliability || packet_getPayloadLength(packet) == 0) {
         /* the sender's packet will make it through, find latency */
-        gdouble latency = topology_getLatency(worker_getTopology(), srcAddress, dstAddress);
+        gdouble latency = path_getLatency(path);
         SimulationTime delay = (SimulationTime) ceil(latency * SIMTIME_ONE_MILLISECOND);
         SimulationTime deliverTime = worker->clock.now + delay;
 
-        topology_incrementPathPacketCounter(worker_getTopology(), srcAddress, dstAddress);
+        guint pathID = path_getID(path);
+        if(pathID >= worker->pathPacketCounts->len) {
+            g_array_set_size(worker->pathPacketCounts, pathID + 1);
+        }
+        g_array_index(worker->pathPacketCounts, gsize, pathID)++;
 
         /* TODO this should change for sending to remote slave (on a different machine)
          * this is the only place where tasks are sent between separate hosts */
@@ -259,10 +380,8 @@ void worker_sendPacket(Packet* packet) {
         utility_assert(dstHost);
 
         packet_ref(packet);
-        Task* packetTask = task_new((TaskCallbackFunc)_worker_runDeliverPacketTask,
-                packet, NULL, (TaskObjectFreeFunc)packet_unref, NULL);
-        Event* packetEvent = event_new_(packetTask, deliverTime, dstHost);
-        task_unref(packetTask);
+        Event* packetEvent = event_newCallback((TaskCallbackFunc)_worker_runDeliverPacketTask,
+                packet, NULL, (TaskObjectFreeFunc)packet_unref, NULL, deliverTime, dstHost);
 
         scheduler_push(worker->scheduler, packetEvent, srcID, dstID);
 
@@ -274,11 +393,11 @@ void worker_sendPacket(Packet* packet) {
 
 static void _worker_bootHost(Host* host, Worker* worker) {
     worker_setActiveHost(host);
-    worker->clock.now = 0;
+    _worker_setClock(worker, 0);
     host_continueExecutionTimer(host);
     host_boot(host);
     host_stopExecutionTimer(host);
-    worker->clock.now = SIMTIME_INVALID;
+    _worker_setClock(worker, SIMTIME_INVALID);
     worker_setActiveHost(NULL);
 }
 
@@ -323,6 +442,15 @@ void worker_setActiveProcess(Process* proc) {
         process_ref(proc);
         worker->active.process = proc;
     }
+    workerActiveProcess = proc;
+    workerEmulatedProcess = process_shouldEmulate(proc) ? proc : NULL;
+}
+
+/* called whenever a process switches between shadow and plugin context. calls
+ * are only ever redirected to the active process, as worker_getActiveProcess
+ * is what the emulated functions will operate on. */
+void worker_setEmulatedProcess(Process* proc) {
+    workerEmulatedProcess = (proc != NULL && proc == workerActiveProcess) ? proc : NULL;
 }
 
 Host* worker_getActiveHost() {
@@ -344,6 +472,9 @@ void worker_setActiveHost(Host* host) {
         host_ref(host);
         worker->active.host = host;
     }
+
+    /* the log filter only depends on the active host, so check it once here */
+    logger_setThreadHostLevel(logger_getDefault(), host ? host_getLogLevel(host) : LOGLEVEL_UNSET);
 }
 
 SimulationTime worker_getCurrentTime() {
@@ -355,7 +486,7 @@ SimulationTime worker_getCurrentTime() {
  * in any places where time is returned to the application, to handle code
  * that assumes the world is in a relatively recent time. */
 EmulatedTime worker_getEmulatedTime() {
-    return (EmulatedTime)(worker_getCurrentTime() + EMULATED_TIME_OFFSET);
+    return workerEmulatedTime;
 }
 
 guint worker_getRawCPUFrequency() {
@@ -390,7 +521,16 @@ void worker_updateMinTimeJump(gdouble minPathLatency) {
 
 void worker_setCurrentTime(SimulationTime time) {
     Worker* worker = _worker_getPrivate();
-    worker->clock.now = time;
+    _worker_setClock(worker, time);
+}
+
+void worker_tracePacketStatus(guint64 packetID, PacketDeliveryStatusFlags status) {
+    /* the slave thread has no worker, and no buffer to trace into */
+    Worker* worker = g_private_get(&workerKey);
+    if(worker && worker->packetTrace) {
+        guint hostIndex = worker->active.host ? host_getIndex(worker->active.host) : 0;
+        packettracebuffer_append(worker->packetTrace, worker->clock.now, hostIndex, packetID, status);
+    }
 }
 
 gboolean worker_isFiltered(LogLevel level) {
@@ -407,6 +547,71 @@ const gchar* worker_getHostsRootPath() {
     return slave_getHostsRootPath(worker->slave);
 }
 
+static ObjectPool** _worker_getPoolSlot(Worker* worker, ObjectType otype, gsize* objectSize) {
+    switch(otype) {
+        case OBJECT_TYPE_TASK: {
+            return &(worker->pools.task);
+        }
+        case OBJECT_TYPE_EVENT: {
+            return &(worker->pools.event);
+        }
+        case OBJECT_TYPE_PACKET: {
+            return &(worker->pools.packet);
+        }
+        case OBJECT_TYPE_PAYLOAD: {
+            /* round up to the smallest class that fits, so that payloads of
+             * different sizes can share a pool */
+            gsize classSize = WORKER_PAYLOAD_POOL_MIN_SIZE;
+            for(gint i = 0; i < WORKER_PAYLOAD_POOL_CLASSES; i++) {
+                if(*objectSize <= classSize) {
+                    *objectSize = classSize;
+                    return &(worker->pools.payload[i]);
+                }
+                classSize *= 2;
+            }
+            /* too big to pool */
+            return NULL;
+        }
+        default: {
+            return NULL;
+        }
+    }
+}
+
+static gpointer _worker_newPooledObject(ObjectType otype, gsize objectSize, gsize zeroSize) {
+    /* the slave thread does not have a worker when running with multiple workers */
+    if(!worker_isAlive()) {
+        return objectpool_allocDetached(objectSize, zeroSize);
+    }
+
+    Worker* worker = _worker_getPrivate();
+    ObjectPool** poolSlot = _worker_getPoolSlot(worker, otype, &objectSize);
+    if(!poolSlot) {
+        return objectpool_allocDetached(objectSize, zeroSize);
+    }
+
+    if(*poolSlot == NULL) {
+        /* objects may be released after this worker is gone, so the slave owns the pool */
+        *poolSlot = objectpool_new(otype, objectSize);
+        slave_storeObjectPool(worker->slave, *poolSlot);
+    }
+
+    /* the pool's size class may be larger than we asked for, and we don't zero the rest */
+    return objectpool_alloc(*poolSlot, zeroSize);
+}
+
+gpointer worker_newPooledObject(ObjectType otype, gsize objectSize) {
+    return _worker_newPooledObject(otype, objectSize, objectSize);
+}
+
+gpointer worker_newPooledObjectWithData(ObjectType otype, gsize objectSize, gsize dataSize) {
+    return _worker_newPooledObject(otype, objectSize + dataSize, objectSize);
+}
+
+void worker_freePooledObject(gpointer object) {
+    objectpool_release(object);
+}
+
 void worker_countObject(ObjectType otype, CounterType ctype) {
     /* the issue is that the slave thread frees some objects that
      * are created by the worker threads. but the slave thread does
@@ -26,10 +26,18 @@ Topology* worker_getTopology();
 Options* worker_getOptions();
 gpointer worker_run(WorkerRunData*);
 gboolean worker_scheduleTask(Task* task, SimulationTime nanoDelay);
+gboolean worker_scheduleCallback(TaskCallbackFunc callback, gpointer callbackObject, gpointer callbackArgument,
+        TaskObjectFreeFunc objectFree, TaskArgumentFreeFunc argumentFree, SimulationTime nanoDelay);
+gboolean worker_rescheduleEvent(Event* event, SimulationTime nanoDelay);
 void worker_sendPacket(Packet* packet);
 gboolean worker_isAlive();
 
 void worker_countObject(ObjectType otype, CounterType ctype);
+gpointer worker_newPooledObject(ObjectType otype, gsize objectSize);
+/* like worker_newPooledObject, but followed by dataSize bytes that are not
+ * zeroed because the caller is about to fill them */
+gpointer worker_newPooledObjectWithData(ObjectType otype, gsize objectSize, gsize dataSize);
+void worker_freePooledObject(gpointer object);
 
 SimulationTime worker_getCurrentTime();
 EmulatedTime worker_getEmulatedTime();
@@ -42,6 +50,7 @@ gint worker_getThreadID();
 void worker_updateMinTimeJump(gdouble minPathLatency);
 void worker_setCurrentTime(SimulationTime time);
 gboolean worker_isFiltered(LogLevel level);
+void worker_tracePacketStatus(guint64 packetID, PacketDeliveryStatusFlags status);
 
 void worker_bootHosts(GQueue* hosts);
 void worker_freeHosts(GQueue* hosts);
@@ -50,6 +59,18 @@ Host* worker_getActiveHost();
 void worker_setActiveHost(Host* host);
 Process* worker_getActiveProcess();
 void worker_setActiveProcess(Process* proc);
+void worker_setEmulatedProcess(Process* proc);
+
+/* The process whose intercepted calls should currently be redirected into
+ * shadow, or NULL when calls should go straight to libc. This is a plain
+ * thread-local instead of a Worker member so that the preload library can
+ * make its per-call decision with a single load. */
+extern __thread Process* workerEmulatedProcess;
+
+/* The current time as the plugins see it, or 0 while no event is running.
+ * Published here for the same reason as workerEmulatedProcess, so that the
+ * preload library can answer time queries without calling into shadow. */
+extern __thread EmulatedTime workerEmulatedTime;
 
 void worker_incrementPluginError();
 
@@ -219,6 +219,13 @@ typedef guint64 EmulatedTime;
  */
 #define CONFIG_MTU 1500
 
+/**
+ * Largest TCP window in packets, from the largest window of 65535 << 14 bytes
+ * that window scaling allows (RFC 7323). We never advertise more than this, so
+ * unacknowledged sequences never span more than this many packets.
+ */
+#define CONFIG_TCP_MAX_WINDOW_PACKETS ((65535 << 14) / (CONFIG_MTU - CONFIG_HEADER_SIZE_TCPIPETH))
+
 /**
  * Maximum size of a datagram we are allowed to send out over the network
  */
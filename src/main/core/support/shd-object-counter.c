@@ -9,6 +9,8 @@ typedef struct _ObjectCounts ObjectCounts;
 struct _ObjectCounts {
     guint64 new;
     guint64 free;
+    guint64 slab;
+    guint64 remote;
 };
 
 struct _ObjectCounter {
@@ -25,6 +27,7 @@ struct _ObjectCounter {
         ObjectCounts udp;
         ObjectCounts epoll;
         ObjectCounts timer;
+        ObjectCounts payload;
     } counters;
 
     GString* stringBuffer;
@@ -64,6 +67,16 @@ static void _objectcount_incrementOne(ObjectCounts* counts, CounterType ctype) {
             break;
         }
 
+        case COUNTER_TYPE_SLAB: {
+            counts->slab++;
+            break;
+        }
+
+        case COUNTER_TYPE_REMOTE: {
+            counts->remote++;
+            break;
+        }
+
         default:
         case COUNTER_TYPE_NONE: {
             break;
@@ -77,6 +90,8 @@ static void _objectcount_incrementAll(ObjectCounts* counts, ObjectCounts* increm
 
     counts->new += increments->new;
     counts->free += increments->free;
+    counts->slab += increments->slab;
+    counts->remote += increments->remote;
 }
 
 void objectcounter_incrementOne(ObjectCounter* counter, ObjectType otype, CounterType ctype) {
@@ -138,6 +153,11 @@ void objectcounter_incrementOne(ObjectCounter* counter, ObjectType otype, Counte
             break;
         }
 
+        case OBJECT_TYPE_PAYLOAD: {
+            _objectcount_incrementOne(&(counter->counters.payload), ctype);
+            break;
+        }
+
         default:
         case OBJECT_TYPE_NONE: {
             break;
@@ -159,6 +179,7 @@ void objectcounter_incrementAll(ObjectCounter* counter, ObjectCounter* increment
     _objectcount_incrementAll(&(counter->counters.udp), &(increment->counters.udp));
     _objectcount_incrementAll(&(counter->counters.epoll), &(increment->counters.epoll));
     _objectcount_incrementAll(&(counter->counters.timer), &(increment->counters.timer));
+    _objectcount_incrementAll(&(counter->counters.payload), &(increment->counters.payload));
 }
 
 const gchar* objectcounter_valuesToString(ObjectCounter* counter) {
@@ -179,7 +200,12 @@ const gchar* objectcounter_valuesToString(ObjectCounter* counter) {
             "tcp_new=%"G_GUINT64_FORMAT" tcp_free=%"G_GUINT64_FORMAT" "
             "udp_new=%"G_GUINT64_FORMAT" udp_free=%"G_GUINT64_FORMAT" "
             "epoll_new=%"G_GUINT64_FORMAT" epoll_free=%"G_GUINT64_FORMAT" "
-            "timer_new=%"G_GUINT64_FORMAT" timer_free=%"G_GUINT64_FORMAT" ",
+            "timer_new=%"G_GUINT64_FORMAT" timer_free=%"G_GUINT64_FORMAT" "
+            "payload_new=%"G_GUINT64_FORMAT" payload_free=%"G_GUINT64_FORMAT" "
+            "task_slab=%"G_GUINT64_FORMAT" task_remote=%"G_GUINT64_FORMAT" "
+            "event_slab=%"G_GUINT64_FORMAT" event_remote=%"G_GUINT64_FORMAT" "
+            "packet_slab=%"G_GUINT64_FORMAT" packet_remote=%"G_GUINT64_FORMAT" "
+            "payload_slab=%"G_GUINT64_FORMAT" payload_remote=%"G_GUINT64_FORMAT" ",
             counter->counters.task.new, counter->counters.task.free,
             counter->counters.event.new, counter->counters.event.free,
             counter->counters.packet.new, counter->counters.packet.free,
@@ -190,7 +216,12 @@ const gchar* objectcounter_valuesToString(ObjectCounter* counter) {
             counter->counters.tcp.new, counter->counters.tcp.free,
             counter->counters.udp.new, counter->counters.udp.free,
             counter->counters.epoll.new, counter->counters.epoll.free,
-            counter->counters.timer.new, counter->counters.timer.free);
+            counter->counters.timer.new, counter->counters.timer.free,
+            counter->counters.payload.new, counter->counters.payload.free,
+            counter->counters.task.slab, counter->counters.task.remote,
+            counter->counters.event.slab, counter->counters.event.remote,
+            counter->counters.packet.slab, counter->counters.packet.remote,
+            counter->counters.payload.slab, counter->counters.payload.remote);
 
     return (const gchar*) counter->stringBuffer->str;
 }
@@ -213,7 +244,8 @@ const gchar* objectcounter_diffsToString(ObjectCounter* counter) {
             "tcp=%"G_GUINT64_FORMAT" "
             "udp=%"G_GUINT64_FORMAT" "
             "epoll=%"G_GUINT64_FORMAT" "
-            "timer=%"G_GUINT64_FORMAT" ",
+            "timer=%"G_GUINT64_FORMAT" "
+            "payload=%"G_GUINT64_FORMAT" ",
             counter->counters.task.new - counter->counters.task.free,
             counter->counters.event.new - counter->counters.event.free,
             counter->counters.packet.new - counter->counters.packet.free,
@@ -224,7 +256,8 @@ const gchar* objectcounter_diffsToString(ObjectCounter* counter) {
             counter->counters.tcp.new - counter->counters.tcp.free,
             counter->counters.udp.new - counter->counters.udp.free,
             counter->counters.epoll.new - counter->counters.epoll.free,
-            counter->counters.timer.new - counter->counters.timer.free);
+            counter->counters.timer.new - counter->counters.timer.free,
+            counter->counters.payload.new - counter->counters.payload.free);
 
     return (const gchar*) counter->stringBuffer->str;
 }
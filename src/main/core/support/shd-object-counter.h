@@ -20,6 +20,7 @@ enum _ObjectType {
     OBJECT_TYPE_UDP,
     OBJECT_TYPE_EPOLL,
     OBJECT_TYPE_TIMER,
+    OBJECT_TYPE_PAYLOAD,
 };
 
 typedef enum _CounterType CounterType;
@@ -27,6 +28,10 @@ enum _CounterType {
     COUNTER_TYPE_NONE,
     COUNTER_TYPE_NEW,
     COUNTER_TYPE_FREE,
+    /* a pooled object type needed a new slab from the system allocator */
+    COUNTER_TYPE_SLAB,
+    /* a pooled object was released by a thread other than its owner */
+    COUNTER_TYPE_REMOTE,
 };
 
 typedef struct _ObjectCounter ObjectCounter;
@@ -0,0 +1,172 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "shadow.h"
+
+/* number of objects we carve out of each slab */
+#define OBJECTPOOL_SLAB_LENGTH 256
+/* keep the objects that follow each header aligned */
+#define OBJECTPOOL_ALIGNMENT 16
+
+typedef struct _ObjectPoolHeader ObjectPoolHeader;
+struct _ObjectPoolHeader {
+    /* the owning pool, or NULL for detached objects */
+    ObjectPool* pool;
+    /* link in the local or remote free list while the object is not in use */
+    ObjectPoolHeader* next;
+};
+
+struct _ObjectPool {
+    ObjectType otype;
+    pthread_t owner;
+
+    /* size of the object and of each header+object unit in the slab */
+    gsize objectSize;
+    gsize unitSize;
+
+    /* free objects only accessed by the owner */
+    ObjectPoolHeader* localFree;
+    /* free objects released by other threads, a lock-free stack */
+    ObjectPoolHeader* remoteFree;
+
+    /* the memory backing all objects */
+    GSList* slabs;
+    guint numSlabs;
+
+    MAGIC_DECLARE;
+};
+
+static gsize _objectpool_roundUp(gsize size) {
+    return (size + OBJECTPOOL_ALIGNMENT - 1) & ~((gsize)OBJECTPOOL_ALIGNMENT - 1);
+}
+
+static gpointer _objectpool_headerToObject(ObjectPoolHeader* header) {
+    return ((guint8*)header) + _objectpool_roundUp(sizeof(ObjectPoolHeader));
+}
+
+static ObjectPoolHeader* _objectpool_objectToHeader(gpointer object) {
+    return (ObjectPoolHeader*)(((guint8*)object) - _objectpool_roundUp(sizeof(ObjectPoolHeader)));
+}
+
+ObjectPool* objectpool_new(ObjectType otype, gsize objectSize) {
+    utility_assert(objectSize > 0);
+
+    ObjectPool* pool = g_new0(ObjectPool, 1);
+    MAGIC_INIT(pool);
+
+    pool->otype = otype;
+    pool->owner = pthread_self();
+    pool->objectSize = objectSize;
+    pool->unitSize = _objectpool_roundUp(sizeof(ObjectPoolHeader)) + _objectpool_roundUp(objectSize);
+
+    return pool;
+}
+
+void objectpool_free(ObjectPool* pool) {
+    MAGIC_ASSERT(pool);
+
+    /* any objects still in use are leaked by their owners, but the
+     * object counter already reports those so we just drop the memory */
+    if(pool->slabs) {
+        g_slist_free_full(pool->slabs, g_free);
+    }
+
+    MAGIC_CLEAR(pool);
+    g_free(pool);
+}
+
+static void _objectpool_addSlab(ObjectPool* pool) {
+    MAGIC_ASSERT(pool);
+
+    guint8* slab = g_malloc(pool->unitSize * OBJECTPOOL_SLAB_LENGTH);
+    pool->slabs = g_slist_prepend(pool->slabs, slab);
+    pool->numSlabs++;
+
+    /* thread the new units onto the local free list */
+    for(gint i = OBJECTPOOL_SLAB_LENGTH - 1; i >= 0; i--) {
+        ObjectPoolHeader* header = (ObjectPoolHeader*)(slab + (i * pool->unitSize));
+        header->pool = pool;
+        header->next = pool->localFree;
+        pool->localFree = header;
+    }
+
+    worker_countObject(pool->otype, COUNTER_TYPE_SLAB);
+}
+
+static void _objectpool_reclaimRemote(ObjectPool* pool) {
+    MAGIC_ASSERT(pool);
+
+    /* take the whole remote stack at once. only the owner ever removes
+     * entries, so the head we read cannot be reused before our swap. */
+    ObjectPoolHeader* head = NULL;
+    do {
+        head = g_atomic_pointer_get(&pool->remoteFree);
+    } while(head != NULL && !g_atomic_pointer_compare_and_exchange(&pool->remoteFree, head, NULL));
+
+    pool->localFree = head;
+}
+
+gpointer objectpool_alloc(ObjectPool* pool, gsize zeroSize) {
+    MAGIC_ASSERT(pool);
+    utility_assert(pthread_equal(pool->owner, pthread_self()));
+    utility_assert(zeroSize <= pool->objectSize);
+
+    if(!pool->localFree) {
+        _objectpool_reclaimRemote(pool);
+    }
+    if(!pool->localFree) {
+        _objectpool_addSlab(pool);
+    }
+
+    ObjectPoolHeader* header = pool->localFree;
+    pool->localFree = header->next;
+    header->next = NULL;
+
+    gpointer object = _objectpool_headerToObject(header);
+    memset(object, 0, zeroSize);
+    return object;
+}
+
+gpointer objectpool_allocDetached(gsize objectSize, gsize zeroSize) {
+    utility_assert(zeroSize <= objectSize);
+
+    ObjectPoolHeader* header = g_malloc(_objectpool_roundUp(sizeof(ObjectPoolHeader)) + objectSize);
+    header->pool = NULL;
+    header->next = NULL;
+
+    gpointer object = _objectpool_headerToObject(header);
+    memset(object, 0, zeroSize);
+    return object;
+}
+
+void objectpool_release(gpointer object) {
+    if(!object) {
+        return;
+    }
+
+    ObjectPoolHeader* header = _objectpool_objectToHeader(object);
+    ObjectPool* pool = header->pool;
+
+    if(!pool) {
+        g_free(header);
+        return;
+    }
+
+    MAGIC_ASSERT(pool);
+
+    if(pthread_equal(pool->owner, pthread_self())) {
+        header->next = pool->localFree;
+        pool->localFree = header;
+    } else {
+        /* lazily hand the object back to its owner */
+        ObjectPoolHeader* head = NULL;
+        do {
+            head = g_atomic_pointer_get(&pool->remoteFree);
+            header->next = head;
+        } while(!g_atomic_pointer_compare_and_exchange(&pool->remoteFree, head, header));
+
+        worker_countObject(pool->otype, COUNTER_TYPE_REMOTE);
+    }
+}
@@ -0,0 +1,38 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_OBJECT_POOL_H_
+#define SHD_OBJECT_POOL_H_
+
+#include "shadow.h"
+
+/*
+ * A free-list allocator for small fixed-size objects that are created and
+ * destroyed at a high rate, such as events, tasks, and packets. Each pool is
+ * owned by the thread that created it, and only that thread may allocate from
+ * it. Any thread may release an object: releases from the owner go straight
+ * back on the free list, while releases from other threads are pushed onto a
+ * lock-free list that the owner reclaims when its own free list runs dry.
+ * Memory is carved out of slabs that are only returned to the system when the
+ * pool is freed, so a pool must outlive every object allocated from it.
+ */
+typedef struct _ObjectPool ObjectPool;
+
+ObjectPool* objectpool_new(ObjectType otype, gsize objectSize);
+void objectpool_free(ObjectPool* pool);
+
+/* returns an object whose first zeroSize bytes are zeroed, must only be called
+ * by the thread that created the pool. the rest is left for the caller to fill. */
+gpointer objectpool_alloc(ObjectPool* pool, gsize zeroSize);
+
+/* returns an object of objectSize bytes whose first zeroSize bytes are zeroed,
+ * that does not belong to any pool, for use by threads that do not own one.
+ * it is released to the system. */
+gpointer objectpool_allocDetached(gsize objectSize, gsize zeroSize);
+
+/* returns an object from objectpool_alloc or objectpool_allocDetached, from any thread */
+void objectpool_release(gpointer object);
+
+#endif /* SHD_OBJECT_POOL_H_ */
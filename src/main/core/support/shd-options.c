@@ -13,6 +13,8 @@ struct _Options {
 
     GOptionGroup* mainOptionGroup;
     gchar* logLevelInput;
+    gchar* logFormatInput;
+    gint logCompressionLevel;
     gint nWorkerThreads;
     guint randomSeed;
     gboolean printSoftwareVersion;
@@ -24,11 +26,17 @@ struct _Options {
     gboolean debug;
     gchar* dataDirPath;
     gchar* dataTemplatePath;
+    gint pthStackCacheSize;
+    gboolean usePthStackHugePages;
+    gboolean tracePackets;
 
     GOptionGroup* networkOptionGroup;
     gint cpuThreshold;
     gint cpuPrecision;
     gint minRunAhead;
+    gboolean useLookahead;
+    gboolean precomputePaths;
+    gchar* pathCacheDirPath;
     gint initialTCPWindow;
     gint interfaceBufferSize;
     gint initialSocketReceiveBufferSize;
@@ -36,6 +44,7 @@ struct _Options {
     gboolean autotuneSocketReceiveBuffer;
     gboolean autotuneSocketSendBuffer;
     gchar* interfaceQueuingDiscipline;
+    gboolean useSyntheticPayloads;
     gchar* eventSchedulingPolicy;
     SimulationTime interfaceBatchTime;
     gchar* tcpCongestionControl;
@@ -76,17 +85,26 @@ Options* options_new(gint argc, gchar* argv[]) {
     options->cpuThreshold = -1;
     options->cpuPrecision = 200;
     options->heartbeatInterval = 1;
+    options->pthStackCacheSize = 64;
 
     /* set options to change defaults for the main group */
     options->mainOptionGroup = g_option_group_new("main", "Main Options", "Primary simulator options", NULL, NULL);
     const GOptionEntry mainEntries[] = {
+      { "compress-logs", 0, 0, G_OPTION_ARG_INT, &(options->logCompressionLevel), "Compress the shadow log and the process output files with zstd at LEVEL, or leave them uncompressed if 0 [0]", "LEVEL" },
       { "data-directory", 'd', 0, G_OPTION_ARG_STRING, &(options->dataDirPath), "PATH to store simulation output ['shadow.data']", "PATH" },
       { "data-template", 'e', 0, G_OPTION_ARG_STRING, &(options->dataTemplatePath), "PATH to recursively copy during startup and use as the data-directory ['shadow.data.template']", "PATH" },
       { "gdb", 'g', 0, G_OPTION_ARG_NONE, &(options->debug), "Pause at startup for debugger attachment", NULL },
       { "heartbeat-frequency", 'h', 0, G_OPTION_ARG_INT, &(options->heartbeatInterval), "Log node statistics every N seconds [1]", "N" },
-      { "heartbeat-log-info", 'i', 0, G_OPTION_ARG_STRING, &(options->heartbeatLogInfo), "Comma separated list of information contained in heartbeat ('node','socket','ram') ['node']", "LIST"},
+      { "heartbeat-log-info", 'i', 0, G_OPTION_ARG_STRING, &(options->heartbeatLogInfo), "Comma separated list of information contained in heartbeat ('node','socket','ram','stack') ['node']", "LIST"},
       { "heartbeat-log-level", 'j', 0, G_OPTION_ARG_STRING, &(options->heartbeatLogLevelInput), "Log LEVEL at which to print node statistics ['message']", "LEVEL" },
+      { "log-format", 0, 0, G_OPTION_ARG_STRING, &(options->logFormatInput), "Log FORMAT, where 'deferred' formats messages in the logger thread instead of the workers, and 'binary' writes records to be formatted with decode-shadow-log.py ('text', 'deferred', 'binary') ['text']", "FORMAT" },
       { "log-level", 'l', 0, G_OPTION_ARG_STRING, &(options->logLevelInput), "Log LEVEL above which to filter messages ('error' < 'critical' < 'warning' < 'message' < 'info' < 'debug') ['message']", "LEVEL" },
+      { "lookahead", 0, 0, G_OPTION_ARG_NONE, &(options->useLookahead), "Run each worker to its own execution window computed from the path latencies between worker host partitions, instead of one global window (thread-based scheduler policies only)", NULL },
+      { "packet-trace", 0, 0, G_OPTION_ARG_NONE, &(options->tracePackets), "Record every packet delivery status change in a binary trace at 'packet-trace.bin' in the data directory, to be printed with decode-packet-trace.py", NULL },
+      { "path-cache", 0, 0, G_OPTION_ARG_STRING, &(options->pathCacheDirPath), "Load precomputed paths from, or store them to, a file in directory PATH named after the topology and host attachments (implies --precompute-paths) [None]", "PATH" },
+      { "precompute-paths", 0, 0, G_OPTION_ARG_NONE, &(options->precomputePaths), "Compute the paths between all vertices with attached hosts in parallel before the simulation starts, instead of on first use", NULL },
+      { "pth-stack-cache", 0, 0, G_OPTION_ARG_INT, &(options->pthStackCacheSize), "Keep up to N released thread stacks of each size in each worker for reuse by any virtual process [64]", "N" },
+      { "pth-stack-hugepages", 0, 0, G_OPTION_ARG_NONE, &(options->usePthStackHugePages), "Ask for transparent huge pages to back virtual process thread stacks", NULL },
       { "preload", 'p', 0, G_OPTION_ARG_STRING, &(options->preloads), "LD_PRELOAD environment VALUE to use for function interposition (/path/to/lib:...) [None]", "VALUE" },
       { "runahead", 'r', 0, G_OPTION_ARG_INT, &(options->minRunAhead), "If set, overrides the automatically calculated minimum TIME workers may run ahead when sending events between nodes, in milliseconds [0]", "TIME" },
       { "seed", 's', 0, G_OPTION_ARG_INT, &(options->randomSeed), "Initialize randomness for each thread using seed N [1]", "N" },
@@ -128,6 +146,7 @@ Options* options_new(gint argc, gchar* argv[]) {
       { "interface-qdisc", 0, 0, G_OPTION_ARG_STRING, &(options->interfaceQueuingDiscipline), "The interface queuing discipline QDISC used to select the next sendable socket ('fifo' or 'rr') ['fifo']", "QDISC" },
       { "socket-recv-buffer", 0, 0, G_OPTION_ARG_INT, &(options->initialSocketReceiveBufferSize), sockrecv->str, "N" },
       { "socket-send-buffer", 0, 0, G_OPTION_ARG_INT, &(options->initialSocketSendBufferSize), socksend->str, "N" },
+      { "synthetic-payloads", 0, 0, G_OPTION_ARG_NONE, &(options->useSyntheticPayloads), "Carry only the length of application data in packets, and deliver zeros to receivers (only for applications that never inspect the data they receive)", NULL },
       { "tcp-congestion-control", 0, 0, G_OPTION_ARG_STRING, &(options->tcpCongestionControl), "Congestion control algorithm to use for TCP ('aimd', 'reno', 'cubic') ['cubic']", "TCPCC" },
       { "tcp-ssthresh", 0, 0, G_OPTION_ARG_INT, &(options->tcpSlowStartThreshold), "Set TCP ssthresh value instead of discovering it via packet loss or hystart [0]", "N" },
       { "tcp-windows", 0, 0, G_OPTION_ARG_INT, &(options->initialTCPWindow), "Initialize the TCP send, receive, and congestion windows to N packets [10]", "N" },
@@ -167,6 +186,9 @@ Options* options_new(gint argc, gchar* argv[]) {
     if(options->logLevelInput == NULL) {
         options->logLevelInput = g_strdup("message");
     }
+    if(options->logFormatInput == NULL) {
+        options->logFormatInput = g_strdup("text");
+    }
     if(options->heartbeatLogLevelInput == NULL) {
         options->heartbeatLogLevelInput = g_strdup("message");
     }
@@ -176,6 +198,9 @@ Options* options_new(gint argc, gchar* argv[]) {
     if(options->heartbeatInterval < 1) {
         options->heartbeatInterval = 1;
     }
+    if(options->pthStackCacheSize < 0) {
+        options->pthStackCacheSize = 0;
+    }
     if(options->initialTCPWindow < 1) {
         options->initialTCPWindow = 1;
     }
@@ -230,6 +255,7 @@ void options_free(Options* options) {
         g_string_free(options->inputXMLFilename, TRUE);
     }
     g_free(options->logLevelInput);
+    g_free(options->logFormatInput);
     g_free(options->heartbeatLogLevelInput);
     g_free(options->heartbeatLogInfo);
     g_free(options->interfaceQueuingDiscipline);
@@ -238,6 +264,9 @@ void options_free(Options* options) {
     if(options->argstr) {
         g_free(options->argstr);
     }
+    if(options->pathCacheDirPath) {
+        g_free(options->pathCacheDirPath);
+    }
     if(options->preloads) {
         g_free(options->preloads);
     }
@@ -260,6 +289,16 @@ LogLevel options_getLogLevel(Options* options) {
     return loglevel_fromStr(options->logLevelInput);
 }
 
+LogFormat options_getLogFormat(Options* options) {
+    MAGIC_ASSERT(options);
+    return logformat_fromStr(options->logFormatInput);
+}
+
+gint options_getLogCompressionLevel(Options* options) {
+    MAGIC_ASSERT(options);
+    return options->logCompressionLevel;
+}
+
 LogLevel options_getHeartbeatLogLevel(Options* options) {
     MAGIC_ASSERT(options);
     const gchar* l = (const gchar*) options->heartbeatLogLevelInput;
@@ -283,8 +322,10 @@ LogInfoFlags options_toHeartbeatLogInfo(Options* options, const gchar* input) {
                 flags |= LOG_INFO_FLAGS_SOCKET;
             } else if(!g_ascii_strcasecmp(parts[i], "ram")) {
                 flags |= LOG_INFO_FLAGS_RAM;
+            } else if(!g_ascii_strcasecmp(parts[i], "stack")) {
+                flags |= LOG_INFO_FLAGS_STACK;
             } else {
-                warning("Did not recognize log info '%s', possible choices are 'node','socket','ram'.", parts[i]);
+                warning("Did not recognize log info '%s', possible choices are 'node','socket','ram','stack'.", parts[i]);
             }
         }
         g_strfreev(parts);
@@ -376,6 +417,36 @@ gint options_getMinRunAhead(Options* options) {
     return options->minRunAhead;
 }
 
+gboolean options_doUseLookahead(Options* options) {
+    MAGIC_ASSERT(options);
+    return options->useLookahead;
+}
+
+gint options_getPthStackCacheSize(Options* options) {
+    MAGIC_ASSERT(options);
+    return options->pthStackCacheSize;
+}
+
+gboolean options_doUsePthStackHugePages(Options* options) {
+    MAGIC_ASSERT(options);
+    return options->usePthStackHugePages;
+}
+
+gboolean options_doTracePackets(Options* options) {
+    MAGIC_ASSERT(options);
+    return options->tracePackets;
+}
+
+gboolean options_doPrecomputePaths(Options* options) {
+    MAGIC_ASSERT(options);
+    return (options->precomputePaths || options->pathCacheDirPath != NULL) ? TRUE : FALSE;
+}
+
+const gchar* options_getPathCacheDirectory(Options* options) {
+    MAGIC_ASSERT(options);
+    return options->pathCacheDirPath;
+}
+
 gint options_getTCPWindow(Options* options) {
     MAGIC_ASSERT(options);
     return options->initialTCPWindow;
@@ -421,6 +492,11 @@ gboolean options_doAutotuneSendBuffer(Options* options) {
     return options->autotuneSocketSendBuffer;
 }
 
+gboolean options_doUseSyntheticPayloads(Options* options) {
+    MAGIC_ASSERT(options);
+    return options->useSyntheticPayloads;
+}
+
 const GString* options_getInputXMLFilename(Options* options) {
     MAGIC_ASSERT(options);
     return options->inputXMLFilename;
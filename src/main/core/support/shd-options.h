@@ -24,6 +24,7 @@ enum _LogInfoFlags {
     LOG_INFO_FLAGS_NODE = 1<<0,
     LOG_INFO_FLAGS_SOCKET = 1<<1,
     LOG_INFO_FLAGS_RAM = 1<<2,
+    LOG_INFO_FLAGS_STACK = 1<<3,
 };
 
 typedef enum _QDiscMode QDiscMode;
@@ -61,6 +62,17 @@ void options_free(Options* options);
 LogLevel options_getLogLevel(Options* options);
 LogLevel options_getHeartbeatLogLevel(Options* options);
 
+/**
+ * Get where log messages are formatted and how they are written.
+ */
+LogFormat options_getLogFormat(Options* options);
+
+/**
+ * Get the zstd level at which to compress the log and process output files,
+ * or 0 if they are written uncompressed.
+ */
+gint options_getLogCompressionLevel(Options* options);
+
 /**
  * Get the configured log level at which heartbeat messages are printed,
  * based on command line input.
@@ -106,6 +118,12 @@ gint options_getCPUThreshold(Options* options);
 gint options_getCPUPrecision(Options* options);
 
 gint options_getMinRunAhead(Options* options);
+gboolean options_doUseLookahead(Options* options);
+gint options_getPthStackCacheSize(Options* options);
+gboolean options_doUsePthStackHugePages(Options* options);
+gboolean options_doPrecomputePaths(Options* options);
+gboolean options_doTracePackets(Options* options);
+const gchar* options_getPathCacheDirectory(Options* options);
 gint options_getTCPWindow(Options* options);
 const gchar* options_getTCPCongestionControl(Options* options);
 gint options_getTCPSlowStartThreshold(Options* options);
@@ -115,6 +133,7 @@ gint options_getSocketReceiveBufferSize(Options* options);
 gint options_getSocketSendBufferSize(Options* options);
 gboolean options_doAutotuneReceiveBuffer(Options* options);
 gboolean options_doAutotuneSendBuffer(Options* options);
+gboolean options_doUseSyntheticPayloads(Options* options);
 
 const GString* options_getInputXMLFilename(Options* options);
 
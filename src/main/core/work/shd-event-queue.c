@@ -0,0 +1,160 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "shadow.h"
+
+/* a 4-ary heap is shallower than a binary heap and keeps all children of a node
+ * in the same or adjacent cache lines, which makes sift-down cheaper */
+#define EVENTQUEUE_ARITY 4
+#define EVENTQUEUE_INITIAL_SIZE 64
+
+typedef struct _EventQueueEntry EventQueueEntry;
+struct _EventQueueEntry {
+    SimulationTime time;
+    guint64 sequence;
+    Event* event;
+};
+
+struct _EventQueue {
+    EventQueueEntry* heap;
+    gsize size;
+    gsize heapSize;
+    MAGIC_DECLARE;
+};
+
+EventQueue* eventqueue_new() {
+    EventQueue* eventq = g_new0(EventQueue, 1);
+    MAGIC_INIT(eventq);
+
+    eventq->heap = g_new(EventQueueEntry, EVENTQUEUE_INITIAL_SIZE);
+    eventq->heapSize = EVENTQUEUE_INITIAL_SIZE;
+    eventq->size = 0;
+
+    return eventq;
+}
+
+void eventqueue_free(EventQueue* eventq) {
+    MAGIC_ASSERT(eventq);
+
+    for(gsize i = 0; i < eventq->size; i++) {
+        event_unref(eventq->heap[i].event);
+    }
+    g_free(eventq->heap);
+
+    MAGIC_CLEAR(eventq);
+    g_free(eventq);
+}
+
+gsize eventqueue_getLength(EventQueue* eventq) {
+    MAGIC_ASSERT(eventq);
+    return eventq->size;
+}
+
+gboolean eventqueue_isEmpty(EventQueue* eventq) {
+    MAGIC_ASSERT(eventq);
+    return eventq->size == 0;
+}
+
+/* same ordering as event_compare(), but on the cached keys */
+static inline gboolean _eventqueue_isLess(const EventQueueEntry* a, const EventQueueEntry* b) {
+    return (a->time < b->time) || (a->time == b->time && a->sequence < b->sequence);
+}
+
+static void _eventqueue_siftUp(EventQueue* eventq, gsize index) {
+    EventQueueEntry entry = eventq->heap[index];
+
+    while(index > 0) {
+        gsize parent = (index - 1) / EVENTQUEUE_ARITY;
+        if(!_eventqueue_isLess(&entry, &eventq->heap[parent])) {
+            break;
+        }
+        eventq->heap[index] = eventq->heap[parent];
+        index = parent;
+    }
+
+    eventq->heap[index] = entry;
+}
+
+static void _eventqueue_siftDown(EventQueue* eventq, gsize index) {
+    EventQueueEntry entry = eventq->heap[index];
+
+    while(TRUE) {
+        gsize firstChild = (index * EVENTQUEUE_ARITY) + 1;
+        if(firstChild >= eventq->size) {
+            break;
+        }
+
+        /* find the smallest of up to EVENTQUEUE_ARITY children */
+        gsize lastChild = MIN(firstChild + EVENTQUEUE_ARITY, eventq->size);
+        gsize minChild = firstChild;
+        for(gsize child = firstChild + 1; child < lastChild; child++) {
+            if(_eventqueue_isLess(&eventq->heap[child], &eventq->heap[minChild])) {
+                minChild = child;
+            }
+        }
+
+        if(!_eventqueue_isLess(&eventq->heap[minChild], &entry)) {
+            break;
+        }
+        eventq->heap[index] = eventq->heap[minChild];
+        index = minChild;
+    }
+
+    eventq->heap[index] = entry;
+}
+
+void eventqueue_push(EventQueue* eventq, Event* event) {
+    MAGIC_ASSERT(eventq);
+    utility_assert(event);
+
+    if(eventq->size >= eventq->heapSize) {
+        eventq->heapSize *= 2;
+        eventq->heap = g_renew(EventQueueEntry, eventq->heap, eventq->heapSize);
+    }
+
+    /* the queue takes the caller's reference to the event */
+    gsize index = eventq->size;
+    eventq->heap[index].time = event_getTime(event);
+    eventq->heap[index].sequence = event_getSequence(event);
+    eventq->heap[index].event = event;
+    eventq->size++;
+
+    _eventqueue_siftUp(eventq, index);
+}
+
+Event* eventqueue_peek(EventQueue* eventq) {
+    MAGIC_ASSERT(eventq);
+    return (eventq->size > 0) ? eventq->heap[0].event : NULL;
+}
+
+SimulationTime eventqueue_getNextTime(EventQueue* eventq) {
+    MAGIC_ASSERT(eventq);
+    return (eventq->size > 0) ? eventq->heap[0].time : SIMTIME_INVALID;
+}
+
+Event* eventqueue_pop(EventQueue* eventq) {
+    MAGIC_ASSERT(eventq);
+
+    if(eventq->size == 0) {
+        return NULL;
+    }
+
+    Event* event = eventq->heap[0].event;
+
+    eventq->size--;
+    if(eventq->size > 0) {
+        eventq->heap[0] = eventq->heap[eventq->size];
+        _eventqueue_siftDown(eventq, 0);
+    }
+
+    /* give back memory if we shrunk a lot, but keep some hysteresis */
+    if((eventq->heapSize > EVENTQUEUE_INITIAL_SIZE) && (eventq->size * 4 < eventq->heapSize)) {
+        eventq->heapSize /= 2;
+        eventq->heap = g_renew(EventQueueEntry, eventq->heap, eventq->heapSize);
+    }
+
+    /* the caller now owns the reference the queue was holding */
+    return event;
+}
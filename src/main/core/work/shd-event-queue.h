@@ -0,0 +1,30 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_EVENT_QUEUE_H_
+#define SHD_EVENT_QUEUE_H_
+
+#include "shadow.h"
+
+/*
+ * A min-queue specialized for Events. Entries store the event time and sequence
+ * inline next to the Event pointer so that heap operations never dereference the
+ * event or hash anything. Ordering is identical to event_compare(). The queue
+ * owns a reference to each event it holds, which is released when the queue is
+ * freed with events still in it.
+ */
+typedef struct _EventQueue EventQueue;
+
+EventQueue* eventqueue_new();
+void eventqueue_free(EventQueue* eventq);
+
+gsize eventqueue_getLength(EventQueue* eventq);
+gboolean eventqueue_isEmpty(EventQueue* eventq);
+void eventqueue_push(EventQueue* eventq, Event* event);
+Event* eventqueue_peek(EventQueue* eventq);
+Event* eventqueue_pop(EventQueue* eventq);
+SimulationTime eventqueue_getNextTime(EventQueue* eventq);
+
+#endif /* SHD_EVENT_QUEUE_H_ */
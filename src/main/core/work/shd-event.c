@@ -7,7 +7,16 @@
 
 struct _Event {
     Host* host;
+    /* a task that may be shared with other events, or NULL if the callback is inline */
     Task* task;
+    /* the callback and its arguments, owned by this event when task is NULL */
+    struct {
+        TaskCallbackFunc execute;
+        gpointer object;
+        gpointer argument;
+        TaskObjectFreeFunc objectFree;
+        TaskArgumentFreeFunc argumentFree;
+    } callback;
     SimulationTime time;
     guint64 sequence;
     gint referenceCount;
@@ -16,7 +25,7 @@ struct _Event {
 
 Event* event_new_(Task* task, SimulationTime time, gpointer host) {
     utility_assert(task != NULL);
-    Event* event = g_new0(Event, 1);
+    Event* event = worker_newPooledObject(OBJECT_TYPE_EVENT, sizeof(Event));
     MAGIC_INIT(event);
 
     event->host = (Host*)host;
@@ -29,10 +38,39 @@ Event* event_new_(Task* task, SimulationTime time, gpointer host) {
     return event;
 }
 
+Event* event_newCallback(TaskCallbackFunc callback, gpointer callbackObject, gpointer callbackArgument,
+        TaskObjectFreeFunc objectFree, TaskArgumentFreeFunc argumentFree,
+        SimulationTime time, gpointer host) {
+    utility_assert(callback != NULL);
+    Event* event = worker_newPooledObject(OBJECT_TYPE_EVENT, sizeof(Event));
+    MAGIC_INIT(event);
+
+    event->host = (Host*)host;
+    event->callback.execute = callback;
+    event->callback.object = callbackObject;
+    event->callback.argument = callbackArgument;
+    event->callback.objectFree = objectFree;
+    event->callback.argumentFree = argumentFree;
+    event->time = time;
+    event->referenceCount = 1;
+
+    worker_countObject(OBJECT_TYPE_EVENT, COUNTER_TYPE_NEW);
+    return event;
+}
+
 static void _event_free(Event* event) {
-    task_unref(event->task);
+    if(event->task) {
+        task_unref(event->task);
+    } else {
+        if(event->callback.objectFree && event->callback.object) {
+            event->callback.objectFree(event->callback.object);
+        }
+        if(event->callback.argumentFree && event->callback.argument) {
+            event->callback.argumentFree(event->callback.argument);
+        }
+    }
     MAGIC_CLEAR(event);
-    g_free(event);
+    worker_freePooledObject(event);
     worker_countObject(OBJECT_TYPE_EVENT, COUNTER_TYPE_FREE);
 }
 
@@ -67,11 +105,15 @@ void event_execute(Event* event) {
         tracker_addVirtualProcessingDelay(host_getTracker(event->host), cpuDelay);
 
         /* this event is delayed due to cpu, so reschedule it to ourselves */
-        worker_scheduleTask(event->task, cpuDelay);
+        worker_rescheduleEvent(event, cpuDelay);
     } else {
         /* cpu is not blocked, its ok to execute the event */
         host_continueExecutionTimer(event->host);
-        task_execute(event->task);
+        if(event->task) {
+            task_execute(event->task);
+        } else {
+            event->callback.execute(event->callback.object, event->callback.argument);
+        }
         host_stopExecutionTimer(event->host);
     }
 
@@ -99,6 +141,11 @@ void event_setSequence(Event* event, guint64 sequence) {
     event->sequence = sequence;
 }
 
+guint64 event_getSequence(Event* event) {
+    MAGIC_ASSERT(event);
+    return event->sequence;
+}
+
 gint event_compare(const Event* a, const Event* b, gpointer userData) {
     MAGIC_ASSERT(a);
     MAGIC_ASSERT(b);
@@ -12,6 +12,10 @@
 typedef struct _Event Event;
 
 Event* event_new_(Task* task, SimulationTime time, gpointer host);
+/* creates an event that owns the callback arguments directly instead of sharing a task */
+Event* event_newCallback(TaskCallbackFunc callback, gpointer callbackObject, gpointer callbackArgument,
+        TaskObjectFreeFunc objectFree, TaskArgumentFreeFunc argumentFree,
+        SimulationTime time, gpointer host);
 void event_ref(Event* event);
 void event_unref(Event* event);
 
@@ -22,5 +26,6 @@ gpointer event_getHost(Event* event);
 SimulationTime event_getTime(Event* event);
 void event_setTime(Event* event, SimulationTime time);
 void event_setSequence(Event* event, guint64 sequence);
+guint64 event_getSequence(Event* event);
 
 #endif /* SHD_EVENT_H_ */
@@ -20,7 +20,7 @@ Task* task_new(TaskCallbackFunc callback, gpointer callbackObject, gpointer call
         TaskObjectFreeFunc objectFree, TaskArgumentFreeFunc argumentFree) {
     utility_assert(callback != NULL);
 
-    Task* task = g_new0(Task, 1);
+    Task* task = worker_newPooledObject(OBJECT_TYPE_TASK, sizeof(Task));
 
     task->execute = callback;
     task->callbackObject = callbackObject;
@@ -43,7 +43,7 @@ static void _task_free(Task* task) {
         task->argumentFree(task->callbackArgument);
     }
     MAGIC_CLEAR(task);
-    g_free(task);
+    worker_freePooledObject(task);
     worker_countObject(OBJECT_TYPE_TASK, COUNTER_TYPE_FREE);
 }
 
@@ -48,7 +48,7 @@ static void channel_free(Channel* channel) {
     worker_countObject(OBJECT_TYPE_CHANNEL, COUNTER_TYPE_FREE);
 }
 
-static gssize channel_linkedWrite(Channel* channel, gconstpointer buffer, gsize nBytes) {
+static gssize channel_linkedWrite(Channel* channel, const struct iovec* iov, gint iovcnt) {
     MAGIC_ASSERT(channel);
     /* our linked channel is trying to send us data, make sure we can read it */
     utility_assert(!(channel->type & CT_WRITEONLY));
@@ -60,8 +60,11 @@ static gssize channel_linkedWrite(Channel* channel, gconstpointer buffer, gsize
     }
 
     /* accept some data from the other end of the pipe */
-    gsize copyLength = MIN(nBytes, available);
-    gsize numCopied = bytequeue_push(channel->buffer, buffer, copyLength);
+    gsize numCopied = 0;
+    for(gint i = 0; i < iovcnt && numCopied < available; i++) {
+        gsize copyLength = MIN(iov[i].iov_len, available - numCopied);
+        numCopied += bytequeue_push(channel->buffer, iov[i].iov_base, copyLength);
+    }
     channel->bufferLength += numCopied;
 
     /* we just got some data in our buffer */
@@ -70,7 +73,7 @@ static gssize channel_linkedWrite(Channel* channel, gconstpointer buffer, gsize
     return (gssize)numCopied;
 }
 
-static gssize channel_sendUserData(Channel* channel, gconstpointer buffer, gsize nBytes, in_addr_t ip, in_port_t port) {
+static gssize channel_sendUserData(Channel* channel, const struct iovec* iov, gint iovcnt, in_addr_t ip, in_port_t port) {
     MAGIC_ASSERT(channel);
     /* the read end of a unidirectional pipe can not write! */
     utility_assert(channel->type != CT_READONLY);
@@ -78,7 +81,7 @@ static gssize channel_sendUserData(Channel* channel, gconstpointer buffer, gsize
     gssize result = 0;
 
     if(channel->linkedChannel) {
-        result = channel_linkedWrite(channel->linkedChannel, buffer, nBytes);
+        result = channel_linkedWrite(channel->linkedChannel, iov, iovcnt);
     } else {
         /* the other end closed or doesn't exist */
         result = -1;
@@ -93,7 +96,7 @@ static gssize channel_sendUserData(Channel* channel, gconstpointer buffer, gsize
     return result;
 }
 
-static gssize channel_receiveUserData(Channel* channel, gpointer buffer, gsize nBytes, in_addr_t* ip, in_port_t* port) {
+static gssize channel_receiveUserData(Channel* channel, const struct iovec* iov, gint iovcnt, in_addr_t* ip, in_port_t* port, gboolean* isTruncated) {
     MAGIC_ASSERT(channel);
     /* the write end of a unidirectional pipe can not read! */
     utility_assert(channel->type != CT_WRITEONLY);
@@ -110,9 +113,12 @@ static gssize channel_receiveUserData(Channel* channel, gpointer buffer, gsize n
         }
     }
 
-    /* accept some data from the other end of the pipe */
-    gsize copyLength = MIN(nBytes, available);
-    gsize numCopied = bytequeue_pop(channel->buffer, buffer, copyLength);
+    /* hand out some data from the other end of the pipe */
+    gsize numCopied = 0;
+    for(gint i = 0; i < iovcnt && numCopied < available; i++) {
+        gsize copyLength = MIN(iov[i].iov_len, available - numCopied);
+        numCopied += bytequeue_pop(channel->buffer, iov[i].iov_base, copyLength);
+    }
     channel->bufferLength -= numCopied;
 
     /* we are no longer readable if we have nothing left */
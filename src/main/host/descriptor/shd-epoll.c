@@ -48,6 +48,8 @@ struct _EpollWatch {
     struct epoll_event event;
     /* current status of the underlying shadow descriptor */
     EpollWatchFlags flags;
+    /* intrusive link into the epoll ready list; data is non-NULL while linked */
+    GList readyLink;
     gint referenceCount;
     MAGIC_DECLARE;
 };
@@ -74,9 +76,15 @@ struct _Epoll {
 
     /* holds the wrappers for the descriptors we are watching for events */
     GHashTable* watching;
+    /* the subset of watches that currently have reportable events. watches join and
+     * leave as their status is updated, so collecting events costs O(ready) */
+    GQueue ready;
 
     Process* ownerProcess;
     gint osEpollDescriptor;
+    /* number of OS file descriptors registered on osEpollDescriptor; we skip
+     * polling the OS when there are none */
+    gint osDescriptorCount;
 
     MAGIC_DECLARE;
 };
@@ -122,10 +130,25 @@ static void _epollwatch_unref(EpollWatch* watch) {
     }
 }
 
+static void _epoll_unlinkReady(Epoll* epoll, EpollWatch* watch) {
+    MAGIC_ASSERT(epoll);
+    MAGIC_ASSERT(watch);
+
+    if(watch->readyLink.data != NULL) {
+        g_queue_unlink(&(epoll->ready), &(watch->readyLink));
+        watch->readyLink.data = NULL;
+    }
+}
+
 /* should only be called from descriptor dereferencing the functionTable */
 static void _epoll_free(Epoll* epoll) {
     MAGIC_ASSERT(epoll);
 
+    /* the ready links live inside the watches, so drop them before the watches go away */
+    while(!g_queue_is_empty(&(epoll->ready))) {
+        _epoll_unlinkReady(epoll, g_queue_peek_head(&(epoll->ready)));
+    }
+
     /* this unrefs all of the remaining watches */
     g_hash_table_destroy(epoll->watching);
 
@@ -191,6 +214,7 @@ Epoll* epoll_new(gint handle) {
 
     /* allocate backend needed for managing events for this descriptor */
     epoll->watching = g_hash_table_new_full(g_int_hash, g_int_equal, NULL, (GDestroyNotify)_epollwatch_unref);
+    g_queue_init(&(epoll->ready));
 
     /* the application may want us to watch some system files, so we need a
      * real OS epoll fd so we can offload that task.
@@ -293,11 +317,28 @@ static gboolean _epollwatch_isReady(EpollWatch* watch) {
     return isReady;
 }
 
+/* re-evaluate a single watch and move it onto or off of the ready list.
+ * this must be called whenever the watch status or its event mask may have changed. */
+static void _epoll_updateReady(Epoll* epoll, EpollWatch* watch) {
+    MAGIC_ASSERT(epoll);
+    MAGIC_ASSERT(watch);
+
+    if(_epollwatch_isReady(watch)) {
+        if(watch->readyLink.data == NULL) {
+            watch->readyLink.data = watch;
+            g_queue_push_tail_link(&(epoll->ready), &(watch->readyLink));
+        }
+    } else {
+        _epoll_unlinkReady(epoll, watch);
+    }
+}
+
 static gboolean _epoll_isReadyOS(Epoll* epoll) {
     MAGIC_ASSERT(epoll);
     gboolean isReady = FALSE;
 
-    if(epoll->osEpollDescriptor >= 3) {
+    /* avoid the syscalls entirely if the application never gave us OS descriptors */
+    if(epoll->osEpollDescriptor >= 3 && epoll->osDescriptorCount > 0) {
         /* the os epoll will be readable when ready */
         struct epoll_event epoll_ev;
         memset(&epoll_ev, 0, sizeof(struct epoll_event));
@@ -333,21 +374,9 @@ static void _epoll_check(Epoll* epoll) {
         return;
     }
 
-    /* check status to see if we need to schedule a notification */
-    gboolean isReady = FALSE;
-
-    /* check all of our children */
-    GHashTableIter iter;
-    gpointer key, value;
-    g_hash_table_iter_init(&iter, epoll->watching);
-    while(g_hash_table_iter_next(&iter, &key, &value)) {
-        EpollWatch* watch = value;
-        MAGIC_ASSERT(watch);
-
-        if(_epollwatch_isReady(watch)) {
-            isReady = TRUE;
-        }
-    }
+    /* check status to see if we need to schedule a notification.
+     * the ready list is kept current as our children change status. */
+    gboolean isReady = g_queue_is_empty(&(epoll->ready)) ? FALSE : TRUE;
 
     /* check for events on the OS epoll instance, but only if we are otherwise not ready */
     if(!isReady && _epoll_isReadyOS(epoll)) {
@@ -361,13 +390,10 @@ static void _epoll_check(Epoll* epoll) {
         /* schedule a notification event for our node, if wanted and one isnt already scheduled */
         if(!(epoll->flags & EF_SCHEDULED) && process_wantsNotify(epoll->ownerProcess, epoll->super.handle)) {
             descriptor_ref(epoll);
-            Task* notifyTask = task_new((TaskCallbackFunc)_epoll_tryNotify,
-                    epoll, NULL, descriptor_unref, NULL);
-
-            if(worker_scheduleTask(notifyTask, 1)) {
+            if(worker_scheduleCallback((TaskCallbackFunc)_epoll_tryNotify,
+                    epoll, NULL, descriptor_unref, NULL, 1)) {
                 epoll->flags |= EF_SCHEDULED;
             }
-            task_unref(notifyTask);
         }
     } else {
         descriptor_adjustStatus(&(epoll->super), DS_READABLE, FALSE);
@@ -410,6 +436,7 @@ gint epoll_control(Epoll* epoll, gint operation, Descriptor* descriptor, struct
 
             /* its added, so we need to listen for changes */
             descriptor_addEpollListener(watch->descriptor, (Descriptor*)epoll);
+            _epoll_updateReady(epoll, watch);
 
             /* initiate a callback if the new watched descriptor is ready */
             _epoll_check(epoll);
@@ -431,6 +458,7 @@ gint epoll_control(Epoll* epoll, gint operation, Descriptor* descriptor, struct
             /* we would need to report the new event again if in ET or ONESHOT modes */
             watch->flags &= ~EWF_EDGETRIGGER_REPORTED;
             watch->flags &= ~EWF_ONESHOT_REPORTED;
+            _epoll_updateReady(epoll, watch);
 
             /* initiate a callback if the new event type on the watched descriptor is ready */
             _epoll_check(epoll);
@@ -449,6 +477,7 @@ gint epoll_control(Epoll* epoll, gint operation, Descriptor* descriptor, struct
 
             /* its deleted, so stop listening for updates */
             descriptor_removeEpollListener(watch->descriptor, (Descriptor*)epoll);
+            _epoll_unlinkReady(epoll, watch);
 
             /* unref gets called on the watch when it is removed from this table */
             g_hash_table_remove(epoll->watching, descriptor_getHandleReference(watch->descriptor));
@@ -472,6 +501,10 @@ gint epoll_controlOS(Epoll* epoll, gint operation, gint fileDescriptor,
     gint ret = epoll_ctl(epoll->osEpollDescriptor, operation, fileDescriptor, event);
     if(ret < 0) {
         ret = errno;
+    } else if(operation == EPOLL_CTL_ADD) {
+        epoll->osDescriptorCount++;
+    } else if(operation == EPOLL_CTL_DEL) {
+        epoll->osDescriptorCount--;
     }
     return ret;
 }
@@ -484,12 +517,14 @@ gint epoll_getEvents(Epoll* epoll, struct epoll_event* eventArray, gint eventArr
      * overflow. the number of actual events is returned in nEvents. */
     gint eventIndex = 0;
 
-    GHashTableIter iter;
-    gpointer key, value;
-    g_hash_table_iter_init(&iter, epoll->watching);
-    while(g_hash_table_iter_next(&iter, &key, &value) && (eventIndex < eventArrayLength)) {
-        EpollWatch* watch = value;
+    /* visit each ready watch at most once. watches that are still ready after
+     * reporting (level-triggered) rotate to the back so that a small event
+     * array does not starve the rest of the list. */
+    guint numToVisit = g_queue_get_length(&(epoll->ready));
+    for(guint i = 0; i < numToVisit && eventIndex < eventArrayLength; i++) {
+        EpollWatch* watch = g_queue_peek_head(&(epoll->ready));
         MAGIC_ASSERT(watch);
+        _epoll_unlinkReady(epoll, watch);
 
         if(_epollwatch_isReady(watch)) {
             /* report the event */
@@ -522,10 +557,12 @@ gint epoll_getEvents(Epoll* epoll, struct epoll_event* eventArray, gint eventArr
                 watch->flags |= EWF_ONESHOT_REPORTED;
             }
         }
+
+        _epoll_updateReady(epoll, watch);
     }
 
     gint space = eventArrayLength - eventIndex;
-    if(space) {
+    if(space > 0 && epoll->osDescriptorCount > 0) {
         /* now we have to get events from the OS descriptors */
         struct epoll_event osEvents[space];
         memset(&osEvents, 0, space*sizeof(struct epoll_event));
@@ -567,6 +604,9 @@ void epoll_descriptorStatusChanged(Epoll* epoll, Descriptor* descriptor) {
 
     debug("status changed in epoll %i for descriptor %i", epoll->super.handle, descriptor->handle);
 
+    /* only this watch could have changed readiness */
+    _epoll_updateReady(epoll, watch);
+
     /* check the status and take the appropriate action */
     _epoll_check(epoll);
 }
@@ -608,18 +648,7 @@ static void _epoll_tryNotify(Epoll* epoll, gpointer userData) {
     }
 
     /* we should notify the plugin only if we still have some events to report */
-    gboolean isReady = FALSE;
-    GHashTableIter iter;
-    gpointer key, value;
-    g_hash_table_iter_init(&iter, epoll->watching);
-    while(g_hash_table_iter_next(&iter, &key, &value)) {
-        EpollWatch* watch = value;
-        MAGIC_ASSERT(watch);
-
-        if(_epollwatch_isReady(watch)) {
-            isReady = TRUE;
-        }
-    }
+    gboolean isReady = g_queue_is_empty(&(epoll->ready)) ? FALSE : TRUE;
 
     /* check if there is events on the OS epoll instance, but only if we would otherwise
      * not call the process. this ensures the process can collect events for which we are
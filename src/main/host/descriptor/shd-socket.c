@@ -47,18 +47,18 @@ void socket_close(Socket* socket) {
     socket->vtable->close((Descriptor*)socket);
 }
 
-gssize socket_sendUserData(Socket* socket, gconstpointer buffer, gsize nBytes,
+gssize socket_sendUserData(Socket* socket, const struct iovec* iov, gint iovcnt,
         in_addr_t ip, in_port_t port) {
     MAGIC_ASSERT(socket);
     MAGIC_ASSERT(socket->vtable);
-    return socket->vtable->send((Transport*)socket, buffer, nBytes, ip, port);
+    return socket->vtable->send((Transport*)socket, iov, iovcnt, ip, port);
 }
 
-gssize socket_receiveUserData(Socket* socket, gpointer buffer, gsize nBytes,
-        in_addr_t* ip, in_port_t* port) {
+gssize socket_receiveUserData(Socket* socket, const struct iovec* iov, gint iovcnt,
+        in_addr_t* ip, in_port_t* port, gboolean* isTruncated) {
     MAGIC_ASSERT(socket);
     MAGIC_ASSERT(socket->vtable);
-    return socket->vtable->receive((Transport*)socket, buffer, nBytes, ip, port);
+    return socket->vtable->receive((Transport*)socket, iov, iovcnt, ip, port, isTruncated);
 }
 
 TransportFunctionTable socket_functions = {
@@ -29,8 +29,10 @@ struct _ScoreBoardBlock {
 };
 
 struct _ScoreBoard {
-    /* list of blocks in the scoreboard */
-    GQueue* blocksQ;
+    /* blocks in the scoreboard, indexed by sequence */
+    SequenceRing* blocks;
+    /* number of blocks currently in the LOST state */
+    guint numLost;
 
     /* the furthest SACKed sequence number */
     gint fack;
@@ -57,18 +59,6 @@ static ScoreBoardBlock* _scoreboardblock_new(gint sequence, BlockStatus status)
     return block;
 }
 
-static gint _scoreboardblock_compareStatus(ScoreBoardBlock* block1, ScoreBoardBlock* block2) {
-    return (block1->status < block2->status ? -1 : block1->status > block2->status ? 1 : 0);
-}
-
-static gint _scoreboardblock_compareSequence(ScoreBoardBlock* block1, ScoreBoardBlock* block2) {
-    return (block1->sequence < block2->sequence ? -1 : block1->sequence > block2->sequence ? 1 : 0);
-}
-
-static gint _scoreboardblock_compareSequenceData(ScoreBoardBlock* block1, ScoreBoardBlock* block2, gpointer userData) {
-    return _scoreboardblock_compareSequence(block1, block2);
-}
-
 static void _scoreboardblock_free(ScoreBoardBlock* block) {
     MAGIC_ASSERT(block);
     MAGIC_CLEAR(block);
@@ -79,7 +69,7 @@ ScoreBoard* scoreboard_new() {
     ScoreBoard* scoreboard = g_new0(ScoreBoard, 1);
     MAGIC_INIT(scoreboard);
 
-    scoreboard->blocksQ = g_queue_new();
+    scoreboard->blocks = sequencering_new(CONFIG_TCP_MAX_WINDOW_PACKETS, (GDestroyNotify)_scoreboardblock_free);
 
     return scoreboard;
 }
@@ -91,39 +81,60 @@ void scoreboard_clear(ScoreBoard* scoreboard) {
     scoreboard->ackedRetransmissionId = -1;
     scoreboard->fack = 0;
     scoreboard->fackOut = 0;
+    scoreboard->numLost = 0;
 
-    /* reset the blocks queue */
-    if(scoreboard->blocksQ) {
-        g_queue_free_full(scoreboard->blocksQ, (GDestroyNotify)_scoreboardblock_free);
-        scoreboard->blocksQ = g_queue_new();
-    }
+    /* reset the blocks */
+    sequencering_clear(scoreboard->blocks);
 }
 
 void scoreboard_free(ScoreBoard* scoreboard) {
     MAGIC_ASSERT(scoreboard);
     scoreboard_clear(scoreboard);
-    g_queue_free(scoreboard->blocksQ);
+    sequencering_free(scoreboard->blocks);
     MAGIC_CLEAR(scoreboard);
     g_free(scoreboard);
 }
 
+static ScoreBoardBlock* _scoreboard_findBlock(ScoreBoard* scoreboard, gint sequence) {
+    MAGIC_ASSERT(scoreboard);
+    if(sequence < 0) {
+        return NULL;
+    }
+    return sequencering_lookup(scoreboard->blocks, (guint)sequence);
+}
+
 static ScoreBoardBlock* _scoreboard_addBlock(ScoreBoard* scoreboard, gint sequence, BlockStatus status) {
     MAGIC_ASSERT(scoreboard);
 
     ScoreBoardBlock* block = _scoreboardblock_new(sequence, status);
-    g_queue_insert_sorted(scoreboard->blocksQ, block, (GCompareDataFunc) _scoreboardblock_compareSequenceData, NULL);
+    if(!sequencering_insert(scoreboard->blocks, (guint)sequence, block)) {
+        _scoreboardblock_free(block);
+        ScoreBoardBlock* existing = _scoreboard_findBlock(scoreboard, sequence);
+        if(existing) {
+            warning("block for sequence %d already exists in the scoreboard", sequence);
+        } else {
+            warning("block for sequence %d is outside of the send window", sequence);
+        }
+        return existing;
+    }
+
+    if(status == BLOCK_STATUS_LOST) {
+        scoreboard->numLost++;
+    }
 
     return block;
 }
 
-static ScoreBoardBlock* _scoreboard_findBlock(ScoreBoard* scoreboard, gint sequence) {
+static void _scoreboard_setStatus(ScoreBoard* scoreboard, ScoreBoardBlock* block, BlockStatus status) {
     MAGIC_ASSERT(scoreboard);
+    MAGIC_ASSERT(block);
 
-    ScoreBoardBlock b;
-    b.sequence = sequence;
-    GList* link = g_queue_find_custom(scoreboard->blocksQ, &b, (GCompareFunc)_scoreboardblock_compareSequence);
-
-    return link ? (ScoreBoardBlock*)link->data : NULL;
+    if(block->status == BLOCK_STATUS_LOST && status != BLOCK_STATUS_LOST) {
+        scoreboard->numLost--;
+    } else if(block->status != BLOCK_STATUS_LOST && status == BLOCK_STATUS_LOST) {
+        scoreboard->numLost++;
+    }
+    block->status = status;
 }
 
 static gchar* _scoreboard_getStatusString(BlockStatus status) {
@@ -149,7 +160,7 @@ static void _scoreboard_dump(ScoreBoard* scoreboard) {
 
     GString* msg = g_string_new("");
     g_string_append_printf(msg, "[SCOREBOARD] fack=%d ackRtx=%d |", scoreboard->fack, scoreboard->ackedRetransmissionId);
-    g_queue_foreach(scoreboard->blocksQ, (GFunc)_scoreboardblock_appendString, msg);
+    sequencering_foreach(scoreboard->blocks, (GFunc)_scoreboardblock_appendString, msg);
 
     message("%s", msg->str);
     g_string_free(msg, TRUE);
@@ -164,24 +175,18 @@ static gint _scoreboard_compareSack(gconstpointer s1, gconstpointer s2) {
 static void _scoreboard_removeAcked(ScoreBoard* scoreboard, gint32 unacked) {
     MAGIC_ASSERT(scoreboard);
 
-    /* reconstruct the blocks queue to avoid editing it in-place */
-    GQueue* updatedBlocksQ = g_queue_new();
+    if(unacked <= 0) {
+        return;
+    }
 
-    /* keep all blocks that have not been fully ACKed */
-    while(!g_queue_is_empty(scoreboard->blocksQ)) {
-        ScoreBoardBlock* block = g_queue_pop_head(scoreboard->blocksQ);
-        if(block->sequence < ((gint)unacked)) {
-            /* the block has been acked, destroy it */
-            _scoreboardblock_free(block);
-        } else {
-            /* the block has not yet been acked, keep it */
-            g_queue_push_tail(updatedBlocksQ, block);
+    /* blocks are ordered by sequence, so we only touch the ones that were acked */
+    ScoreBoardBlock* block = NULL;
+    while((block = sequencering_stealLowestBefore(scoreboard->blocks, (guint)unacked)) != NULL) {
+        if(block->status == BLOCK_STATUS_LOST) {
+            scoreboard->numLost--;
         }
+        _scoreboardblock_free(block);
     }
-
-    /* clean up the old blocks queue */
-    g_queue_free(scoreboard->blocksQ);
-    scoreboard->blocksQ = updatedBlocksQ;
 }
 
 TCPProcessFlags scoreboard_update(ScoreBoard* scoreboard, GList* selectiveACKs, gint32 unacked, gint32 next) {
@@ -202,10 +207,14 @@ TCPProcessFlags scoreboard_update(ScoreBoard* scoreboard, GList* selectiveACKs,
         }
         scoreboard->fack = MAX(scoreboard->fack, lastSeq);
 
-        /* go through all sequence that might be sacked and update scoreboard */
+        /* go through all sequence that might be sacked and update scoreboard.
+         * the sacks are sorted, so we walk them alongside the sequence */
+        GList* sackLink = selectiveACKs;
         for(gint seq = firstSeq; seq <= lastSeq; seq++) {
-            GList* findResult = g_list_find(selectiveACKs, GINT_TO_POINTER(seq));
-            gboolean sacked = findResult ? TRUE : FALSE;
+            while(sackLink && GPOINTER_TO_INT(sackLink->data) < seq) {
+                sackLink = g_list_next(sackLink);
+            }
+            gboolean sacked = (sackLink && GPOINTER_TO_INT(sackLink->data) == seq) ? TRUE : FALSE;
             BlockStatus status = (sacked ? BLOCK_STATUS_SACKED : BLOCK_STATUS_INFLIGHT);
 
             ScoreBoardBlock* block = _scoreboard_findBlock(scoreboard, seq);
@@ -216,7 +225,7 @@ TCPProcessFlags scoreboard_update(ScoreBoard* scoreboard, GList* selectiveACKs,
                 if(block->status == BLOCK_STATUS_RETRANSMITTED) {
                     scoreboard->ackedRetransmissionId = block->retransmissionId;
                 }
-                block->status = status;
+                _scoreboard_setStatus(scoreboard, block, status);
             }
         }
     }
@@ -230,8 +239,10 @@ TCPProcessFlags scoreboard_update(ScoreBoard* scoreboard, GList* selectiveACKs,
     scoreboard->lastAcknowledgment = unacked;
 
     /* go through all the blocks and check if any of the INFLIGHT ones need to be retransmitted */
-    for(guint i = 0; i < g_queue_get_length(scoreboard->blocksQ); i++) {
-        ScoreBoardBlock* block = (ScoreBoardBlock*)g_queue_peek_nth(scoreboard->blocksQ, i);
+    ScoreBoardBlock* lowest = sequencering_peekLowest(scoreboard->blocks);
+    ScoreBoardBlock* highest = sequencering_peekHighest(scoreboard->blocks);
+    for(gint seq = lowest ? lowest->sequence : 0; lowest && seq <= highest->sequence; seq++) {
+        ScoreBoardBlock* block = _scoreboard_findBlock(scoreboard, seq);
         if(!block) continue;
 
         switch(block->status) {
@@ -239,7 +250,7 @@ TCPProcessFlags scoreboard_update(ScoreBoard* scoreboard, GList* selectiveACKs,
                 /* checks for 3 duplicate ACKs */
                 if(block->sequence <= scoreboard->fack - 4 || 
                    (block->sequence == scoreboard->lastAcknowledgment && scoreboard->duplicateACKCount == 3)) {
-                    block->status = BLOCK_STATUS_LOST;
+                    _scoreboard_setStatus(scoreboard, block, BLOCK_STATUS_LOST);
                     scoreboard->fackOut += 1;
                     flag |= TCP_PF_DATA_LOST;
                 }
@@ -248,7 +259,7 @@ TCPProcessFlags scoreboard_update(ScoreBoard* scoreboard, GList* selectiveACKs,
             case BLOCK_STATUS_RETRANSMITTED:
                 if((block->nextSend <= scoreboard->fack) ||
                    (block->retransmissionId + 4 < scoreboard->ackedRetransmissionId)) {
-                    block->status = BLOCK_STATUS_LOST;
+                    _scoreboard_setStatus(scoreboard, block, BLOCK_STATUS_LOST);
                     scoreboard->fackOut += 1;
                     flag |= TCP_PF_DATA_LOST;
                 }
@@ -271,11 +282,21 @@ TCPProcessFlags scoreboard_update(ScoreBoard* scoreboard, GList* selectiveACKs,
 gint scoreboard_getNextRetransmit(ScoreBoard* scoreboard) {
     MAGIC_ASSERT(scoreboard);
 
-    ScoreBoardBlock b;
-    b.status = BLOCK_STATUS_LOST;
-    GList* link = g_queue_find_custom(scoreboard->blocksQ, &b, (GCompareFunc)_scoreboardblock_compareStatus);
+    /* this is checked on every flush, so avoid the scan when nothing is lost */
+    if(scoreboard->numLost == 0) {
+        return -1;
+    }
+
+    ScoreBoardBlock* lowest = sequencering_peekLowest(scoreboard->blocks);
+    ScoreBoardBlock* highest = sequencering_peekHighest(scoreboard->blocks);
+    for(gint seq = lowest->sequence; seq <= highest->sequence; seq++) {
+        ScoreBoardBlock* block = _scoreboard_findBlock(scoreboard, seq);
+        if(block && block->status == BLOCK_STATUS_LOST) {
+            return seq;
+        }
+    }
 
-    return link ? ((ScoreBoardBlock*)(link->data))->sequence : -1;
+    return -1;
 }
 
 void scoreboard_markRetransmitted(ScoreBoard* scoreboard, gint sequence, gint nextSend) {
@@ -292,7 +313,7 @@ void scoreboard_markRetransmitted(ScoreBoard* scoreboard, gint sequence, gint ne
         warning("fack out is negative at %d with sequence %d and next send %d", scoreboard->fackOut, sequence, nextSend);
     }
 
-    block->status = BLOCK_STATUS_RETRANSMITTED;
+    _scoreboard_setStatus(scoreboard, block, BLOCK_STATUS_RETRANSMITTED);
     block->nextSend = nextSend;
     block->retransmissionId = scoreboard->retransmissionId;
     scoreboard->retransmissionId++;
@@ -306,11 +327,11 @@ void scoreboard_packetDropped(ScoreBoard* scoreboard, gint sequence) {
         block = _scoreboard_addBlock(scoreboard, sequence, BLOCK_STATUS_INFLIGHT);
     }
 
-    if(block->status != BLOCK_STATUS_INFLIGHT) {
+    if(!block || block->status != BLOCK_STATUS_INFLIGHT) {
         return;
     }
 
-    block->status = BLOCK_STATUS_LOST;
+    _scoreboard_setStatus(scoreboard, block, BLOCK_STATUS_LOST);
 
     scoreboard->fackOut++;
 }
@@ -322,19 +343,19 @@ static void _scoreboard_markLossHelper(ScoreBoardBlock* block, ScoreBoard* score
         if(block->status != BLOCK_STATUS_LOST) {
             scoreboard->fackOut += 1;
         }
-        block->status = BLOCK_STATUS_LOST;
+        _scoreboard_setStatus(scoreboard, block, BLOCK_STATUS_LOST);
     }
 }
 
 void scoreboard_markLoss(ScoreBoard* scoreboard, gint unacked, gint nextSend) {
     MAGIC_ASSERT(scoreboard);
 
-    g_queue_foreach(scoreboard->blocksQ, (GFunc)_scoreboard_markLossHelper, scoreboard);
+    sequencering_foreach(scoreboard->blocks, (GFunc)_scoreboard_markLossHelper, scoreboard);
 
     gint start = unacked;
     BlockStatus status = BLOCK_STATUS_LOST;
-    if(!g_queue_is_empty(scoreboard->blocksQ)) {
-        ScoreBoardBlock* block = g_queue_peek_tail(scoreboard->blocksQ);
+    if(!sequencering_isEmpty(scoreboard->blocks)) {
+        ScoreBoardBlock* block = sequencering_peekHighest(scoreboard->blocks);
         start = block->sequence + 1;
         status = BLOCK_STATUS_INFLIGHT;
     }
@@ -132,16 +132,15 @@ struct _TCP {
     } send;
 
     struct {
-        /* TCP provides reliable transport, keep track of packets until they are acked */
-        GHashTable* queue;
+        /* TCP provides reliable transport, keep track of packets until they are acked.
+         * packets are indexed by sequence so acks drain the queue from the front */
+        SequenceRing* queue;
         /* track amount of queued application data */
         gsize queueLength;
         /* retransmission timeout value (rto), in milliseconds */
         gint timeout;
-        /* when the scheduled timer events will expire; empty if no retransmit is scheduled */
-        PriorityQueue* scheduledTimerExpirations;
-        /* our updated expiration time, to determine if previous events are still valid */
-        SimulationTime desiredTimerExpiration;
+        /* the retransmission timer, armed while we have unacknowledged data */
+        WheelTimer timer;
         /* number of times we backed off due to congestion */
         guint backoffCount;
 
@@ -192,6 +191,9 @@ struct _TCP {
     /* if I am a multiplexed child, I have a pointer to my parent */
     TCPChild* child;
 
+    /* finishes the closing process from the LASTACK and TIMEWAIT states */
+    WheelTimer closeTimer;
+
     MAGIC_DECLARE;
 };
 
@@ -504,12 +506,11 @@ static void _tcp_setState(TCP* tcp, enum TCPState state) {
         }
         case TCPS_LASTACK:
         case TCPS_TIMEWAIT: {
-            /* schedule a close timer self-event to finish out the closing process */
-            descriptor_ref(tcp);
-            Task* closeTask = task_new((TaskCallbackFunc)_tcp_runCloseTimerExpiredTask,
-                    tcp, NULL, descriptor_unref, NULL);
-            worker_scheduleTask(closeTask, CONFIG_TCPCLOSETIMER_DELAY);
-            task_unref(closeTask);
+            /* start the close timer to finish out the closing process */
+            if(!wheeltimer_isArmed(&(tcp->closeTimer))) {
+                timerwheel_arm(host_getTimerWheel(worker_getActiveHost()), &(tcp->closeTimer),
+                        worker_getCurrentTime() + CONFIG_TCPCLOSETIMER_DELAY);
+            }
             break;
         }
         default:
@@ -659,7 +660,7 @@ static void _tcp_updateReceiveWindow(TCP* tcp) {
     //gsize space = _tcp_getBufferSpaceIn(tcp); // causes throughput problems
     gsize space = socket_getInputBufferSpace(&(tcp->super));
     gsize nPackets = space / (CONFIG_MTU - CONFIG_HEADER_SIZE_TCPIPETH);
-    tcp->receive.window = nPackets;
+    tcp->receive.window = (guint32)MIN(nPackets, (gsize)CONFIG_TCP_MAX_WINDOW_PACKETS);
 
     /* handle window updates */
     if(tcp->receive.window == 0) {
@@ -680,7 +681,8 @@ static void _tcp_updateSendWindow(TCP* tcp) {
     tcp->send.window = (guint32)MIN(tcp->congestion->window, (gint)tcp->receive.lastWindow);
 }
 
-static Packet* _tcp_createPacket(TCP* tcp, enum ProtocolTCPFlags flags, gconstpointer payload, gsize payloadLength) {
+/* payload is gathered from the cursor, which is NULL for control packets */
+static Packet* _tcp_createPacket(TCP* tcp, enum ProtocolTCPFlags flags, IOVecCursor* payload, gsize payloadLength) {
     MAGIC_ASSERT(tcp);
 
     /*
@@ -713,7 +715,7 @@ static Packet* _tcp_createPacket(TCP* tcp, enum ProtocolTCPFlags flags, gconstpo
     guint sequence = payloadLength > 0 || isFinNotAck ? tcp->send.next : 0;
 
     /* create the TCP packet. the ack, window, and timestamps will be set in _tcp_flush */
-    Packet* packet = packet_new(payload, payloadLength);
+    Packet* packet = packet_newFromIOVec(payload, payloadLength);
     packet_setDropNotificationDelay(packet, (tcp->congestion->rttSmoothed * 2) * SIMTIME_ONE_MILLISECOND);
     packet_setTCP(packet, flags, sourceIP, sourcePort, destinationIP, destinationPort, sequence);
     packet_addDeliveryStatus(packet, PDS_SND_CREATED);
@@ -731,12 +733,10 @@ static void _tcp_addRetransmit(TCP* tcp, Packet* packet) {
 
     PacketTCPHeader header;
     packet_getTCPHeader(packet, &header);
-    gpointer key = GINT_TO_POINTER(header.sequence);
 
     /* if it is already in the queue, it won't consume another packet reference */
-    if(g_hash_table_lookup(tcp->retransmit.queue, key) == NULL) {
+    if(sequencering_insert(tcp->retransmit.queue, (guint)header.sequence, packet)) {
         /* its not in the queue yet */
-        g_hash_table_insert(tcp->retransmit.queue, key, packet);
         packet_ref(packet);
 
         packet_addDeliveryStatus(packet, PDS_SND_TCP_ENQUEUE_RETRANSMIT);
@@ -745,6 +745,9 @@ static void _tcp_addRetransmit(TCP* tcp, Packet* packet) {
         if(_tcp_getBufferSpaceOut(tcp) == 0) {
             descriptor_adjustStatus((Descriptor*)tcp, DS_WRITABLE, FALSE);
         }
+    } else {
+        /* we only send inside the window, so the queue never refuses a packet for being too far out */
+        utility_assert(sequencering_lookup(tcp->retransmit.queue, (guint)header.sequence) != NULL);
     }
 }
 
@@ -752,19 +755,12 @@ static void _tcp_addRetransmit(TCP* tcp, Packet* packet) {
 static void _tcp_clearRetransmit(TCP* tcp, guint sequence) {
     MAGIC_ASSERT(tcp);
 
-    GHashTableIter iter;
-    gpointer key, value;
-    g_hash_table_iter_init(&iter, tcp->retransmit.queue);
-
-    while(g_hash_table_iter_next(&iter, &key, &value)) {
-        guint ackedSequence = GPOINTER_TO_INT(key);
-        Packet* ackedPacket = (Packet*)value;
-
-        if(ackedSequence < sequence) {
-            tcp->retransmit.queueLength -= packet_getPayloadLength(ackedPacket);
-            packet_addDeliveryStatus(ackedPacket, PDS_SND_TCP_DEQUEUE_RETRANSMIT);
-            g_hash_table_iter_remove(&iter);
-        }
+    /* the queue is ordered by sequence, so we only touch the packets being acked */
+    Packet* ackedPacket = NULL;
+    while((ackedPacket = sequencering_stealLowestBefore(tcp->retransmit.queue, sequence)) != NULL) {
+        tcp->retransmit.queueLength -= packet_getPayloadLength(ackedPacket);
+        packet_addDeliveryStatus(ackedPacket, PDS_SND_TCP_DEQUEUE_RETRANSMIT);
+        packet_unref(ackedPacket);
     }
 
     if(_tcp_getBufferSpaceOut(tcp) > 0) {
@@ -772,64 +768,25 @@ static void _tcp_clearRetransmit(TCP* tcp, guint sequence) {
     }
 }
 
-// XXX forward declaration
-static void _tcp_runRetransmitTimerExpiredTask(TCP* tcp, gpointer userData);
-
-static void _tcp_scheduleRetransmitTimer(TCP* tcp, SimulationTime now, SimulationTime delay) {
-    MAGIC_ASSERT(tcp);
-
-    SimulationTime* expireTimePtr = g_new0(SimulationTime, 1);
-    *expireTimePtr = now + delay;
-    gboolean success = priorityqueue_push(tcp->retransmit.scheduledTimerExpirations, expireTimePtr);
-
-    if(success) {
-        descriptor_ref(tcp);
-        Task* retexpTask = task_new((TaskCallbackFunc)_tcp_runRetransmitTimerExpiredTask,
-                tcp, NULL, descriptor_unref, NULL);
-        worker_scheduleTask(retexpTask, delay);
-        task_unref(retexpTask);
-
-        debug("%s retransmit timer scheduled for %"G_GUINT64_FORMAT" ns",
-                tcp->super.boundString, *expireTimePtr);
-    } else {
-        warning("%s could not schedule a retransmit timer for %"G_GUINT64_FORMAT" ns",
-                tcp->super.boundString, *expireTimePtr);
-        g_free(expireTimePtr);
-    }
-}
-
-static void _tcp_scheduleRetransmitTimerIfNeeded(TCP* tcp, SimulationTime now) {
-    /* logic for scheduling retransmission events. we only need to schedule one if
-     * we have no events that will allow us to schedule one later. */
-    SimulationTime* nextTimePtr = priorityqueue_peek(tcp->retransmit.scheduledTimerExpirations);
-    if(nextTimePtr && *nextTimePtr <= tcp->retransmit.desiredTimerExpiration) {
-        /* another event will fire before the RTO expires, check again then */
-        return;
-    }
-
-    /* no existing timer will expire as early as desired */
-    SimulationTime delay = tcp->retransmit.desiredTimerExpiration - now;
-    _tcp_scheduleRetransmitTimer(tcp, now, delay);
-}
-
 static void _tcp_setRetransmitTimer(TCP* tcp, SimulationTime now) {
     MAGIC_ASSERT(tcp);
 
-    /* our retransmission timer needs to change
-     * track the new expiration time based on the current RTO */
-    SimulationTime delay = tcp->retransmit.timeout * SIMTIME_ONE_MILLISECOND;
-    tcp->retransmit.desiredTimerExpiration = now + delay;
+    /* our retransmission timer needs to change. re-arming only moves the timer
+     * inside the host's timer wheel, so this is cheap even on every ack. */
+    SimulationTime expireTime = now + (tcp->retransmit.timeout * SIMTIME_ONE_MILLISECOND);
+    timerwheel_arm(host_getTimerWheel(worker_getActiveHost()), &(tcp->retransmit.timer), expireTime);
 
-    _tcp_scheduleRetransmitTimerIfNeeded(tcp, now);
+    debug("%s retransmit timer set to expire at %"G_GUINT64_FORMAT" ns",
+            tcp->super.boundString, expireTime);
 }
 
 static void _tcp_stopRetransmitTimer(TCP* tcp) {
     MAGIC_ASSERT(tcp);
-    /* we want to stop the timer. since there may be an event already scheduled,
-     * lets mark our desired time as 0 so we know to cancel when the event fires. */
-    tcp->retransmit.desiredTimerExpiration = 0;
 
-    debug("%s retransmit timer disabled", tcp->super.boundString);
+    if(wheeltimer_isArmed(&(tcp->retransmit.timer))) {
+        timerwheel_disarm(host_getTimerWheel(worker_getActiveHost()), &(tcp->retransmit.timer));
+        debug("%s retransmit timer disabled", tcp->super.boundString);
+    }
 }
 
 static void _tcp_setRetransmitTimeout(TCP* tcp, gint newTimeout) {
@@ -875,7 +832,9 @@ static void _tcp_updateRTTEstimate(TCP* tcp, SimulationTime timestamp) {
 static void _tcp_retransmitPacket(TCP* tcp, gint sequence) {
     MAGIC_ASSERT(tcp);
 
-    Packet* packet = g_hash_table_lookup(tcp->retransmit.queue, GINT_TO_POINTER(sequence));
+    /* remove from queue and update length and status.
+     * calling steal means that the packet ref count is not decremented */
+    Packet* packet = sequencering_steal(tcp->retransmit.queue, (guint)sequence);
     /* if packet wasn't found is was most likely retransmitted from a previous SACK
      * but has yet to be received/acknowledged by the receiver */
     if(!packet) {
@@ -884,10 +843,6 @@ static void _tcp_retransmitPacket(TCP* tcp, gint sequence) {
 
     debug("retransmitting packet %d", sequence);
 
-    /* remove from queue and update length and status.
-     * calling steal means that the packet ref count is not decremented */
-    g_hash_table_steal(tcp->retransmit.queue, GINT_TO_POINTER(sequence));
-
     /* update queue length and status */
     tcp->retransmit.queueLength -= packet_getPayloadLength(packet);
     packet_addDeliveryStatus(packet, PDS_SND_TCP_DEQUEUE_RETRANSMIT);
@@ -899,11 +854,18 @@ static void _tcp_retransmitPacket(TCP* tcp, gint sequence) {
     /* reset retransmit timer since we are resending it now */
     _tcp_setRetransmitTimer(tcp, worker_getCurrentTime());
 
+    /* the receiver may still hold the packet we sent before, and its headers must not
+     * change once sent. we send a copy instead, whose headers we update in _tcp_flush. */
+    Packet* retransmitPacket = packet_copy(packet);
+
     /* queue it for sending */
-    _tcp_bufferPacketOut(tcp, packet);
-    packet_addDeliveryStatus(packet, PDS_SND_TCP_RETRANSMITTED);
+    _tcp_bufferPacketOut(tcp, retransmitPacket);
+    packet_addDeliveryStatus(retransmitPacket, PDS_SND_TCP_RETRANSMITTED);
     tcp->info.retransmitCount++;
 
+    /* the throttled queue holds its own ref to the copy */
+    packet_unref(retransmitPacket);
+
     /* free the ref that we stole */
     packet_unref(packet);
 }
@@ -965,7 +927,7 @@ static void _tcp_flush(TCP* tcp) {
             _tcp_addRetransmit(tcp, packet);
 
             /* start retransmit timer if its not running (rfc 6298, section 5.1) */
-            if(!tcp->retransmit.desiredTimerExpiration) {
+            if(!wheeltimer_isArmed(&(tcp->retransmit.timer))) {
                 _tcp_setRetransmitTimer(tcp, now);
             }
         }
@@ -1068,13 +1030,11 @@ static void _tcp_fastRetransmitAlert(TCP* tcp, TCPProcessFlags flags) {
 static void _tcp_runRetransmitTimerExpiredTask(TCP* tcp, gpointer userData) {
     MAGIC_ASSERT(tcp);
 
-    /* a timer expired, update our timer tracking state */
+    /* the wheel only runs us when the current timer expires, never for a
+     * timer that was reset or stopped in the meantime */
     SimulationTime now = worker_getCurrentTime();
-    SimulationTime* scheduledTimerExpirationPtr = priorityqueue_pop(tcp->retransmit.scheduledTimerExpirations);
-    utility_assert(scheduledTimerExpirationPtr);
-    g_free(scheduledTimerExpirationPtr);
 
-    debug("%s a scheduled retransmit timer expired", tcp->super.boundString);
+    debug("%s the retransmit timer expired", tcp->super.boundString);
 
     /* if we are closed, we don't care */
     if(tcp->state == TCPS_CLOSED) {
@@ -1083,21 +1043,11 @@ static void _tcp_runRetransmitTimerExpiredTask(TCP* tcp, gpointer userData) {
         return;
     }
 
-    if(g_hash_table_size(tcp->retransmit.queue) == 0) {
+    if(sequencering_isEmpty(tcp->retransmit.queue)) {
         _tcp_stopRetransmitTimer(tcp);
         return;
     }
 
-    /* if the timer should be off or was reset, ignore this event */
-    if(tcp->retransmit.desiredTimerExpiration == 0) {
-        return;
-    } else if(tcp->retransmit.desiredTimerExpiration > now) {
-        /* the timer was reset after this event was scheduled, check if we need to
-         * schedule another event, or if we can do it when the next event fires instead */
-        _tcp_scheduleRetransmitTimerIfNeeded(tcp, now);
-        return;
-    }
-
     /* rfc 6298, section 5.4-5.7 (http://tools.ietf.org/html/rfc6298)
      * if we get here, this is a valid timer expiration and we need to do a retransmission
      * do exponential backoff */
@@ -1117,7 +1067,7 @@ static void _tcp_runRetransmitTimerExpiredTask(TCP* tcp, gpointer userData) {
 
     /* resend the next unacked packet */
     gint sequence = (gint)tcp->send.unacked;
-    if(tcp->send.unacked == 1 && g_hash_table_lookup(tcp->retransmit.queue, GINT_TO_POINTER(0))) {
+    if(tcp->send.unacked == 1 && sequencering_lookup(tcp->retransmit.queue, 0)) {
         sequence = 0;
     }
 
@@ -1877,7 +1827,7 @@ static void _tcp_endOfFileSignalled(TCP* tcp) {
     descriptor_adjustStatus(&(tcp->super.super.super), DS_ACTIVE, FALSE);
 }
 
-gssize tcp_sendUserData(TCP* tcp, gconstpointer buffer, gsize nBytes, in_addr_t ip, in_port_t port) {
+gssize tcp_sendUserData(TCP* tcp, const struct iovec* iov, gint iovcnt, in_addr_t ip, in_port_t port) {
     MAGIC_ASSERT(tcp);
 
     /* return 0 to signal close, if necessary */
@@ -1894,20 +1844,22 @@ gssize tcp_sendUserData(TCP* tcp, gconstpointer buffer, gsize nBytes, in_addr_t
     }
 
     /* maximum data we can send network, o/w tcp truncates and only sends 65536*/
-    gsize acceptable = MIN(nBytes, 65535);
+    gsize acceptable = MIN(iovec_getLength(iov, iovcnt), 65535);
     gsize space = _tcp_getBufferSpaceOut(tcp);
     gsize remaining = MIN(acceptable, space);
 
     /* break data into segments and send each in a packet */
     gsize maxPacketLength = CONFIG_MTU - CONFIG_HEADER_SIZE_TCPIPETH;
     gsize bytesCopied = 0;
+    IOVecCursor cursor;
+    iovcursor_init(&cursor, iov, iovcnt);
 
     /* create as many packets as needed */
     while(remaining > 0) {
         gsize copyLength = MIN(maxPacketLength, remaining);
 
-        /* use helper to create the packet */
-        Packet* packet = _tcp_createPacket(tcp, PTCP_ACK, buffer + bytesCopied, copyLength);
+        /* use helper to create the packet, segmenting straight from the iovecs */
+        Packet* packet = _tcp_createPacket(tcp, PTCP_ACK, &cursor, copyLength);
         if(copyLength > 0) {
             /* we are sending more user data */
             tcp->send.end++;
@@ -1948,7 +1900,7 @@ static void _tcp_sendWindowUpdate(TCP* tcp, gpointer data) {
     tcp->receive.windowUpdatePending = FALSE;
 }
 
-gssize tcp_receiveUserData(TCP* tcp, gpointer buffer, gsize nBytes, in_addr_t* ip, in_port_t* port) {
+gssize tcp_receiveUserData(TCP* tcp, const struct iovec* iov, gint iovcnt, in_addr_t* ip, in_port_t* port, gboolean* isTruncated) {
     MAGIC_ASSERT(tcp);
 
     /*
@@ -1962,11 +1914,12 @@ gssize tcp_receiveUserData(TCP* tcp, gpointer buffer, gsize nBytes, in_addr_t* i
     /* make sure we pull in all readable user data */
     _tcp_flush(tcp);
 
-    gsize remaining = nBytes;
+    gsize remaining = iovec_getLength(iov, iovcnt);
     gsize bytesCopied = 0;
     gsize totalCopied = 0;
-    gsize offset = 0;
     gsize copyLength = 0;
+    IOVecCursor cursor;
+    iovcursor_init(&cursor, iov, iovcnt);
 
     /* check if we have a partial packet waiting to get finished */
     if(remaining > 0 && tcp->partialUserDataPacket) {
@@ -1975,10 +1928,9 @@ gssize tcp_receiveUserData(TCP* tcp, gpointer buffer, gsize nBytes, in_addr_t* i
         utility_assert(partialBytes > 0);
 
         copyLength = MIN(partialBytes, remaining);
-        bytesCopied = packet_copyPayload(tcp->partialUserDataPacket, tcp->partialOffset, buffer, copyLength);
+        bytesCopied = packet_copyPayloadToIOVec(tcp->partialUserDataPacket, tcp->partialOffset, &cursor, copyLength);
         totalCopied += bytesCopied;
         remaining -= bytesCopied;
-        offset += bytesCopied;
 
         if(bytesCopied >= partialBytes) {
             /* we finished off the partial packet */
@@ -2009,10 +1961,9 @@ gssize tcp_receiveUserData(TCP* tcp, gpointer buffer, gsize nBytes, in_addr_t* i
 
         guint packetLength = packet_getPayloadLength(packet);
         copyLength = MIN(packetLength, remaining);
-        bytesCopied = packet_copyPayload(packet, 0, buffer + offset, copyLength);
+        bytesCopied = packet_copyPayloadToIOVec(packet, 0, &cursor, copyLength);
         totalCopied += bytesCopied;
         remaining -= bytesCopied;
-        offset += bytesCopied;
 
         if(bytesCopied < packetLength) {
             /* we were only able to read part of this packet */
@@ -2072,10 +2023,8 @@ gssize tcp_receiveUserData(TCP* tcp, gpointer buffer, gsize nBytes, in_addr_t* i
          * make sure we don't send multiple events when read is called many times per instant */
         descriptor_ref(tcp);
 
-        Task* updateWindowTask = task_new((TaskCallbackFunc)_tcp_sendWindowUpdate,
-                tcp, NULL, descriptor_unref, NULL);
-        worker_scheduleTask(updateWindowTask, 1);
-        task_unref(updateWindowTask);
+        worker_scheduleCallback((TaskCallbackFunc)_tcp_sendWindowUpdate,
+                tcp, NULL, descriptor_unref, NULL, 1);
 
         tcp->receive.windowUpdatePending = TRUE;
     }
@@ -2090,8 +2039,7 @@ void tcp_free(TCP* tcp) {
 
     priorityqueue_free(tcp->throttledOutput);
     priorityqueue_free(tcp->unorderedInput);
-    g_hash_table_destroy(tcp->retransmit.queue);
-    priorityqueue_free(tcp->retransmit.scheduledTimerExpirations);
+    sequencering_free(tcp->retransmit.queue);
 
     if(tcp->child) {
         MAGIC_ASSERT(tcp->child);
@@ -2240,11 +2188,14 @@ TCP* tcp_new(gint handle, guint receiveBufferSize, guint sendBufferSize) {
             priorityqueue_new((GCompareDataFunc)packet_compareTCPSequence, NULL, (GDestroyNotify)packet_unref);
     tcp->unorderedInput =
             priorityqueue_new((GCompareDataFunc)packet_compareTCPSequence, NULL, (GDestroyNotify)packet_unref);
-    tcp->retransmit.queue =
-            g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)packet_unref);
+    tcp->retransmit.queue = sequencering_new(CONFIG_TCP_MAX_WINDOW_PACKETS, (GDestroyNotify)packet_unref);
     tcp->retransmit.scoreboard = scoreboard_new();
-    tcp->retransmit.scheduledTimerExpirations =
-            priorityqueue_new((GCompareDataFunc)utility_simulationTimeCompare, NULL, g_free);
+
+    /* armed timers hold a reference to us until they expire or are stopped */
+    wheeltimer_init(&(tcp->retransmit.timer), (TaskCallbackFunc)_tcp_runRetransmitTimerExpiredTask,
+            tcp, NULL, descriptor_ref, descriptor_unref);
+    wheeltimer_init(&(tcp->closeTimer), (TaskCallbackFunc)_tcp_runCloseTimerExpiredTask,
+            tcp, NULL, descriptor_ref, descriptor_unref);
 
     /* initialize tcp retransmission timeout */
     _tcp_setRetransmitTimeout(tcp, CONFIG_TCP_RTO_INIT);
@@ -18,20 +18,22 @@ struct _Timer {
     /* number of expires that happened since the timer was last set */
     guint64 expireCountSinceLastSet;
 
-    /* expire ids are used internally to cancel events that fire after
-     * they have become invalid because the user reset the timer */
-    guint nextExpireID;
-    guint minValidExpireID;
+    /* runs the next expiration; resetting the timer just re-arms it */
+    WheelTimer expireTimer;
 
-    guint numEventsScheduled;
     gboolean isClosed;
 
     MAGIC_DECLARE;
 };
 
+static void _timer_disarm(Timer* timer);
+static void _timer_expire(Timer* timer, gpointer data);
+
 static void _timer_close(Timer* timer) {
     MAGIC_ASSERT(timer);
     timer->isClosed = TRUE;
+    /* releases the reference the armed expiration holds */
+    _timer_disarm(timer);
     descriptor_adjustStatus(&(timer->super), DS_ACTIVE, FALSE);
     host_closeDescriptor(worker_getActiveHost(), timer->super.handle);
 }
@@ -71,6 +73,9 @@ Timer* timer_new(gint handle, gint clockid, gint flags) {
     descriptor_init(&(timer->super), DT_TIMER, &_timerFunctions, handle);
     descriptor_adjustStatus(&(timer->super), DS_ACTIVE, TRUE);
 
+    wheeltimer_init(&(timer->expireTimer), (TaskCallbackFunc)_timer_expire,
+            timer, NULL, descriptor_ref, descriptor_unref);
+
     worker_countObject(OBJECT_TYPE_TIMER, COUNTER_TYPE_NEW);
 
     return timer;
@@ -129,7 +134,9 @@ static void _timer_disarm(Timer* timer) {
     MAGIC_ASSERT(timer);
     timer->nextExpireTime = 0;
     timer->expireInterval = 0;
-    timer->minValidExpireID = timer->nextExpireID;
+    if(wheeltimer_isArmed(&(timer->expireTimer))) {
+        timerwheel_disarm(host_getTimerWheel(worker_getActiveHost()), &(timer->expireTimer));
+    }
     debug("timer fd %i disarmed", timer->super.handle);
 }
 
@@ -184,69 +191,41 @@ static void _timer_setCurrentInterval(Timer* timer, const struct timespec* confi
     timer->expireInterval = _timer_timespecToSimTime(config, FALSE);
 }
 
-static void _timer_expire(Timer* timer, gpointer data);
-
 static void _timer_scheduleNewExpireEvent(Timer* timer) {
     MAGIC_ASSERT(timer);
 
-    /* callback to our own node */
-    gpointer next = GUINT_TO_POINTER(timer->nextExpireID);
-
-    /* ref the timer storage in the callback event */
-    descriptor_ref(timer);
-    Task* task = task_new((TaskCallbackFunc)_timer_expire,
-            timer, next, descriptor_unref, NULL);
-
-    SimulationTime delay = timer->nextExpireTime - worker_getCurrentTime();
-
-    /* if the user set a super long delay, let's call back sooner to check if they closed
-     * or disarmed the timer in the meantime. This prevents queueing the task indefinitely. */
-    delay = MIN(delay, SIMTIME_ONE_SECOND);
-
-    worker_scheduleTask(task, delay);
-    task_unref(task);
-
-    timer->nextExpireID++;
-    timer->numEventsScheduled++;
+    /* the host's timer wheel holds a ref to us while we are armed, and drops
+     * it when the user disarms or closes us no matter how far out we are */
+    timerwheel_arm(host_getTimerWheel(worker_getActiveHost()),
+            &(timer->expireTimer), timer->nextExpireTime);
 }
 
 static void _timer_expire(Timer* timer, gpointer data) {
     MAGIC_ASSERT(timer);
 
-    /* this is a task callback event */
-
-    guint expireID = GPOINTER_TO_UINT(data);
-    debug("timer fd %i expired; isClosed=%i expireID=%u minValidExpireID=%u", timer->isClosed, expireID, timer->minValidExpireID);
-
-    timer->numEventsScheduled--;
-
-    /* make sure the timer has not been reset since we scheduled this expiration event */
-    if(!timer->isClosed && expireID >= timer->minValidExpireID) {
-        /* check if it actually expired on this callback check */
-        if(timer->nextExpireTime <= worker_getCurrentTime()) {
-            /* if a one-time (non-periodic) timer already expired before they
-             * started listening for the event with epoll, the event is reported
-             * immediately on the next epoll_wait call. this behavior was
-             * verified on linux. */
-            timer->expireCountSinceLastSet++;
-            descriptor_adjustStatus(&(timer->super), DS_READABLE, TRUE);
-
-            if(timer->expireInterval > 0) {
-                SimulationTime now = worker_getCurrentTime();
-                timer->nextExpireTime += timer->expireInterval;
-                if(timer->nextExpireTime < now) {
-                    /* for some reason we looped the interval. expire again immediately
-                     * to keep the periodic timer going. */
-                    timer->nextExpireTime = now;
-                }
-                _timer_scheduleNewExpireEvent(timer);
-            } else {
-                /* the timer is now disarmed */
-                _timer_disarm(timer);
+    /* this is a timer wheel callback, which only runs for the current expiration */
+    debug("timer fd %i expired; isClosed=%i", timer->super.handle, timer->isClosed);
+
+    if(!timer->isClosed) {
+        /* if a one-time (non-periodic) timer already expired before they
+         * started listening for the event with epoll, the event is reported
+         * immediately on the next epoll_wait call. this behavior was
+         * verified on linux. */
+        timer->expireCountSinceLastSet++;
+        descriptor_adjustStatus(&(timer->super), DS_READABLE, TRUE);
+
+        if(timer->expireInterval > 0) {
+            SimulationTime now = worker_getCurrentTime();
+            timer->nextExpireTime += timer->expireInterval;
+            if(timer->nextExpireTime < now) {
+                /* for some reason we looped the interval. expire again immediately
+                 * to keep the periodic timer going. */
+                timer->nextExpireTime = now;
             }
-        } else {
-            /* it didn't expire yet, check again in another second */
             _timer_scheduleNewExpireEvent(timer);
+        } else {
+            /* the timer is now disarmed */
+            _timer_disarm(timer);
         }
     }
 }
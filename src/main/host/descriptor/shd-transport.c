@@ -38,16 +38,20 @@ void transport_init(Transport* transport, TransportFunctionTable* vtable, Descri
 
 }
 
-gssize transport_sendUserData(Transport* transport, gconstpointer buffer, gsize nBytes,
+gssize transport_sendUserData(Transport* transport, const struct iovec* iov, gint iovcnt,
         in_addr_t ip, in_port_t port) {
     MAGIC_ASSERT(transport);
     MAGIC_ASSERT(transport->vtable);
-    return transport->vtable->send(transport, buffer, nBytes, ip, port);
+    return transport->vtable->send(transport, iov, iovcnt, ip, port);
 }
 
-gssize transport_receiveUserData(Transport* transport, gpointer buffer, gsize nBytes,
-        in_addr_t* ip, in_port_t* port) {
+gssize transport_receiveUserData(Transport* transport, const struct iovec* iov, gint iovcnt,
+        in_addr_t* ip, in_port_t* port, gboolean* isTruncated) {
     MAGIC_ASSERT(transport);
     MAGIC_ASSERT(transport->vtable);
-    return transport->vtable->receive(transport, buffer, nBytes, ip, port);
+    /* only message based transports ever drop the part that did not fit */
+    if(isTruncated) {
+        *isTruncated = FALSE;
+    }
+    return transport->vtable->receive(transport, iov, iovcnt, ip, port, isTruncated);
 }
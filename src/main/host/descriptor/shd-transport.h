@@ -12,8 +12,10 @@
 typedef struct _Transport Transport;
 typedef struct _TransportFunctionTable TransportFunctionTable;
 
-typedef gssize (*TransportSendFunc)(Transport* transport, gconstpointer buffer, gsize nBytes, in_addr_t ip, in_port_t port);
-typedef gssize (*TransportReceiveFunc)(Transport* transport, gpointer buffer, gsize nBytes, in_addr_t* ip, in_port_t* port);
+/* user data is passed as the caller's iovec array, so that transports can
+ * segment directly from and reassemble directly into the plug-in's buffers */
+typedef gssize (*TransportSendFunc)(Transport* transport, const struct iovec* iov, gint iovcnt, in_addr_t ip, in_port_t port);
+typedef gssize (*TransportReceiveFunc)(Transport* transport, const struct iovec* iov, gint iovcnt, in_addr_t* ip, in_port_t* port, gboolean* isTruncated);
 
 struct _TransportFunctionTable {
     DescriptorFunc close;
@@ -32,9 +34,9 @@ struct _Transport {
 
 void transport_init(Transport* transport, TransportFunctionTable* vtable, DescriptorType type, gint handle);
 
-gssize transport_sendUserData(Transport* transport, gconstpointer buffer, gsize nBytes,
+gssize transport_sendUserData(Transport* transport, const struct iovec* iov, gint iovcnt,
         in_addr_t ip, in_port_t port);
-gssize transport_receiveUserData(Transport* transport, gpointer buffer, gsize nBytes,
-        in_addr_t* ip, in_port_t* port);
+gssize transport_receiveUserData(Transport* transport, const struct iovec* iov, gint iovcnt,
+        in_addr_t* ip, in_port_t* port, gboolean* isTruncated);
 
 #endif /* SHD_TRANSPORT_H_ */
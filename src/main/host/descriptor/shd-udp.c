@@ -55,9 +55,11 @@ void udp_dropPacket(UDP* udp, Packet* packet) {
  * ip and port parameters. this function assumes that the socket is already
  * bound to a local port, no matter if that happened explicitly or implicitly.
  */
-gssize udp_sendUserData(UDP* udp, gconstpointer buffer, gsize nBytes, in_addr_t ip, in_port_t port) {
+gssize udp_sendUserData(UDP* udp, const struct iovec* iov, gint iovcnt, in_addr_t ip, in_port_t port) {
     MAGIC_ASSERT(udp);
 
+    gsize nBytes = iovec_getLength(iov, iovcnt);
+
     gsize space = socket_getOutputBufferSpace(&(udp->super));
     if(space < nBytes) {
         /* not enough space to buffer the data */
@@ -68,6 +70,8 @@ gssize udp_sendUserData(UDP* udp, gconstpointer buffer, gsize nBytes, in_addr_t
     gsize maxPacketLength = CONFIG_DATAGRAM_MAX_SIZE;
     gsize remaining = nBytes;
     gsize offset = 0;
+    IOVecCursor cursor;
+    iovcursor_init(&cursor, iov, iovcnt);
 
     /* create as many packets as needed */
     while(remaining > 0) {
@@ -92,8 +96,8 @@ gssize udp_sendUserData(UDP* udp, gconstpointer buffer, gsize nBytes, in_addr_t
 
         utility_assert(sourceIP && sourcePort && destinationIP && destinationPort);
 
-        /* create the UDP packet */
-        Packet* packet = packet_new(buffer + offset, copyLength);
+        /* create the UDP packet, gathering the payload straight from the iovecs */
+        Packet* packet = packet_newFromIOVec(&cursor, copyLength);
         packet_setUDP(packet, PUDP_NONE, sourceIP, sourcePort, destinationIP, destinationPort);
         packet_addDeliveryStatus(packet, PDS_SND_CREATED);
 
@@ -123,7 +127,7 @@ gssize udp_sendUserData(UDP* udp, gconstpointer buffer, gsize nBytes, in_addr_t
     return (gssize) offset;
 }
 
-gssize udp_receiveUserData(UDP* udp, gpointer buffer, gsize nBytes, in_addr_t* ip, in_port_t* port) {
+gssize udp_receiveUserData(UDP* udp, const struct iovec* iov, gint iovcnt, in_addr_t* ip, in_port_t* port, gboolean* isTruncated) {
     MAGIC_ASSERT(udp);
 
     Packet* packet = socket_removeFromInputBuffer((Socket*)udp);
@@ -131,14 +135,21 @@ gssize udp_receiveUserData(UDP* udp, gpointer buffer, gsize nBytes, in_addr_t* i
         return -1;
     }
 
-    /* copy lesser of requested and available amount to application buffer */
+    /* copy lesser of requested and available amount to application buffers */
     guint packetLength = packet_getPayloadLength(packet);
-    gsize copyLength = MIN(nBytes, packetLength);
-    guint bytesCopied = packet_copyPayload(packet, 0, buffer, copyLength);
+    gsize copyLength = MIN(iovec_getLength(iov, iovcnt), packetLength);
+    IOVecCursor cursor;
+    iovcursor_init(&cursor, iov, iovcnt);
+    guint bytesCopied = packet_copyPayloadToIOVec(packet, 0, &cursor, copyLength);
 
     utility_assert(bytesCopied == copyLength);
     packet_addDeliveryStatus(packet, PDS_RCV_SOCKET_DELIVERED);
 
+    /* the rest of the datagram is lost, let the caller know */
+    if(isTruncated) {
+        *isTruncated = (packetLength > copyLength) ? TRUE : FALSE;
+    }
+
     /* fill in address info */
     if(ip) {
         *ip = packet_getSourceIP(packet);
@@ -6,6 +6,19 @@
 
 #include "shadow.h"
 
+/* one slot of the descriptor table. a slot is allocated from the time its
+ * handle is given out until the handle is returned, which for descriptors
+ * may be well after they were closed and stopped being looked up. */
+typedef struct _HostHandle HostHandle;
+struct _HostHandle {
+    HandleType type;
+    gboolean isAllocated;
+    /* the descriptor, for HT_DESCRIPTOR */
+    Descriptor* descriptor;
+    /* the descriptor the OS gave us, for HT_OSFILE and HT_RANDOM */
+    gint osHandle;
+};
+
 struct _Host {
     /* general node lock. nothing that belongs to the node should be touched
      * unless holding this lock. everything following this falls under the lock. */
@@ -23,31 +36,32 @@ struct _Host {
     /* a statistics tracker for in/out bytes, CPU, memory, etc. */
     Tracker* tracker;
 
-    /* virtual descriptor numbers */
-    GQueue* availableDescriptors;
-    gint descriptorHandleCounter;
+    /* internal timers of our interfaces, descriptors, and tracker */
+    TimerWheel* timers;
 
     /* virtual process id counter */
     guint processIDCounter;
 
-    /* all file, socket, and epoll descriptors we know about and track */
-    GHashTable* descriptors;
-
-    /* map from the descriptor handle we returned to the plug-in, and
-     * descriptor handle that the OS gave us for files, etc.
-     * We do this so that we can give out low descriptor numbers even though the OS
-     * may give out those same low numbers when files are opened. */
-    GHashTable* shadowToOSHandleMap;
+    /* all file, socket, and epoll descriptors we know about and track, and
+     * the OS descriptors we emulate, as an array of HostHandle indexed by the
+     * handle we returned to the plug-in. We emulate OS descriptors so that we
+     * can give out low descriptor numbers even though the OS may give out
+     * those same low numbers when files are opened. */
+    GArray* handles;
+    /* min-heap of returned handles, so we always give out the lowest one */
+    GArray* availableHandles;
+
+    /* the handle emulating each OS descriptor we were given. OS descriptors
+     * are shared by all hosts in the process, so this stays sparse */
     GHashTable* osToShadowHandleMap;
 
-    /* list of all /dev/random shadow handles that have been created */
-    GHashTable* randomShadowHandleMap;
-
     /* map path to ports for unix sockets */
     GHashTable* unixPathToPortMap;
 
     /* track the order in which the application sent us application data */
     gdouble packetPriorityCounter;
+    /* numbers the packets we create when tracing them */
+    guint32 packetIDCounter;
 
     /* random stream */
     Random* random;
@@ -88,19 +102,20 @@ Host* host_new(HostParameters* params) {
 
     host->interfaces = g_hash_table_new_full(g_direct_hash, g_direct_equal,
             NULL, (GDestroyNotify) networkinterface_free);
-    host->availableDescriptors = g_queue_new();
-    host->descriptorHandleCounter = MIN_DESCRIPTOR;
 
-    /* virtual descriptor management */
-    host->descriptors = g_hash_table_new_full(g_int_hash, g_int_equal, NULL, descriptor_unref);
-    host->shadowToOSHandleMap = g_hash_table_new(g_direct_hash, g_direct_equal);
+    /* virtual descriptor management. handles below MIN_DESCRIPTOR are never
+     * allocated, so their slots just stay empty */
+    host->handles = g_array_sized_new(FALSE, TRUE, sizeof(HostHandle), MIN_DESCRIPTOR*4);
+    g_array_set_size(host->handles, MIN_DESCRIPTOR);
+    host->availableHandles = g_array_new(FALSE, FALSE, sizeof(gint));
     host->osToShadowHandleMap = g_hash_table_new(g_direct_hash, g_direct_equal);
-    host->randomShadowHandleMap = g_hash_table_new(g_direct_hash, g_direct_equal);
     host->unixPathToPortMap = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 
     /* applications this node will run */
     host->processes = g_queue_new();
 
+    host->timers = timerwheel_new();
+
     message("Created host id '%u' name '%s'", (guint)host->params.id, g_quark_to_string(host->params.id));
 
     host->processIDCounter = 1000;
@@ -134,6 +149,13 @@ void host_shutdown(Host* host) {
         g_queue_free(host->processes);
     }
 
+    /* drop the armed timers first, while the objects their release may free
+     * can still reach the interfaces. nothing is armed again after this. */
+    if(host->timers) {
+        timerwheel_free(host->timers);
+        host->timers = NULL;
+    }
+
     if(host->defaultAddress) {
         topology_detach(worker_getTopology(), host->defaultAddress);
         //address_unref(host->defaultAddress);
@@ -143,12 +165,9 @@ void host_shutdown(Host* host) {
         g_hash_table_destroy(host->interfaces);
     }
 
-    if(host->descriptors) {
-        GHashTableIter iter;
-        gpointer key, value;
-        g_hash_table_iter_init(&iter, host->descriptors);
-        while(g_hash_table_iter_next(&iter, &key, &value)) {
-            Descriptor* desc = value;
+    if(host->handles) {
+        for(guint i = 0; i < host->handles->len; i++) {
+            Descriptor* desc = g_array_index(host->handles, HostHandle, i).descriptor;
             if(desc && desc->type == DT_TCPSOCKET) {
               /* tcp servers and their children holds refs to each other. make
                * sure they all get freed by removing the refs in one direction */
@@ -159,17 +178,28 @@ void host_shutdown(Host* host) {
             }
         }
 
-        g_hash_table_destroy(host->descriptors);
+        /* unreffing may return handles to us, so clear each slot first */
+        for(guint i = 0; i < host->handles->len; i++) {
+            HostHandle* slot = &g_array_index(host->handles, HostHandle, i);
+            Descriptor* desc = slot->descriptor;
+            if(desc) {
+                slot->type = HT_NONE;
+                slot->descriptor = NULL;
+                descriptor_unref(desc);
+            }
+        }
+
+        g_array_free(host->handles, TRUE);
+        host->handles = NULL;
     }
 
-    if(host->shadowToOSHandleMap) {
-        g_hash_table_destroy(host->shadowToOSHandleMap);
+    if(host->availableHandles) {
+        g_array_free(host->availableHandles, TRUE);
+        host->availableHandles = NULL;
     }
     if(host->osToShadowHandleMap) {
         g_hash_table_destroy(host->osToShadowHandleMap);
-    }
-    if(host->randomShadowHandleMap) {
-        g_hash_table_destroy(host->randomShadowHandleMap);
+        host->osToShadowHandleMap = NULL;
     }
     if(host->unixPathToPortMap) {
         g_hash_table_destroy(host->unixPathToPortMap);
@@ -182,9 +212,6 @@ void host_shutdown(Host* host) {
         tracker_free(host->tracker);
     }
 
-    if(host->availableDescriptors) {
-        g_queue_free(host->availableDescriptors);
-    }
     if(host->random) {
         random_free(host->random);
     }
@@ -259,6 +286,11 @@ GQuark host_getID(Host* host) {
     return host->params.id;
 }
 
+guint host_getIndex(Host* host) {
+    MAGIC_ASSERT(host);
+    return host->params.index;
+}
+
 void host_boot(Host* host) {
     MAGIC_ASSERT(host);
 
@@ -273,7 +305,10 @@ void host_boot(Host* host) {
         g_mkdir_with_parents(host->dataDirPath, 0775);
     }
 
-    host->random = random_new(host->params.nodeSeed);
+    /* hosts whose seeds happen to collide still get independent streams. the indices
+     * are assigned in config order, so this does not depend on threads or on the
+     * order in which host names were first seen as quarks. */
+    host->random = random_newStream(host->params.nodeSeed, (guint64)host->params.index);
     host->cpu = cpu_new(host->params.cpuFrequency, host->params.cpuThreshold, host->params.cpuPrecision);
 
     /* connect to topology and get the default bandwidth */
@@ -328,6 +363,11 @@ void host_addApplication(Host* host, SimulationTime startTime, SimulationTime st
     g_queue_push_tail(host->processes, proc);
 }
 
+void host_foreachApplication(Host* host, GFunc func, gpointer userData) {
+    MAGIC_ASSERT(host);
+    g_queue_foreach(host->processes, func, userData);
+}
+
 void host_freeAllApplications(Host* host) {
     MAGIC_ASSERT(host);
     debug("start freeing applications for host '%s'", host->params.hostname);
@@ -339,13 +379,10 @@ void host_freeAllApplications(Host* host) {
     debug("done freeing application for host '%s'", host->params.hostname);
 
     debug("start clearing epoll descriptors for host '%s'", host->params.hostname);
-    GHashTableIter iter;
-    gpointer key, value;
-    g_hash_table_iter_init(&iter, host->descriptors);
-    while(g_hash_table_iter_next(&iter, &key, &value)) {
-        Descriptor* descriptor = value;
-        if(descriptor->type == DT_EPOLL) {
-            epoll_clearWatchListeners((Epoll*) descriptor);
+    for(guint i = 0; i < host->handles->len; i++) {
+        HostHandle* slot = &g_array_index(host->handles, HostHandle, i);
+        if(slot->type == HT_DESCRIPTOR && slot->descriptor->type == DT_EPOLL) {
+            epoll_clearWatchListeners((Epoll*) slot->descriptor);
         }
     }
     debug("done clearing epoll descriptors for host '%s'", host->params.hostname);
@@ -404,9 +441,34 @@ gboolean host_autotuneSendBuffer(Host* host) {
     return host->params.autotuneSendBuf;
 }
 
+static HostHandle* _host_getHandleSlot(Host* host, gint handle) {
+    if(handle < 0 || (guint)handle >= host->handles->len) {
+        return NULL;
+    }
+    return &g_array_index(host->handles, HostHandle, handle);
+}
+
+HandleType host_classifyHandle(Host* host, gint handle, Descriptor** descriptor, gint* osHandle) {
+    MAGIC_ASSERT(host);
+
+    HostHandle* slot = _host_getHandleSlot(host, handle);
+    if(slot == NULL) {
+        return HT_NONE;
+    }
+
+    if(descriptor) {
+        *descriptor = slot->descriptor;
+    }
+    if(osHandle) {
+        *osHandle = slot->osHandle;
+    }
+    return slot->type;
+}
+
 Descriptor* host_lookupDescriptor(Host* host, gint handle) {
     MAGIC_ASSERT(host);
-    return g_hash_table_lookup(host->descriptors, (gconstpointer) &handle);
+    HostHandle* slot = _host_getHandleSlot(host, handle);
+    return (slot && slot->type == HT_DESCRIPTOR) ? slot->descriptor : NULL;
 }
 
 NetworkInterface* host_lookupInterface(Host* host, in_addr_t handle) {
@@ -467,10 +529,15 @@ static void _host_disassociateInterface(Host* host, Socket* socket) {
 static gint _host_monitorDescriptor(Host* host, Descriptor* descriptor) {
     MAGIC_ASSERT(host);
 
-    /* make sure there are no collisions before inserting */
+    /* make sure there are no collisions before inserting. the handle came
+     * from _host_getNextDescriptorHandle, so its slot is reserved for it */
     gint* handle = descriptor_getHandleReference(descriptor);
-    utility_assert(handle && !host_lookupDescriptor(host, *handle));
-    g_hash_table_replace(host->descriptors, handle, descriptor);
+    HostHandle* slot = handle ? _host_getHandleSlot(host, *handle) : NULL;
+    utility_assert(slot && slot->isAllocated && slot->type == HT_NONE);
+
+    /* the table holds the reference given to us by the creator */
+    slot->type = HT_DESCRIPTOR;
+    slot->descriptor = descriptor;
 
     return *handle;
 }
@@ -485,28 +552,90 @@ static void _host_unmonitorDescriptor(Host* host, gint handle) {
             _host_disassociateInterface(host, socket);
         }
 
-        g_hash_table_remove(host->descriptors, (gconstpointer) &handle);
+        /* the handle stays reserved until the descriptor is freed and
+         * returns it, so it will not be reused while still referenced */
+        HostHandle* slot = _host_getHandleSlot(host, handle);
+        slot->type = HT_NONE;
+        slot->descriptor = NULL;
+        descriptor_unref(descriptor);
+    }
+}
+
+static void _host_pushAvailableHandle(Host* host, gint handle) {
+    GArray* heap = host->availableHandles;
+    g_array_append_val(heap, handle);
+
+    /* sift up */
+    guint i = heap->len - 1;
+    while(i > 0) {
+        guint parent = (i - 1) / 2;
+        if(g_array_index(heap, gint, parent) <= handle) {
+            break;
+        }
+        g_array_index(heap, gint, i) = g_array_index(heap, gint, parent);
+        i = parent;
     }
+    g_array_index(heap, gint, i) = handle;
 }
 
-static gint _host_compareDescriptors(gconstpointer a, gconstpointer b, gpointer userData) {
-  gint aint = GPOINTER_TO_INT(a);
-  gint bint = GPOINTER_TO_INT(b);
-  return aint < bint ? -1 : aint == bint ? 0 : 1;
+static gint _host_popAvailableHandle(Host* host) {
+    GArray* heap = host->availableHandles;
+    utility_assert(heap->len > 0);
+
+    gint lowest = g_array_index(heap, gint, 0);
+    gint last = g_array_index(heap, gint, heap->len - 1);
+    g_array_set_size(heap, heap->len - 1);
+
+    /* sift down */
+    guint i = 0;
+    while(heap->len > 0) {
+        guint child = 2 * i + 1;
+        if(child >= heap->len) {
+            break;
+        }
+        if(child + 1 < heap->len && g_array_index(heap, gint, child + 1) < g_array_index(heap, gint, child)) {
+            child++;
+        }
+        if(last <= g_array_index(heap, gint, child)) {
+            break;
+        }
+        g_array_index(heap, gint, i) = g_array_index(heap, gint, child);
+        i = child;
+    }
+    if(heap->len > 0) {
+        g_array_index(heap, gint, i) = last;
+    }
+
+    return lowest;
 }
 
 static gint _host_getNextDescriptorHandle(Host* host) {
     MAGIC_ASSERT(host);
-    if(g_queue_get_length(host->availableDescriptors) > 0) {
-        return GPOINTER_TO_INT(g_queue_pop_head(host->availableDescriptors));
+
+    gint handle;
+    if(host->availableHandles->len > 0) {
+        handle = _host_popAvailableHandle(host);
+    } else {
+        /* all handles below the end of the table are in use, so grow it */
+        handle = (gint) host->handles->len;
+        g_array_set_size(host->handles, host->handles->len + 1);
     }
-    return (host->descriptorHandleCounter)++;
+
+    HostHandle* slot = _host_getHandleSlot(host, handle);
+    utility_assert(!slot->isAllocated);
+    slot->isAllocated = TRUE;
+    slot->type = HT_NONE;
+    return handle;
 }
 
 static void _host_returnPreviousDescriptorHandle(Host* host, gint handle) {
     MAGIC_ASSERT(host);
-    if(handle >= 3) {
-        g_queue_insert_sorted(host->availableDescriptors, GINT_TO_POINTER(handle), _host_compareDescriptors, NULL);
+
+    /* only take back handles we gave out that no longer refer to anything */
+    HostHandle* slot = _host_getHandleSlot(host, handle);
+    if(slot && slot->isAllocated && slot->type == HT_NONE) {
+        memset(slot, 0, sizeof(HostHandle));
+        _host_pushAvailableHandle(host, handle);
     }
 }
 
@@ -537,8 +666,13 @@ gint host_createShadowHandle(Host* host, gint osHandle) {
      * so that the plugin will not be given duplicate shadow/os numbers. */
     gint shadowHandle = _host_getNextDescriptorHandle(host);
 
-    g_hash_table_replace(host->shadowToOSHandleMap, GINT_TO_POINTER(shadowHandle), GINT_TO_POINTER(osHandle));
-    g_hash_table_replace(host->osToShadowHandleMap, GINT_TO_POINTER(osHandle), GINT_TO_POINTER(shadowHandle));
+    HostHandle* slot = _host_getHandleSlot(host, shadowHandle);
+    slot->type = HT_OSFILE;
+    slot->osHandle = osHandle;
+
+    if(osHandle >= 0) {
+        g_hash_table_replace(host->osToShadowHandleMap, GINT_TO_POINTER(osHandle), GINT_TO_POINTER(shadowHandle));
+    }
 
     return shadowHandle;
 }
@@ -566,19 +700,23 @@ gint host_getOSHandle(Host* host, gint shadowHandle) {
     }
 
     /* find os handle that we mapped, if one exists */
-    gpointer osHandleP = g_hash_table_lookup(host->shadowToOSHandleMap, GINT_TO_POINTER(shadowHandle));
+    HostHandle* slot = _host_getHandleSlot(host, shadowHandle);
 
-    return osHandleP ? GPOINTER_TO_INT(osHandleP) : -1;
+    return (slot && (slot->type == HT_OSFILE || slot->type == HT_RANDOM)) ? slot->osHandle : -1;
 }
 
 void host_setRandomHandle(Host* host, gint handle) {
     MAGIC_ASSERT(host);
-    g_hash_table_insert(host->randomShadowHandleMap, GINT_TO_POINTER(handle), GINT_TO_POINTER(handle));
+    HostHandle* slot = _host_getHandleSlot(host, handle);
+    if(slot && slot->type == HT_OSFILE) {
+        slot->type = HT_RANDOM;
+    }
 }
 
 gboolean host_isRandomHandle(Host* host, gint handle) {
     MAGIC_ASSERT(host);
-    return g_hash_table_contains(host->randomShadowHandleMap, GINT_TO_POINTER(handle));
+    HostHandle* slot = _host_getHandleSlot(host, handle);
+    return (slot && slot->type == HT_RANDOM) ? TRUE : FALSE;
 }
 
 
@@ -590,14 +728,18 @@ void host_destroyShadowHandle(Host* host, gint shadowHandle) {
         return;
     }
 
-    gint osHandle = host_getOSHandle(host, shadowHandle);
-    gboolean didExist = g_hash_table_remove(host->shadowToOSHandleMap, GINT_TO_POINTER(shadowHandle));
-    if(didExist) {
-        g_hash_table_remove(host->osToShadowHandleMap, GINT_TO_POINTER(osHandle));
+    HostHandle* slot = _host_getHandleSlot(host, shadowHandle);
+    if(slot && (slot->type == HT_OSFILE || slot->type == HT_RANDOM)) {
+        gint osHandle = slot->osHandle;
+        /* the OS may have reused the descriptor for a newer handle */
+        gpointer shadowHandleP = g_hash_table_lookup(host->osToShadowHandleMap, GINT_TO_POINTER(osHandle));
+        if(shadowHandleP && GPOINTER_TO_INT(shadowHandleP) == shadowHandle) {
+            g_hash_table_remove(host->osToShadowHandleMap, GINT_TO_POINTER(osHandle));
+        }
+
+        slot->type = HT_NONE;
         _host_returnPreviousDescriptorHandle(host, shadowHandle);
     }
-
-    g_hash_table_remove(host->randomShadowHandleMap, GINT_TO_POINTER(shadowHandle));
 }
 
 gint host_createDescriptor(Host* host, DescriptorType type) {
@@ -775,43 +917,31 @@ gint host_select(Host* host, fd_set* readable, fd_set* writeable, fd_set* errone
     GQueue* readyDescsRead = g_queue_new();
     GQueue* readyDescsWrite = g_queue_new();
 
-    /* first look at shadow internal descriptors */
-    GList* descs = g_hash_table_get_values(host->descriptors);
-    GList* item = g_list_first(descs);
-
-    /* iterate all descriptors */
-    while(item) {
-        Descriptor* desc = item->data;
-        if(desc) {
-            DescriptorStatus status = descriptor_getStatus(desc);
-            if((readable != NULL) && FD_ISSET(desc->handle, readable) && (status & DS_ACTIVE) && (status & DS_READABLE)) {
-                g_queue_push_head(readyDescsRead, GINT_TO_POINTER(desc->handle));
-            }
-            if((writeable != NULL) && FD_ISSET(desc->handle, writeable) && (status & DS_ACTIVE) && (status & DS_WRITABLE)) {
-                g_queue_push_head(readyDescsWrite, GINT_TO_POINTER(desc->handle));
-            }
-        }
-        item = g_list_next(item);
-    }
-    /* cleanup the iterator lists */
-    g_list_free(descs);
-    item = descs = NULL;
-
-    /* now check on OS descriptors */
     struct timeval zeroTimeout;
     zeroTimeout.tv_sec = 0;
     zeroTimeout.tv_usec = 0;
     fd_set osFDSet;
 
-    /* setup our iterator */
-    GHashTableIter iter;
-    gpointer key, value;
-    g_hash_table_iter_init(&iter, host->shadowToOSHandleMap);
+    /* iterate all handles that fit in the sets, checking shadow internal
+     * descriptors ourselves and asking the os for events on os handles */
+    guint numHandles = MIN(host->handles->len, (guint)FD_SETSIZE);
+    for(gint shadowHandle = 0; shadowHandle < (gint)numHandles; shadowHandle++) {
+        HostHandle* slot = &g_array_index(host->handles, HostHandle, shadowHandle);
+
+        if(slot->type == HT_DESCRIPTOR) {
+            DescriptorStatus status = descriptor_getStatus(slot->descriptor);
+            if((readable != NULL) && FD_ISSET(shadowHandle, readable) && (status & DS_ACTIVE) && (status & DS_READABLE)) {
+                g_queue_push_head(readyDescsRead, GINT_TO_POINTER(shadowHandle));
+            }
+            if((writeable != NULL) && FD_ISSET(shadowHandle, writeable) && (status & DS_ACTIVE) && (status & DS_WRITABLE)) {
+                g_queue_push_head(readyDescsWrite, GINT_TO_POINTER(shadowHandle));
+            }
+            continue;
+        } else if(slot->type != HT_OSFILE && slot->type != HT_RANDOM) {
+            continue;
+        }
 
-    /* iterate all os handles and ask the os for events */
-    while (g_hash_table_iter_next(&iter, &key, &value)) {
-        gint shadowHandle = GPOINTER_TO_INT(key);
-        gint osHandle = GPOINTER_TO_INT(value);
+        gint osHandle = slot->osHandle;
 
         if ((readable != NULL) && FD_ISSET(shadowHandle, readable)) {
             FD_ZERO(&osFDSet);
@@ -979,17 +1109,19 @@ static in_port_t _host_getRandomPort(Host* host) {
 static in_port_t _host_getRandomFreePort(Host* host, in_addr_t interfaceIP, DescriptorType type) {
     MAGIC_ASSERT(host);
 
-    /* we need a random port that is free everywhere we need it to be.
-     * we have two modes here: first we just try grabbing a random port until we
-     * get a free one. if we cannot find one in an expected number of loops
-     * (based on how many we think are free), then we do an inefficient linear
-     * search that is guaranteed to succeed/fail as a fallback. */
+    /* we need a port that is free everywhere we need it to be. we start the
+     * search at a random (but deterministic) port, and then scan the bound port
+     * bitmaps of the interfaces a word at a time from there. for INADDR_ANY,
+     * a port must be free in the union of all of the interface bitmaps. */
+    enum ProtocolType protocol = type == DT_TCPSOCKET ? PTCP : type == DT_UDPSOCKET ? PUDP : PLOCAL;
 
-    /* lets see if we have enough free ports to just choose randomly */
-    guint maxNumBound = 0;
+    guint numBitmaps = 0;
+    PortBitmap** bitmaps = NULL;
 
     if(interfaceIP == htonl(INADDR_ANY)) {
         /* need to make sure the port is free on all interfaces */
+        bitmaps = g_newa(PortBitmap*, g_hash_table_size(host->interfaces));
+
         GHashTableIter iter;
         gpointer key, value;
         g_hash_table_iter_init(&iter, host->interfaces);
@@ -997,60 +1129,24 @@ static in_port_t _host_getRandomFreePort(Host* host, in_addr_t interfaceIP, Desc
         while(g_hash_table_iter_next(&iter, &key, &value)) {
             NetworkInterface* interface = value;
             if(interface) {
-                guint numBoundSockets = networkinterface_getAssociationCount(interface);
-                maxNumBound = MAX(numBoundSockets, maxNumBound);
+                bitmaps[numBitmaps++] = networkinterface_getBoundPorts(interface, protocol);
             }
         }
     } else {
         /* just check the one at the given IP */
+        bitmaps = g_newa(PortBitmap*, 1);
         NetworkInterface* interface = host_lookupInterface(host, interfaceIP);
         if(interface) {
-            guint numBoundSockets = networkinterface_getAssociationCount(interface);
-            maxNumBound = MAX(numBoundSockets, maxNumBound);
-        }
-    }
-
-    guint numAllocatablePorts = (guint)(UINT16_MAX - MIN_RANDOM_PORT);
-    guint numFreePorts = 0;
-    if(maxNumBound < numAllocatablePorts) {
-        numFreePorts = numAllocatablePorts - maxNumBound;
-    }
-
-    /* we will try to get a port */
-    in_port_t randomNetworkPort = 0;
-
-    /* if more than 1/10 of allocatable ports are free, choose randomly but only
-     * until we try to many times */
-    guint threshold = (guint)(numAllocatablePorts / 100);
-    if(numFreePorts >= threshold) {
-        guint numTries = 0;
-        while(numTries < numFreePorts) {
-            in_port_t randomPort = _host_getRandomPort(host);
-
-            /* this will check all interfaces in the case of INADDR_ANY */
-            if(_host_isInterfaceAvailable(host, interfaceIP, type, randomPort)) {
-                randomNetworkPort = randomPort;
-                break;
-            }
-
-            numTries++;
+            bitmaps[numBitmaps++] = networkinterface_getBoundPorts(interface, protocol);
         }
     }
 
-    /* now if we tried too many times and still don't have a port, fall back
-     * to a linear search to make sure we get a free port if we have one */
-    if(!randomNetworkPort) {
-        for(in_port_t i = MIN_RANDOM_PORT; i < UINT16_MAX; i++) {
-            /* this will check all interfaces in the case of INADDR_ANY */
-            if(_host_isInterfaceAvailable(host, interfaceIP, type, i)) {
-                randomNetworkPort = i;
-                break;
-            }
-        }
-    }
+    in_port_t startPort = ntohs(_host_getRandomPort(host));
+    in_port_t freePort = portbitmap_findUnset(bitmaps, numBitmaps,
+            MIN_RANDOM_PORT, UINT16_MAX - 1, startPort);
 
     /* this will return 0 if we can't find a free port */
-    return randomNetworkPort;
+    return htons(freePort);
 }
 
 gint host_bindToInterface(Host* host, gint handle, const struct sockaddr* address) {
@@ -1403,7 +1499,7 @@ gint host_getSocketName(Host* host, gint handle, const struct sockaddr* address,
     }
 }
 
-gint host_sendUserData(Host* host, gint handle, gconstpointer buffer, gsize nBytes,
+gint host_sendUserData(Host* host, gint handle, const struct iovec* iov, gint iovcnt,
         in_addr_t ip, in_addr_t port, gsize* bytesCopied) {
     MAGIC_ASSERT(host);
     utility_assert(bytesCopied);
@@ -1429,7 +1525,8 @@ gint host_sendUserData(Host* host, gint handle, gconstpointer buffer, gsize nByt
 
     /* we should block if our cpu has been too busy lately */
     if(cpu_isBlocked(host->cpu)) {
-        debug("blocked on CPU when trying to send %"G_GSIZE_FORMAT" bytes from socket %i", nBytes, handle);
+        debug("blocked on CPU when trying to send %"G_GSIZE_FORMAT" bytes from socket %i",
+                iovec_getLength(iov, iovcnt), handle);
 
         /*
          * immediately schedule an event to tell the socket it can write. it will
@@ -1478,7 +1575,7 @@ gint host_sendUserData(Host* host, gint handle, gconstpointer buffer, gsize nByt
         }
     }
 
-    gssize n = transport_sendUserData(transport, buffer, nBytes, ip, port);
+    gssize n = transport_sendUserData(transport, iov, iovcnt, ip, port);
     if(n > 0) {
         /* user is writing some bytes. */
         *bytesCopied = (gsize)n;
@@ -1491,8 +1588,8 @@ gint host_sendUserData(Host* host, gint handle, gconstpointer buffer, gsize nByt
     return 0;
 }
 
-gint host_receiveUserData(Host* host, gint handle, gpointer buffer, gsize nBytes,
-        in_addr_t* ip, in_port_t* port, gsize* bytesCopied) {
+gint host_receiveUserData(Host* host, gint handle, const struct iovec* iov, gint iovcnt,
+        in_addr_t* ip, in_port_t* port, gsize* bytesCopied, gboolean* isTruncated) {
     MAGIC_ASSERT(host);
     utility_assert(ip && port && bytesCopied);
 
@@ -1516,7 +1613,8 @@ gint host_receiveUserData(Host* host, gint handle, gpointer buffer, gsize nBytes
 
     /* we should block if our cpu has been too busy lately */
     if(cpu_isBlocked(host->cpu)) {
-        debug("blocked on CPU when trying to send %"G_GSIZE_FORMAT" bytes from socket %i", nBytes, handle);
+        debug("blocked on CPU when trying to receive %"G_GSIZE_FORMAT" bytes from socket %i",
+                iovec_getLength(iov, iovcnt), handle);
 
         /*
          * immediately schedule an event to tell the socket it can read. it will
@@ -1527,7 +1625,7 @@ gint host_receiveUserData(Host* host, gint handle, gpointer buffer, gsize nBytes
         return EAGAIN;
     }
 
-    gssize n = transport_receiveUserData(transport, buffer, nBytes, ip, port);
+    gssize n = transport_receiveUserData(transport, iov, iovcnt, ip, port, isTruncated);
     if(n > 0) {
         /* user is reading some bytes. */
         *bytesCopied = (gsize)n;
@@ -1565,6 +1663,11 @@ Tracker* host_getTracker(Host* host) {
     return host->tracker;
 }
 
+TimerWheel* host_getTimerWheel(Host* host) {
+    MAGIC_ASSERT(host);
+    return host->timers;
+}
+
 LogLevel host_getLogLevel(Host* host) {
     MAGIC_ASSERT(host);
     return host->params.logLevel;
@@ -1575,6 +1678,12 @@ gdouble host_getNextPacketPriority(Host* host) {
     return ++(host->packetPriorityCounter);
 }
 
+guint64 host_getNextPacketID(Host* host) {
+    MAGIC_ASSERT(host);
+    /* unique among all hosts, and the same in every run with the same config */
+    return (((guint64)host->params.index) << 32) | (guint64)(++(host->packetIDCounter));
+}
+
 const gchar* host_getDataPath(Host* host) {
     MAGIC_ASSERT(host);
     return host->dataDirPath;
@@ -13,9 +13,24 @@
 
 typedef struct _Host Host;
 
+/* what a descriptor handle given to a plug-in refers to */
+typedef enum _HandleType HandleType;
+enum _HandleType {
+    HT_NONE,
+    /* a shadow file, socket, or epoll descriptor */
+    HT_DESCRIPTOR,
+    /* a descriptor the OS gave us, that we emulate with a low number */
+    HT_OSFILE,
+    /* an OS descriptor for /dev/random, served from the host random stream */
+    HT_RANDOM,
+};
+
 typedef struct _HostParameters HostParameters;
 struct _HostParameters {
     GQuark id;
+    /* the order in which the host was created, starting at 1. unlike the id,
+     * this only depends on the configuration, so it is the same in every run. */
+    guint index;
     guint nodeSeed;
     gchar* hostname;
     gchar* ipHint;
@@ -59,10 +74,12 @@ void host_shutdown(Host* host);
 void host_addApplication(Host* host, SimulationTime startTime, SimulationTime stopTime,
         const gchar* pluginName, const gchar* pluginPath, const gchar* pluginSymbol,
         const gchar* preloadName, const gchar* preloadPath, gchar* arguments);
+void host_foreachApplication(Host* host, GFunc func, gpointer userData);
 void host_freeAllApplications(Host* host);
 
 gint host_compare(gconstpointer a, gconstpointer b, gpointer user_data);
 GQuark host_getID(Host* host);
+guint host_getIndex(Host* host);
 gboolean host_isEqual(Host* a, Host* b);
 CPU* host_getCPU(Host* host);
 gchar* host_getName(Host* host);
@@ -70,6 +87,7 @@ Address* host_getDefaultAddress(Host* host);
 in_addr_t host_getDefaultIP(Host* host);
 Random* host_getRandom(Host* host);
 gdouble host_getNextPacketPriority(Host* host);
+guint64 host_getNextPacketID(Host* host);
 
 gboolean host_autotuneReceiveBuffer(Host* host);
 gboolean host_autotuneSendBuffer(Host* host);
@@ -78,6 +96,7 @@ gint host_createDescriptor(Host* host, DescriptorType type);
 void host_closeDescriptor(Host* host, gint handle);
 gint host_closeUser(Host* host, gint handle);
 Descriptor* host_lookupDescriptor(Host* host, gint handle);
+HandleType host_classifyHandle(Host* host, gint handle, Descriptor** descriptor, gint* osHandle);
 NetworkInterface* host_lookupInterface(Host* host, in_addr_t handle);
 
 void host_returnHandleHack(gint handle);
@@ -100,12 +119,13 @@ gint host_bindToInterface(Host* host, gint handle, const struct sockaddr* addres
 gint host_connectToPeer(Host* host, gint handle, const struct sockaddr* address);
 gint host_listenForPeer(Host* host, gint handle, gint backlog);
 gint host_acceptNewPeer(Host* host, gint handle, in_addr_t* ip, in_port_t* port, gint* acceptedHandle);
-gint host_sendUserData(Host* host, gint handle, gconstpointer buffer, gsize nBytes, in_addr_t ip, in_addr_t port, gsize* bytesCopied);
-gint host_receiveUserData(Host* host, gint handle, gpointer buffer, gsize nBytes, in_addr_t* ip, in_port_t* port, gsize* bytesCopied);
+gint host_sendUserData(Host* host, gint handle, const struct iovec* iov, gint iovcnt, in_addr_t ip, in_addr_t port, gsize* bytesCopied);
+gint host_receiveUserData(Host* host, gint handle, const struct iovec* iov, gint iovcnt, in_addr_t* ip, in_port_t* port, gsize* bytesCopied, gboolean* isTruncated);
 gint host_getPeerName(Host* host, gint handle, const struct sockaddr* address, socklen_t* len);
 gint host_getSocketName(Host* host, gint handle, const struct sockaddr* address, socklen_t* len);
 
 Tracker* host_getTracker(Host* host);
+TimerWheel* host_getTimerWheel(Host* host);
 LogLevel host_getLogLevel(Host* host);
 
 const gchar* host_getDataPath(Host* host);
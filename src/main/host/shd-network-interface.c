@@ -6,15 +6,7 @@
 
 #include "shadow.h"
 
-typedef enum _NetworkInterfaceFlags NetworkInterfaceFlags;
-enum _NetworkInterfaceFlags {
-    NIF_NONE = 0,
-    NIF_SENDING = 1 << 0,
-    NIF_RECEIVING = 1 << 1,
-};
-
 struct _NetworkInterface {
-    NetworkInterfaceFlags flags;
     QDiscMode qdisc;
 
     Address* address;
@@ -26,6 +18,8 @@ struct _NetworkInterface {
 
     /* (protocol,port)-to-socket bindings */
     GHashTable* boundSockets;
+    /* ports of the bound sockets, per protocol, for finding free ports */
+    PortBitmap* boundPorts[PUDP+1];
 
     /* NIC input queue */
     GQueue* inBuffer;
@@ -42,11 +36,18 @@ struct _NetworkInterface {
     gdouble sendNanosecondsConsumed;
     gdouble receiveNanosecondsConsumed;
 
+    /* armed while we are 'sending' or 'receiving' a batch of packets */
+    WheelTimer sendTimer;
+    WheelTimer receiveTimer;
+
     PCapWriter* pcap;
 
     MAGIC_DECLARE;
 };
 
+static void _networkinterface_runReceievedTask(NetworkInterface* interface, gpointer userData);
+static void _networkinterface_runSentTask(NetworkInterface* interface, gpointer userData);
+
 static gint _networkinterface_compareSocket(const Socket* sa, const Socket* sb, gpointer userData) {
     Packet* pa = socket_peekNextPacket(sa);
     Packet* pb = socket_peekNextPacket(sb);
@@ -80,6 +81,12 @@ NetworkInterface* networkinterface_new(Address* address, guint64 bwDownKiBps, gu
     interface->rrQueue = g_queue_new();
     interface->fifoQueue = priorityqueue_new((GCompareDataFunc)_networkinterface_compareSocket, NULL, descriptor_unref);
 
+    /* the host owns us, so the timers need no refs */
+    wheeltimer_init(&(interface->sendTimer), (TaskCallbackFunc)_networkinterface_runSentTask,
+            interface, NULL, NULL, NULL);
+    wheeltimer_init(&(interface->receiveTimer), (TaskCallbackFunc)_networkinterface_runReceievedTask,
+            interface, NULL, NULL, NULL);
+
     /* parse queuing discipline */
     interface->qdisc = (qdisc == QDISC_MODE_NONE) ? QDISC_MODE_FIFO : qdisc;
 
@@ -119,6 +126,11 @@ void networkinterface_free(NetworkInterface* interface) {
     priorityqueue_free(interface->fifoQueue);
 
     g_hash_table_destroy(interface->boundSockets);
+    for(gint i = 0; i <= PUDP; i++) {
+        if(interface->boundPorts[i]) {
+            portbitmap_free(interface->boundPorts[i]);
+        }
+    }
 
     dns_deregister(worker_getDNS(), interface->address);
     address_unref(interface->address);
@@ -161,6 +173,12 @@ guint networkinterface_getAssociationCount(NetworkInterface* interface) {
     return g_hash_table_size(interface->boundSockets);
 }
 
+PortBitmap* networkinterface_getBoundPorts(NetworkInterface* interface, enum ProtocolType protocol) {
+    MAGIC_ASSERT(interface);
+    utility_assert(protocol <= PUDP);
+    return interface->boundPorts[protocol];
+}
+
 void networkinterface_associate(NetworkInterface* interface, Socket* socket) {
     MAGIC_ASSERT(interface);
 
@@ -172,6 +190,14 @@ void networkinterface_associate(NetworkInterface* interface, Socket* socket) {
     /* insert to our storage */
     g_hash_table_replace(interface->boundSockets, GINT_TO_POINTER(key), socket);
     descriptor_ref(socket);
+
+    /* the key holds the protocol above the port, which is in network order */
+    enum ProtocolType protocol = (enum ProtocolType)(key >> 16);
+    utility_assert(protocol <= PUDP);
+    if(!interface->boundPorts[protocol]) {
+        interface->boundPorts[protocol] = portbitmap_new();
+    }
+    portbitmap_set(interface->boundPorts[protocol], ntohs((in_port_t)(key & 0xFFFF)));
 }
 
 void networkinterface_disassociate(NetworkInterface* interface, Socket* socket) {
@@ -180,19 +206,23 @@ void networkinterface_disassociate(NetworkInterface* interface, Socket* socket)
     gint key = socket_getAssociationKey(socket);
 
     /* we will no longer receive packets for this port, this unrefs descriptor */
-    g_hash_table_remove(interface->boundSockets, GINT_TO_POINTER(key));
+    if(g_hash_table_remove(interface->boundSockets, GINT_TO_POINTER(key))) {
+        enum ProtocolType protocol = (enum ProtocolType)(key >> 16);
+        utility_assert(protocol <= PUDP && interface->boundPorts[protocol]);
+        portbitmap_clear(interface->boundPorts[protocol], ntohs((in_port_t)(key & 0xFFFF)));
+    }
 }
 
 static void _networkinterface_capturePacket(NetworkInterface* interface, Packet* packet) {
-    PCapPacket* pcapPacket = g_new0(PCapPacket, 1);
+    PCapPacket pcapPacketStorage;
+    memset(&pcapPacketStorage, 0, sizeof(PCapPacket));
+    PCapPacket* pcapPacket = &pcapPacketStorage;
 
     pcapPacket->headerSize = packet_getHeaderSize(packet);
     pcapPacket->payloadLength = packet_getPayloadLength(packet);
 
-    if(pcapPacket->payloadLength > 0) {
-        pcapPacket->payload = g_new0(guchar, pcapPacket->payloadLength);
-        packet_copyPayload(packet, 0, pcapPacket->payload, pcapPacket->payloadLength);
-    }
+    /* written straight from the packet's payload, which may be NULL if it is synthetic */
+    pcapPacket->payload = packet_peekPayload(packet);
 
     PacketTCPHeader tcpHeader;
     packet_getTCPHeader(packet, &tcpHeader);
@@ -214,12 +244,6 @@ static void _networkinterface_capturePacket(NetworkInterface* interface, Packet*
     }
 
     pcapwriter_writePacket(interface->pcap, pcapPacket);
-
-    if(pcapPacket->payloadLength > 0) {
-        g_free(pcapPacket->payload);
-    }
-
-    g_free(pcapPacket);
 }
 
 static void _networkinterface_runReceievedTask(NetworkInterface* interface, gpointer userData) {
@@ -275,13 +299,9 @@ static void _networkinterface_scheduleNextReceive(NetworkInterface* interface) {
      */
     SimulationTime receiveTime = (SimulationTime) floor(interface->receiveNanosecondsConsumed);
     if(receiveTime >= SIMTIME_ONE_NANOSECOND) {
-        /* we are 'receiving' the packets */
-        interface->flags |= NIF_RECEIVING;
-        /* call back when the packets are 'received' */
-        Task* receivedTask = task_new((TaskCallbackFunc)_networkinterface_runReceievedTask,
-                interface, NULL, NULL, NULL);
-        worker_scheduleTask(receivedTask, receiveTime);
-        task_unref(receivedTask);
+        /* we are 'receiving' the packets, call back when they are 'received' */
+        timerwheel_arm(host_getTimerWheel(worker_getActiveHost()), &(interface->receiveTimer),
+                worker_getCurrentTime() + receiveTime);
     }
 }
 
@@ -301,7 +321,7 @@ void networkinterface_packetArrived(NetworkInterface* interface, Packet* packet)
         packet_addDeliveryStatus(packet, PDS_RCV_INTERFACE_BUFFERED);
 
         /* we need a trigger if we are not currently receiving */
-        if(!(interface->flags & NIF_RECEIVING)) {
+        if(!wheeltimer_isArmed(&(interface->receiveTimer))) {
             _networkinterface_scheduleNextReceive(interface);
         }
     } else {
@@ -313,8 +333,7 @@ void networkinterface_packetArrived(NetworkInterface* interface, Packet* packet)
 void networkinterface_received(NetworkInterface* interface) {
     MAGIC_ASSERT(interface);
 
-    /* we just finished receiving some packets */
-    interface->flags &= ~NIF_RECEIVING;
+    /* we just finished receiving some packets, and our timer is no longer armed */
 
     /* decide how much delay we get to absorb based on the passed time */
     SimulationTime now = worker_getCurrentTime();
@@ -415,10 +434,8 @@ static void _networkinterface_scheduleNextSend(NetworkInterface* interface) {
         if(address_toNetworkIP(interface->address) == packet_getDestinationIP(packet)) {
             /* packet will arrive on our own interface */
             packet_ref(packet);
-            Task* packetTask = task_new((TaskCallbackFunc)networkinterface_packetArrived,
-                    interface, packet, NULL, (TaskArgumentFreeFunc)packet_unref);
-            worker_scheduleTask(packetTask, 1);
-            task_unref(packetTask);
+            worker_scheduleCallback((TaskCallbackFunc)networkinterface_packetArrived,
+                    interface, packet, NULL, (TaskArgumentFreeFunc)packet_unref, 1);
         } else {
             /* let the worker send to remote with appropriate delays */
             worker_sendPacket(packet);
@@ -443,13 +460,9 @@ static void _networkinterface_scheduleNextSend(NetworkInterface* interface) {
      */
     SimulationTime sendTime = (SimulationTime) floor(interface->sendNanosecondsConsumed);
     if(sendTime >= SIMTIME_ONE_NANOSECOND) {
-        /* we are 'sending' the packets */
-        interface->flags |= NIF_SENDING;
-        /* call back when the packets are 'sent' */
-        Task* sentTask = task_new((TaskCallbackFunc)_networkinterface_runSentTask,
-                interface, NULL, NULL, NULL);
-        worker_scheduleTask(sentTask, sendTime);
-        task_unref(sentTask);
+        /* we are 'sending' the packets, call back when they are 'sent' */
+        timerwheel_arm(host_getTimerWheel(worker_getActiveHost()), &(interface->sendTimer),
+                worker_getCurrentTime() + sendTime);
     }
 }
 
@@ -476,7 +489,7 @@ void networkinterface_wantsSend(NetworkInterface* interface, Socket* socket) {
     }
 
     /* trigger a send if we are currently idle */
-    if(!(interface->flags & NIF_SENDING)) {
+    if(!wheeltimer_isArmed(&(interface->sendTimer))) {
         _networkinterface_scheduleNextSend(interface);
     }
 }
@@ -484,8 +497,7 @@ void networkinterface_wantsSend(NetworkInterface* interface, Socket* socket) {
 void networkinterface_sent(NetworkInterface* interface) {
     MAGIC_ASSERT(interface);
 
-    /* we just finished sending some packets */
-    interface->flags &= ~NIF_SENDING;
+    /* we just finished sending some packets, and our timer is no longer armed */
 
     /* decide how much delay we get to absorb based on the passed time */
     SimulationTime now = worker_getCurrentTime();
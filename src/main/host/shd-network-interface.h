@@ -23,6 +23,8 @@ gboolean networkinterface_isAssociated(NetworkInterface* interface, gint key);
 void networkinterface_associate(NetworkInterface* interface, Socket* transport);
 void networkinterface_disassociate(NetworkInterface* interface, Socket* transport);
 guint networkinterface_getAssociationCount(NetworkInterface* interface);
+/* returns the ports (in host order) bound for protocol, or NULL if none ever were */
+PortBitmap* networkinterface_getBoundPorts(NetworkInterface* interface, enum ProtocolType protocol);
 
 void networkinterface_packetArrived(NetworkInterface* interface, Packet* packet);
 void networkinterface_received(NetworkInterface* interface);
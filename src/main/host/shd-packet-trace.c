@@ -0,0 +1,354 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "shadow.h"
+
+#include <fcntl.h>
+#include <glib/gstdio.h>
+
+/* records each worker collects before sorting them into a run */
+#define PACKETTRACE_BUFFER_RECORDS (1 << 16)
+/* records read from each run at a time while merging */
+#define PACKETTRACE_READ_RECORDS 4096
+
+typedef struct _PacketTraceRun PacketTraceRun;
+struct _PacketTraceRun {
+    /* where the run is in the scratch file of its worker */
+    gint fd;
+    goffset offset;
+    gsize numUnread;
+
+    /* the records read from the run while merging */
+    PacketTraceRecord* records;
+    guint numRecords;
+    guint next;
+};
+
+struct _PacketTraceBuffer {
+    PacketTrace* trace;
+    guint threadID;
+
+    PacketTraceRecord* records;
+    guint numRecords;
+
+    /* the sorted runs we wrote to our scratch file */
+    gchar* scratchPath;
+    gint scratchFD;
+    goffset scratchOffset;
+    GQueue* runs;
+
+    MAGIC_DECLARE;
+};
+
+struct _PacketTrace {
+    gchar* path;
+    GMutex lock;
+
+    /* names of the hosts by id, for the header of the trace */
+    GHashTable* hostNames;
+    /* buffers whose runs will be merged when we are freed */
+    GQueue* buffers;
+
+    MAGIC_DECLARE;
+};
+
+/* so packets can skip all tracing work with one check when it is off */
+static gboolean packetTraceIsEnabled = FALSE;
+
+static gint _packettrace_compareRecords(const PacketTraceRecord* a, const PacketTraceRecord* b) {
+    if(a->time != b->time) {
+        return (a->time < b->time) ? -1 : 1;
+    }
+    if(a->hostIndex != b->hostIndex) {
+        return (a->hostIndex < b->hostIndex) ? -1 : 1;
+    }
+    return 0;
+}
+
+static gint _packettrace_compareRecordsWithData(gconstpointer a, gconstpointer b, gpointer userData) {
+    return _packettrace_compareRecords(a, b);
+}
+
+static void _packettrace_writeAll(gint fd, gconstpointer data, gsize length) {
+    const guint8* bytes = data;
+    while(length > 0) {
+        gssize written = write(fd, bytes, length);
+        if(written < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            error("unable to write the packet trace: %s", g_strerror(errno));
+            return;
+        }
+        bytes += written;
+        length -= (gsize) written;
+    }
+}
+
+gboolean packettrace_isEnabled() {
+    return packetTraceIsEnabled;
+}
+
+PacketTrace* packettrace_new(const gchar* path) {
+    PacketTrace* trace = g_new0(PacketTrace, 1);
+    MAGIC_INIT(trace);
+
+    trace->path = g_strdup(path);
+    g_mutex_init(&(trace->lock));
+    trace->hostNames = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+    trace->buffers = g_queue_new();
+
+    packetTraceIsEnabled = TRUE;
+
+    return trace;
+}
+
+void packettrace_addHost(PacketTrace* trace, guint hostIndex, const gchar* hostName) {
+    MAGIC_ASSERT(trace);
+    g_mutex_lock(&(trace->lock));
+    g_hash_table_replace(trace->hostNames, GUINT_TO_POINTER(hostIndex), g_strdup(hostName));
+    g_mutex_unlock(&(trace->lock));
+}
+
+PacketTraceBuffer* packettrace_newBuffer(PacketTrace* trace, guint threadID) {
+    MAGIC_ASSERT(trace);
+
+    PacketTraceBuffer* buffer = g_new0(PacketTraceBuffer, 1);
+    MAGIC_INIT(buffer);
+
+    buffer->trace = trace;
+    buffer->threadID = threadID;
+    buffer->records = g_new(PacketTraceRecord, PACKETTRACE_BUFFER_RECORDS);
+    buffer->runs = g_queue_new();
+
+    buffer->scratchPath = g_strdup_printf("%s.worker-%u", trace->path, threadID);
+    buffer->scratchFD = g_open(buffer->scratchPath, O_RDWR|O_CREAT|O_TRUNC|O_CLOEXEC, 0644);
+    if(buffer->scratchFD < 0) {
+        error("unable to open packet trace scratch file '%s': %s", buffer->scratchPath, g_strerror(errno));
+    }
+
+    return buffer;
+}
+
+static void _packettracebuffer_writeRun(PacketTraceBuffer* buffer) {
+    if(buffer->numRecords == 0) {
+        return;
+    }
+
+    /* the sort is stable, so the changes of a packet at the same time keep their order */
+    g_qsort_with_data(buffer->records, (gint)buffer->numRecords, sizeof(PacketTraceRecord),
+            _packettrace_compareRecordsWithData, NULL);
+
+    gsize length = buffer->numRecords * sizeof(PacketTraceRecord);
+    _packettrace_writeAll(buffer->scratchFD, buffer->records, length);
+
+    PacketTraceRun* run = g_new0(PacketTraceRun, 1);
+    run->fd = buffer->scratchFD;
+    run->offset = buffer->scratchOffset;
+    run->numUnread = buffer->numRecords;
+    g_queue_push_tail(buffer->runs, run);
+
+    buffer->scratchOffset += (goffset) length;
+    buffer->numRecords = 0;
+}
+
+void packettracebuffer_append(PacketTraceBuffer* buffer, SimulationTime time,
+        guint hostIndex, guint64 packetID, PacketDeliveryStatusFlags status) {
+    MAGIC_ASSERT(buffer);
+
+    PacketTraceRecord* record = &(buffer->records[buffer->numRecords++]);
+    record->time = time;
+    record->packetID = packetID;
+    record->hostIndex = (guint32) hostIndex;
+    record->status = (guint32) status;
+
+    if(buffer->numRecords >= PACKETTRACE_BUFFER_RECORDS) {
+        _packettracebuffer_writeRun(buffer);
+    }
+}
+
+void packettrace_storeBuffer(PacketTrace* trace, PacketTraceBuffer* buffer) {
+    MAGIC_ASSERT(trace);
+    MAGIC_ASSERT(buffer);
+
+    _packettracebuffer_writeRun(buffer);
+    g_free(buffer->records);
+    buffer->records = NULL;
+
+    g_mutex_lock(&(trace->lock));
+    g_queue_push_tail(trace->buffers, buffer);
+    g_mutex_unlock(&(trace->lock));
+}
+
+static void _packettracebuffer_free(PacketTraceBuffer* buffer) {
+    MAGIC_ASSERT(buffer);
+
+    g_queue_free_full(buffer->runs, g_free);
+    if(buffer->scratchFD >= 0) {
+        close(buffer->scratchFD);
+        g_unlink(buffer->scratchPath);
+    }
+    g_free(buffer->scratchPath);
+    if(buffer->records) {
+        g_free(buffer->records);
+    }
+
+    MAGIC_CLEAR(buffer);
+    g_free(buffer);
+}
+
+static gint _packettracebuffer_compareThreads(const PacketTraceBuffer* a, const PacketTraceBuffer* b,
+        gpointer userData) {
+    return (a->threadID < b->threadID) ? -1 : (a->threadID > b->threadID) ? 1 : 0;
+}
+
+static gint _packettrace_compareHostIndices(gconstpointer a, gconstpointer b) {
+    guint indexA = GPOINTER_TO_UINT(a), indexB = GPOINTER_TO_UINT(b);
+    return (indexA < indexB) ? -1 : (indexA > indexB) ? 1 : 0;
+}
+
+/* returns the next record of the run, reading more from its file as needed */
+static PacketTraceRecord* _packettracerun_head(PacketTraceRun* run) {
+    if(run->next >= run->numRecords) {
+        if(run->numUnread == 0) {
+            return NULL;
+        }
+
+        guint count = (guint) MIN(run->numUnread, PACKETTRACE_READ_RECORDS);
+        gsize length = count * sizeof(PacketTraceRecord);
+        gssize numRead = pread(run->fd, run->records, length, run->offset);
+        if(numRead != (gssize)length) {
+            error("unable to read a packet trace run: %s", numRead < 0 ? g_strerror(errno) : "short read");
+            run->numUnread = 0;
+            return NULL;
+        }
+
+        run->offset += (goffset) length;
+        run->numUnread -= count;
+        run->numRecords = count;
+        run->next = 0;
+    }
+    return &(run->records[run->next]);
+}
+
+/* heads are ordered by time and host, then by the order of the runs */
+static gboolean _packettrace_isBefore(PacketTraceRun** runs, guint* heap, guint a, guint b) {
+    gint result = _packettrace_compareRecords(_packettracerun_head(runs[heap[a]]),
+            _packettracerun_head(runs[heap[b]]));
+    return (result < 0 || (result == 0 && heap[a] < heap[b])) ? TRUE : FALSE;
+}
+
+static void _packettrace_siftDown(PacketTraceRun** runs, guint* heap, guint heapSize, guint node) {
+    while(TRUE) {
+        guint smallest = node;
+        guint left = 2*node + 1, right = 2*node + 2;
+        if(left < heapSize && _packettrace_isBefore(runs, heap, left, smallest)) {
+            smallest = left;
+        }
+        if(right < heapSize && _packettrace_isBefore(runs, heap, right, smallest)) {
+            smallest = right;
+        }
+        if(smallest == node) {
+            return;
+        }
+        guint swap = heap[node];
+        heap[node] = heap[smallest];
+        heap[smallest] = swap;
+        node = smallest;
+    }
+}
+
+static void _packettrace_writeHeader(PacketTrace* trace, FILE* output) {
+    fwrite(PACKETTRACE_MAGIC, 1, strlen(PACKETTRACE_MAGIC), output);
+
+    GList* hostIndices = g_list_sort(g_hash_table_get_keys(trace->hostNames), _packettrace_compareHostIndices);
+    guint32 numHosts = (guint32) g_list_length(hostIndices);
+    fwrite(&numHosts, sizeof(numHosts), 1, output);
+
+    for(GList* item = hostIndices; item != NULL; item = g_list_next(item)) {
+        const gchar* name = g_hash_table_lookup(trace->hostNames, item->data);
+        guint32 header[2] = {(guint32) GPOINTER_TO_UINT(item->data), (guint32) strlen(name)};
+        fwrite(header, sizeof(header), 1, output);
+        fwrite(name, 1, header[1], output);
+    }
+
+    g_list_free(hostIndices);
+}
+
+static void _packettrace_merge(PacketTrace* trace) {
+    FILE* output = g_fopen(trace->path, "wb");
+    if(!output) {
+        critical("unable to open packet trace file '%s': %s", trace->path, g_strerror(errno));
+        return;
+    }
+
+    _packettrace_writeHeader(trace, output);
+
+    /* ordering the buffers by thread makes ties between runs break the same way every time */
+    g_queue_sort(trace->buffers, (GCompareDataFunc)_packettracebuffer_compareThreads, NULL);
+
+    GPtrArray* runArray = g_ptr_array_new();
+    for(GList* item = g_queue_peek_head_link(trace->buffers); item != NULL; item = g_list_next(item)) {
+        PacketTraceBuffer* buffer = item->data;
+        for(GList* runItem = g_queue_peek_head_link(buffer->runs); runItem != NULL; runItem = g_list_next(runItem)) {
+            PacketTraceRun* run = runItem->data;
+            run->records = g_new(PacketTraceRecord, PACKETTRACE_READ_RECORDS);
+            g_ptr_array_add(runArray, run);
+        }
+    }
+
+    PacketTraceRun** runs = (PacketTraceRun**) runArray->pdata;
+    guint* heap = g_new(guint, runArray->len + 1);
+    guint heapSize = 0;
+    for(guint i = 0; i < runArray->len; i++) {
+        if(_packettracerun_head(runs[i]) != NULL) {
+            heap[heapSize++] = i;
+        }
+    }
+    for(guint i = heapSize / 2; i > 0; i--) {
+        _packettrace_siftDown(runs, heap, heapSize, i - 1);
+    }
+
+    /* always write the earliest head of any run */
+    guint64 numRecords = 0;
+    while(heapSize > 0) {
+        PacketTraceRun* run = runs[heap[0]];
+        fwrite(_packettracerun_head(run), sizeof(PacketTraceRecord), 1, output);
+        numRecords++;
+
+        run->next++;
+        if(_packettracerun_head(run) == NULL) {
+            heap[0] = heap[--heapSize];
+        }
+        _packettrace_siftDown(runs, heap, heapSize, 0);
+    }
+
+    for(guint i = 0; i < runArray->len; i++) {
+        g_free(runs[i]->records);
+        runs[i]->records = NULL;
+    }
+    g_free(heap);
+    g_ptr_array_free(runArray, TRUE);
+
+    fclose(output);
+
+    message("wrote %"G_GUINT64_FORMAT" packet status changes to '%s'", numRecords, trace->path);
+}
+
+void packettrace_free(PacketTrace* trace) {
+    MAGIC_ASSERT(trace);
+
+    _packettrace_merge(trace);
+
+    g_queue_free_full(trace->buffers, (GDestroyNotify)_packettracebuffer_free);
+    g_hash_table_destroy(trace->hostNames);
+    g_mutex_clear(&(trace->lock));
+    g_free(trace->path);
+
+    packetTraceIsEnabled = FALSE;
+
+    MAGIC_CLEAR(trace);
+    g_free(trace);
+}
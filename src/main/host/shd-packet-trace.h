@@ -0,0 +1,52 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_PACKET_TRACE_H_
+#define SHD_PACKET_TRACE_H_
+
+/**
+ * An opt-in binary trace of every packet delivery status change.
+ *
+ * Each worker appends (simulation time, host, packet, status) records to its
+ * own PacketTraceBuffer without any locking or formatting. A full buffer is
+ * sorted and written as a run to a scratch file of the worker. When the
+ * simulation ends, the runs of all workers are merged into a single trace
+ * sorted by time, and the scratch files are removed.
+ *
+ * The trace starts with PACKETTRACE_MAGIC, followed by a u32 count of hosts
+ * and for each host its u32 index, u32 name length and name, followed by the
+ * records until the end of the file, in the byte order of the machine that ran
+ * shadow. Use src/tools/decode-packet-trace.py to print it as text.
+ */
+
+#define PACKETTRACE_MAGIC "shadow-packet-trace-1\n"
+
+typedef struct _PacketTraceRecord PacketTraceRecord;
+struct _PacketTraceRecord {
+    SimulationTime time;
+    guint64 packetID;
+    /* the index of the host, or 0 if no host was active */
+    guint32 hostIndex;
+    guint32 status;
+};
+
+typedef struct _PacketTrace PacketTrace;
+typedef struct _PacketTraceBuffer PacketTraceBuffer;
+
+PacketTrace* packettrace_new(const gchar* path);
+/* merges all stored buffers into the trace file */
+void packettrace_free(PacketTrace* trace);
+gboolean packettrace_isEnabled();
+
+void packettrace_addHost(PacketTrace* trace, guint hostIndex, const gchar* hostName);
+
+PacketTraceBuffer* packettrace_newBuffer(PacketTrace* trace, guint threadID);
+/* hands the buffer over to be merged, freeing it */
+void packettrace_storeBuffer(PacketTrace* trace, PacketTraceBuffer* buffer);
+
+void packettracebuffer_append(PacketTraceBuffer* buffer, SimulationTime time,
+        guint hostIndex, guint64 packetID, PacketDeliveryStatusFlags status);
+
+#endif /* SHD_PACKET_TRACE_H_ */
@@ -6,7 +6,16 @@
 
 #include "shadow.h"
 
-/* thread-safe structure representing a data/network packet */
+/* structure representing a data/network packet.
+ *
+ * a packet is shared by the workers of the sending and receiving hosts. its
+ * headers and payload are only written before the packet is handed to
+ * worker_sendPacket and are read-only afterwards, so they are accessed without
+ * locking. the reference count and delivery status may change on any worker
+ * and are updated atomically. */
+
+/* the number of delivery status changes we remember for debug logging */
+#define PACKET_STATUS_HISTORY_LENGTH 32
 
 typedef struct _PacketLocalHeader PacketLocalHeader;
 struct _PacketLocalHeader {
@@ -26,12 +35,12 @@ struct _PacketUDPHeader {
 };
 
 struct _Packet {
-    GMutex lock;
-    guint referenceCount;
+    gint referenceCount;
 
     enum ProtocolType protocol;
     gpointer header;
-    gpointer payload;
+    /* shared with copies of this packet, and read in place by the pcap writer */
+    Payload* payload;
     guint payloadLength;
 
     /* tracks application priority so we flush packets from the interface to
@@ -42,41 +51,59 @@ struct _Packet {
     gdouble priority;
 
     PacketDeliveryStatusFlags allStatus;
-    GQueue* orderedStatus;
+    /* only recorded when debug logging is on. the slot is reserved atomically,
+     * and statuses past the length of the history are not recorded. each
+     * status is a single flag, so we store its bit position plus one. */
+    gint orderedStatusCount;
+    guint8 orderedStatus[PACKET_STATUS_HISTORY_LENGTH];
+
+    /* only set when packets are traced, otherwise 0 */
+    guint64 id;
 
     SimulationTime dropNotificationDelay;
 
     MAGIC_DECLARE;
 };
 
-Packet* packet_new(gconstpointer payload, gsize payloadLength) {
-    Packet* packet = g_new0(Packet, 1);
+static void _packet_setTraceID(Packet* packet) {
+    if(packettrace_isEnabled()) {
+        Host* host = worker_getActiveHost();
+        packet->id = host ? host_getNextPacketID(host) : 0;
+    }
+}
+
+static Packet* _packet_new(Payload* payload) {
+    Packet* packet = worker_newPooledObject(OBJECT_TYPE_PACKET, sizeof(Packet));
     MAGIC_INIT(packet);
 
-    g_mutex_init(&(packet->lock));
     packet->referenceCount = 1;
+    _packet_setTraceID(packet);
 
-    if(payload != NULL && payloadLength > 0) {
-        packet->payload = g_malloc0(payloadLength);
-        g_memmove(packet->payload, payload, payloadLength);
-        packet->payloadLength = payloadLength;
-        utility_assert(packet->payload);
+    if(payload != NULL) {
+        packet->payload = payload;
+        packet->payloadLength = (guint) payload_getLength(payload);
 
         /* application data needs a priority ordering for FIFO onto the wire */
         packet->priority = host_getNextPacketPriority(worker_getActiveHost());
     }
 
-    packet->orderedStatus = g_queue_new();
-
     worker_countObject(OBJECT_TYPE_PACKET, COUNTER_TYPE_NEW);
     return packet;
 }
 
+Packet* packet_new(gconstpointer payload, gsize payloadLength) {
+    return _packet_new((payload != NULL && payloadLength > 0) ?
+            payload_new(payload, payloadLength) : NULL);
+}
+
+Packet* packet_newFromIOVec(IOVecCursor* cursor, gsize payloadLength) {
+    return _packet_new((cursor != NULL && payloadLength > 0) ?
+            payload_newFromIOVec(cursor, payloadLength) : NULL);
+}
+
 static void _packet_free(Packet* packet) {
     MAGIC_ASSERT(packet);
 
-    g_mutex_clear(&(packet->lock));
-
     if(packet->protocol == PTCP) {
         PacketTCPHeader* header = (PacketTCPHeader*)packet->header;
         if(header->selectiveACKs) {
@@ -88,68 +115,89 @@ static void _packet_free(Packet* packet) {
         g_free(packet->header);
     }
     if(packet->payload) {
-        g_free(packet->payload);
-    }
-    if(packet->orderedStatus) {
-        g_queue_free(packet->orderedStatus);
+        payload_unref(packet->payload);
     }
 
     MAGIC_CLEAR(packet);
-    g_free(packet);
+    worker_freePooledObject(packet);
 
     worker_countObject(OBJECT_TYPE_PACKET, COUNTER_TYPE_FREE);
 }
 
-static void _packet_lock(Packet* packet) {
+Packet* packet_copy(Packet* packet) {
     MAGIC_ASSERT(packet);
-    g_mutex_lock(&(packet->lock));
-}
 
-static void _packet_unlock(Packet* packet) {
-    MAGIC_ASSERT(packet);
-    g_mutex_unlock(&(packet->lock));
+    Packet* copy = worker_newPooledObject(OBJECT_TYPE_PACKET, sizeof(Packet));
+    MAGIC_INIT(copy);
+
+    copy->referenceCount = 1;
+    /* a copy is traced as a packet of its own */
+    _packet_setTraceID(copy);
+    copy->protocol = packet->protocol;
+    copy->priority = packet->priority;
+    copy->dropNotificationDelay = packet->dropNotificationDelay;
+    copy->allStatus = (PacketDeliveryStatusFlags) g_atomic_int_get((gint*)&(packet->allStatus));
+
+    if(packet->payload) {
+        payload_ref(packet->payload);
+        copy->payload = packet->payload;
+        copy->payloadLength = packet->payloadLength;
+    }
+
+    switch(packet->protocol) {
+        case PLOCAL: {
+            copy->header = g_memdup(packet->header, sizeof(PacketLocalHeader));
+            break;
+        }
+        case PUDP: {
+            copy->header = g_memdup(packet->header, sizeof(PacketUDPHeader));
+            break;
+        }
+        case PTCP: {
+            PacketTCPHeader* header = g_memdup(packet->header, sizeof(PacketTCPHeader));
+            /* we store integers in the data pointers, so a shallow copy is OK */
+            header->selectiveACKs = g_list_copy(header->selectiveACKs);
+            copy->header = header;
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+
+    worker_countObject(OBJECT_TYPE_PACKET, COUNTER_TYPE_NEW);
+    return copy;
 }
 
 void packet_ref(Packet* packet) {
-    _packet_lock(packet);
-    (packet->referenceCount)++;
-    _packet_unlock(packet);
+    MAGIC_ASSERT(packet);
+    g_atomic_int_inc(&(packet->referenceCount));
 }
 
 void packet_unref(Packet* packet) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
 
-    (packet->referenceCount)--;
-    if(packet->referenceCount == 0) {
-        _packet_unlock(packet);
+    if(g_atomic_int_dec_and_test(&(packet->referenceCount))) {
         packet_addDeliveryStatus(packet, PDS_DESTROYED);
         _packet_free(packet);
-    } else {
-        _packet_unlock(packet);
     }
 }
 
 gint packet_compareTCPSequence(Packet* packet1, Packet* packet2, gpointer user_data) {
-    /* packet1 for one worker might be packet2 for another, dont lock both
-     * at once or a deadlock will occur */
-    guint sequence1 = 0, sequence2 = 0;
-
-    _packet_lock(packet1);
+    MAGIC_ASSERT(packet1);
+    MAGIC_ASSERT(packet2);
     utility_assert(packet1->protocol == PTCP);
-    sequence1 = ((PacketTCPHeader*)(packet1->header))->sequence;
-    _packet_unlock(packet1);
-
-    _packet_lock(packet2);
     utility_assert(packet2->protocol == PTCP);
-    sequence2 = ((PacketTCPHeader*)(packet2->header))->sequence;
-    _packet_unlock(packet2);
+
+    guint sequence1 = ((PacketTCPHeader*)(packet1->header))->sequence;
+    guint sequence2 = ((PacketTCPHeader*)(packet2->header))->sequence;
 
     return sequence1 < sequence2 ? -1 : sequence1 > sequence2 ? 1 : 0;
 }
 
 void packet_setLocal(Packet* packet, enum ProtocolLocalFlags flags,
         gint sourceDescriptorHandle, gint destinationDescriptorHandle, in_port_t port) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
     utility_assert(!(packet->header) && packet->protocol == PNONE);
     utility_assert(port > 0);
 
@@ -162,13 +210,12 @@ void packet_setLocal(Packet* packet, enum ProtocolLocalFlags flags,
 
     packet->header = header;
     packet->protocol = PLOCAL;
-    _packet_unlock(packet);
 }
 
 void packet_setUDP(Packet* packet, enum ProtocolUDPFlags flags,
         in_addr_t sourceIP, in_port_t sourcePort,
         in_addr_t destinationIP, in_port_t destinationPort) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
     utility_assert(!(packet->header) && packet->protocol == PNONE);
     utility_assert(sourceIP && sourcePort && destinationIP && destinationPort);
 
@@ -182,13 +229,12 @@ void packet_setUDP(Packet* packet, enum ProtocolUDPFlags flags,
 
     packet->header = header;
     packet->protocol = PUDP;
-    _packet_unlock(packet);
 }
 
 void packet_setTCP(Packet* packet, enum ProtocolTCPFlags flags,
         in_addr_t sourceIP, in_port_t sourcePort,
         in_addr_t destinationIP, in_port_t destinationPort, guint sequence) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
     utility_assert(!(packet->header) && packet->protocol == PNONE);
     utility_assert(sourceIP && sourcePort && destinationIP && destinationPort);
 
@@ -203,12 +249,11 @@ void packet_setTCP(Packet* packet, enum ProtocolTCPFlags flags,
 
     packet->header = header;
     packet->protocol = PTCP;
-    _packet_unlock(packet);
 }
 
 void packet_updateTCP(Packet* packet, guint acknowledgement, GList* selectiveACKs,
         guint window, SimulationTime timestampValue, SimulationTime timestampEcho) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
     utility_assert(packet->header && (packet->protocol == PTCP));
 
     PacketTCPHeader* header = (PacketTCPHeader*) packet->header;
@@ -230,7 +275,6 @@ void packet_updateTCP(Packet* packet, guint acknowledgement, GList* selectiveACK
     header->timestampValue = timestampValue;
     header->timestampEcho = timestampEcho;
 
-    _packet_unlock(packet);
 }
 
 guint packet_getPayloadLength(Packet* packet) {
@@ -244,15 +288,14 @@ gdouble packet_getPriority(Packet* packet) {
 }
 
 guint packet_getHeaderSize(Packet* packet) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
     guint size = packet->protocol == PUDP ? CONFIG_HEADER_SIZE_UDPIPETH :
             packet->protocol == PTCP ? CONFIG_HEADER_SIZE_TCPIPETH : 0;
-    _packet_unlock(packet);
     return size;
 }
 
 in_addr_t packet_getDestinationIP(Packet* packet) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
 
     in_addr_t ip = 0;
 
@@ -280,12 +323,11 @@ in_addr_t packet_getDestinationIP(Packet* packet) {
         }
     }
 
-    _packet_unlock(packet);
     return ip;
 }
 
 in_addr_t packet_getSourceIP(Packet* packet) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
 
     in_addr_t ip = 0;
 
@@ -313,12 +355,11 @@ in_addr_t packet_getSourceIP(Packet* packet) {
         }
     }
 
-    _packet_unlock(packet);
     return ip;
 }
 
 in_port_t packet_getSourcePort(Packet* packet) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
 
     in_port_t port = 0;
 
@@ -347,28 +388,40 @@ in_port_t packet_getSourcePort(Packet* packet) {
         }
     }
 
-    _packet_unlock(packet);
     return port;
 }
 
 guint packet_copyPayload(Packet* packet, gsize payloadOffset, gpointer buffer, gsize bufferLength) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
 
     utility_assert(payloadOffset <= packet->payloadLength);
 
-    guint targetLength = packet->payloadLength - ((guint)payloadOffset);
-    guint copyLength = MIN(targetLength, bufferLength);
+    if(!packet->payload) {
+        return 0;
+    }
+
+    return (guint) payload_copyData(packet->payload, payloadOffset, buffer, bufferLength);
+}
 
-    if(copyLength > 0) {
-        g_memmove(buffer, packet->payload + payloadOffset, copyLength);
+guint packet_copyPayloadToIOVec(Packet* packet, gsize payloadOffset, IOVecCursor* cursor, gsize nBytes) {
+    MAGIC_ASSERT(packet);
+
+    utility_assert(payloadOffset <= packet->payloadLength);
+
+    if(!packet->payload) {
+        return 0;
     }
 
-    _packet_unlock(packet);
-    return copyLength;
+    return (guint) payload_copyToIOVec(packet->payload, payloadOffset, cursor, nBytes);
+}
+
+gconstpointer packet_peekPayload(Packet* packet) {
+    MAGIC_ASSERT(packet);
+    return packet->payload ? payload_peekData(packet->payload) : NULL;
 }
 
 gint packet_getDestinationAssociationKey(Packet* packet) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
 
     in_port_t port = 0;
     switch (packet->protocol) {
@@ -398,12 +451,11 @@ gint packet_getDestinationAssociationKey(Packet* packet) {
 
     gint key = PROTOCOL_DEMUX_KEY(packet->protocol, port);
 
-    _packet_unlock(packet);
     return key;
 }
 
 gint packet_getSourceAssociationKey(Packet* packet) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
 
     in_port_t port = 0;
     switch (packet->protocol) {
@@ -433,12 +485,11 @@ gint packet_getSourceAssociationKey(Packet* packet) {
 
     gint key = PROTOCOL_DEMUX_KEY(packet->protocol, port);
 
-    _packet_unlock(packet);
     return key;
 }
 
 GList* packet_copyTCPSelectiveACKs(Packet* packet) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
     utility_assert(packet->protocol == PTCP);
 
     PacketTCPHeader* packetHeader = (PacketTCPHeader*)packet->header;
@@ -450,7 +501,6 @@ GList* packet_copyTCPSelectiveACKs(Packet* packet) {
         selectiveACKsCopy = g_list_copy(packetHeader->selectiveACKs);
     }
 
-    _packet_unlock(packet);
 
     return selectiveACKsCopy;
 }
@@ -460,7 +510,7 @@ void packet_getTCPHeader(Packet* packet, PacketTCPHeader* header) {
         return;
     }
 
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
 
     utility_assert(packet->protocol == PTCP);
 
@@ -481,7 +531,6 @@ void packet_getTCPHeader(Packet* packet, PacketTCPHeader* header) {
     /* don't copy the selective acks list here; use packet_copyTCPSelectiveACKs for that */
     header->selectiveACKs = NULL;
 
-    _packet_unlock(packet);
 }
 
 static const gchar* _packet_deliveryStatusToAscii(PacketDeliveryStatusFlags status) {
@@ -512,8 +561,6 @@ static const gchar* _packet_deliveryStatusToAscii(PacketDeliveryStatusFlags stat
 static gchar* _packet_getString(Packet* packet) {
     GString* packetString = g_string_new("");
 
-    //_packet_lock(packet);
-
     switch (packet->protocol) {
         case PLOCAL: {
             PacketLocalHeader* header = packet->header;
@@ -606,60 +653,50 @@ static gchar* _packet_getString(Packet* packet) {
     
     g_string_append_printf(packetString, " status=");
 
-    guint statusLength = g_queue_get_length(packet->orderedStatus);
-    for(int i = 0; i < statusLength; i++) {
-        gpointer statusPtr = g_queue_pop_head(packet->orderedStatus);
-        PacketDeliveryStatusFlags status = (PacketDeliveryStatusFlags) GPOINTER_TO_UINT(statusPtr);
+    gint statusLength = MIN(g_atomic_int_get(&(packet->orderedStatusCount)), PACKET_STATUS_HISTORY_LENGTH);
+    for(gint i = 0; i < statusLength; i++) {
+        guint8 position = packet->orderedStatus[i];
+        PacketDeliveryStatusFlags status = position ? (PacketDeliveryStatusFlags)(1 << (position - 1)) : PDS_NONE;
 
         if(i < statusLength - 1) {
             g_string_append_printf(packetString, "%s,", _packet_deliveryStatusToAscii(status));
         } else {
             g_string_append_printf(packetString, "%s", _packet_deliveryStatusToAscii(status));
         }
-
-        g_queue_push_tail(packet->orderedStatus, statusPtr);
     }
 
-    //_packet_unlock(packet);
     return g_string_free(packetString, FALSE);
 }
 
 void packet_addDeliveryStatus(Packet* packet, PacketDeliveryStatusFlags status) {
-    gboolean skipDebug = worker_isFiltered(LOGLEVEL_DEBUG);
-    gchar* packetStr = NULL;
-
-    _packet_lock(packet);
-    packet->allStatus |= status;
+    MAGIC_ASSERT(packet);
+    g_atomic_int_or((guint*)&(packet->allStatus), (guint)status);
 
-    if(!skipDebug) {
-        g_queue_push_tail(packet->orderedStatus, GUINT_TO_POINTER(status));
-        packetStr = _packet_getString(packet);
+    if(packet->id != 0) {
+        worker_tracePacketStatus(packet->id, status);
     }
 
-    _packet_unlock(packet);
-
-    if(!skipDebug) {
+    if(logger_isEnabled(LOGLEVEL_DEBUG) && !worker_isFiltered(LOGLEVEL_DEBUG)) {
+        gint slot = g_atomic_int_add(&(packet->orderedStatusCount), 1);
+        if(slot < PACKET_STATUS_HISTORY_LENGTH) {
+            packet->orderedStatus[slot] = (guint8)(status ? g_bit_nth_lsf((gulong)status, -1) + 1 : 0);
+        }
+        gchar* packetStr = _packet_getString(packet);
         message("[%s] %s", _packet_deliveryStatusToAscii(status), packetStr);
+        g_free(packetStr);
     }
 }
 
 PacketDeliveryStatusFlags packet_getDeliveryStatus(Packet* packet) {
-    _packet_lock(packet);
-    PacketDeliveryStatusFlags flags = packet->allStatus;
-    _packet_unlock(packet);
-    return flags;
+    MAGIC_ASSERT(packet);
+    return (PacketDeliveryStatusFlags) g_atomic_int_get((gint*)&(packet->allStatus));
 }
 
 void packet_setDropNotificationDelay(Packet* packet, SimulationTime delay) {
     MAGIC_ASSERT(packet);
-    _packet_lock(packet);
     packet->dropNotificationDelay = delay;
-    _packet_unlock(packet);
 }
 SimulationTime packet_getDropNotificationDelay(Packet* packet) {
     MAGIC_ASSERT(packet);
-    _packet_lock(packet);
-    SimulationTime delay = packet->dropNotificationDelay;
-    _packet_unlock(packet);
-    return delay;
+    return packet->dropNotificationDelay;
 }
@@ -50,7 +50,12 @@ struct _PacketTCPHeader {
 };
 
 Packet* packet_new(gconstpointer payload, gsize payloadLength);
+/* creates the payload by gathering payloadLength bytes from the cursor */
+Packet* packet_newFromIOVec(IOVecCursor* cursor, gsize payloadLength);
 
+/* returns a new packet with the same headers and payload, for when the
+ * headers of a packet that was already sent need to change */
+Packet* packet_copy(Packet* packet);
 void packet_ref(Packet* packet);
 void packet_unref(Packet* packet);
 
@@ -63,6 +68,8 @@ void packet_setTCP(Packet* packet, enum ProtocolTCPFlags flags,
         in_addr_t sourceIP, in_port_t sourcePort,
         in_addr_t destinationIP, in_port_t destinationPort, guint sequence);
 
+/* must only be called before the packet is sent, since the receiver reads the
+ * headers of sent packets without locking */
 void packet_updateTCP(Packet* packet, guint acknowledgement, GList* selectiveACKs,
         guint window, SimulationTime timestampValue, SimulationTime timestampEcho);
 
@@ -73,6 +80,10 @@ in_addr_t packet_getDestinationIP(Packet* packet);
 in_addr_t packet_getSourceIP(Packet* packet);
 in_port_t packet_getSourcePort(Packet* packet);
 guint packet_copyPayload(Packet* packet, gsize payloadOffset, gpointer buffer, gsize bufferLength);
+guint packet_copyPayloadToIOVec(Packet* packet, gsize payloadOffset, IOVecCursor* cursor, gsize nBytes);
+/* returns the payload bytes without copying them, or NULL if there are none
+ * or the payload is synthetic */
+gconstpointer packet_peekPayload(Packet* packet);
 GList* packet_copyTCPSelectiveACKs(Packet* packet);
 void packet_getTCPHeader(Packet* packet, PacketTCPHeader* header);
 gint packet_compareTCPSequence(Packet* packet1, Packet* packet2, gpointer user_data);
@@ -0,0 +1,116 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "shadow.h"
+
+struct _Payload {
+    gint referenceCount;
+    gsize length;
+    /* FALSE if this is a synthetic payload, in which case data holds no bytes */
+    gboolean hasData;
+    MAGIC_DECLARE;
+    /* the bytes are stored in the same pooled object as the payload */
+    guchar data[];
+};
+
+static Payload* _payload_new(gboolean hasData, gsize dataLength) {
+    utility_assert(dataLength > 0);
+
+    /* the callers fill in all of the data, so only the struct is zeroed */
+    Payload* payload = worker_newPooledObjectWithData(OBJECT_TYPE_PAYLOAD,
+            sizeof(Payload), hasData ? dataLength : 0);
+    MAGIC_INIT(payload);
+
+    payload->referenceCount = 1;
+    payload->length = dataLength;
+    payload->hasData = hasData;
+
+    worker_countObject(OBJECT_TYPE_PAYLOAD, COUNTER_TYPE_NEW);
+    return payload;
+}
+
+Payload* payload_new(gconstpointer data, gsize dataLength) {
+    gboolean hasData = (data != NULL && !options_doUseSyntheticPayloads(worker_getOptions())) ? TRUE : FALSE;
+    Payload* payload = _payload_new(hasData, dataLength);
+
+    if(hasData) {
+        memcpy(payload->data, data, dataLength);
+    }
+
+    return payload;
+}
+
+Payload* payload_newFromIOVec(IOVecCursor* cursor, gsize dataLength) {
+    utility_assert(cursor);
+
+    gboolean hasData = !options_doUseSyntheticPayloads(worker_getOptions());
+    Payload* payload = _payload_new(hasData, dataLength);
+
+    /* copy straight out of the caller's buffers, or just consume them */
+    gsize consumed = hasData ? iovcursor_gather(cursor, payload->data, dataLength) :
+            iovcursor_skip(cursor, dataLength);
+    utility_assert(consumed == dataLength);
+
+    return payload;
+}
+
+static void _payload_free(Payload* payload) {
+    MAGIC_ASSERT(payload);
+    MAGIC_CLEAR(payload);
+    worker_freePooledObject(payload);
+    worker_countObject(OBJECT_TYPE_PAYLOAD, COUNTER_TYPE_FREE);
+}
+
+void payload_ref(Payload* payload) {
+    MAGIC_ASSERT(payload);
+    g_atomic_int_inc(&(payload->referenceCount));
+}
+
+void payload_unref(Payload* payload) {
+    MAGIC_ASSERT(payload);
+    if(g_atomic_int_dec_and_test(&(payload->referenceCount))) {
+        _payload_free(payload);
+    }
+}
+
+gsize payload_getLength(Payload* payload) {
+    MAGIC_ASSERT(payload);
+    return payload->length;
+}
+
+gconstpointer payload_peekData(Payload* payload) {
+    MAGIC_ASSERT(payload);
+    return payload->hasData ? payload->data : NULL;
+}
+
+gsize payload_copyData(Payload* payload, gsize offset, gpointer buffer, gsize bufferLength) {
+    MAGIC_ASSERT(payload);
+    utility_assert(offset <= payload->length);
+
+    gsize copyLength = MIN(payload->length - offset, bufferLength);
+
+    if(copyLength > 0) {
+        if(payload->hasData) {
+            memcpy(buffer, payload->data + offset, copyLength);
+        } else {
+            memset(buffer, 0, copyLength);
+        }
+    }
+
+    return copyLength;
+}
+
+gsize payload_copyToIOVec(Payload* payload, gsize offset, IOVecCursor* cursor, gsize nBytes) {
+    MAGIC_ASSERT(payload);
+    utility_assert(offset <= payload->length);
+
+    gsize copyLength = MIN(payload->length - offset, nBytes);
+
+    if(copyLength > 0) {
+        copyLength = iovcursor_scatter(cursor, payload->hasData ? payload->data + offset : NULL, copyLength);
+    }
+
+    return copyLength;
+}
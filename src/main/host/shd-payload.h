@@ -0,0 +1,35 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_PAYLOAD_H_
+#define SHD_PAYLOAD_H_
+
+#include "shadow.h"
+
+/*
+ * The application data carried by a packet. The data is copied in once when
+ * the payload is created and is read-only afterwards, so a payload can be
+ * shared without copying by every packet, pcap writer, and receiver that
+ * needs it. A synthetic payload only carries its length, and reads as zeros.
+ */
+typedef struct _Payload Payload;
+
+/* copies data into a new payload, or creates a synthetic one if the simulation
+ * is configured to not carry payload bytes */
+Payload* payload_new(gconstpointer data, gsize dataLength);
+/* same as payload_new, but gathers the data directly from the cursor's iovecs */
+Payload* payload_newFromIOVec(IOVecCursor* cursor, gsize dataLength);
+void payload_ref(Payload* payload);
+void payload_unref(Payload* payload);
+
+gsize payload_getLength(Payload* payload);
+/* returns the payload bytes, or NULL if the payload is synthetic */
+gconstpointer payload_peekData(Payload* payload);
+/* copies up to bufferLength bytes starting at offset into buffer, and returns the number copied */
+gsize payload_copyData(Payload* payload, gsize offset, gpointer buffer, gsize bufferLength);
+/* same as payload_copyData, but scatters into the iovecs at the cursor */
+gsize payload_copyToIOVec(Payload* payload, gsize offset, IOVecCursor* cursor, gsize nBytes);
+
+#endif /* SHD_PAYLOAD_H_ */
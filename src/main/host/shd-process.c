@@ -196,6 +196,8 @@ struct _Process {
 
     /* the portable thread state this process uses when executing the program */
     pth_gctx_t tstate;
+    /* stack statistics of tstate, as of when it was freed */
+    pth_stackstats_t stackStats;
     /* the main fd used to wait for notifications from shadow */
     gint epollfd;
 
@@ -267,6 +269,8 @@ static ProcessContext _process_changeContext(Process* proc, ProcessContext from,
         prevContext = proc->activeContext;
         proc->activeContext = to;
     }
+    /* let the interposer know where calls from this thread should go */
+    worker_setEmulatedProcess(to == PCTX_SHADOW ? NULL : proc);
     return prevContext;
 }
 
@@ -293,6 +297,29 @@ static const gchar* _process_getName(Process* proc) {
     return proc->processName->str;
 }
 
+const gchar* process_getName(Process* proc) {
+    return _process_getName(proc);
+}
+
+void process_getStackStats(Process* proc, gsize* numSpawned, gsize* numReused, gsize* highWaterBytes) {
+    MAGIC_ASSERT(proc);
+
+    pth_stackstats_t stats = proc->stackStats;
+    if(proc->tstate != NULL) {
+        pth_gctx_get_stackstats(proc->tstate, &stats);
+    }
+
+    if(numSpawned) {
+        *numSpawned = (gsize) stats.spawned;
+    }
+    if(numReused) {
+        *numReused = (gsize) stats.reused;
+    }
+    if(highWaterBytes) {
+        *highWaterBytes = (gsize) stats.highwater;
+    }
+}
+
 static void _process_updateErrnoLocation(Process* proc) {
     /* clear dlerror status string */
     dlerror();
@@ -602,7 +629,7 @@ static void _process_logCachedWarnings(Process* proc) {
     if(proc->cachedWarningMessages) {
         gchar* msgStr = NULL;
         while((msgStr = g_queue_pop_head(proc->cachedWarningMessages)) != NULL) {
-            warning(msgStr);
+            warning("%s", msgStr);
             g_free(msgStr);
         }
     }
@@ -670,10 +697,12 @@ static void _process_free(Process* proc) {
 
 static FILE* _process_openFile(Process* proc, const gchar* prefix) {
     const gchar* hostDataPath = host_getDataPath(proc->host);
+    Compressor* compressor = compressor_getDefault();
     GString* fileNameString = g_string_new(NULL);
-    g_string_printf(fileNameString, "%s-%s.log", prefix, _process_getName(proc));
+    g_string_printf(fileNameString, "%s-%s.log%s", prefix, _process_getName(proc),
+            compressor ? compressor_getFileSuffix() : "");
     gchar* pathStr = g_build_filename(hostDataPath, fileNameString->str, NULL);
-    FILE* f = g_fopen(pathStr, "a");
+    FILE* f = compressor ? compressor_fopen(compressor, pathStr) : g_fopen(pathStr, "a");
     g_string_free(fileNameString, TRUE);
     if(!f) {
         /* if we log as normal, glib will freak out about recursion if the plugin was trying to log with glib */
@@ -1295,6 +1324,9 @@ void process_stop(Process* proc) {
         proc->programMainThread = NULL;
     }
 
+    /* keep the stack statistics around for the tracker */
+    pth_gctx_get_stackstats(proc->tstate, &proc->stackStats);
+
     /* now we are done with all pth state */
     pth_gctx_free(proc->tstate);
     proc->tstate = NULL;
@@ -1327,19 +1359,15 @@ void process_schedule(Process* proc, gpointer nothing) {
     if(proc->stopTime == 0 || proc->startTime < proc->stopTime) {
         SimulationTime startDelay = proc->startTime <= now ? 1 : proc->startTime - now;
         process_ref(proc);
-        Task* startProcessTask = task_new((TaskCallbackFunc)_process_runStartTask,
-                proc, NULL, (TaskObjectFreeFunc)process_unref, NULL);
-        worker_scheduleTask(startProcessTask, startDelay);
-        task_unref(startProcessTask);
+        worker_scheduleCallback((TaskCallbackFunc)_process_runStartTask,
+                proc, NULL, (TaskObjectFreeFunc)process_unref, NULL, startDelay);
     }
 
     if(proc->stopTime > 0 && proc->stopTime > proc->startTime) {
         SimulationTime stopDelay = proc->stopTime <= now ? 1 : proc->stopTime - now;
         process_ref(proc);
-        Task* stopProcessTask = task_new((TaskCallbackFunc)_process_runStopTask,
-                proc, NULL, (TaskObjectFreeFunc)process_unref, NULL);
-        worker_scheduleTask(stopProcessTask, stopDelay);
-        task_unref(stopProcessTask);
+        worker_scheduleCallback((TaskCallbackFunc)_process_runStopTask,
+                proc, NULL, (TaskObjectFreeFunc)process_unref, NULL, stopDelay);
     }
 }
 
@@ -1452,8 +1480,8 @@ static gint _process_emu_addressHelper(Process* proc, gint fd, const struct sock
     return 0;
 }
 
-static gssize _process_emu_sendHelper(Process* proc, gint fd, gconstpointer buf, gsize n, gint flags,
-        const struct sockaddr* addr, socklen_t len) {
+static gssize _process_emu_sendvHelper(Process* proc, gint fd, const struct iovec* iov, gint iovcnt,
+        gint flags, const struct sockaddr* addr, socklen_t len) {
     /* this function MUST be called after switching in shadow context */
     utility_assert(proc->activeContext == PCTX_SHADOW);
 
@@ -1475,7 +1503,7 @@ static gssize _process_emu_sendHelper(Process* proc, gint fd, gconstpointer buf,
     }
 
     gsize bytes = 0;
-    gint result = host_sendUserData(proc->host, fd, buf, n, ip, port, &bytes);
+    gint result = host_sendUserData(proc->host, fd, iov, iovcnt, ip, port, &bytes);
 
     if(result != 0) {
         _process_setErrno(proc, result);
@@ -1484,8 +1512,14 @@ static gssize _process_emu_sendHelper(Process* proc, gint fd, gconstpointer buf,
     return (gssize) bytes;
 }
 
-static gssize _process_emu_recvHelper(Process* proc, gint fd, gpointer buf, size_t n, gint flags,
-        struct sockaddr* addr, socklen_t* len) {
+static gssize _process_emu_sendHelper(Process* proc, gint fd, gconstpointer buf, gsize n, gint flags,
+        const struct sockaddr* addr, socklen_t len) {
+    struct iovec vec = {(gpointer)buf, n};
+    return _process_emu_sendvHelper(proc, fd, &vec, 1, flags, addr, len);
+}
+
+static gssize _process_emu_recvvHelper(Process* proc, gint fd, const struct iovec* iov, gint iovcnt,
+        gint flags, struct sockaddr* addr, socklen_t* len, gboolean* isTruncated) {
     /* this function MUST be called after switching in shadow context */
     utility_assert(proc->activeContext == PCTX_SHADOW);
 
@@ -1500,7 +1534,7 @@ static gssize _process_emu_recvHelper(Process* proc, gint fd, gpointer buf, size
     in_port_t port = 0;
 
     gsize bytes = 0;
-    gint result = host_receiveUserData(proc->host, fd, buf, n, &ip, &port, &bytes);
+    gint result = host_receiveUserData(proc->host, fd, iov, iovcnt, &ip, &port, &bytes, isTruncated);
 
     if(result != 0) {
         _process_setErrno(proc, result);
@@ -1519,6 +1553,77 @@ static gssize _process_emu_recvHelper(Process* proc, gint fd, gpointer buf, size
     return (gssize) bytes;
 }
 
+static gssize _process_emu_recvHelper(Process* proc, gint fd, gpointer buf, size_t n, gint flags,
+        struct sockaddr* addr, socklen_t* len) {
+    struct iovec vec = {buf, n};
+    return _process_emu_recvvHelper(proc, fd, &vec, 1, flags, addr, len, NULL);
+}
+
+/* rpth wraps neither the msg nor the mmsg calls, so when a plug-in makes them on
+ * a blocking socket we do the same wait for readiness that pth does in its
+ * other I/O wrappers before the transfer itself is attempted */
+static void _process_emu_awaitDescriptor(Process* proc, gint fd, gint flags, DescriptorStatus status) {
+    /* this function MUST be called after switching in shadow context from the plugin */
+    utility_assert(proc->activeContext == PCTX_SHADOW);
+
+    Descriptor* descriptor = host_lookupDescriptor(proc->host, fd);
+    if(!descriptor || (flags & MSG_DONTWAIT) || (descriptor_getFlags(descriptor) & O_NONBLOCK) ||
+            (descriptor_getStatus(descriptor) & (status|DS_CLOSED))) {
+        return;
+    }
+
+    _process_changeContext(proc, PCTX_SHADOW, PCTX_PTH);
+    utility_assert(proc->tstate == pth_gctx_get());
+    pth_event_t ev = pth_event(PTH_EVENT_FD|((status & DS_READABLE) ?
+            PTH_UNTIL_FD_READABLE : PTH_UNTIL_FD_WRITEABLE), fd);
+    if(ev != NULL) {
+        pth_wait(ev);
+        pth_event_free(ev, PTH_FREE_THIS);
+    }
+    _process_changeContext(proc, PCTX_PTH, PCTX_SHADOW);
+}
+
+static gssize _process_emu_sendmsgHelper(Process* proc, gint fd, const struct msghdr* message, gint flags) {
+    /* this function MUST be called after switching in shadow context */
+    utility_assert(proc->activeContext == PCTX_SHADOW);
+
+    if(message->msg_iovlen > IOV_MAX) {
+        _process_setErrno(proc, EMSGSIZE);
+        return -1;
+    }
+
+    /* control messages are not supported and are ignored */
+    return _process_emu_sendvHelper(proc, fd, message->msg_iov, (gint) message->msg_iovlen,
+            flags, (const struct sockaddr*) message->msg_name, message->msg_namelen);
+}
+
+static gssize _process_emu_recvmsgHelper(Process* proc, gint fd, struct msghdr* message, gint flags) {
+    /* this function MUST be called after switching in shadow context */
+    utility_assert(proc->activeContext == PCTX_SHADOW);
+
+    if(message->msg_iovlen > IOV_MAX) {
+        _process_setErrno(proc, EMSGSIZE);
+        return -1;
+    }
+
+    gboolean isTruncated = FALSE;
+    gssize ret = _process_emu_recvvHelper(proc, fd, message->msg_iov, (gint) message->msg_iovlen,
+            flags, (struct sockaddr*) message->msg_name, message->msg_name ? &message->msg_namelen : NULL,
+            &isTruncated);
+
+    if(ret >= 0) {
+        if(!message->msg_name) {
+            message->msg_namelen = 0;
+        }
+        /* we never produce control messages */
+        message->msg_controllen = 0;
+        /* the datagram did not fit in the buffers and the rest was discarded */
+        message->msg_flags = isTruncated ? MSG_TRUNC : 0;
+    }
+
+    return ret;
+}
+
 static gint _process_emu_fcntlHelper(Process* proc, int fd, int cmd, void* argp) {
     /* check if this is a socket */
     ProcessContext prevCTX = _process_changeContext(proc, proc->activeContext, PCTX_SHADOW);
@@ -2265,12 +2370,72 @@ ssize_t process_emu_sendto(Process* proc, int fd, const void *buf, size_t n, int
 }
 
 ssize_t process_emu_sendmsg(Process* proc, int fd, const struct msghdr *message, int flags) {
-    /* TODO implement */
     ProcessContext prevCTX = _process_changeContext(proc, proc->activeContext, PCTX_SHADOW);
-    warning("sendmsg not implemented");
-    _process_setErrno(proc, ENOSYS);
+    gssize ret = 0;
+
+    if(!message) {
+        _process_setErrno(proc, EFAULT);
+        ret = -1;
+    } else if(!host_isShadowDescriptor(proc->host, fd)) {
+        gint osfd = host_getOSHandle(proc->host, fd);
+        if(osfd >= 0) {
+            ret = sendmsg(osfd, message, flags);
+            if(ret < 0) {
+                _process_setErrno(proc, errno);
+            }
+        } else {
+            _process_setErrno(proc, EBADF);
+            ret = -1;
+        }
+    } else {
+        if(prevCTX == PCTX_PLUGIN) {
+            _process_emu_awaitDescriptor(proc, fd, flags, DS_WRITABLE);
+        }
+        ret = _process_emu_sendmsgHelper(proc, fd, message, flags);
+    }
+
     _process_changeContext(proc, PCTX_SHADOW, prevCTX);
-    return -1;
+    return ret;
+}
+
+int process_emu_sendmmsg(Process* proc, int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags) {
+    ProcessContext prevCTX = _process_changeContext(proc, proc->activeContext, PCTX_SHADOW);
+    gint ret = 0;
+
+    if(!msgvec) {
+        _process_setErrno(proc, EFAULT);
+        ret = -1;
+    } else if(!host_isShadowDescriptor(proc->host, fd)) {
+        gint osfd = host_getOSHandle(proc->host, fd);
+        if(osfd >= 0) {
+            ret = sendmmsg(osfd, msgvec, vlen, flags);
+            if(ret < 0) {
+                _process_setErrno(proc, errno);
+            }
+        } else {
+            _process_setErrno(proc, EBADF);
+            ret = -1;
+        }
+    } else {
+        if(prevCTX == PCTX_PLUGIN) {
+            _process_emu_awaitDescriptor(proc, fd, flags, DS_WRITABLE);
+        }
+
+        /* like the kernel, we only block for the first message and report an
+         * error only if nothing could be sent */
+        guint i = 0;
+        for(i = 0; i < MIN(vlen, (guint)IOV_MAX); i++) {
+            gssize n = _process_emu_sendmsgHelper(proc, fd, &msgvec[i].msg_hdr, flags);
+            if(n < 0) {
+                break;
+            }
+            msgvec[i].msg_len = (guint) n;
+        }
+        ret = (i > 0 || vlen == 0) ? (gint) i : -1;
+    }
+
+    _process_changeContext(proc, PCTX_SHADOW, prevCTX);
+    return ret;
 }
 
 ssize_t process_emu_recv(Process* proc, int fd, void *buf, size_t n, int flags) {
@@ -2310,12 +2475,73 @@ ssize_t process_emu_recvfrom(Process* proc, int fd, void *buf, size_t n, int fla
 }
 
 ssize_t process_emu_recvmsg(Process* proc, int fd, struct msghdr *message, int flags) {
-    /* TODO implement */
     ProcessContext prevCTX = _process_changeContext(proc, proc->activeContext, PCTX_SHADOW);
-    warning("recvmsg not implemented");
-    _process_setErrno(proc, ENOSYS);
+    gssize ret = 0;
+
+    if(!message) {
+        _process_setErrno(proc, EFAULT);
+        ret = -1;
+    } else if(!host_isShadowDescriptor(proc->host, fd)) {
+        gint osfd = host_getOSHandle(proc->host, fd);
+        if(osfd >= 0) {
+            ret = recvmsg(osfd, message, flags);
+            if(ret < 0) {
+                _process_setErrno(proc, errno);
+            }
+        } else {
+            _process_setErrno(proc, EBADF);
+            ret = -1;
+        }
+    } else {
+        if(prevCTX == PCTX_PLUGIN) {
+            _process_emu_awaitDescriptor(proc, fd, flags, DS_READABLE);
+        }
+        ret = _process_emu_recvmsgHelper(proc, fd, message, flags);
+    }
+
     _process_changeContext(proc, PCTX_SHADOW, prevCTX);
-    return -1;
+    return ret;
+}
+
+int process_emu_recvmmsg(Process* proc, int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags, struct timespec *timeout) {
+    ProcessContext prevCTX = _process_changeContext(proc, proc->activeContext, PCTX_SHADOW);
+    gint ret = 0;
+
+    if(!msgvec) {
+        _process_setErrno(proc, EFAULT);
+        ret = -1;
+    } else if(!host_isShadowDescriptor(proc->host, fd)) {
+        gint osfd = host_getOSHandle(proc->host, fd);
+        if(osfd >= 0) {
+            ret = recvmmsg(osfd, msgvec, vlen, flags, timeout);
+            if(ret < 0) {
+                _process_setErrno(proc, errno);
+            }
+        } else {
+            _process_setErrno(proc, EBADF);
+            ret = -1;
+        }
+    } else {
+        if(prevCTX == PCTX_PLUGIN) {
+            _process_emu_awaitDescriptor(proc, fd, flags, DS_READABLE);
+        }
+
+        /* we only block for the first message, as if MSG_WAITFORONE were always
+         * set, and then drain whatever is already buffered. the timeout would
+         * only matter while waiting for more, so it is ignored. */
+        guint i = 0;
+        for(i = 0; i < MIN(vlen, (guint)IOV_MAX); i++) {
+            gssize n = _process_emu_recvmsgHelper(proc, fd, &msgvec[i].msg_hdr, flags);
+            if(n < 0) {
+                break;
+            }
+            msgvec[i].msg_len = (guint) n;
+        }
+        ret = (i > 0 || vlen == 0) ? (gint) i : -1;
+    }
+
+    _process_changeContext(proc, PCTX_SHADOW, prevCTX);
+    return ret;
 }
 
 int process_emu_getsockopt(Process* proc, int fd, int level, int optname, void* optval, socklen_t* optlen) {
@@ -2608,7 +2834,11 @@ ssize_t process_emu_read(Process* proc, int fd, void *buff, size_t numbytes) {
     ProcessContext prevCTX = _process_changeContext(proc, proc->activeContext, PCTX_SHADOW);
     gssize ret = 0;
 
-    if(prevCTX == PCTX_PLUGIN && host_isShadowDescriptor(proc->host, fd)) {
+    Descriptor* desc = NULL;
+    gint osfd = -1;
+    HandleType htype = host_classifyHandle(proc->host, fd, &desc, &osfd);
+
+    if(prevCTX == PCTX_PLUGIN && htype == HT_DESCRIPTOR) {
         _process_changeContext(proc, PCTX_SHADOW, PCTX_PTH);
         utility_assert(proc->tstate == pth_gctx_get());
         ret = pth_read(fd, buff, numbytes);
@@ -2619,19 +2849,21 @@ ssize_t process_emu_read(Process* proc, int fd, void *buff, size_t numbytes) {
     } else if(prevCTX == PCTX_PLUGIN && (fd == STDOUT_FILENO || fd == STDERR_FILENO)) {
         ret = fread(buff, numbytes, 1, _process_getIOFile(proc, fd));
     } else {
-        if(host_isShadowDescriptor(proc->host, fd)){
-            Descriptor* desc = host_lookupDescriptor(proc->host, fd);
+        if(htype == HT_DESCRIPTOR){
             if(descriptor_getType(desc) == DT_TIMER) {
                 ret = timer_read((Timer*) desc, buff, numbytes);
             } else {
                 ret = _process_emu_recvHelper(proc, fd, buff, numbytes, 0, NULL, 0);
             }
-        } else if(host_isRandomHandle(proc->host, fd)) {
+        } else if(htype == HT_RANDOM) {
             Random* random = host_getRandom(proc->host);
             random_nextNBytes(random, (guchar*)buff, numbytes);
             ret = (ssize_t) numbytes;
         } else {
-            gint osfd = host_getOSHandle(proc->host, fd);
+            /* stdin, stdout, and stderr map to themselves */
+            if(htype != HT_OSFILE) {
+                osfd = host_getOSHandle(proc->host, fd);
+            }
             if(osfd >= 0) {
                 ret = read(osfd, buff, numbytes);
                 if(ret < 0) {
@@ -2655,7 +2887,10 @@ ssize_t process_emu_write(Process* proc, int fd, const void *buff, size_t n) {
     }
     ProcessContext prevCTX = _process_changeContext(proc, proc->activeContext, PCTX_SHADOW);
 
-    if(prevCTX == PCTX_PLUGIN && host_isShadowDescriptor(proc->host, fd)) {
+    gint osfd = -1;
+    HandleType htype = host_classifyHandle(proc->host, fd, NULL, &osfd);
+
+    if(prevCTX == PCTX_PLUGIN && htype == HT_DESCRIPTOR) {
         _process_changeContext(proc, PCTX_SHADOW, PCTX_PTH);
         utility_assert(proc->tstate == pth_gctx_get());
         ret = pth_write(fd, buff, n);
@@ -2673,10 +2908,13 @@ ssize_t process_emu_write(Process* proc, int fd, const void *buff, size_t n) {
             debug("%.*s", n-1, buff);
         }
     } else {
-        if(host_isShadowDescriptor(proc->host, fd)){
+        if(htype == HT_DESCRIPTOR){
             ret = _process_emu_sendHelper(proc, fd, buff, n, 0, NULL, 0);
         } else {
-            gint osfd = host_getOSHandle(proc->host, fd);
+            /* stdin, stdout, and stderr map to themselves */
+            if(htype != HT_OSFILE && htype != HT_RANDOM) {
+                osfd = host_getOSHandle(proc->host, fd);
+            }
             if(osfd >= 0) {
                 ret = write(osfd, buff, n);
                 if(ret < 0) {
@@ -2720,36 +2958,24 @@ ssize_t process_emu_readv(Process* proc, int fd, const struct iovec *iov, int io
         if (iovcnt < 0 || iovcnt > IOV_MAX) {
             _process_setErrno(proc, EINVAL);
             ret = -1;
+        } else if (iovec_getLength(iov, iovcnt) == 0) {
+            ret = 0;
         } else {
-            /* figure out how much they want to read total */
-            int i = 0;
-            size_t totalIOLength = 0;
-            for (i = 0; i < iovcnt; i++) {
-                totalIOLength += iov[i].iov_len;
-            }
-
-            if (totalIOLength == 0) {
-                ret = 0;
-            } else {
-                /* get a temporary buffer and read to it */
-                void* tempBuffer = g_malloc0(totalIOLength);
-                _process_changeContext(proc, PCTX_SHADOW, prevCTX);
-                ssize_t totalBytesRead = process_emu_read(proc, fd, tempBuffer, totalIOLength);
-                _process_changeContext(proc, prevCTX, PCTX_SHADOW);
-
-                if (totalBytesRead > 0) {
-                    /* place all of the bytes we read in the iov buffers */
-                    size_t bytesCopied = 0;
-                    for (i = 0; i < iovcnt; i++) {
-                        size_t bytesRemaining = (size_t) (totalBytesRead - bytesCopied);
-                        size_t bytesToCopy = MIN(bytesRemaining, iov[i].iov_len);
-                        g_memmove(iov[i].iov_base, tempBuffer+bytesCopied, bytesToCopy);
-                        bytesCopied += bytesToCopy;
-                    }
+            Descriptor* desc = host_lookupDescriptor(proc->host, fd);
+            if(desc && descriptor_getType(desc) == DT_TIMER) {
+                /* timers only ever hand out a single expiration counter */
+                guint64 expirations = 0;
+                ret = timer_read((Timer*) desc, &expirations, MIN(iovec_getLength(iov, iovcnt), sizeof(guint64)));
+                if(ret > 0) {
+                    IOVecCursor cursor;
+                    iovcursor_init(&cursor, iov, iovcnt);
+                    iovcursor_scatter(&cursor, &expirations, (gsize) ret);
+                } else if(ret < 0) {
+                    _process_setErrno(proc, errno);
                 }
-
-                g_free(tempBuffer);
-                ret = totalBytesRead;
+            } else {
+                /* the transport scatters directly into the iov buffers */
+                ret = _process_emu_recvvHelper(proc, fd, iov, iovcnt, 0, NULL, 0, NULL);
             }
         }
     }
@@ -2785,36 +3011,11 @@ ssize_t process_emu_writev(Process* proc, int fd, const struct iovec *iov, int i
         if(iovcnt < 0 || iovcnt > IOV_MAX) {
             _process_setErrno(proc, EINVAL);
             ret = -1;
+        } else if(iovec_getLength(iov, iovcnt) == 0) {
+            ret = 0;
         } else {
-            /* figure out how much they want to write total */
-            int i = 0;
-            size_t totalIOLength = 0;
-            for(i = 0; i < iovcnt; i++) {
-                totalIOLength += iov[i].iov_len;
-            }
-
-            if(totalIOLength == 0) {
-                ret = 0;
-            } else {
-                /* get a temporary buffer and write to it */
-                void* tempBuffer = g_malloc0(totalIOLength);
-                size_t bytesCopied = 0;
-                for(i = 0; i < iovcnt; i++) {
-                    g_memmove(tempBuffer+bytesCopied, iov[i].iov_base, iov[i].iov_len);
-                    bytesCopied += iov[i].iov_len;
-                }
-
-                ssize_t totalBytesWritten = 0;
-                if(bytesCopied > 0) {
-                    /* try to write all of the bytes we got from the iov buffers */
-                    _process_changeContext(proc, PCTX_SHADOW, prevCTX);
-                    totalBytesWritten = process_emu_write(proc, fd, tempBuffer, bytesCopied);
-                    _process_changeContext(proc, prevCTX, PCTX_SHADOW);
-                }
-
-                g_free(tempBuffer);
-                ret = totalBytesWritten;
-            }
+            /* the transport segments directly from the iov buffers */
+            ret = _process_emu_sendvHelper(proc, fd, iov, iovcnt, 0, NULL, 0);
         }
     }
 
@@ -2908,6 +3109,7 @@ int process_emu_close(Process* proc, int fd) {
         if(osfd == STDOUT_FILENO) {
             if(proc->stdoutFile) {
                 ret = fclose(proc->stdoutFile);
+                proc->stdoutFile = NULL;
                 if(ret == EOF) {
                     _process_setErrno(proc, errno);
                 }
@@ -2915,6 +3117,7 @@ int process_emu_close(Process* proc, int fd) {
         } else if (osfd == STDERR_FILENO) {
             if(proc->stderrFile) {
                 ret = fclose(proc->stderrFile);
+                proc->stderrFile = NULL;
                 if(ret == EOF) {
                     _process_setErrno(proc, errno);
                 }
@@ -3769,7 +3972,8 @@ int process_emu_fsync(Process* proc, int fd) {
 
     if(prevCTX == PCTX_PLUGIN && (fd == STDOUT_FILENO || fd == STDERR_FILENO)) {
         FILE* f = _process_getIOFile(proc, fd);
-        ret = fsync(fileno(f));
+        /* compressed output files have no descriptor of their own */
+        ret = (fileno(f) >= 0) ? fsync(fileno(f)) : fflush(f);
         if(ret == -1) {
             _process_setErrno(proc, errno);
         }
@@ -4325,20 +4529,20 @@ int process_emu_fflush(Process* proc, FILE *stream) {
 
 /* time family */
 
-/* make sure we return the 'emulated' time, and not the actual simulation clock */
-EmulatedTime _process_getEmulatedTimeHelper(Process* proc) {
-    return worker_getEmulatedTime();
+/* make sure we return the 'emulated' time, and not the actual simulation clock.
+ * none of the time functions call anything that could be intercepted, so they
+ * skip the context switch and just read the time the worker published. the
+ * preload library answers the common cases the same way without calling us. */
+static inline EmulatedTime _process_getEmulatedTimeHelper(Process* proc) {
+    return workerEmulatedTime;
 }
 
 time_t process_emu_time(Process* proc, time_t *t)  {
-    ProcessContext prevCTX = _process_changeContext(proc, proc->activeContext, PCTX_SHADOW);
-
     EmulatedTime now = _process_getEmulatedTimeHelper(proc);
     time_t secs = (time_t) (now / SIMTIME_ONE_SECOND);
     if(t != NULL){
         *t = secs;
     }
-    _process_changeContext(proc, PCTX_SHADOW, prevCTX);
     return secs;
 }
 
@@ -4348,28 +4552,18 @@ int process_emu_clock_gettime(Process* proc, clockid_t clk_id, struct timespec *
         return -1;
     }
 
-    ProcessContext prevCTX = _process_changeContext(proc, proc->activeContext, PCTX_SHADOW);
-
     EmulatedTime now = _process_getEmulatedTimeHelper(proc);
     tp->tv_sec = now / SIMTIME_ONE_SECOND;
     tp->tv_nsec = now % SIMTIME_ONE_SECOND;
 
-    _process_changeContext(proc, PCTX_SHADOW, prevCTX);
     return 0;
 }
 
 int process_emu_gettimeofday(Process* proc, struct timeval* tv, struct timezone* tz) {
     if(tv) {
-        ProcessContext prevCTX = _process_changeContext(proc, proc->activeContext, PCTX_SHADOW);
-
         EmulatedTime now = _process_getEmulatedTimeHelper(proc);
-        EmulatedTime sec = now / (EmulatedTime)SIMTIME_ONE_SECOND;
-        EmulatedTime usec = (now - (sec*(EmulatedTime)SIMTIME_ONE_SECOND)) / (EmulatedTime)SIMTIME_ONE_MICROSECOND;
-        utility_assert(usec < (EmulatedTime)1000000);
-        tv->tv_sec = (time_t)sec;
-        tv->tv_usec = (suseconds_t)usec;
-
-        _process_changeContext(proc, PCTX_SHADOW, prevCTX);
+        tv->tv_sec = (time_t)(now / SIMTIME_ONE_SECOND);
+        tv->tv_usec = (suseconds_t)((now % SIMTIME_ONE_SECOND) / SIMTIME_ONE_MICROSECOND);
     }
     return 0;
 }
@@ -4964,6 +5158,9 @@ int process_emu_syscall(Process* proc, int number, va_list ap) {
 #if defined SYS_recvfrom
         case SYS_recvfrom:
 #endif
+#if defined SYS_recvmmsg
+        case SYS_recvmmsg:
+#endif
 #if defined SYS_recvmsg
         case SYS_recvmsg:
 #endif
@@ -4973,6 +5170,9 @@ int process_emu_syscall(Process* proc, int number, va_list ap) {
 #if defined SYS_send
         case SYS_send:
 #endif
+#if defined SYS_sendmmsg
+        case SYS_sendmmsg:
+#endif
 #if defined SYS_sendmsg
         case SYS_sendmsg:
 #endif
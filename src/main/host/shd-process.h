@@ -91,6 +91,8 @@ void process_migrate(Process* proc, gpointer threads);
 gboolean process_wantsNotify(Process* proc, gint epollfd);
 gboolean process_isRunning(Process* proc);
 gboolean process_shouldEmulate(Process* proc);
+const gchar* process_getName(Process* proc);
+void process_getStackStats(Process* proc, gsize* numSpawned, gsize* numReused, gsize* highWaterBytes);
 
 gboolean process_addAtExitCallback(Process* proc, gpointer userCallback, gpointer userArgument,
         gboolean shouldPassArgument);
@@ -133,9 +135,11 @@ int process_emu_getpeername(Process* proc, int fd, struct sockaddr* addr, sockle
 ssize_t process_emu_send(Process* proc, int fd, const void *buf, size_t n, int flags);
 ssize_t process_emu_sendto(Process* proc, int fd, const void *buf, size_t n, int flags, const struct sockaddr* addr, socklen_t addr_len);
 ssize_t process_emu_sendmsg(Process* proc, int fd, const struct msghdr *message, int flags);
+int process_emu_sendmmsg(Process* proc, int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags);
 ssize_t process_emu_recv(Process* proc, int fd, void *buf, size_t n, int flags);
 ssize_t process_emu_recvfrom(Process* proc, int fd, void *buf, size_t n, int flags, struct sockaddr* addr, socklen_t *addr_len);
 ssize_t process_emu_recvmsg(Process* proc, int fd, struct msghdr *message, int flags);
+int process_emu_recvmmsg(Process* proc, int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags, struct timespec *timeout);
 int process_emu_getsockopt(Process* proc, int fd, int level, int optname, void* optval, socklen_t* optlen);
 int process_emu_setsockopt(Process* proc, int fd, int level, int optname, const void *optval, socklen_t optlen);
 int process_emu_listen(Process* proc, int fd, int n);
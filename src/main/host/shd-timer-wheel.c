@@ -0,0 +1,325 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "shadow.h"
+
+/* slot positions are computed from ticks of 1024 nanoseconds. timers that land
+ * in the same tick are still run in exact expiration time order. */
+#define TIMERWHEEL_TICK_SHIFT 10
+#define TIMERWHEEL_SLOT_BITS 6
+#define TIMERWHEEL_NUM_SLOTS (1 << TIMERWHEEL_SLOT_BITS)
+/* 6 levels of 64 slots cover 2^36 ticks, about 19.5 hours */
+#define TIMERWHEEL_NUM_LEVELS 6
+/* timers further out than the top level covers wait in an unsorted list */
+#define TIMERWHEEL_OVERFLOW_LEVEL TIMERWHEEL_NUM_LEVELS
+
+struct _TimerWheel {
+    /* the tick all of the slot positions are relative to. a timer sits in the
+     * level of the highest 6-bit digit in which its tick differs from this one,
+     * so every timer in a level expires before any timer in the levels above. */
+    guint64 currentTick;
+
+    /* bit s of occupied[l] is set when slots[l][s] is not empty */
+    guint64 occupied[TIMERWHEEL_NUM_LEVELS];
+    WheelTimer* slots[TIMERWHEEL_NUM_LEVELS][TIMERWHEEL_NUM_SLOTS];
+    WheelTimer* overflow;
+
+    guint64 nextSequence;
+
+    /* the earliest time we have a callback event in the scheduler, if any */
+    SimulationTime nextEventTime;
+    /* we reschedule after running the expired timers, not while doing so */
+    gboolean isRunning;
+
+    MAGIC_DECLARE;
+};
+
+void wheeltimer_init(WheelTimer* timer, TaskCallbackFunc callback, gpointer object, gpointer argument,
+        TaskObjectFreeFunc objectRef, TaskObjectFreeFunc objectUnref) {
+    utility_assert(timer);
+    utility_assert(callback);
+
+    memset(timer, 0, sizeof(WheelTimer));
+    timer->callback = callback;
+    timer->object = object;
+    timer->argument = argument;
+    timer->objectRef = objectRef;
+    timer->objectUnref = objectUnref;
+}
+
+gboolean wheeltimer_isArmed(WheelTimer* timer) {
+    utility_assert(timer);
+    return timer->pprev != NULL ? TRUE : FALSE;
+}
+
+SimulationTime wheeltimer_getExpireTime(WheelTimer* timer) {
+    utility_assert(timer);
+    return wheeltimer_isArmed(timer) ? timer->expireTime : SIMTIME_INVALID;
+}
+
+TimerWheel* timerwheel_new() {
+    TimerWheel* wheel = g_new0(TimerWheel, 1);
+    MAGIC_INIT(wheel);
+
+    wheel->nextEventTime = SIMTIME_INVALID;
+
+    return wheel;
+}
+
+void timerwheel_free(TimerWheel* wheel) {
+    MAGIC_ASSERT(wheel);
+
+    /* release the references held by the armed timers. this may free the
+     * objects that own them, so always start again from a slot's head. */
+    for(guint level = 0; level < TIMERWHEEL_NUM_LEVELS; level++) {
+        for(guint slot = 0; slot < TIMERWHEEL_NUM_SLOTS; slot++) {
+            while(wheel->slots[level][slot]) {
+                timerwheel_disarm(wheel, wheel->slots[level][slot]);
+            }
+        }
+    }
+    while(wheel->overflow) {
+        timerwheel_disarm(wheel, wheel->overflow);
+    }
+
+    MAGIC_CLEAR(wheel);
+    g_free(wheel);
+}
+
+static inline guint64 _timerwheel_toTick(SimulationTime time) {
+    return ((guint64)time) >> TIMERWHEEL_TICK_SHIFT;
+}
+
+static void _timerwheel_link(TimerWheel* wheel, WheelTimer* timer) {
+    /* timers that are already due go into the current tick's slot */
+    guint64 tick = MAX(_timerwheel_toTick(timer->expireTime), wheel->currentTick);
+    guint64 diff = tick ^ wheel->currentTick;
+
+    guint level = diff ? (guint)(63 - __builtin_clzll(diff)) / TIMERWHEEL_SLOT_BITS : 0;
+    guint slot = 0;
+    WheelTimer** head = NULL;
+
+    if(level >= TIMERWHEEL_NUM_LEVELS) {
+        level = TIMERWHEEL_OVERFLOW_LEVEL;
+        head = &wheel->overflow;
+    } else {
+        slot = (guint)(tick >> (level * TIMERWHEEL_SLOT_BITS)) & (TIMERWHEEL_NUM_SLOTS - 1);
+        head = &wheel->slots[level][slot];
+        wheel->occupied[level] |= ((guint64)1) << slot;
+    }
+
+    timer->level = (guint8)level;
+    timer->slot = (guint8)slot;
+
+    timer->next = *head;
+    if(timer->next) {
+        timer->next->pprev = &timer->next;
+    }
+    *head = timer;
+    timer->pprev = head;
+}
+
+static void _timerwheel_unlink(TimerWheel* wheel, WheelTimer* timer) {
+    utility_assert(timer->pprev);
+
+    *(timer->pprev) = timer->next;
+    if(timer->next) {
+        timer->next->pprev = timer->pprev;
+    }
+
+    if(timer->level != TIMERWHEEL_OVERFLOW_LEVEL && !wheel->slots[timer->level][timer->slot]) {
+        wheel->occupied[timer->level] &= ~(((guint64)1) << timer->slot);
+    }
+
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+/* place each timer of a detached list again relative to the current tick */
+static void _timerwheel_relink(TimerWheel* wheel, WheelTimer* list) {
+    while(list) {
+        WheelTimer* next = list->next;
+        _timerwheel_link(wheel, list);
+        list = next;
+    }
+}
+
+static WheelTimer* _timerwheel_findEarliest(WheelTimer* list) {
+    WheelTimer* earliest = list;
+    for(WheelTimer* timer = list ? list->next : NULL; timer; timer = timer->next) {
+        if(timer->expireTime < earliest->expireTime ||
+                (timer->expireTime == earliest->expireTime && timer->sequence < earliest->sequence)) {
+            earliest = timer;
+        }
+    }
+    return earliest;
+}
+
+/* the lowest occupied slot of the lowest occupied level holds the earliest
+ * timers, because slots below the current tick's digit are never occupied */
+static WheelTimer* _timerwheel_getEarliestList(TimerWheel* wheel, guint* levelOut, guint* slotOut) {
+    for(guint level = 0; level < TIMERWHEEL_NUM_LEVELS; level++) {
+        if(wheel->occupied[level]) {
+            guint slot = (guint)__builtin_ctzll(wheel->occupied[level]);
+            *levelOut = level;
+            *slotOut = slot;
+            return wheel->slots[level][slot];
+        }
+    }
+    *levelOut = TIMERWHEEL_OVERFLOW_LEVEL;
+    *slotOut = 0;
+    return wheel->overflow;
+}
+
+static SimulationTime _timerwheel_getNextExpireTime(TimerWheel* wheel) {
+    guint level, slot;
+    WheelTimer* earliest = _timerwheel_findEarliest(_timerwheel_getEarliestList(wheel, &level, &slot));
+    return earliest ? earliest->expireTime : SIMTIME_INVALID;
+}
+
+static void _timerwheel_runTimer(WheelTimer* timer) {
+    /* the callback may re-arm the timer, so keep what we need to release our ref */
+    gpointer object = timer->object;
+    TaskObjectFreeFunc objectUnref = timer->objectUnref;
+
+    timer->callback(timer->object, timer->argument);
+
+    if(objectUnref && object) {
+        objectUnref(object);
+    }
+}
+
+/* run every timer expiring at or before now, in order */
+static void _timerwheel_advance(TimerWheel* wheel, SimulationTime now) {
+    guint64 targetTick = _timerwheel_toTick(now);
+
+    while(TRUE) {
+        guint level, slot;
+        WheelTimer* list = _timerwheel_getEarliestList(wheel, &level, &slot);
+
+        if(level == TIMERWHEEL_OVERFLOW_LEVEL) {
+            /* the wheel is empty, jump ahead if the earliest far-out timer is due */
+            WheelTimer* earliest = _timerwheel_findEarliest(list);
+            if(!earliest || _timerwheel_toTick(earliest->expireTime) > targetTick) {
+                break;
+            }
+            wheel->currentTick = _timerwheel_toTick(earliest->expireTime);
+            wheel->overflow = NULL;
+            _timerwheel_relink(wheel, list);
+            continue;
+        }
+
+        guint shift = level * TIMERWHEEL_SLOT_BITS;
+        guint64 slotTick = ((wheel->currentTick >> (shift + TIMERWHEEL_SLOT_BITS)) << (shift + TIMERWHEEL_SLOT_BITS))
+                | (((guint64)slot) << shift);
+        if(slotTick > targetTick) {
+            break;
+        }
+        wheel->currentTick = slotTick;
+
+        if(level > 0) {
+            /* the slot's range started, so spread its timers over the lower levels */
+            wheel->slots[level][slot] = NULL;
+            wheel->occupied[level] &= ~(((guint64)1) << slot);
+            _timerwheel_relink(wheel, list);
+            continue;
+        }
+
+        WheelTimer* earliest = _timerwheel_findEarliest(list);
+        if(earliest->expireTime > now) {
+            break;
+        }
+
+        _timerwheel_unlink(wheel, earliest);
+        _timerwheel_runTimer(earliest);
+    }
+
+    if(targetTick > wheel->currentTick) {
+        wheel->currentTick = targetTick;
+        /* moving the current tick may have brought far-out timers into range */
+        if(wheel->overflow) {
+            WheelTimer* list = wheel->overflow;
+            wheel->overflow = NULL;
+            _timerwheel_relink(wheel, list);
+        }
+    }
+}
+
+static void _timerwheel_run(TimerWheel* wheel, gpointer userData);
+
+static void _timerwheel_scheduleEvent(TimerWheel* wheel, SimulationTime expireTime) {
+    if(wheel->isRunning) {
+        /* we will check for the next deadline when done running timers */
+        return;
+    }
+    if(wheel->nextEventTime != SIMTIME_INVALID && wheel->nextEventTime <= expireTime) {
+        /* we will already wake up in time */
+        return;
+    }
+
+    SimulationTime now = worker_getCurrentTime();
+    SimulationTime eventTime = MAX(expireTime, now);
+
+    /* the wheel is owned by the host and outlives all of its events */
+    if(worker_scheduleCallback((TaskCallbackFunc)_timerwheel_run,
+            wheel, NULL, NULL, NULL, eventTime - now)) {
+        wheel->nextEventTime = eventTime;
+    }
+}
+
+static void _timerwheel_run(TimerWheel* wheel, gpointer userData) {
+    MAGIC_ASSERT(wheel);
+
+    SimulationTime now = worker_getCurrentTime();
+
+    /* events for deadlines that were pulled in earlier may still fire late,
+     * and those just find nothing to do */
+    if(wheel->nextEventTime != SIMTIME_INVALID && wheel->nextEventTime <= now) {
+        wheel->nextEventTime = SIMTIME_INVALID;
+    }
+
+    wheel->isRunning = TRUE;
+    _timerwheel_advance(wheel, now);
+    wheel->isRunning = FALSE;
+
+    SimulationTime nextExpireTime = _timerwheel_getNextExpireTime(wheel);
+    if(nextExpireTime != SIMTIME_INVALID) {
+        _timerwheel_scheduleEvent(wheel, nextExpireTime);
+    }
+}
+
+void timerwheel_arm(TimerWheel* wheel, WheelTimer* timer, SimulationTime expireTime) {
+    MAGIC_ASSERT(wheel);
+    utility_assert(timer && timer->callback);
+
+    if(timer->pprev) {
+        /* re-arming keeps the reference we already hold */
+        _timerwheel_unlink(wheel, timer);
+    } else if(timer->objectRef && timer->object) {
+        timer->objectRef(timer->object);
+    }
+
+    timer->expireTime = expireTime;
+    timer->sequence = wheel->nextSequence++;
+    _timerwheel_link(wheel, timer);
+
+    _timerwheel_scheduleEvent(wheel, expireTime);
+}
+
+void timerwheel_disarm(TimerWheel* wheel, WheelTimer* timer) {
+    MAGIC_ASSERT(wheel);
+    utility_assert(timer);
+
+    if(!timer->pprev) {
+        return;
+    }
+
+    /* any event we scheduled for this timer will find nothing to run */
+    _timerwheel_unlink(wheel, timer);
+
+    if(timer->objectUnref && timer->object) {
+        timer->objectUnref(timer->object);
+    }
+}
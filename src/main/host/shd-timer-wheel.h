@@ -0,0 +1,62 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_TIMER_WHEEL_H_
+#define SHD_TIMER_WHEEL_H_
+
+#include <glib.h>
+
+/**
+ * A hierarchical timing wheel holding the internal timers of a single host,
+ * e.g. TCP retransmission and close timers, timerfd expirations, tracker
+ * heartbeats, and network interface send/receive completions.
+ *
+ * Arming, re-arming, and disarming a timer only relinks it inside of the
+ * wheel and never touches the scheduler. The wheel itself keeps a single
+ * callback event scheduled for its earliest deadline, and runs every timer
+ * that expired when that event fires. Timers that are reset before they
+ * expire (the common case for retransmission timers) therefore no longer
+ * leave stale events behind in the scheduler.
+ *
+ * WheelTimers are owned and embedded by the object they belong to. While a
+ * timer is armed, the wheel holds a reference to that object (if a ref
+ * function was given), which is released after the callback runs or when
+ * the timer is disarmed.
+ */
+
+typedef struct _TimerWheel TimerWheel;
+typedef struct _WheelTimer WheelTimer;
+
+struct _WheelTimer {
+    /* links for the wheel slot the timer is in; pprev is NULL while disarmed */
+    WheelTimer* next;
+    WheelTimer** pprev;
+
+    /* the absolute simulation time at which the callback runs */
+    SimulationTime expireTime;
+    /* breaks ties between timers expiring at the same time in arming order */
+    guint64 sequence;
+    guint8 level;
+    guint8 slot;
+
+    TaskCallbackFunc callback;
+    gpointer object;
+    gpointer argument;
+    TaskObjectFreeFunc objectRef;
+    TaskObjectFreeFunc objectUnref;
+};
+
+void wheeltimer_init(WheelTimer* timer, TaskCallbackFunc callback, gpointer object, gpointer argument,
+        TaskObjectFreeFunc objectRef, TaskObjectFreeFunc objectUnref);
+gboolean wheeltimer_isArmed(WheelTimer* timer);
+SimulationTime wheeltimer_getExpireTime(WheelTimer* timer);
+
+TimerWheel* timerwheel_new();
+void timerwheel_free(TimerWheel* wheel);
+
+void timerwheel_arm(TimerWheel* wheel, WheelTimer* timer, SimulationTime expireTime);
+void timerwheel_disarm(TimerWheel* wheel, WheelTimer* timer);
+
+#endif /* SHD_TIMER_WHEEL_H_ */
@@ -43,6 +43,7 @@ struct _Tracker {
     gboolean didLogNodeHeader;
     gboolean didLogRAMHeader;
     gboolean didLogSocketHeader;
+    gboolean didLogStackHeader;
 
     SimulationTime processingTimeTotal;
     SimulationTime processingTimeLastInterval;
@@ -64,6 +65,8 @@ struct _Tracker {
     GHashTable* socketStats;
 
     SimulationTime lastHeartbeat;
+    /* the tracker belongs to the host, so the timer needs no refs */
+    WheelTimer heartbeatTimer;
 
     MAGIC_DECLARE;
 };
@@ -123,6 +126,9 @@ Tracker* tracker_new(SimulationTime interval, LogLevel loglevel, LogInfoFlags lo
     tracker->allocatedLocations = g_hash_table_new(g_direct_hash, g_direct_equal);
     tracker->socketStats = g_hash_table_new_full(g_int_hash, g_int_equal, NULL, (GDestroyNotify)_socketstats_free);
 
+    wheeltimer_init(&(tracker->heartbeatTimer), (TaskCallbackFunc)tracker_heartbeat,
+            tracker, NULL, NULL, NULL);
+
     /* send an alive message, and start periodic heartbeats */
     tracker_heartbeat(tracker, NULL);
 
@@ -545,6 +551,38 @@ static void _tracker_logRAM(Tracker* tracker, LogLevel level, SimulationTime int
         tracker->allocatedBytesTotal, numptrs, tracker->numFailedFrees);
 }
 
+static void _tracker_appendProcessStack(Process* proc, GString* msg) {
+    gsize numSpawned = 0, numReused = 0, highWaterBytes = 0;
+    process_getStackStats(proc, &numSpawned, &numReused, &highWaterBytes);
+
+    /* print the separator between process logs */
+    if(msg->len > 0) {
+        g_string_append_printf(msg, "|");
+    }
+
+    g_string_append_printf(msg, "%s,%"G_GSIZE_FORMAT",%"G_GSIZE_FORMAT",%"G_GSIZE_FORMAT,
+            process_getName(proc), numSpawned, numReused, highWaterBytes);
+}
+
+static void _tracker_logStack(Tracker* tracker, LogLevel level, SimulationTime interval) {
+    if(!tracker->didLogStackHeader) {
+        tracker->didLogStackHeader = TRUE;
+        logger_log(logger_getDefault(), level, __FILE__, __FUNCTION__, __LINE__,
+                "[shadow-heartbeat] [stack-header] process-name,stacks-spawned,stacks-reused,stack-highwater-bytes|..."); // for each process
+    }
+
+    /* construct the log message from all processes running on our host */
+    GString* msg = g_string_new(NULL);
+    host_foreachApplication(worker_getActiveHost(), (GFunc)_tracker_appendProcessStack, msg);
+
+    if(msg->len > 0) {
+        logger_log(logger_getDefault(), level, __FILE__, __FUNCTION__, __LINE__,
+                "[shadow-heartbeat] [stack] %s", msg->str);
+    }
+
+    g_string_free(msg, TRUE);
+}
+
 void tracker_heartbeat(Tracker* tracker, gpointer userData) {
     MAGIC_ASSERT(tracker);
 
@@ -563,6 +601,11 @@ void tracker_heartbeat(Tracker* tracker, gpointer userData) {
         _tracker_logRAM(tracker, tracker->loglevel, tracker->interval);
     }
 
+    /* check to see if virtual process stack info is being logged */
+    if(tracker->loginfo & LOG_INFO_FLAGS_STACK) {
+        _tracker_logStack(tracker, tracker->loglevel, tracker->interval);
+    }
+
     /* clear interval stats */
     tracker->processingTimeLastInterval = 0;
     tracker->delayTimeLastInterval = 0;
@@ -586,8 +629,6 @@ void tracker_heartbeat(Tracker* tracker, gpointer userData) {
 
     /* schedule the next heartbeat */
     tracker->lastHeartbeat = worker_getCurrentTime();
-    Task* heartbeatTask = task_new((TaskCallbackFunc)tracker_heartbeat,
-            tracker, NULL, NULL, NULL);
-    worker_scheduleTask(heartbeatTask, tracker->interval);
-    task_unref(heartbeatTask);
+    timerwheel_arm(host_getTimerWheel(worker_getActiveHost()), &(tracker->heartbeatTimer),
+            tracker->lastHeartbeat + tracker->interval);
 }
@@ -31,6 +31,9 @@ struct _Address {
 
     gboolean isLocal;
 
+    /* dense index of the topology vertex we are attached to, or -1 if not attached */
+    gint attachmentIndex;
+
     GQuark hostID;
     MAGIC_DECLARE;
 };
@@ -44,6 +47,7 @@ Address* address_new(GQuark hostID, guint mac, guint32 ip, const gchar* name, gb
     address->ip = ip;
     address->ipString = address_ipToNewString((in_addr_t)ip);
     address->isLocal = isLocal;
+    address->attachmentIndex = -1;
     address->name = g_strdup(name);
     address->referenceCount = 1;
 
@@ -89,6 +93,16 @@ gboolean address_isLocal(Address* address) {
     return address->isLocal;
 }
 
+gint address_getAttachmentIndex(Address* address) {
+    MAGIC_ASSERT(address);
+    return address->attachmentIndex;
+}
+
+void address_setAttachmentIndex(Address* address, gint attachmentIndex) {
+    MAGIC_ASSERT(address);
+    address->attachmentIndex = attachmentIndex;
+}
+
 gboolean address_isEqual(Address* a, Address* b) {
     if(a == NULL && b == NULL) {
         return TRUE;
@@ -36,6 +36,14 @@ void address_ref(Address* address);
 void address_unref(Address* address);
 gboolean address_isLocal(Address* address);
 
+/**
+ * The topology assigns each vertex with attached addresses a dense index, and
+ * stores it in the address so that paths can be found without a table lookup.
+ * @return the index, or -1 if the address is not attached to the topology
+ */
+gint address_getAttachmentIndex(Address* address);
+void address_setAttachmentIndex(Address* address, gint attachmentIndex);
+
 /**
  * Checks if the given addresses are equal. This function is NULL safe, so
  * so either or both addresses may be NULL.
@@ -12,7 +12,10 @@ struct _Path {
     gint64 dstVertexIndex;
     gdouble latency;
     gdouble reliability;
-    guint64 packetCount;
+    /* assigned by the topology when the path is cached */
+    guint id;
+    /* workers count packets by path id and add their counts when they finish */
+    gsize packetCount;
     MAGIC_DECLARE;
 };
 
@@ -40,6 +43,11 @@ void path_free(Path* path) {
     g_free(path);
 }
 
+gboolean path_isDirect(Path* path) {
+    MAGIC_ASSERT(path);
+    return path->isDirect;
+}
+
 gdouble path_getLatency(Path* path) {
     MAGIC_ASSERT(path);
     return path->latency;
@@ -50,9 +58,19 @@ gdouble path_getReliability(Path* path) {
     return path->reliability;
 }
 
-void path_incrementPacketCount(Path* path) {
+guint path_getID(Path* path) {
+    MAGIC_ASSERT(path);
+    return path->id;
+}
+
+void path_setID(Path* path, guint id) {
+    MAGIC_ASSERT(path);
+    path->id = id;
+}
+
+void path_addPacketCount(Path* path, gsize count) {
     MAGIC_ASSERT(path);
-    path->packetCount++;
+    g_atomic_pointer_add(&(path->packetCount), count);
 }
 
 gchar* path_toString(Path* path) {
@@ -62,7 +80,7 @@ gchar* path_toString(Path* path) {
 
     g_string_printf(pathStringBuffer,
             "SourceIndex=%"G_GINT64_FORMAT" DestinationIndex=%"G_GINT64_FORMAT" "
-            "Latency=%f Reliability=%f PacketCount=%"G_GUINT64_FORMAT" isDirect=%s",
+            "Latency=%f Reliability=%f PacketCount=%"G_GSIZE_FORMAT" isDirect=%s",
             path->srcVertexIndex, path->dstVertexIndex,
             path->latency, path->reliability, path->packetCount,
             path->isDirect ? "True" : "False");
@@ -14,10 +14,14 @@ typedef struct _Path Path;
 Path* path_new(gboolean isDirect, gint64 srcVertexIndex, gint64 dstVertexIndex, gdouble latency, gdouble reliability);
 void path_free(Path* path);
 
+gboolean path_isDirect(Path* path);
 gdouble path_getLatency(Path* path);
 gdouble path_getReliability(Path* path);
 
-void path_incrementPacketCount(Path* path);
+guint path_getID(Path* path);
+void path_setID(Path* path, guint id);
+
+void path_addPacketCount(Path* path, gsize count);
 
 gchar* path_toString(Path* path);
 
@@ -4,33 +4,128 @@
  * See LICENSE for licensing information
  */
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "shadow.h"
 
+/* identifies path cache files, and the layout of their records */
+#define PATHCACHE_MAGIC "SHDPATHS"
+#define PATHCACHE_VERSION 4
+
+/* the records follow the header, one for each pair of attached vertices that
+ * a path is computed for, sorted by source and then destination vertex so
+ * that they can be searched in place. undirected graphs only have a record
+ * from the lower to the higher vertex of each pair. */
+typedef struct _PathCacheHeader PathCacheHeader;
+struct _PathCacheHeader {
+    gchar magic[8];
+    guint32 version;
+    guint32 numRecords;
+    gdouble minimumLatency;
+};
+
+typedef struct _PathCacheRecord PathCacheRecord;
+struct _PathCacheRecord {
+    gint32 srcVertexIndex;
+    gint32 dstVertexIndex;
+    guint32 isDirect;
+    /* 0 if there is no path between the vertices */
+    guint32 isRoutable;
+    gdouble latency;
+    gdouble reliability;
+};
+
+/* the graph as plain arrays of outgoing arcs per vertex, used to precompute paths */
+typedef struct _RouteGraph RouteGraph;
+struct _RouteGraph {
+    gint numVertices;
+    gboolean isDirected;
+    /* when the edge between two vertices is used as their path, see _routegraph_getRoute */
+    gboolean isComplete;
+    gboolean prefersDirectPaths;
+    /* arcs leaving vertex v are at [arcOffsets[v], arcOffsets[v+1]) */
+    gint* arcOffsets;
+    gint* arcTargets;
+    gdouble* arcLatencies;
+    gdouble* arcReliabilities;
+    gdouble* vertexReliabilities;
+    /* vertex indices of attached vertices, in increasing order */
+    gint numAttached;
+    gint* attachedVertices;
+};
+
+/* the shortest path tree grown from one vertex of a RouteGraph */
+typedef struct _RouteTree RouteTree;
+struct _RouteTree {
+    gint rootVertexIndex;
+    /* for each vertex, the latency from the root and the arc used to reach it,
+     * which is -1 for the root and for vertices that are unreachable */
+    gdouble* distances;
+    gint* predecessorArcs;
+    GArray* heap;
+};
+
+/* number of destinations in each block of a PathIndex row */
+#define PATHINDEX_BLOCK_LENGTH 64
+
+/* cached paths indexed by the attachment index of the source and destination.
+ * rows are split into blocks of destinations, and both rows and blocks are only
+ * allocated once a path in them is used, so memory grows with the number of
+ * communicating vertex pairs rather than with the square of attached vertices.
+ * rows, blocks, and entries are published atomically, so lookups never lock. */
+typedef struct _PathIndex PathIndex;
+struct _PathIndex {
+    gint numVertices;
+    gint numBlocks;
+    /* numVertices rows, each an array of numBlocks blocks of Path pointers */
+    Path**** rows;
+};
+
 struct _Topology {
     /* the imported igraph graph data - operations on it after initializations
      * MUST be locked in cases where igraph is not thread-safe! */
     igraph_t graph;
     GMutex graphLock;
 
-    /* the edge weights currently used when computing shortest paths.
-     * this is protected by its own lock */
-    igraph_vector_t* edgeWeights;
-    GRWLock edgeWeightsLock;
-
     /* each connected virtual host is assigned to a PoI vertex. we store the mapping to the
      * vertex index so we can correctly lookup the assigned edge when computing latency.
      * virtualIP->vertexIndex (stored as pointer) */
     GHashTable* virtualIP;
     GHashTable* verticesWithAttachedHosts;
+    /* vertexIndex->attachmentIndex for vertices with attached hosts */
+    GHashTable* attachmentIndices;
     GRWLock virtualIPLock;
 
     /* cached latencies to avoid excessive shortest path lookups
      * store a cache table for every connected address
      * fromAddress->toAddress->Path* */
     GHashTable* pathCache;
+    /* every path in the cache, indexed by its id */
+    GPtrArray* pathsByID;
     gdouble minimumPathLatency;
     GRWLock pathCacheLock;
 
+    /* a loaded path cache file or the table of precomputed paths, laid out
+     * like the file, mapped for the rest of the run. a path is only added to
+     * the cache when it is first looked up. */
+    gpointer pathCacheMap;
+    gsize pathCacheMapSize;
+    const PathCacheRecord* mappedPaths;
+    guint32 numMappedPaths;
+
+    /* lock-free index of the paths in the cache, created once all hosts
+     * have been attached */
+    PathIndex* pathIndex;
+
+    /* copy of the graph that all paths are computed from, created when the
+     * first path is needed, after hosts have been attached */
+    RouteGraph* routeGraph;
+    /* sha256 of the graphml file, part of the path cache key */
+    gchar* graphChecksum;
+
     /******/
     /* START - items protected by a global topology lock */
     GMutex topologyLock;
@@ -380,6 +475,16 @@ static gboolean _topology_loadGraph(Topology* top, const gchar* graphPath) {
 
     message("successfully read graphml topology graph at '%s'", graphPath);
 
+    gchar* contents = NULL;
+    gsize length = 0;
+    if(g_file_get_contents(graphPath, &contents, &length, NULL)) {
+        top->graphChecksum = g_compute_checksum_for_data(G_CHECKSUM_SHA256, (const guchar*)contents, length);
+        g_free(contents);
+    } else {
+        /* still usable, just never matches a cached file */
+        top->graphChecksum = g_strdup("");
+    }
+
     return TRUE;
 }
 
@@ -1191,67 +1296,446 @@ static gboolean _topology_checkGraph(Topology* top) {
     return isSuccess;
 }
 
-static gboolean _topology_extractEdgeWeights(Topology* top) {
+static gboolean _topology_verticesAreAdjacent(Topology* top, igraph_integer_t srcVertexIndex, igraph_integer_t dstVertexIndex) {
     MAGIC_ASSERT(top);
 
+    igraph_integer_t edge_id = -1;
+    gint result;
+
     _topology_lockGraph(top);
-    g_rw_lock_writer_lock(&(top->edgeWeightsLock));
+    result = _topology_getEdgeHelper(top, srcVertexIndex, dstVertexIndex, &edge_id, NULL, NULL);
+    _topology_unlockGraph(top);
 
-    /* create new or clear existing edge weights */
-    if(!top->edgeWeights) {
-        top->edgeWeights = g_new0(igraph_vector_t, 1);
-    } else {
-        igraph_vector_destroy(top->edgeWeights);
-        memset(top->edgeWeights, 0, sizeof(igraph_vector_t));
+    if (result != IGRAPH_SUCCESS) {
+        warning("Unable to determine whether or not an edge exists between vertexes %d and %d",
+                srcVertexIndex, dstVertexIndex);
+        return FALSE;
+    }
+    return edge_id >= 0;
+}
+
+static PathIndex* _pathindex_new(gint numVertices) {
+    PathIndex* index = g_new0(PathIndex, 1);
+    index->numVertices = numVertices;
+    index->numBlocks = (numVertices + PATHINDEX_BLOCK_LENGTH - 1) / PATHINDEX_BLOCK_LENGTH;
+    index->rows = g_new0(Path***, MAX(numVertices, 1));
+    return index;
+}
+
+static void _pathindex_free(PathIndex* index) {
+    /* the paths themselves are owned by the path cache */
+    for(gint i = 0; i < index->numVertices; i++) {
+        Path*** row = index->rows[i];
+        if(row) {
+            for(gint j = 0; j < index->numBlocks; j++) {
+                g_free(row[j]);
+            }
+            g_free(row);
+        }
     }
+    g_free(index->rows);
+    g_free(index);
+}
 
-    /* now we have fresh memory */
-    gint result = igraph_vector_init(top->edgeWeights, (glong) top->edgeCount);
-    if(result != IGRAPH_SUCCESS) {
-        g_rw_lock_writer_unlock(&(top->edgeWeightsLock));
-        _topology_unlockGraph(top);
-        critical("igraph_vector_init return non-success code %i", result);
-        return FALSE;
+static Path* _pathindex_get(PathIndex* index, gint srcIndex, gint dstIndex) {
+    Path*** row = g_atomic_pointer_get(&(index->rows[srcIndex]));
+    if(!row) {
+        return NULL;
+    }
+    Path** block = g_atomic_pointer_get(&(row[dstIndex / PATHINDEX_BLOCK_LENGTH]));
+    if(!block) {
+        return NULL;
     }
+    return g_atomic_pointer_get(&(block[dstIndex % PATHINDEX_BLOCK_LENGTH]));
+}
 
-    /* use the 'latency' edge attribute as the edge weight */
-    const gchar* latencyKey = _topology_edgeAttributeToString(EDGE_ATTR_LATENCY);
-    result = EANV(&top->graph, latencyKey, top->edgeWeights);
-    g_rw_lock_writer_unlock(&(top->edgeWeightsLock));
-    _topology_unlockGraph(top);
-    if(result != IGRAPH_SUCCESS) {
-        critical("igraph_cattribute_EANV return non-success code %i", result);
-        return FALSE;
+static void _pathindex_set(PathIndex* index, gint srcIndex, gint dstIndex, Path* path) {
+    Path*** row = g_atomic_pointer_get(&(index->rows[srcIndex]));
+    if(!row) {
+        Path*** newRow = g_new0(Path**, index->numBlocks);
+        if(g_atomic_pointer_compare_and_exchange(&(index->rows[srcIndex]), NULL, newRow)) {
+            row = newRow;
+        } else {
+            /* another worker beat us to it */
+            g_free(newRow);
+            row = g_atomic_pointer_get(&(index->rows[srcIndex]));
+        }
     }
 
-    return TRUE;
+    gint blockIndex = dstIndex / PATHINDEX_BLOCK_LENGTH;
+    Path** block = g_atomic_pointer_get(&(row[blockIndex]));
+    if(!block) {
+        Path** newBlock = g_new0(Path*, PATHINDEX_BLOCK_LENGTH);
+        if(g_atomic_pointer_compare_and_exchange(&(row[blockIndex]), NULL, newBlock)) {
+            block = newBlock;
+        } else {
+            g_free(newBlock);
+            block = g_atomic_pointer_get(&(row[blockIndex]));
+        }
+    }
+
+    /* every writer stores the same cached path, so the last one may win */
+    g_atomic_pointer_set(&(block[dstIndex % PATHINDEX_BLOCK_LENGTH]), path);
 }
 
-static gboolean _topology_verticesAreAdjacent(Topology* top, igraph_integer_t srcVertexIndex, igraph_integer_t dstVertexIndex) {
+static gint _topology_compareVertexIndex(gconstpointer a, gconstpointer b) {
+    gint va = *((const gint*)a), vb = *((const gint*)b);
+    return (va > vb) - (va < vb);
+}
+
+/* a read-only copy of the graph in compressed adjacency form. all paths are
+ * computed from it, so that workers can run dijkstra in parallel without
+ * touching igraph or holding the graph lock. */
+static RouteGraph* _routegraph_new(Topology* top) {
     MAGIC_ASSERT(top);
 
-    igraph_integer_t edge_id = -1;
-    gint result;
+    RouteGraph* rg = g_new0(RouteGraph, 1);
+
+    rg->isDirected = top->isDirected ? TRUE : FALSE;
+    rg->isComplete = top->isComplete ? TRUE : FALSE;
+    rg->prefersDirectPaths = top->prefersDirectPaths;
 
     _topology_lockGraph(top);
-    result = _topology_getEdgeHelper(top, srcVertexIndex, dstVertexIndex, &edge_id, NULL, NULL);
+
+    rg->numVertices = (gint) igraph_vcount(&top->graph);
+    gint numEdges = (gint) igraph_ecount(&top->graph);
+    /* undirected edges can be traversed in both directions */
+    gint numArcs = top->isDirected ? numEdges : 2 * numEdges;
+
+    rg->arcOffsets = g_new0(gint, rg->numVertices + 1);
+    rg->arcTargets = g_new0(gint, MAX(numArcs, 1));
+    rg->arcLatencies = g_new0(gdouble, MAX(numArcs, 1));
+    rg->arcReliabilities = g_new0(gdouble, MAX(numArcs, 1));
+    rg->vertexReliabilities = g_new0(gdouble, MAX(rg->numVertices, 1));
+
+    igraph_integer_t* fromVertices = g_new0(igraph_integer_t, MAX(numEdges, 1));
+    igraph_integer_t* toVertices = g_new0(igraph_integer_t, MAX(numEdges, 1));
+
+    /* count the arcs leaving each vertex */
+    for(gint edgeIndex = 0; edgeIndex < numEdges; edgeIndex++) {
+        igraph_edge(&top->graph, (igraph_integer_t)edgeIndex, &fromVertices[edgeIndex], &toVertices[edgeIndex]);
+        rg->arcOffsets[fromVertices[edgeIndex] + 1]++;
+        if(!top->isDirected) {
+            rg->arcOffsets[toVertices[edgeIndex] + 1]++;
+        }
+    }
+    for(gint vertexIndex = 0; vertexIndex < rg->numVertices; vertexIndex++) {
+        rg->arcOffsets[vertexIndex + 1] += rg->arcOffsets[vertexIndex];
+
+        rg->vertexReliabilities[vertexIndex] = 1.0f;
+        gdouble vertexPacketLoss;
+        if(_topology_findVertexAttributeDouble(top, (igraph_integer_t)vertexIndex, VERTEX_ATTR_PACKETLOSS, &vertexPacketLoss)) {
+            rg->vertexReliabilities[vertexIndex] = (1.0f - vertexPacketLoss);
+        }
+    }
+
+    /* now fill them in, in edge order */
+    gint* nextArc = g_memdup(rg->arcOffsets, (guint)(sizeof(gint) * rg->numVertices));
+    for(gint edgeIndex = 0; edgeIndex < numEdges; edgeIndex++) {
+        gdouble edgeLatency = 0, edgePacketLoss = 0;
+        gboolean found = _topology_findEdgeAttributeDouble(top, (igraph_integer_t)edgeIndex, EDGE_ATTR_LATENCY, &edgeLatency);
+        utility_assert(found);
+        found = _topology_findEdgeAttributeDouble(top, (igraph_integer_t)edgeIndex, EDGE_ATTR_PACKETLOSS, &edgePacketLoss);
+        utility_assert(found);
+
+        gint arc = nextArc[fromVertices[edgeIndex]]++;
+        rg->arcTargets[arc] = (gint) toVertices[edgeIndex];
+        rg->arcLatencies[arc] = edgeLatency;
+        rg->arcReliabilities[arc] = (1.0f - edgePacketLoss);
+
+        if(!top->isDirected) {
+            arc = nextArc[toVertices[edgeIndex]]++;
+            rg->arcTargets[arc] = (gint) fromVertices[edgeIndex];
+            rg->arcLatencies[arc] = edgeLatency;
+            rg->arcReliabilities[arc] = (1.0f - edgePacketLoss);
+        }
+    }
+
     _topology_unlockGraph(top);
 
-    if (result != IGRAPH_SUCCESS) {
-        warning("Unable to determine whether or not an edge exists between vertexes %d and %d",
-                srcVertexIndex, dstVertexIndex);
+    g_free(nextArc);
+    g_free(fromVertices);
+    g_free(toVertices);
+
+    /* the attached vertices, sorted so that the set does not depend on the
+     * order in which the hosts happened to attach */
+    g_rw_lock_reader_lock(&(top->virtualIPLock));
+    rg->numAttached = (gint) g_hash_table_size(top->attachmentIndices);
+    rg->attachedVertices = g_new0(gint, MAX(rg->numAttached, 1));
+
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, top->attachmentIndices);
+    while(g_hash_table_iter_next(&iter, &key, &value)) {
+        rg->attachedVertices[GPOINTER_TO_INT(value)] = GPOINTER_TO_INT(key);
+    }
+    g_rw_lock_reader_unlock(&(top->virtualIPLock));
+
+    qsort(rg->attachedVertices, (size_t)rg->numAttached, sizeof(gint), _topology_compareVertexIndex);
+
+    return rg;
+}
+
+static void _routegraph_free(RouteGraph* rg) {
+    g_free(rg->arcOffsets);
+    g_free(rg->arcTargets);
+    g_free(rg->arcLatencies);
+    g_free(rg->arcReliabilities);
+    g_free(rg->vertexReliabilities);
+    g_free(rg->attachedVertices);
+    g_free(rg);
+}
+
+static gint _routegraph_findArc(RouteGraph* rg, gint srcVertexIndex, gint dstVertexIndex) {
+    for(gint arc = rg->arcOffsets[srcVertexIndex]; arc < rg->arcOffsets[srcVertexIndex+1]; arc++) {
+        if(rg->arcTargets[arc] == dstVertexIndex) {
+            return arc;
+        }
+    }
+    return -1;
+}
+
+static gint _routegraph_getArcSource(RouteGraph* rg, gint arc) {
+    /* arcs are grouped by source, so the source is the last offset at or before the arc */
+    gint low = 0, high = rg->numVertices - 1;
+    while(low < high) {
+        gint mid = (low + high + 1) / 2;
+        if(rg->arcOffsets[mid] <= arc) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return low;
+}
+
+typedef struct _RouteHeapEntry RouteHeapEntry;
+struct _RouteHeapEntry {
+    gdouble distance;
+    gint vertexIndex;
+};
+
+/* vertices at the same distance are settled in vertex order, so that the
+ * tree does not depend on the order of the entries in the heap */
+static gboolean _routegraph_heapIsBefore(const RouteHeapEntry* a, const RouteHeapEntry* b) {
+    return (a->distance < b->distance ||
+            (a->distance == b->distance && a->vertexIndex < b->vertexIndex)) ? TRUE : FALSE;
+}
+
+static void _routegraph_heapPush(GArray* heap, gdouble distance, gint vertexIndex) {
+    RouteHeapEntry entry = {distance, vertexIndex};
+    g_array_append_val(heap, entry);
+
+    RouteHeapEntry* e = (RouteHeapEntry*) heap->data;
+    guint i = heap->len - 1;
+    while(i > 0 && _routegraph_heapIsBefore(&e[i], &e[(i-1)/2])) {
+        RouteHeapEntry tmp = e[i];
+        e[i] = e[(i-1)/2];
+        e[(i-1)/2] = tmp;
+        i = (i-1)/2;
+    }
+}
+
+static RouteHeapEntry _routegraph_heapPop(GArray* heap) {
+    RouteHeapEntry* e = (RouteHeapEntry*) heap->data;
+    RouteHeapEntry top = e[0];
+
+    e[0] = e[heap->len - 1];
+    g_array_set_size(heap, heap->len - 1);
+
+    guint i = 0;
+    while(TRUE) {
+        guint left = 2*i + 1, right = left + 1, min = i;
+        if(left < heap->len && _routegraph_heapIsBefore(&e[left], &e[min])) {
+            min = left;
+        }
+        if(right < heap->len && _routegraph_heapIsBefore(&e[right], &e[min])) {
+            min = right;
+        }
+        if(min == i) {
+            break;
+        }
+        RouteHeapEntry tmp = e[i];
+        e[i] = e[min];
+        e[min] = tmp;
+        i = min;
+    }
+
+    return top;
+}
+
+static RouteTree* _routetree_new(RouteGraph* rg) {
+    RouteTree* tree = g_new0(RouteTree, 1);
+    tree->rootVertexIndex = -1;
+    tree->distances = g_new0(gdouble, MAX(rg->numVertices, 1));
+    tree->predecessorArcs = g_new0(gint, MAX(rg->numVertices, 1));
+    tree->heap = g_array_new(FALSE, FALSE, sizeof(RouteHeapEntry));
+    return tree;
+}
+
+static void _routetree_free(RouteTree* tree) {
+    g_array_free(tree->heap, TRUE);
+    g_free(tree->predecessorArcs);
+    g_free(tree->distances);
+    g_free(tree);
+}
+
+/* single-source dijkstra over the latency weights. arcs are relaxed in edge
+ * order and only replace a predecessor when they are strictly shorter, so
+ * among equal-latency routes a vertex keeps the first one it was reached by. */
+static void _routegraph_runDijkstra(RouteGraph* rg, RouteTree* tree, gint srcVertexIndex) {
+    gdouble* distances = tree->distances;
+    gint* predecessorArcs = tree->predecessorArcs;
+    GArray* heap = tree->heap;
+
+    for(gint i = 0; i < rg->numVertices; i++) {
+        distances[i] = INFINITY;
+        predecessorArcs[i] = -1;
+    }
+
+    tree->rootVertexIndex = srcVertexIndex;
+    g_array_set_size(heap, 0);
+    distances[srcVertexIndex] = 0;
+    _routegraph_heapPush(heap, 0, srcVertexIndex);
+
+    while(heap->len > 0) {
+        RouteHeapEntry entry = _routegraph_heapPop(heap);
+        if(entry.distance > distances[entry.vertexIndex]) {
+            /* stale entry, we already found a shorter way here */
+            continue;
+        }
+
+        for(gint arc = rg->arcOffsets[entry.vertexIndex]; arc < rg->arcOffsets[entry.vertexIndex+1]; arc++) {
+            gint target = rg->arcTargets[arc];
+            gdouble distance = entry.distance + rg->arcLatencies[arc];
+            if(distance < distances[target]) {
+                distances[target] = distance;
+                predecessorArcs[target] = arc;
+                _routegraph_heapPush(heap, distance, target);
+            }
+        }
+    }
+}
+
+/* the vertex whose shortest path tree the route between two vertices comes
+ * from. in undirected graphs it is the lower vertex, so that a pair gets the
+ * same route no matter which of its hosts sends first. */
+static gint _routegraph_getRouteRoot(RouteGraph* rg, gint srcVertexIndex, gint dstVertexIndex) {
+    return (!rg->isDirected && dstVertexIndex < srcVertexIndex) ? dstVertexIndex : srcVertexIndex;
+}
+
+/* the arc that is the route between the vertices, or -1 if the route is not direct */
+static gint _routegraph_getDirectArc(RouteGraph* rg, gint srcVertexIndex, gint dstVertexIndex) {
+    if(rg->isComplete || rg->prefersDirectPaths) {
+        return _routegraph_findArc(rg, srcVertexIndex, dstVertexIndex);
+    }
+    return -1;
+}
+
+static gboolean _routegraph_needsTree(RouteGraph* rg, gint srcVertexIndex, gint dstVertexIndex) {
+    return (srcVertexIndex != dstVertexIndex &&
+            _routegraph_getDirectArc(rg, srcVertexIndex, dstVertexIndex) < 0) ? TRUE : FALSE;
+}
+
+/* fills in the route from srcVertexIndex, which must be the route root, to
+ * dstVertexIndex. paths computed on first use and precomputed paths both come
+ * from here, so both modes always agree on every route. the tree is only used
+ * if _routegraph_needsTree, and must then be grown from srcVertexIndex.
+ * returns FALSE if there is no route. */
+static gboolean _routegraph_getRoute(RouteGraph* rg, RouteTree* tree,
+        gint srcVertexIndex, gint dstVertexIndex, PathCacheRecord* route) {
+    utility_assert(srcVertexIndex == _routegraph_getRouteRoot(rg, srcVertexIndex, dstVertexIndex));
+
+    memset(route, 0, sizeof(PathCacheRecord));
+    route->srcVertexIndex = (gint32) srcVertexIndex;
+    route->dstVertexIndex = (gint32) dstVertexIndex;
+
+    /* the edge between them, when the graph tells us to prefer it */
+    gint directArc = _routegraph_getDirectArc(rg, srcVertexIndex, dstVertexIndex);
+    if(directArc >= 0) {
+        route->isDirect = 1;
+        route->latency = rg->arcLatencies[directArc];
+        route->reliability = rg->vertexReliabilities[srcVertexIndex] *
+                rg->vertexReliabilities[dstVertexIndex] * rg->arcReliabilities[directArc];
+        return TRUE;
+    }
+
+    /* back to the same vertex over its shortest edge, used twice */
+    if(srcVertexIndex == dstVertexIndex) {
+        gint minArc = -1;
+        for(gint arc = rg->arcOffsets[srcVertexIndex]; arc < rg->arcOffsets[srcVertexIndex+1]; arc++) {
+            if(minArc < 0 || rg->arcLatencies[arc] < rg->arcLatencies[minArc]) {
+                minArc = arc;
+            }
+        }
+        if(minArc < 0) {
+            return FALSE;
+        }
+        route->latency = 2.0f * rg->arcLatencies[minArc];
+        route->reliability = rg->arcReliabilities[minArc] * rg->arcReliabilities[minArc];
+        return TRUE;
+    }
+
+    utility_assert(tree && tree->rootVertexIndex == srcVertexIndex);
+    if(tree->predecessorArcs[dstVertexIndex] < 0) {
         return FALSE;
     }
-    return edge_id >= 0;
+
+    /* walk back from the destination, accumulating the edge reliabilities */
+    route->latency = tree->distances[dstVertexIndex];
+    route->reliability = rg->vertexReliabilities[srcVertexIndex] * rg->vertexReliabilities[dstVertexIndex];
+    for(gint v = dstVertexIndex; v != srcVertexIndex; ) {
+        gint arc = tree->predecessorArcs[v];
+        route->reliability *= rg->arcReliabilities[arc];
+        v = _routegraph_getArcSource(rg, arc);
+    }
+
+    if(route->latency == 0) {
+        warning("found shortest path latency of 0 ms between source vertex %i and destination vertex %i, using 1 ms instead",
+                srcVertexIndex, dstVertexIndex);
+        route->latency = 1;
+    }
+
+    return TRUE;
+}
+
+static RouteGraph* _topology_getRouteGraph(Topology* top) {
+    MAGIC_ASSERT(top);
+
+    if(g_once_init_enter(&(top->routeGraph))) {
+        GTimer* graphTimer = g_timer_new();
+        RouteGraph* rg = _routegraph_new(top);
+        message("copied %i vertices and %i arcs for shortest path computation in %f seconds",
+                rg->numVertices, rg->arcOffsets[rg->numVertices], g_timer_elapsed(graphTimer, NULL));
+        g_timer_destroy(graphTimer);
+        g_once_init_leave(&(top->routeGraph), rg);
+    }
+
+    return top->routeGraph;
 }
 
 static void _topology_clearCache(Topology* top) {
     MAGIC_ASSERT(top);
     g_rw_lock_writer_lock(&(top->pathCacheLock));
+    if(top->pathIndex) {
+        _pathindex_free(top->pathIndex);
+        top->pathIndex = NULL;
+    }
     if(top->pathCache) {
         g_hash_table_destroy(top->pathCache);
         top->pathCache = NULL;
     }
+    if(top->pathsByID) {
+        /* the paths were owned by the path cache */
+        g_ptr_array_free(top->pathsByID, TRUE);
+        top->pathsByID = NULL;
+    }
+    if(top->pathCacheMap) {
+        munmap(top->pathCacheMap, top->pathCacheMapSize);
+        top->pathCacheMap = NULL;
+        top->mappedPaths = NULL;
+        top->numMappedPaths = 0;
+    }
     g_rw_lock_writer_unlock(&(top->pathCacheLock));
 
     /* lock the read on the shortest path info */
@@ -1290,9 +1774,11 @@ static gboolean _topology_shouldStorePath(Topology* top, gboolean isDirectPath,
         igraph_integer_t srcVertexIndex, igraph_integer_t dstVertexIndex) {
     MAGIC_ASSERT(top);
 
-    /* double check that we don't overwrite existing path entries */
+    /* double check that we don't overwrite existing path entries. only
+     * undirected graphs use the path in the other direction. */
     Path* srcToDstCachedPath = _topology_getPathFromCache(top, srcVertexIndex, dstVertexIndex);
-    Path* dstToSrcCachedPath = _topology_getPathFromCache(top, dstVertexIndex, srcVertexIndex);
+    Path* dstToSrcCachedPath = top->isDirected ? NULL :
+            _topology_getPathFromCache(top, dstVertexIndex, srcVertexIndex);
 
     if(srcToDstCachedPath != NULL || dstToSrcCachedPath != NULL) {
         /* we already have a cached path entry in one direction or the other */
@@ -1317,6 +1803,19 @@ static gboolean _topology_shouldStorePath(Topology* top, gboolean isDirectPath,
     return TRUE;
 }
 
+/* gives a path that was just added to the cache its id. the caller must
+ * hold the path cache write lock. */
+static void _topology_registerPath(Topology* top, Path* path) {
+    MAGIC_ASSERT(top);
+
+    if(!top->pathsByID) {
+        top->pathsByID = g_ptr_array_new();
+    }
+
+    path_setID(path, top->pathsByID->len);
+    g_ptr_array_add(top->pathsByID, path);
+}
+
 static void _topology_storePathInCache(Topology* top, gboolean isDirectPath,
         igraph_integer_t srcVertexIndex, igraph_integer_t dstVertexIndex,
         igraph_real_t totalLatency, igraph_real_t totalReliability) {
@@ -1346,12 +1845,20 @@ static void _topology_storePathInCache(Topology* top, gboolean isDirectPath,
         g_hash_table_replace(top->pathCache, GINT_TO_POINTER(srcVertexIndex), srcCache);
     }
 
+    /* another worker may have stored it since we checked, and the path it
+     * stored may already be in use, so we keep that one */
+    if(g_hash_table_contains(srcCache, GINT_TO_POINTER(dstVertexIndex))) {
+        g_rw_lock_writer_unlock(&(top->pathCacheLock));
+        return;
+    }
+
     /* create the path */
     Path* path = path_new(isDirectPath, (gint64)srcVertexIndex, (gint64)dstVertexIndex, latencyMS, reliability);
 
     /* store it in the cache. don't bother storing the path for the reverse direction,
      * because we can check both directions for this cached path later. */
     g_hash_table_replace(srcCache, GINT_TO_POINTER(dstVertexIndex), path);
+    _topology_registerPath(top, path);
 
     /* track the minimum network latency in the entire graph */
     if(top->minimumPathLatency == 0 || latencyMS < top->minimumPathLatency) {
@@ -1367,141 +1874,77 @@ static void _topology_storePathInCache(Topology* top, gboolean isDirectPath,
     }
 }
 
-static igraph_integer_t _topology_getConnectedVertexIndex(Topology* top, Address* address) {
-    MAGIC_ASSERT(top);
-
-    /* find the vertex where this virtual ip was attached */
-    gpointer vertexIndexPtr = NULL;
-    in_addr_t ip = address_toNetworkIP(address);
-
-    g_rw_lock_reader_lock(&(top->virtualIPLock));
-    gboolean found = g_hash_table_lookup_extended(top->virtualIP, GUINT_TO_POINTER(ip), NULL, &vertexIndexPtr);
-    g_rw_lock_reader_unlock(&(top->virtualIPLock));
+static gint _topology_comparePathCacheRecord(const PathCacheRecord* record,
+        gint32 srcVertexIndex, gint32 dstVertexIndex) {
+    if(record->srcVertexIndex != srcVertexIndex) {
+        return record->srcVertexIndex < srcVertexIndex ? -1 : 1;
+    }
+    if(record->dstVertexIndex != dstVertexIndex) {
+        return record->dstVertexIndex < dstVertexIndex ? -1 : 1;
+    }
+    return 0;
+}
 
-    if(!found) {
-        warning("address %s is not connected to the topology", address_toHostIPString(address));
-        return (igraph_integer_t) -1;
+static const PathCacheRecord* _topology_findMappedPath(Topology* top,
+        igraph_integer_t srcVertexIndex, igraph_integer_t dstVertexIndex) {
+    gsize low = 0, high = top->numMappedPaths;
+
+    while(low < high) {
+        gsize middle = low + (high - low) / 2;
+        gint cmp = _topology_comparePathCacheRecord(&(top->mappedPaths[middle]),
+                (gint32)srcVertexIndex, (gint32)dstVertexIndex);
+        if(cmp == 0) {
+            return &(top->mappedPaths[middle]);
+        } else if(cmp < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
     }
 
-    return (igraph_integer_t) GPOINTER_TO_INT(vertexIndexPtr);
+    return NULL;
 }
 
-static gboolean _topology_computePathProperties(Topology* top, igraph_integer_t srcVertexIndex,
-        igraph_vector_t* resultPathVertices, GString* pathStringBuffer,
-        igraph_real_t* pathLatencyOut, igraph_real_t* pathReliabilityOut, igraph_integer_t* pathTargetIndexOut) {
+/* adds the path from the mapped path table to the cache, if it has one */
+static gboolean _topology_loadMappedPath(Topology* top, igraph_integer_t srcVertexIndex,
+        igraph_integer_t dstVertexIndex) {
     MAGIC_ASSERT(top);
 
-    /* WARNING This function should only be called when there are more than 0 result paths, ie,
-     * when the src and dst are not attached to the same vertex.
-     *
-     * each position represents a single destination.
-     * this resultPathVertices vector holds the links that form the shortest path to this destination.
-     * the destination vertex is the last vertex in the vector.
-     *
-     * there are multiple chances to drop a packet here:
-     * psrc : loss rate from source vertex
-     * plink ... : loss rate on the links between source-vertex and destination-vertex
-     * pdst : loss rate from destination vertex
-     *
-     * The reliability is then the combination of the probability
-     * that its not dropped in each case:
-     * P = ((1-psrc)(1-plink)...(1-pdst))
-     */
-    gint result = 0;
-    igraph_real_t totalLatency = 0.0;
-    igraph_real_t totalReliability = (igraph_real_t) 1;
-
-    igraph_integer_t targetVertexIndex = (igraph_integer_t) -1;
-    const gchar* dstIDStr = NULL;
-    const gchar* srcIDStr = NULL;
-
-    glong nVertices = igraph_vector_size(resultPathVertices);
-    utility_assert(nVertices > 0);
-
-    _topology_lockGraph(top);
-
-    /* get source properties */
-    gdouble sourcePacketLoss;
-    if(_topology_findVertexAttributeDouble(top, srcVertexIndex, VERTEX_ATTR_PACKETLOSS, &sourcePacketLoss)) {
-        totalReliability *= (1.0f - sourcePacketLoss);
+    /* the mapping does not change once it is loaded */
+    if(!top->mappedPaths) {
+        return FALSE;
     }
 
-    gboolean found = _topology_findVertexAttributeString(top, srcVertexIndex, VERTEX_ATTR_ID, &srcIDStr);
-    utility_assert(found);
-    g_string_printf(pathStringBuffer, "%s", srcIDStr);
-
-    /* get destination properties */
-    targetVertexIndex = (igraph_integer_t) igraph_vector_tail(resultPathVertices);
-    found = _topology_findVertexAttributeString(top, targetVertexIndex, VERTEX_ATTR_ID, &dstIDStr);
-    utility_assert(found);
-
-    /* only include dst loss if there is no path between src and dst vertices */
-    if((srcVertexIndex != targetVertexIndex) || (srcVertexIndex == targetVertexIndex && nVertices > 2)) {
-        gdouble destPacketLoss;
-        if(_topology_findVertexAttributeDouble(top, targetVertexIndex, VERTEX_ATTR_PACKETLOSS, &destPacketLoss)) {
-            totalReliability *= (1.0f - destPacketLoss);
-        }
+    const PathCacheRecord* record = _topology_findMappedPath(top, srcVertexIndex, dstVertexIndex);
+    if(!record && !top->isDirected) {
+        record = _topology_findMappedPath(top, dstVertexIndex, srcVertexIndex);
     }
-
-    /* the source is in the first position only if we have more than one vertex */
-    if(nVertices > 1) {
-        utility_assert(srcVertexIndex == igraph_vector_e(resultPathVertices, 0));
+    if(!record || !record->isRoutable) {
+        return FALSE;
     }
 
-    /* if we have only one vertex, its the destination at position 0; otherwise, the source is
-     * at position 0 and the part of the path after the source starts at position 1 */
-    gint startingPosition = nVertices == 1 ? 0 : 1;
-
-    igraph_integer_t fromVertexIndex = srcVertexIndex, toVertexIndex = 0,  edgeIndex = 0;
-    const gchar* fromIDStr = srcIDStr;
-
-    /* now iterate to get latency and reliability from each edge in the path */
-    for (gint i = startingPosition; i < nVertices; i++) {
-        /* get the edge */
-        toVertexIndex = igraph_vector_e(resultPathVertices, i);
-
-        const gchar* toIDStr;
-        gboolean found = _topology_findVertexAttributeString(top, toVertexIndex, VERTEX_ATTR_ID, &toIDStr);
-        utility_assert(found);
-
-        igraph_real_t edgeLatency = 0, edgeReliability = 0;
-        igraph_integer_t edgeIndex = 0;
-
-        result = _topology_getEdgeHelper(top, fromVertexIndex, toVertexIndex, &edgeIndex, &edgeLatency, &edgeReliability);
-
-        if(result != IGRAPH_SUCCESS || edgeIndex < 0) {
-            _topology_unlockGraph(top);
-            critical("igraph_get_eid return non-success code %i for edge between "
-                     "%s (%i) and %s (%i)", result, fromIDStr, (gint) fromVertexIndex, toIDStr, (gint) toVertexIndex);
-            return FALSE;
-        }
-
-        /* accumulate path attributes */
-        totalLatency += edgeLatency;
-        totalReliability *= edgeReliability;
+    _topology_storePathInCache(top, record->isDirect ? TRUE : FALSE, record->srcVertexIndex,
+            record->dstVertexIndex, record->latency, record->reliability);
+    return TRUE;
+}
 
-        /* accumulate path information */
-        g_string_append_printf(pathStringBuffer, "%s[%f,%f]-->%s",
-                top->isDirected ? "--" : "<--", edgeLatency, 1.0f-edgeReliability, toIDStr);
+static igraph_integer_t _topology_getConnectedVertexIndex(Topology* top, Address* address) {
+    MAGIC_ASSERT(top);
 
-        /* update for next edge */
-        fromVertexIndex = toVertexIndex;
-        fromIDStr = toIDStr;
-    }
+    /* find the vertex where this virtual ip was attached */
+    gpointer vertexIndexPtr = NULL;
+    in_addr_t ip = address_toNetworkIP(address);
 
-    _topology_unlockGraph(top);
+    g_rw_lock_reader_lock(&(top->virtualIPLock));
+    gboolean found = g_hash_table_lookup_extended(top->virtualIP, GUINT_TO_POINTER(ip), NULL, &vertexIndexPtr);
+    g_rw_lock_reader_unlock(&(top->virtualIPLock));
 
-    if(pathLatencyOut) {
-        *pathLatencyOut = totalLatency;
-    }
-    if(pathReliabilityOut) {
-        *pathReliabilityOut = totalReliability;
-    }
-    if(pathTargetIndexOut) {
-        *pathTargetIndexOut = targetVertexIndex;
+    if(!found) {
+        warning("address %s is not connected to the topology", address_toHostIPString(address));
+        return (igraph_integer_t) -1;
     }
 
-    return TRUE;
+    return (igraph_integer_t) GPOINTER_TO_INT(vertexIndexPtr);
 }
 
 static GQueue* _topology_getUniqueVertexTargets(Topology* top) {
@@ -1524,244 +1967,78 @@ static GQueue* _topology_getUniqueVertexTargets(Topology* top) {
     return uniqueVertexIDs;
 }
 
-static gboolean _topology_computeShortestPathToSelf(Topology* top, igraph_integer_t vertexIndex, const gchar* idStr) {
+/* the vertex ids along a route in the tree, for logging */
+static GString* _topology_getRouteString(Topology* top, RouteGraph* rg, RouteTree* tree, gint dstVertexIndex) {
     MAGIC_ASSERT(top);
 
-    igraph_real_t minLatency = 0.0f;
-    igraph_real_t reliabilityOfMinLatencyEdge = 0.0f;
-    igraph_integer_t indexOfMinLatencyEdge = 0;
-    gint result = 0;
-    gboolean found = FALSE;
-
-    /* iterate over all outgoing edges from vertex, get the shortest, and use it twice */
-    _topology_lockGraph(top);
+    GArray* vertices = g_array_new(FALSE, FALSE, sizeof(gint));
+    for(gint v = dstVertexIndex; v != tree->rootVertexIndex; ) {
+        g_array_append_val(vertices, v);
+        v = _routegraph_getArcSource(rg, tree->predecessorArcs[v]);
+    }
+    g_array_append_val(vertices, tree->rootVertexIndex);
 
-    /* first we 'select' the incident edges, that is, those to which vertexIndex is connected */
-    igraph_es_t edgeSelector;
-    result = igraph_es_incident(&edgeSelector, vertexIndex, IGRAPH_OUT);
+    GString* routeString = g_string_new(NULL);
 
-    if(result != IGRAPH_SUCCESS) {
-        critical("igraph_es_incident return non-success code %i", result);
-        _topology_unlockGraph(top);
-        return FALSE;
+    _topology_lockGraph(top);
+    for(gint i = (gint)vertices->len - 1; i >= 0; i--) {
+        const gchar* idStr = NULL;
+        gboolean found = _topology_findVertexAttributeString(top,
+                (igraph_integer_t)g_array_index(vertices, gint, i), VERTEX_ATTR_ID, &idStr);
+        utility_assert(found);
+        g_string_append_printf(routeString, "%s%s", idStr,
+                i > 0 ? (top->isDirected ? "-->" : "<-->") : "");
     }
+    _topology_unlockGraph(top);
 
-    /* now we set up an iterator on these edges */
-    igraph_eit_t edgeIterator;
-    result = igraph_eit_create(&top->graph, edgeSelector, &edgeIterator);
-
-    if(result != IGRAPH_SUCCESS) {
-        critical("igraph_eit_create return non-success code %i", result);
-        igraph_es_destroy(&edgeSelector);
-        _topology_unlockGraph(top);
-        return FALSE;
-    }
-
-    /* time the shortest path loop */
-    GTimer* pathTimer = g_timer_new();
-
-    /* keep the min latency and packetloss while iterating */
-    while (!IGRAPH_EIT_END(edgeIterator)) {
-        igraph_integer_t edgeIndex = IGRAPH_EIT_GET(edgeIterator);
-
-        igraph_real_t edgeLatency = 0.0f;
-        igraph_real_t edgePacketLoss = 0.0f;
-
-        /* latency and packet loss are required attributes on edges */
-        found = _topology_findEdgeAttributeDouble(top, edgeIndex, EDGE_ATTR_LATENCY, &edgeLatency);
-        utility_assert(found);
-
-        if(minLatency == 0 || edgeLatency < minLatency) {
-            minLatency = edgeLatency;
-
-            found = _topology_findEdgeAttributeDouble(top, edgeIndex, EDGE_ATTR_PACKETLOSS, &edgePacketLoss);
-            utility_assert(found);
-            reliabilityOfMinLatencyEdge = 1.0f - edgePacketLoss;
-
-            indexOfMinLatencyEdge = edgeIndex;
-        }
-
-        IGRAPH_EIT_NEXT(edgeIterator);
-    }
-
-    _topology_unlockGraph(top);
-
-    /* track the time spent running the algorithm */
-    gdouble elapsedSeconds = g_timer_elapsed(pathTimer, NULL);
-    g_timer_destroy(pathTimer);
-
-    igraph_eit_destroy(&edgeIterator);
-    igraph_es_destroy(&edgeSelector);
-
-    g_mutex_lock(&top->topologyLock);
-    top->selfPathTotalTime += elapsedSeconds;
-    top->selfPathCount++;
-    g_mutex_unlock(&top->topologyLock);
-
-    _topology_lockGraph(top);
-
-    /* get the other vertex that we chose */
-    igraph_integer_t fromVertexIndex, toVertexIndex;
-    result = igraph_edge(&top->graph, indexOfMinLatencyEdge, &fromVertexIndex, &toVertexIndex);
-
-    if(result != IGRAPH_SUCCESS) {
-        critical("igraph_edge return non-success code %i", result);
-        _topology_unlockGraph(top);
-        return FALSE;
-    }
-
-    /* figure out which index is the other side of the edge */
-    igraph_integer_t targetIndex = (fromVertexIndex == vertexIndex) ? toVertexIndex : fromVertexIndex;
-    const gchar* targetIDStr;
-    found = _topology_findVertexAttributeString(top, targetIndex, VERTEX_ATTR_ID, &targetIDStr);
-    utility_assert(found);
-
-    _topology_unlockGraph(top);
-
-    /* this edge will be used "twice" to get back to source */
-    igraph_real_t latency = 2.0f * minLatency;
-    igraph_real_t reliability = reliabilityOfMinLatencyEdge * reliabilityOfMinLatencyEdge;
-
-    info("shortest path back to self is %f ms with %f loss, path: "
-            "%s%s--[%f,%f]-->%s%s--[%f,%f]-->%s",
-            (gdouble)latency, (gdouble)(1.0f-reliability),
-            idStr, top->isDirected ? "" : "<", minLatency, 1.0f-reliabilityOfMinLatencyEdge,
-            targetIDStr, top->isDirected ? "" : "<", minLatency, 1.0f-reliabilityOfMinLatencyEdge, idStr);
-
-    /* cache the latency and reliability we just computed */
-    _topology_storePathInCache(top, FALSE, vertexIndex, vertexIndex, latency, reliability);
-
-    return TRUE;
+    g_array_free(vertices, TRUE);
+    return routeString;
 }
 
-static gboolean _topology_computeSourcePaths(Topology* top, igraph_integer_t srcVertexIndex,
+/* computes the path between the vertices and stores it in the cache. if that
+ * takes a dijkstra run, we store the paths from the same root to all of the
+ * vertices with attached hosts, to cut down on the number of runs we do. */
+static gboolean _topology_computePaths(Topology* top, igraph_integer_t srcVertexIndex,
         igraph_integer_t dstVertexIndex) {
     MAGIC_ASSERT(top);
     utility_assert(srcVertexIndex >= 0);
     utility_assert(dstVertexIndex >= 0);
 
-    gboolean found;
-    _topology_lockGraph(top);
-    const gchar* srcIDStr;
-    found = _topology_findVertexAttributeString(top, srcVertexIndex, VERTEX_ATTR_ID, &srcIDStr);
-    utility_assert(found);
-    const gchar* dstIDStr;
-    found = _topology_findVertexAttributeString(top, dstVertexIndex, VERTEX_ATTR_ID, &dstIDStr);
-    utility_assert(found);
-    _topology_unlockGraph(top);
-
-    info("requested path between source vertex %li (%s) and destination vertex %li (%s)",
-            (glong)srcVertexIndex, srcIDStr, (glong)dstVertexIndex, dstIDStr);
-
-    if(srcVertexIndex == dstVertexIndex) {
-        return _topology_computeShortestPathToSelf(top, srcVertexIndex, srcIDStr);
-    }
-
-    /* we are going to compute shortest path from the source to all attached destinations
-     * (including dstAddress) in order to cut down on the the number of dijkstra runs we do.
-     * but we only need to do it once for each unique vertex no matter how many hosts live there. */
-    GQueue* attachedTargets = _topology_getUniqueVertexTargets(top);
-
-    /* normally we should hold the lock while modifying the list, but since the virtualIPLock
-     * hash table stores vertex indices in pointers, this should be OK. */
-    guint numTargets = g_queue_get_length(attachedTargets);
-
-    /* initialize vector to hold intended destinations */
-    igraph_vector_t dstVertexIndexSet;
+    RouteGraph* rg = _topology_getRouteGraph(top);
+    PathCacheRecord route;
 
-    gint result = igraph_vector_init(&dstVertexIndexSet, (long int) numTargets);
-    if(result != IGRAPH_SUCCESS) {
-        critical("igraph_vector_init return non-success code %i", result);
-        return FALSE;
-    }
+    gint rootVertexIndex = _routegraph_getRouteRoot(rg, (gint)srcVertexIndex, (gint)dstVertexIndex);
+    gint otherVertexIndex = (rootVertexIndex == (gint)srcVertexIndex) ? (gint)dstVertexIndex : (gint)srcVertexIndex;
 
-    /* initialize our result vector where the resulting paths will be stored */
-    igraph_vector_ptr_t resultPaths;
-    result = igraph_vector_ptr_init(&resultPaths, (long int) numTargets);
-    if(result != IGRAPH_SUCCESS) {
-        critical("igraph_vector_ptr_init return non-success code %i", result);
-        return FALSE;
-    }
-
-    gboolean foundDstVertexIndex = FALSE;
-    gint dstVertexIndexPosition = -1;
-    for(gint position = 0; position < numTargets; position++) {
-        gpointer vertexIndexPointer = g_queue_pop_head(attachedTargets);
-        utility_assert(vertexIndexPointer != NULL);
+    if(!_routegraph_needsTree(rg, rootVertexIndex, otherVertexIndex)) {
+        GTimer* pathTimer = g_timer_new();
+        gboolean isSuccess = _routegraph_getRoute(rg, NULL, rootVertexIndex, otherVertexIndex, &route);
+        gdouble elapsedSeconds = g_timer_elapsed(pathTimer, NULL);
+        g_timer_destroy(pathTimer);
 
-        /* set each vertex index as a destination for dijkstra */
-        igraph_integer_t vertexIndex = (igraph_integer_t) GPOINTER_TO_INT(vertexIndexPointer);
-        igraph_vector_set(&dstVertexIndexSet, position, (igraph_real_t) vertexIndex);
-        utility_assert(vertexIndex == igraph_vector_e(&dstVertexIndexSet, position));
-
-        if(vertexIndex == dstVertexIndex) {
-            foundDstVertexIndex = TRUE;
-            dstVertexIndexPosition = position;
+        if(rootVertexIndex == otherVertexIndex) {
+            g_mutex_lock(&top->topologyLock);
+            top->selfPathTotalTime += elapsedSeconds;
+            top->selfPathCount++;
+            g_mutex_unlock(&top->topologyLock);
         }
 
-        /* initialize a vector to hold the result path vertices for this target */
-        igraph_vector_t* resultPathVertices = g_new0(igraph_vector_t, 1);
-
-        /* initialize with 0 entries, since we dont know how long the paths with be */
-        result = igraph_vector_init(resultPathVertices, 0);
-        if(result != IGRAPH_SUCCESS) {
-            critical("igraph_vector_init return non-success code %i", result);
-            return FALSE;
+        if(isSuccess) {
+            info("%s path from vertex %i to vertex %i is %f ms with %f loss",
+                    route.isDirect ? "direct" : "self", rootVertexIndex, otherVertexIndex,
+                    route.latency, 1.0f - route.reliability);
+            _topology_storePathInCache(top, route.isDirect ? TRUE : FALSE, route.srcVertexIndex,
+                    route.dstVertexIndex, route.latency, route.reliability);
         }
-
-        /* assign our element to the result vector */
-        igraph_vector_ptr_set(&resultPaths, position, resultPathVertices);
-        utility_assert(resultPathVertices == igraph_vector_ptr_e(&resultPaths, position));
+        return isSuccess;
     }
 
-    if(attachedTargets) {
-        g_queue_free(attachedTargets);
-        attachedTargets = NULL;
-    }
-
-    utility_assert(numTargets == igraph_vector_size(&dstVertexIndexSet));
-    utility_assert(numTargets == igraph_vector_ptr_size(&resultPaths));
-    utility_assert(foundDstVertexIndex == TRUE);
-
-    info("computing shortest paths from source vertex %li (%s) to all %u vertices with connected hosts",
-            (glong)srcVertexIndex, srcIDStr, numTargets);
-
-    _topology_lockGraph(top);
-    g_rw_lock_reader_lock(&(top->edgeWeightsLock));
+    RouteTree* tree = _routetree_new(rg);
 
     /* time the dijkstra algorithm */
     GTimer* pathTimer = g_timer_new();
-
-    /* run dijkstra's shortest path algorithm */
-#if defined (IGRAPH_VERSION_MAJOR) && defined (IGRAPH_VERSION_MINOR) && defined (IGRAPH_VERSION_PATCH)
-#if ((IGRAPH_VERSION_MAJOR == 0 && IGRAPH_VERSION_MINOR >= 7) || IGRAPH_VERSION_MAJOR > 0)
-    result = igraph_get_shortest_paths_dijkstra(&top->graph, &resultPaths, NULL,
-            srcVertexIndex, igraph_vss_vector(&dstVertexIndexSet), top->edgeWeights, IGRAPH_OUT, NULL, NULL);
-#else
-    result = igraph_get_shortest_paths_dijkstra(&top->graph, &resultPaths, NULL,
-                srcVertexIndex, igraph_vss_vector(&dstVertexIndexSet), top->edgeWeights, IGRAPH_OUT);
-#endif
-#else
-#if defined (IGRAPH_VERSION)
-#if defined (IGRAPH_VERSION_MAJOR_GUESS) && defined (IGRAPH_VERSION_MINOR_GUESS) && ((IGRAPH_VERSION_MAJOR_GUESS == 0 && IGRAPH_VERSION_MINOR_GUESS >= 7) || IGRAPH_VERSION_MAJOR_GUESS > 0)
-    result = igraph_get_shortest_paths_dijkstra(&top->graph, &resultPaths, NULL,
-                srcVertexIndex, igraph_vss_vector(&dstVertexIndexSet), top->edgeWeights, IGRAPH_OUT, NULL, NULL);
-#else
-    result = igraph_get_shortest_paths_dijkstra(&top->graph, &resultPaths, NULL,
-                srcVertexIndex, igraph_vss_vector(&dstVertexIndexSet), top->edgeWeights, IGRAPH_OUT);
-#endif
-#else
-    result = igraph_get_shortest_paths_dijkstra(&top->graph, &resultPaths,
-            srcVertexIndex, igraph_vss_vector(&dstVertexIndexSet), top->edgeWeights, IGRAPH_OUT);
-#endif
-#endif
-
-    /* track the time spent running the algorithm */
+    _routegraph_runDijkstra(rg, tree, rootVertexIndex);
     gdouble elapsedSeconds = g_timer_elapsed(pathTimer, NULL);
-
-    g_rw_lock_reader_unlock(&(top->edgeWeightsLock));
-    _topology_unlockGraph(top);
-
     g_timer_destroy(pathTimer);
 
     g_mutex_lock(&top->topologyLock);
@@ -1769,143 +2046,47 @@ static gboolean _topology_computeSourcePaths(Topology* top, igraph_integer_t src
     top->shortestPathCount++;
     g_mutex_unlock(&top->topologyLock);
 
-    if(result != IGRAPH_SUCCESS) {
-        critical("igraph_get_shortest_paths_dijkstra return non-success code %i", result);
-        return FALSE;
-    }
-
-    /* sanity checks */
-    utility_assert(numTargets == igraph_vector_size(&dstVertexIndexSet));
-    utility_assert(numTargets == igraph_vector_ptr_size(&resultPaths));
-
-    /* process the results */
-    gboolean isAllSuccess = TRUE;
-    gboolean foundDstPosition = FALSE;
-    GString* pathStringBuffer = g_string_new(NULL);
-
-    /* go through the result paths for all targets */
-    for(gint position = 0; position < numTargets; position++) {
-        /* handle the path to the destination at this position */
-        igraph_vector_t* resultPathVertices = igraph_vector_ptr_e(&resultPaths, position);
-
-        /* check the number of vertices in the result path */
-        glong nVertices = igraph_vector_size(resultPathVertices);
-
-        /* if there are no vertices, then the source and destination hosts are attached to
-         * the same igraph vertex. igraph doesn't give us a shortest path in this case.
-         * so, we handle the other cases here where it does provide paths. */
-        if(nVertices > 0) {
-            igraph_integer_t pathTargetIndex = 0;
-            igraph_real_t pathLatency = 0.0f, pathReliability = 0.0f;
-
-            gboolean isSuccess = _topology_computePathProperties(top, srcVertexIndex, resultPathVertices,
-                    pathStringBuffer, &pathLatency, &pathReliability, &pathTargetIndex);
-
-            if(isSuccess) {
-                const gchar* targetIDStr;
-                _topology_lockGraph(top);
-                found = _topology_findVertexAttributeString(top, pathTargetIndex, VERTEX_ATTR_ID, &targetIDStr);
-                utility_assert(found);
-                _topology_unlockGraph(top);
-
-                GString* logMessage = g_string_new(NULL);
-
-                g_string_printf(logMessage, "shortest path %s%s%s (%i%s%i) is %f ms with %f loss, path: %s",
-                                    srcIDStr, top->isDirected ? "-->" : "<-->", targetIDStr,
-                                    (gint) srcVertexIndex, top->isDirected ? "-->" : "<-->", (gint) pathTargetIndex,
-                                    pathLatency, 1-pathReliability, pathStringBuffer->str);
-
-                /* make sure at least one of the targets is the destination.
-                 * the case where src and dest are the same are handled in _topology_computePathToSelf */
-                if(dstVertexIndexPosition == position) {
-                    utility_assert(dstVertexIndex == pathTargetIndex);
-                    foundDstPosition = TRUE;
-                    info("%s", logMessage->str);
-                } else {
-                    debug("%s", logMessage->str);
-                }
-
-                g_string_free(logMessage, TRUE);
-
-                if(pathLatency == 0) {
-                    warning("found shortest path latency of 0 ms between source %s (%i) and destination %s (%i), using 1 ms instead",
-                            srcIDStr, srcVertexIndex, targetIDStr, pathTargetIndex);
-                    pathLatency = 1;
-                }
-
-                /* cache the latency and reliability we just computed */
-                _topology_storePathInCache(top, FALSE, srcVertexIndex, pathTargetIndex, pathLatency, pathReliability);
-            } else {
-                isAllSuccess = FALSE;
-            }
-        }
-
-        /* we are now done with the resultPathVertices vector, clean up */
-        igraph_vector_destroy(resultPathVertices);
-        g_free(resultPathVertices);
-    }
-
-    utility_assert(foundDstPosition == TRUE);
-
-    /* clean up */
-    igraph_vector_ptr_destroy(&resultPaths);
-    igraph_vector_destroy(&dstVertexIndexSet);
-    g_string_free(pathStringBuffer, TRUE);
-
-    /* success */
-    return isAllSuccess;
-}
-
-static gboolean _topology_lookupDirectPath(Topology* top, igraph_integer_t srcVertexIndex,
-        igraph_integer_t dstVertexIndex) {
-    MAGIC_ASSERT(top);
-
-    /* for complete graphs, we lookup the edge and use it as the path instead
-     * of running the shortest path algorithm.
-     *
-     * see the comment in _topology_computeSourcePathsHelper
-     */
+    /* we only need to do it once for each unique vertex no matter how many hosts live there */
+    GQueue* attachedTargets = _topology_getUniqueVertexTargets(top);
+    guint numTargets = g_queue_get_length(attachedTargets);
+    gboolean isSuccess = FALSE;
 
-    igraph_real_t totalLatency = 0.0, totalReliability = 1.0;
-    igraph_real_t edgeLatency = 0.0, edgeReliability = 1.0;
-    gboolean found;
-    const gchar* srcIDStr;
-    const gchar* dstIDStr;
+    info("computed shortest paths from root vertex %i to all %u vertices with connected hosts",
+            rootVertexIndex, numTargets);
 
-    _topology_lockGraph(top);
+    while(!g_queue_is_empty(attachedTargets)) {
+        gint targetVertexIndex = GPOINTER_TO_INT(g_queue_pop_head(attachedTargets));
 
-    found = _topology_findVertexAttributeString(top, srcVertexIndex, VERTEX_ATTR_ID, &srcIDStr);
-    utility_assert(found);
-    found = _topology_findVertexAttributeString(top, dstVertexIndex, VERTEX_ATTR_ID, &dstIDStr);
-    utility_assert(found);
+        /* the other pairs get their routes from another root */
+        if(targetVertexIndex == rootVertexIndex ||
+                _routegraph_getRouteRoot(rg, rootVertexIndex, targetVertexIndex) != rootVertexIndex) {
+            continue;
+        }
 
-    gdouble sourcePacketLoss;
-    if(_topology_findVertexAttributeDouble(top, srcVertexIndex, VERTEX_ATTR_PACKETLOSS, &sourcePacketLoss)) {
-        totalReliability *= (1.0f - sourcePacketLoss);
-    }
-    gdouble destPacketLoss;
-    if(_topology_findVertexAttributeDouble(top, dstVertexIndex, VERTEX_ATTR_PACKETLOSS, &destPacketLoss)) {
-        totalReliability *= (1.0f - destPacketLoss);
-    }
+        if(!_routegraph_getRoute(rg, tree, rootVertexIndex, targetVertexIndex, &route)) {
+            if(targetVertexIndex == otherVertexIndex) {
+                warning("no path from vertex %i to vertex %i", rootVertexIndex, targetVertexIndex);
+            }
+            continue;
+        }
 
-    gint result = _topology_getEdgeHelper(top, srcVertexIndex, dstVertexIndex, NULL, &edgeLatency, &edgeReliability);
+        if(targetVertexIndex == otherVertexIndex) {
+            GString* routeString = _topology_getRouteString(top, rg, tree, targetVertexIndex);
+            info("shortest path from vertex %i to vertex %i is %f ms with %f loss, path: %s",
+                    rootVertexIndex, targetVertexIndex, route.latency, 1.0f - route.reliability, routeString->str);
+            g_string_free(routeString, TRUE);
+            isSuccess = TRUE;
+        }
 
-    if(result != IGRAPH_SUCCESS) {
-        critical("igraph_get_eid return non-success code %i for edge between "
-                 "%s (%i) and %s (%i)", result, srcIDStr, (gint) srcVertexIndex, dstIDStr, (gint) dstVertexIndex);
-        _topology_unlockGraph(top);
-        return FALSE;
+        /* cache the latency and reliability we just computed */
+        _topology_storePathInCache(top, route.isDirect ? TRUE : FALSE, route.srcVertexIndex,
+                route.dstVertexIndex, route.latency, route.reliability);
     }
 
-    _topology_unlockGraph(top);
-
-    totalLatency += edgeLatency;
-    totalReliability *= edgeReliability;
-
-    /* cache the latency and reliability we just computed */
-    _topology_storePathInCache(top, TRUE, srcVertexIndex, dstVertexIndex, totalLatency, totalReliability);
+    g_queue_free(attachedTargets);
+    _routetree_free(tree);
 
-    return TRUE;
+    return isSuccess;
 }
 
 static void _topology_logAllCachedPathsHelper2(gpointer dstIndexKey, Path* path, Topology* top) {
@@ -1969,6 +2150,14 @@ static Path* _topology_getPathEntry(Topology* top, Address* srcAddress, Address*
         path = _topology_getPathFromCache(top, dstVertexIndex, srcVertexIndex);
     }
 
+    if(!path && _topology_loadMappedPath(top, srcVertexIndex, dstVertexIndex)) {
+        /* computed in an earlier run */
+        path = _topology_getPathFromCache(top, srcVertexIndex, dstVertexIndex);
+        if(!path && !top->isDirected) {
+            path = _topology_getPathFromCache(top, dstVertexIndex, srcVertexIndex);
+        }
+    }
+
     if(!path) {
         /* cache miss, lets find the path */
         gboolean success = FALSE;
@@ -1996,23 +2185,13 @@ static Path* _topology_getPathEntry(Topology* top, Address* srcAddress, Address*
                 top->prefersDirectPaths ? "True" : "False",
                 verticesAreAdjacent ? "True" : "False");
 
-        if(top->isComplete || (top->prefersDirectPaths && verticesAreAdjacent)) {
-            /* use the edge between src and dst as the path */
-            success = _topology_lookupDirectPath(top, srcVertexIndex, dstVertexIndex);
-
-            if(success) {
-                info("We found a direct path between node %s at %s (vertex %i) and "
-                        "node %s at %s (vertex %i), and stored the path in the cache.",
-                        address_toString(srcAddress), srcIDStr, (gint)srcVertexIndex,
-                        address_toString(dstAddress), dstIDStr, (gint)dstVertexIndex);
-            }
-        } else {
-            success = _topology_computeSourcePaths(top, srcVertexIndex, dstVertexIndex);
-        }
+        /* the same rules as for precomputed paths decide whether it is the
+         * edge between src and dst or a shortest path */
+        success = _topology_computePaths(top, srcVertexIndex, dstVertexIndex);
 
         if(success) {
             path = _topology_getPathFromCache(top, srcVertexIndex, dstVertexIndex);
-            if(!path) {
+            if(!path && !top->isDirected) {
                 path = _topology_getPathFromCache(top, dstVertexIndex, srcVertexIndex);
             }
         }
@@ -2030,22 +2209,81 @@ static Path* _topology_getPathEntry(Topology* top, Address* srcAddress, Address*
     return path;
 }
 
-void topology_incrementPathPacketCounter(Topology* top, Address* srcAddress, Address* dstAddress) {
+void topology_createPathIndex(Topology* top) {
+    MAGIC_ASSERT(top);
+
+    /* the first thread creates it, the others find it done */
+    if(g_once_init_enter(&(top->pathIndex))) {
+        g_rw_lock_reader_lock(&(top->virtualIPLock));
+        gint numVertices = (gint) g_hash_table_size(top->attachmentIndices);
+        g_rw_lock_reader_unlock(&(top->virtualIPLock));
+
+        info("creating path index for %i attached vertices", numVertices);
+        g_once_init_leave(&(top->pathIndex), _pathindex_new(numVertices));
+    }
+}
+
+Path* topology_getPath(Topology* top, Address* srcAddress, Address* dstAddress) {
     MAGIC_ASSERT(top);
 
+    PathIndex* index = g_atomic_pointer_get(&(top->pathIndex));
+
+    gint srcIndex = address_getAttachmentIndex(srcAddress);
+    gint dstIndex = address_getAttachmentIndex(dstAddress);
+    gboolean isIndexed = (index && srcIndex >= 0 && srcIndex < index->numVertices &&
+            dstIndex >= 0 && dstIndex < index->numVertices) ? TRUE : FALSE;
+
+    /* the index is created after every host has attached and before the
+     * simulation starts, so every lookup should be covered by it */
+    utility_assert(isIndexed);
+
+    if(isIndexed) {
+        Path* path = _pathindex_get(index, srcIndex, dstIndex);
+        if(path) {
+            return path;
+        }
+    }
+
+    /* first use of this pair, get it from the cache or compute it */
     Path* path = _topology_getPathEntry(top, srcAddress, dstAddress);
+
+    if(path && isIndexed) {
+        _pathindex_set(index, srcIndex, dstIndex, path);
+    }
+
+    return path;
+}
+
+void topology_incrementPathPacketCounter(Topology* top, Address* srcAddress, Address* dstAddress) {
+    MAGIC_ASSERT(top);
+
+    Path* path = topology_getPath(top, srcAddress, dstAddress);
     if(path != NULL) {
-        path_incrementPacketCount(path);
+        path_addPacketCount(path, 1);
     } else {
         error("unable to find path between node %s and node %s",
                 address_toString(srcAddress), address_toString(dstAddress));
     }
 }
 
+void topology_addPathPacketCounts(Topology* top, const gsize* packetCounts, guint numPathIDs) {
+    MAGIC_ASSERT(top);
+
+    g_rw_lock_reader_lock(&(top->pathCacheLock));
+    guint numPaths = top->pathsByID ? top->pathsByID->len : 0;
+    utility_assert(numPathIDs <= numPaths);
+    for(guint id = 0; id < numPathIDs && id < numPaths; id++) {
+        if(packetCounts[id] > 0) {
+            path_addPacketCount(g_ptr_array_index(top->pathsByID, id), packetCounts[id]);
+        }
+    }
+    g_rw_lock_reader_unlock(&(top->pathCacheLock));
+}
+
 gdouble topology_getLatency(Topology* top, Address* srcAddress, Address* dstAddress) {
     MAGIC_ASSERT(top);
 
-    Path* path = _topology_getPathEntry(top, srcAddress, dstAddress);
+    Path* path = topology_getPath(top, srcAddress, dstAddress);
 
     if(path != NULL) {
         return path_getLatency(path);
@@ -2057,7 +2295,7 @@ gdouble topology_getLatency(Topology* top, Address* srcAddress, Address* dstAddr
 gdouble topology_getReliability(Topology* top, Address* srcAddress, Address* dstAddress) {
     MAGIC_ASSERT(top);
 
-    Path* path = _topology_getPathEntry(top, srcAddress, dstAddress);
+    Path* path = topology_getPath(top, srcAddress, dstAddress);
 
     if(path != NULL) {
         return path_getReliability(path);
@@ -2071,6 +2309,294 @@ gboolean topology_isRoutable(Topology* top, Address* srcAddress, Address* dstAdd
     return (topology_getLatency(top, srcAddress, dstAddress) > -1) ? TRUE : FALSE;
 }
 
+
+/* the number of pairs of attached vertices that get a path. in undirected
+ * graphs that is each vertex with itself and every higher vertex. */
+static guint64 _routegraph_getNumPairs(RouteGraph* rg) {
+    guint64 n = (guint64) rg->numAttached;
+    return rg->isDirected ? n * n : n * (n + 1) / 2;
+}
+
+/* the ordinals in attachedVertices of the pair at position pair in the order
+ * of path table records */
+static void _routegraph_getPair(RouteGraph* rg, guint64 pair, gint* srcOrdinal, gint* dstOrdinal) {
+    guint64 n = (guint64) rg->numAttached;
+
+    if(rg->isDirected) {
+        *srcOrdinal = (gint)(pair / n);
+        *dstOrdinal = (gint)(pair % n);
+        return;
+    }
+
+    /* row i holds the n - i pairs (i, j) with j >= i */
+    guint64 i = 0;
+    while(pair >= n - i) {
+        pair -= n - i;
+        i++;
+    }
+    *srcOrdinal = (gint) i;
+    *dstOrdinal = (gint)(i + pair);
+}
+
+/* creates the table that all threads precompute paths into, laid out like a
+ * path cache file, and maps it in place of one */
+static PathCacheRecord* _topology_getPrecomputedPathTable(Topology* top, RouteGraph* rg) {
+    MAGIC_ASSERT(top);
+
+    if(g_once_init_enter(&(top->pathCacheMap))) {
+        guint64 numPairs = _routegraph_getNumPairs(rg);
+        if(numPairs > G_MAXUINT32) {
+            error("unable to precompute paths between %i attached vertices, "
+                    "the %"G_GUINT64_FORMAT" pairs do not fit in a path table", rg->numAttached, numPairs);
+        }
+
+        gsize mapSize = sizeof(PathCacheHeader) + (gsize)numPairs * sizeof(PathCacheRecord);
+        gpointer map = mmap(NULL, mapSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if(map == MAP_FAILED) {
+            error("unable to map %"G_GSIZE_FORMAT" bytes for precomputed paths: error %i: %s",
+                    mapSize, errno, g_strerror(errno));
+        }
+
+        PathCacheHeader* header = map;
+        memcpy(header->magic, PATHCACHE_MAGIC, sizeof(header->magic));
+        header->version = PATHCACHE_VERSION;
+        header->numRecords = (guint32) numPairs;
+
+        top->pathCacheMapSize = mapSize;
+        top->mappedPaths = (const PathCacheRecord*) (header + 1);
+        top->numMappedPaths = (guint32) numPairs;
+
+        g_once_init_leave(&(top->pathCacheMap), map);
+    }
+
+    return (PathCacheRecord*) (((PathCacheHeader*) top->pathCacheMap) + 1);
+}
+
+void topology_precomputePaths(Topology* top, guint threadIndex, guint numThreads) {
+    MAGIC_ASSERT(top);
+    utility_assert(numThreads > 0 && threadIndex < numThreads);
+
+    RouteGraph* rg = _topology_getRouteGraph(top);
+    PathCacheRecord* records = _topology_getPrecomputedPathTable(top, rg);
+    RouteTree* tree = _routetree_new(rg);
+
+    GTimer* pathTimer = g_timer_new();
+    gdouble dijkstraSeconds = 0;
+    guint numSources = 0, numPaths = 0;
+    gdouble minLatency = 0;
+
+    /* each thread takes an equal share of the pairs, so the threads are
+     * balanced even though undirected graphs have shorter rows for higher
+     * vertices. a thread whose share starts or ends inside a row only runs
+     * dijkstra for that source once more than it otherwise would. */
+    guint64 numPairs = _routegraph_getNumPairs(rg);
+    guint64 firstPair = numPairs * threadIndex / numThreads;
+    guint64 endPair = numPairs * (threadIndex + 1) / numThreads;
+
+    gint srcOrdinal = 0, dstOrdinal = 0;
+    if(firstPair < endPair) {
+        _routegraph_getPair(rg, firstPair, &srcOrdinal, &dstOrdinal);
+    }
+
+    for(guint64 pair = firstPair; pair < endPair; pair++) {
+        gint srcVertexIndex = rg->attachedVertices[srcOrdinal];
+        gint dstVertexIndex = rg->attachedVertices[dstOrdinal];
+
+        /* the table only has the pairs whose path is computed from their source */
+        utility_assert(_routegraph_getRouteRoot(rg, srcVertexIndex, dstVertexIndex) == srcVertexIndex);
+
+        if(_routegraph_needsTree(rg, srcVertexIndex, dstVertexIndex) &&
+                tree->rootVertexIndex != srcVertexIndex) {
+            g_timer_start(pathTimer);
+            _routegraph_runDijkstra(rg, tree, srcVertexIndex);
+            dijkstraSeconds += g_timer_elapsed(pathTimer, NULL);
+            numSources++;
+        }
+
+        /* the threads write disjoint records, straight into the table */
+        PathCacheRecord* record = &(records[pair]);
+        if(_routegraph_getRoute(rg, tree, srcVertexIndex, dstVertexIndex, record)) {
+            record->isRoutable = 1;
+            minLatency = (minLatency == 0) ? record->latency : MIN(minLatency, record->latency);
+            numPaths++;
+        } else {
+            record->isRoutable = 0;
+            warning("no path from vertex %i to vertex %i", srcVertexIndex, dstVertexIndex);
+        }
+
+        /* on to the next record */
+        dstOrdinal++;
+        if(dstOrdinal == rg->numAttached) {
+            srcOrdinal++;
+            dstOrdinal = rg->isDirected ? 0 : srcOrdinal;
+        }
+    }
+
+    g_timer_destroy(pathTimer);
+    _routetree_free(tree);
+
+    gboolean wasUpdated = FALSE;
+
+    g_rw_lock_writer_lock(&(top->pathCacheLock));
+    if(minLatency > 0 && (top->minimumPathLatency == 0 || minLatency < top->minimumPathLatency)) {
+        top->minimumPathLatency = minLatency;
+        /* the table is stored as is, so keep its header up to date */
+        ((PathCacheHeader*) top->pathCacheMap)->minimumLatency = minLatency;
+        wasUpdated = TRUE;
+    }
+    g_rw_lock_writer_unlock(&(top->pathCacheLock));
+
+    if(wasUpdated) {
+        worker_updateMinTimeJump(minLatency);
+    }
+
+    g_mutex_lock(&top->topologyLock);
+    top->shortestPathTotalTime += dijkstraSeconds;
+    top->shortestPathCount += numSources;
+    g_mutex_unlock(&top->topologyLock);
+
+    message("precomputed %u of %"G_GUINT64_FORMAT" paths, running dijkstra from %u source vertices in %f seconds",
+            numPaths, endPair - firstPair, numSources, dijkstraSeconds);
+}
+
+/* the cache file key covers everything the precomputed paths depend on */
+static gchar* _topology_getPathCacheKey(Topology* top) {
+    MAGIC_ASSERT(top);
+
+    RouteGraph* rg = _topology_getRouteGraph(top);
+
+    GChecksum* checksum = g_checksum_new(G_CHECKSUM_SHA256);
+    guint32 version = PATHCACHE_VERSION;
+    g_checksum_update(checksum, (const guchar*)&version, sizeof(guint32));
+    g_checksum_update(checksum, (const guchar*)top->graphChecksum, (gssize)strlen(top->graphChecksum));
+    g_checksum_update(checksum, (const guchar*)rg->attachedVertices, (gssize)(sizeof(gint) * rg->numAttached));
+
+    gchar* key = g_strdup(g_checksum_get_string(checksum));
+
+    g_checksum_free(checksum);
+
+    return key;
+}
+
+static gchar* _topology_getPathCacheFilename(Topology* top, const gchar* cacheDirPath) {
+    gchar* key = _topology_getPathCacheKey(top);
+    gchar* basename = g_strdup_printf("%s.paths", key);
+    gchar* filename = g_build_filename(cacheDirPath, basename, NULL);
+    g_free(basename);
+    g_free(key);
+    return filename;
+}
+
+gboolean topology_loadPathCache(Topology* top, const gchar* cacheDirPath) {
+    MAGIC_ASSERT(top);
+    utility_assert(cacheDirPath);
+
+    gchar* filename = _topology_getPathCacheFilename(top, cacheDirPath);
+
+    gint fd = open(filename, O_RDONLY);
+    if(fd < 0) {
+        message("no path cache at '%s', paths will be computed", filename);
+        g_free(filename);
+        return FALSE;
+    }
+
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) < 0 || (gsize)fileStat.st_size < sizeof(PathCacheHeader)) {
+        warning("ignoring truncated path cache at '%s'", filename);
+        close(fd);
+        g_free(filename);
+        return FALSE;
+    }
+
+    gsize fileSize = (gsize) fileStat.st_size;
+    gpointer map = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(map == MAP_FAILED) {
+        warning("unable to mmap path cache at '%s': error %i: %s", filename, errno, g_strerror(errno));
+        g_free(filename);
+        return FALSE;
+    }
+
+    const PathCacheHeader* header = map;
+    const PathCacheRecord* records = (const PathCacheRecord*) (header + 1);
+
+    gboolean isValid = (memcmp(header->magic, PATHCACHE_MAGIC, sizeof(header->magic)) == 0 &&
+            header->version == PATHCACHE_VERSION &&
+            fileSize == sizeof(PathCacheHeader) + (gsize)header->numRecords * sizeof(PathCacheRecord)) ? TRUE : FALSE;
+
+    if(!isValid) {
+        warning("ignoring invalid path cache at '%s'", filename);
+        munmap(map, fileSize);
+        g_free(filename);
+        return FALSE;
+    }
+
+    /* keep the file mapped and look up each path in it when it is first used,
+     * so we only pay for the pairs of hosts that actually communicate */
+    gboolean wasUpdated = FALSE;
+
+    g_rw_lock_writer_lock(&(top->pathCacheLock));
+    utility_assert(!top->pathCacheMap);
+    top->pathCacheMap = map;
+    top->pathCacheMapSize = fileSize;
+    top->mappedPaths = records;
+    top->numMappedPaths = header->numRecords;
+
+    /* the round length depends on the shortest path, so we need it up front */
+    if(header->minimumLatency > 0 && (top->minimumPathLatency == 0 ||
+            header->minimumLatency < top->minimumPathLatency)) {
+        top->minimumPathLatency = header->minimumLatency;
+        wasUpdated = TRUE;
+    }
+    g_rw_lock_writer_unlock(&(top->pathCacheLock));
+
+    if(wasUpdated) {
+        worker_updateMinTimeJump(header->minimumLatency);
+    }
+
+    message("mapped %u paths from path cache at '%s'", header->numRecords, filename);
+    g_free(filename);
+
+    return TRUE;
+}
+
+void topology_storePathCache(Topology* top, const gchar* cacheDirPath) {
+    MAGIC_ASSERT(top);
+    utility_assert(cacheDirPath);
+
+    if(g_mkdir_with_parents(cacheDirPath, 0775) < 0) {
+        warning("unable to create path cache directory '%s': error %i: %s",
+                cacheDirPath, errno, g_strerror(errno));
+        return;
+    }
+
+    g_rw_lock_reader_lock(&(top->pathCacheLock));
+    gpointer map = top->pathCacheMap;
+    gsize mapSize = top->pathCacheMapSize;
+    guint32 numRecords = top->numMappedPaths;
+    g_rw_lock_reader_unlock(&(top->pathCacheLock));
+
+    if(!map) {
+        warning("no precomputed paths to store in the path cache");
+        return;
+    }
+
+    gchar* filename = _topology_getPathCacheFilename(top, cacheDirPath);
+
+    /* the precomputed table is already laid out and sorted like the file.
+     * written to a temporary file and renamed, so other runs never see a partial cache. */
+    GError* error = NULL;
+    if(g_file_set_contents(filename, (const gchar*)map, (gssize)mapSize, &error)) {
+        message("stored %u paths in path cache at '%s'", numRecords, filename);
+    } else {
+        warning("unable to write path cache at '%s': %s", filename, error->message);
+        g_error_free(error);
+    }
+
+    g_free(filename);
+}
+
 static gboolean _topology_findAttachmentVertexHelperHook(Topology* top, igraph_integer_t vertexIndex, AttachHelper* ah) {
     MAGIC_ASSERT(top);
     utility_assert(ah);
@@ -2362,6 +2888,14 @@ void topology_attach(Topology* top, Address* address, Random* randomSourcePool,
     g_rw_lock_writer_lock(&(top->virtualIPLock));
     g_hash_table_replace(top->virtualIP, GUINT_TO_POINTER(nodeIP), GINT_TO_POINTER(vertexIndex));
     g_hash_table_replace(top->verticesWithAttachedHosts, GUINT_TO_POINTER(vertexIndex), GINT_TO_POINTER(vertexIndex));
+
+    /* the first host on each vertex gives it the next attachment index */
+    gpointer attachmentIndexPtr = NULL;
+    if(!g_hash_table_lookup_extended(top->attachmentIndices, GINT_TO_POINTER(vertexIndex), NULL, &attachmentIndexPtr)) {
+        attachmentIndexPtr = GINT_TO_POINTER(g_hash_table_size(top->attachmentIndices));
+        g_hash_table_replace(top->attachmentIndices, GINT_TO_POINTER(vertexIndex), attachmentIndexPtr);
+    }
+    address_setAttachmentIndex(address, GPOINTER_TO_INT(attachmentIndexPtr));
     g_rw_lock_writer_unlock(&(top->virtualIPLock));
 
     const gchar* idStr = NULL;
@@ -2434,22 +2968,25 @@ void topology_free(Topology* top) {
         g_hash_table_destroy(top->verticesWithAttachedHosts);
         top->verticesWithAttachedHosts = NULL;
     }
+    if(top->attachmentIndices) {
+        g_hash_table_destroy(top->attachmentIndices);
+        top->attachmentIndices = NULL;
+    }
     g_rw_lock_writer_unlock(&(top->virtualIPLock));
     g_rw_lock_clear(&(top->virtualIPLock));
 
     /* this functions grabs and releases the pathCache write lock */
     _topology_clearCache(top);
-    g_rw_lock_clear(&(top->pathCacheLock));
 
-    /* clear the stored edge weights */
-    g_rw_lock_writer_lock(&(top->edgeWeightsLock));
-    if(top->edgeWeights) {
-        igraph_vector_destroy(top->edgeWeights);
-        g_free(top->edgeWeights);
-        top->edgeWeights = NULL;
+    if(top->routeGraph) {
+        _routegraph_free(top->routeGraph);
+        top->routeGraph = NULL;
     }
-    g_rw_lock_writer_unlock(&(top->edgeWeightsLock));
-    g_rw_lock_clear(&(top->edgeWeightsLock));
+    if(top->graphChecksum) {
+        g_free(top->graphChecksum);
+        top->graphChecksum = NULL;
+    }
+    g_rw_lock_clear(&(top->pathCacheLock));
 
     /* clear the graph */
     _topology_lockGraph(top);
@@ -2470,17 +3007,15 @@ Topology* topology_new(const gchar* graphPath) {
 
     top->virtualIP = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, NULL);
     top->verticesWithAttachedHosts = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, NULL);
+    top->attachmentIndices = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, NULL);
 
     _topology_initGraphLock(&(top->graphLock));
     g_mutex_init(&(top->topologyLock));
-    g_rw_lock_init(&(top->edgeWeightsLock));
     g_rw_lock_init(&(top->virtualIPLock));
     g_rw_lock_init(&(top->pathCacheLock));
 
-    /* first read in the graph and make sure its formed correctly,
-     * then setup our edge weights for shortest path */
-    if(!_topology_loadGraph(top, graphPath) || !_topology_checkGraph(top) ||
-            !_topology_extractEdgeWeights(top)) {
+    /* first read in the graph and make sure its formed correctly */
+    if(!_topology_loadGraph(top, graphPath) || !_topology_checkGraph(top)) {
         topology_free(top);
         critical("we failed to create the simulation topology because we were unable to validate the topology graphml file");
         return NULL;
@@ -19,9 +19,27 @@ void topology_attach(Topology* top, Address* address, Random* randomSourcePool,
         guint64* bwDownOut, guint64* bwUpOut);
 void topology_detach(Topology* top, Address* address);
 
+/* create the index that paths are looked up in during the simulation, sized
+ * for the attached vertices. every thread must call this after all hosts are
+ * attached and before any path is looked up. */
+void topology_createPathIndex(Topology* top);
+/* returns the cached path between the vertices the addresses are attached to,
+ * computing it on first use, or NULL if no path exists */
+Path* topology_getPath(Topology* top, Address* srcAddress, Address* dstAddress);
+/* compute the paths from this thread's share of the attached vertices, so that
+ * no path has to be computed during the simulation. every thread must call this
+ * after all hosts are attached and before any packet is sent. */
+void topology_precomputePaths(Topology* top, guint threadIndex, guint numThreads);
+/* load or store all cached paths in a file in cacheDirPath, whose name is derived
+ * from the graph and the set of attached vertices. a loaded file stays mapped,
+ * and each path is read from it when it is first looked up. */
+gboolean topology_loadPathCache(Topology* top, const gchar* cacheDirPath);
+void topology_storePathCache(Topology* top, const gchar* cacheDirPath);
 gboolean topology_isRoutable(Topology* top, Address* srcAddress, Address* dstAddress);
 gdouble topology_getLatency(Topology* top, Address* srcAddress, Address* dstAddress);
 gdouble topology_getReliability(Topology* top, Address* srcAddress, Address* dstAddress);
 void topology_incrementPathPacketCounter(Topology* top, Address* srcAddress, Address* dstAddress);
+/* adds the number of packets a worker sent on each path, indexed by path id */
+void topology_addPathPacketCounts(Topology* top, const gsize* packetCounts, guint numPathIDs);
 
 #endif /* SHD_TOPOLOGY_H_ */
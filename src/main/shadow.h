@@ -63,30 +63,40 @@ typedef struct _Process Process;
 /* logging */
 #include "core/logger/shd-log-level.h"
 #include "core/logger/shd-log-record.h"
+#include "core/logger/shd-log-buffer.h"
 #include "core/logger/shd-logger-helper.h"
 #include "core/logger/shd-logger.h"
 
 /* configuration, base runnables, and input parsing */
 #include "core/support/shd-object-counter.h"
+#include "core/support/shd-object-pool.h"
 #include "core/support/shd-examples.h"
 #include "core/support/shd-options.h"
 #include "utility/shd-utility.h"
+#include "utility/shd-iovec.h"
+#include "utility/shd-port-bitmap.h"
 #include "core/work/shd-task.h"
 #include "core/work/shd-event.h"
+#include "core/work/shd-event-queue.h"
 #include "core/work/shd-message.h"
 #include "host/shd-protocol.h"
 #include "host/descriptor/shd-descriptor.h"
 #include "core/support/shd-configuration.h"
+#include "host/shd-payload.h"
 #include "host/shd-packet.h"
+#include "host/shd-packet-trace.h"
 #include "host/shd-cpu.h"
+#include "host/shd-timer-wheel.h"
 #include "utility/shd-pcap-writer.h"
 
 /* utilities with limited dependencies */
 #include "utility/shd-byte-queue.h"
 #include "utility/shd-priority-queue.h"
+#include "utility/shd-sequence-ring.h"
 #include "utility/shd-async-priority-queue.h"
 #include "utility/shd-count-down-latch.h"
 #include "utility/shd-random.h"
+#include "utility/shd-compressor.h"
 
 #include "routing/shd-address.h"
 #include "routing/shd-dns.h"
@@ -0,0 +1,406 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "shadow.h"
+
+#include <fcntl.h>
+#include <glib/gstdio.h>
+
+#ifdef SHADOW_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+/* the seek table is a skippable frame listing the compressed and uncompressed
+ * size of every frame, followed by a footer with the number of frames, see
+ * the seekable format in the contrib directory of the zstd sources */
+#define COMPRESSOR_SKIPPABLE_MAGIC 0x184D2A5E
+#define COMPRESSOR_SEEKABLE_MAGIC 0x8F92EAB1
+
+typedef enum _CompressorJobType CompressorJobType;
+enum _CompressorJobType {
+    CJ_FRAME, CJ_CLOSE, CJ_SYNC, CJ_STOP,
+};
+
+typedef struct _CompressorJob CompressorJob;
+struct _CompressorJob {
+    CompressorJobType type;
+    CompressedStream* stream;
+    GByteArray* frame;
+    CountDownLatch* latch;
+};
+
+struct _Compressor {
+    gint level;
+    GAsyncQueue* jobs;
+    pthread_t thread;
+
+    /* uncompressed bytes handed to the thread and not yet written */
+    GMutex queuedLock;
+    GCond queuedCond;
+    gsize queuedBytes;
+
+    /* the rest is only used by the compressor thread */
+#ifdef SHADOW_HAVE_ZSTD
+    ZSTD_CCtx* context;
+#endif
+    GByteArray* output;
+
+    MAGIC_DECLARE;
+};
+
+struct _CompressedStream {
+    Compressor* compressor;
+    gint fd;
+    gboolean closeWhenDone;
+    gsize frameSize;
+    /* if the writer waits while too many bytes are queued */
+    gboolean mayBlock;
+
+    /* the frame being filled by the writer of the stream */
+    GByteArray* pending;
+
+    /* the rest is only used by the compressor thread */
+    GByteArray* seekTable;
+    guint32 numFrames;
+    gboolean hasFailed;
+
+    MAGIC_DECLARE;
+};
+
+static Compressor* defaultCompressor = NULL;
+
+gboolean compressor_isSupported() {
+#ifdef SHADOW_HAVE_ZSTD
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
+const gchar* compressor_getFileSuffix() {
+    return ".zst";
+}
+
+static void _compressor_pushJob(Compressor* compressor, CompressorJobType type,
+        CompressedStream* stream, GByteArray* frame, CountDownLatch* latch) {
+    CompressorJob* job = g_new0(CompressorJob, 1);
+    job->type = type;
+    job->stream = stream;
+    job->frame = frame;
+    job->latch = latch;
+    g_async_queue_push(compressor->jobs, job);
+}
+
+/* hands a full frame to the thread. streams that may block wait until the
+ * queue drains below the cap first, so a writer producing output faster than
+ * it can be compressed is slowed down instead of growing our memory. */
+static void _compressor_pushFrame(Compressor* compressor, CompressedStream* stream, GByteArray* frame) {
+    g_mutex_lock(&(compressor->queuedLock));
+    while(stream->mayBlock && compressor->queuedBytes >= COMPRESSOR_MAX_QUEUED_BYTES) {
+        g_cond_wait(&(compressor->queuedCond), &(compressor->queuedLock));
+    }
+    compressor->queuedBytes += frame->len;
+    g_mutex_unlock(&(compressor->queuedLock));
+
+    _compressor_pushJob(compressor, CJ_FRAME, stream, frame, NULL);
+}
+
+static void _compressor_releaseFrame(Compressor* compressor, GByteArray* frame) {
+    g_mutex_lock(&(compressor->queuedLock));
+    utility_assert(compressor->queuedBytes >= frame->len);
+    compressor->queuedBytes -= frame->len;
+    g_cond_broadcast(&(compressor->queuedCond));
+    g_mutex_unlock(&(compressor->queuedLock));
+
+    g_byte_array_free(frame, TRUE);
+}
+
+static gboolean _compressor_writeAll(gint fd, const guint8* data, gsize length) {
+    while(length > 0) {
+        gssize written = write(fd, data, length);
+        if(written < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return FALSE;
+        }
+        data += written;
+        length -= (gsize) written;
+    }
+    return TRUE;
+}
+
+static void _compressor_writeFrame(Compressor* compressor, CompressedStream* stream, GByteArray* frame) {
+    if(stream->hasFailed || frame->len == 0) {
+        return;
+    }
+
+#ifdef SHADOW_HAVE_ZSTD
+    gsize bound = ZSTD_compressBound(frame->len);
+    if(compressor->output->len < bound) {
+        g_byte_array_set_size(compressor->output, (guint)bound);
+    }
+
+    gsize compressedSize = ZSTD_compressCCtx(compressor->context, compressor->output->data, bound,
+            frame->data, frame->len, compressor->level);
+    if(ZSTD_isError(compressedSize)) {
+        /* the logger may be writing through this stream, so we can't use it */
+        g_printerr("** unable to compress a frame of %u bytes: %s\n", frame->len, ZSTD_getErrorName(compressedSize));
+        stream->hasFailed = TRUE;
+        return;
+    }
+
+    if(!_compressor_writeAll(stream->fd, compressor->output->data, compressedSize)) {
+        g_printerr("** unable to write a compressed frame to fd %i: %s\n", stream->fd, g_strerror(errno));
+        stream->hasFailed = TRUE;
+        return;
+    }
+
+    guint32 entry[2] = {GUINT32_TO_LE((guint32)compressedSize), GUINT32_TO_LE(frame->len)};
+    g_byte_array_append(stream->seekTable, (const guint8*) entry, sizeof(entry));
+    stream->numFrames++;
+#endif
+}
+
+static void _compressor_closeStream(Compressor* compressor, CompressedStream* stream) {
+    MAGIC_ASSERT(stream);
+
+    if(!stream->hasFailed && stream->numFrames > 0) {
+        guint32 numFrames = GUINT32_TO_LE(stream->numFrames);
+        guint8 descriptor = 0;
+        guint32 seekableMagic = GUINT32_TO_LE(COMPRESSOR_SEEKABLE_MAGIC);
+        g_byte_array_append(stream->seekTable, (const guint8*) &numFrames, sizeof(numFrames));
+        g_byte_array_append(stream->seekTable, &descriptor, sizeof(descriptor));
+        g_byte_array_append(stream->seekTable, (const guint8*) &seekableMagic, sizeof(seekableMagic));
+
+        guint32 header[2] = {GUINT32_TO_LE(COMPRESSOR_SKIPPABLE_MAGIC), GUINT32_TO_LE(stream->seekTable->len)};
+        if(!_compressor_writeAll(stream->fd, (const guint8*) header, sizeof(header)) ||
+                !_compressor_writeAll(stream->fd, stream->seekTable->data, stream->seekTable->len)) {
+            g_printerr("** unable to write a seek table to fd %i: %s\n", stream->fd, g_strerror(errno));
+        }
+    }
+
+    if(stream->closeWhenDone) {
+        close(stream->fd);
+    }
+
+    g_byte_array_free(stream->seekTable, TRUE);
+    MAGIC_CLEAR(stream);
+    g_free(stream);
+}
+
+static gpointer _compressor_runThread(Compressor* compressor) {
+    gboolean stop = FALSE;
+
+    while(!stop) {
+        CompressorJob* job = g_async_queue_pop(compressor->jobs);
+
+        switch(job->type) {
+            case CJ_FRAME: {
+                _compressor_writeFrame(compressor, job->stream, job->frame);
+                _compressor_releaseFrame(compressor, job->frame);
+                break;
+            }
+
+            case CJ_CLOSE: {
+                _compressor_closeStream(compressor, job->stream);
+                break;
+            }
+
+            case CJ_SYNC: {
+                countdownlatch_countDown(job->latch);
+                break;
+            }
+
+            case CJ_STOP: {
+                stop = TRUE;
+                countdownlatch_countDown(job->latch);
+                break;
+            }
+
+            default:
+                break;
+        }
+
+        g_free(job);
+    }
+
+    return NULL;
+}
+
+Compressor* compressor_new(gint level) {
+#ifdef SHADOW_HAVE_ZSTD
+    Compressor* compressor = g_new0(Compressor, 1);
+    MAGIC_INIT(compressor);
+
+    compressor->level = level;
+    compressor->jobs = g_async_queue_new();
+    g_mutex_init(&(compressor->queuedLock));
+    g_cond_init(&(compressor->queuedCond));
+    compressor->context = ZSTD_createCCtx();
+    compressor->output = g_byte_array_new();
+
+    gint returnVal = pthread_create(&(compressor->thread), NULL, (void*(*)(void*))_compressor_runThread, compressor);
+    if(returnVal != 0) {
+        ZSTD_freeCCtx(compressor->context);
+        g_byte_array_free(compressor->output, TRUE);
+        g_async_queue_unref(compressor->jobs);
+        g_mutex_clear(&(compressor->queuedLock));
+        g_cond_clear(&(compressor->queuedCond));
+        MAGIC_CLEAR(compressor);
+        g_free(compressor);
+        return NULL;
+    }
+
+    pthread_setname_np(compressor->thread, "compressor");
+
+    return compressor;
+#else
+    return NULL;
+#endif
+}
+
+void compressor_free(Compressor* compressor) {
+    MAGIC_ASSERT(compressor);
+
+    /* everything queued before the stop job is written before it returns.
+     * like the logger helper, we wait on a latch instead of joining. */
+    CountDownLatch* latch = countdownlatch_new(1);
+    _compressor_pushJob(compressor, CJ_STOP, NULL, NULL, latch);
+    countdownlatch_await(latch);
+    countdownlatch_free(latch);
+
+    utility_assert(g_async_queue_length(compressor->jobs) == 0);
+    utility_assert(compressor->queuedBytes == 0);
+    g_async_queue_unref(compressor->jobs);
+    g_mutex_clear(&(compressor->queuedLock));
+    g_cond_clear(&(compressor->queuedCond));
+#ifdef SHADOW_HAVE_ZSTD
+    ZSTD_freeCCtx(compressor->context);
+#endif
+    g_byte_array_free(compressor->output, TRUE);
+
+    MAGIC_CLEAR(compressor);
+    g_free(compressor);
+}
+
+void compressor_setDefault(Compressor* compressor) {
+    if(defaultCompressor != NULL) {
+        Compressor* c = defaultCompressor;
+        defaultCompressor = NULL;
+        compressor_free(c);
+    }
+    if(compressor != NULL) {
+        MAGIC_ASSERT(compressor);
+        defaultCompressor = compressor;
+    }
+}
+
+Compressor* compressor_getDefault() {
+    return defaultCompressor;
+}
+
+void compressor_sync(Compressor* compressor) {
+    MAGIC_ASSERT(compressor);
+    CountDownLatch* latch = countdownlatch_new(1);
+    _compressor_pushJob(compressor, CJ_SYNC, NULL, NULL, latch);
+    countdownlatch_await(latch);
+    countdownlatch_free(latch);
+}
+
+CompressedStream* compressor_openStream(Compressor* compressor, gint fd,
+        gboolean closeWhenDone, gsize frameSize, gboolean mayBlock) {
+    MAGIC_ASSERT(compressor);
+    utility_assert(frameSize > 0 && frameSize <= COMPRESSOR_MAX_QUEUED_BYTES);
+
+    CompressedStream* stream = g_new0(CompressedStream, 1);
+    MAGIC_INIT(stream);
+
+    stream->compressor = compressor;
+    stream->fd = fd;
+    stream->closeWhenDone = closeWhenDone;
+    stream->frameSize = frameSize;
+    stream->mayBlock = mayBlock;
+    stream->seekTable = g_byte_array_new();
+
+    return stream;
+}
+
+void compressedstream_write(CompressedStream* stream, gconstpointer data, gsize length) {
+    MAGIC_ASSERT(stream);
+    const guint8* bytes = data;
+
+    /* every frame but the last of a stream holds exactly frameSize bytes */
+    while(length > 0) {
+        if(!stream->pending) {
+            stream->pending = g_byte_array_sized_new((guint)stream->frameSize);
+        }
+
+        gsize amount = MIN(length, stream->frameSize - stream->pending->len);
+        g_byte_array_append(stream->pending, bytes, (guint)amount);
+        bytes += amount;
+        length -= amount;
+
+        if(stream->pending->len >= stream->frameSize) {
+            _compressor_pushFrame(stream->compressor, stream, stream->pending);
+            stream->pending = NULL;
+        }
+    }
+}
+
+void compressedstream_close(CompressedStream* stream) {
+    MAGIC_ASSERT(stream);
+    Compressor* compressor = stream->compressor;
+
+    if(stream->pending) {
+        _compressor_pushFrame(compressor, stream, stream->pending);
+        stream->pending = NULL;
+    }
+
+    /* the compressor thread frees the stream once its frames are written */
+    _compressor_pushJob(compressor, CJ_CLOSE, stream, NULL, NULL);
+}
+
+static ssize_t _compressor_writeCookie(void* cookie, const char* buffer, size_t size) {
+    compressedstream_write((CompressedStream*) cookie, buffer, size);
+    return (ssize_t) size;
+}
+
+static int _compressor_closeCookie(void* cookie) {
+    compressedstream_close((CompressedStream*) cookie);
+    return 0;
+}
+
+FILE* compressor_fopen(Compressor* compressor, const gchar* path) {
+    MAGIC_ASSERT(compressor);
+
+    gint fd = g_open(path, O_WRONLY|O_CREAT|O_APPEND|O_CLOEXEC, 0644);
+    if(fd < 0) {
+        return NULL;
+    }
+
+    /* these are written by the workers, which must never wait on us */
+    CompressedStream* stream = compressor_openStream(compressor, fd, TRUE, COMPRESSOR_FILE_FRAME_SIZE, FALSE);
+
+    cookie_io_functions_t functions = {
+        .read = NULL,
+        .write = _compressor_writeCookie,
+        .seek = NULL,
+        .close = _compressor_closeCookie,
+    };
+
+    FILE* f = fopencookie(stream, "a", functions);
+    if(!f) {
+        gint error = errno;
+        compressedstream_close(stream);
+        errno = error;
+        return NULL;
+    }
+
+    /* the stream already collects whole frames, so don't copy twice */
+    setvbuf(f, NULL, _IONBF, 0);
+
+    return f;
+}
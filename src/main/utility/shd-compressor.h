@@ -0,0 +1,58 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_COMPRESSOR_H_
+#define SHD_COMPRESSOR_H_
+
+/**
+ * Compresses output streams on a dedicated thread.
+ *
+ * A stream collects whatever is written to it until it holds a full frame of
+ * uncompressed data, and then hands the frame to the compressor thread. That
+ * thread compresses each frame independently with zstd and writes it to the
+ * file descriptor of its stream, so writers never wait for the codec or for
+ * the disk. When a stream is closed, its last frame is written followed by a
+ * seek table in the zstd seekable format, so readers can jump to any frame
+ * without decompressing the ones before it. Any zstd decoder can read the
+ * output as it is, including files holding several closed streams.
+ *
+ * Compression is only supported when shadow was built with zstd.
+ */
+
+typedef struct _Compressor Compressor;
+typedef struct _CompressedStream CompressedStream;
+
+/* uncompressed bytes in each frame of the main log */
+#define COMPRESSOR_LOG_FRAME_SIZE (1024*1024)
+/* uncompressed bytes in each frame of virtual process output files, of
+ * which there are many but they are written slowly */
+#define COMPRESSOR_FILE_FRAME_SIZE (64*1024)
+/* uncompressed bytes queued for the compressor thread at which writers of
+ * blocking streams wait for it to catch up */
+#define COMPRESSOR_MAX_QUEUED_BYTES (64*1024*1024)
+
+gboolean compressor_isSupported();
+const gchar* compressor_getFileSuffix();
+
+Compressor* compressor_new(gint level);
+void compressor_free(Compressor* compressor);
+
+void compressor_setDefault(Compressor* compressor);
+Compressor* compressor_getDefault();
+
+/* block until everything handed to the compressor is written */
+void compressor_sync(Compressor* compressor);
+
+/* if mayBlock, writes to the stream wait while the compressor is behind */
+CompressedStream* compressor_openStream(Compressor* compressor, gint fd,
+        gboolean closeWhenDone, gsize frameSize, gboolean mayBlock);
+/* open a stdio stream writing compressed frames to the end of the file at
+ * path. writes to it never block. */
+FILE* compressor_fopen(Compressor* compressor, const gchar* path);
+
+void compressedstream_write(CompressedStream* stream, gconstpointer data, gsize length);
+void compressedstream_close(CompressedStream* stream);
+
+#endif /* SHD_COMPRESSOR_H_ */
@@ -0,0 +1,82 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "shadow.h"
+
+gsize iovec_getLength(const struct iovec* iov, gint iovcnt) {
+    gsize total = 0;
+    for(gint i = 0; i < iovcnt; i++) {
+        total += iov[i].iov_len;
+    }
+    return total;
+}
+
+void iovcursor_init(IOVecCursor* cursor, const struct iovec* iov, gint iovcnt) {
+    utility_assert(cursor);
+    utility_assert(iov || iovcnt == 0);
+    cursor->iov = iov;
+    cursor->iovcnt = iovcnt;
+    cursor->index = 0;
+    cursor->offset = 0;
+}
+
+gsize iovcursor_getRemaining(IOVecCursor* cursor) {
+    utility_assert(cursor);
+    if(cursor->index >= cursor->iovcnt) {
+        return 0;
+    }
+    return iovec_getLength(&cursor->iov[cursor->index], cursor->iovcnt - cursor->index) - cursor->offset;
+}
+
+/* walk the cursor forward over at most nBytes. a negative direction gathers
+ * from the iovecs into buffer, a positive one scatters buffer into the iovecs,
+ * and zero only skips. returns the number of bytes walked over. */
+static gsize _iovcursor_walk(IOVecCursor* cursor, guchar* buffer, gsize nBytes, gint direction) {
+    utility_assert(cursor);
+    gsize walked = 0;
+
+    while(walked < nBytes && cursor->index < cursor->iovcnt) {
+        const struct iovec* vec = &cursor->iov[cursor->index];
+        gsize available = vec->iov_len - cursor->offset;
+        gsize length = MIN(available, nBytes - walked);
+
+        if(length > 0) {
+            guchar* base = ((guchar*)vec->iov_base) + cursor->offset;
+            if(direction < 0 && buffer) {
+                memcpy(buffer + walked, base, length);
+            } else if(direction > 0) {
+                if(buffer) {
+                    memcpy(base, buffer + walked, length);
+                } else {
+                    memset(base, 0, length);
+                }
+            }
+            walked += length;
+            cursor->offset += length;
+        }
+
+        if(cursor->offset >= vec->iov_len) {
+            cursor->index++;
+            cursor->offset = 0;
+        }
+    }
+
+    return walked;
+}
+
+gsize iovcursor_skip(IOVecCursor* cursor, gsize nBytes) {
+    return _iovcursor_walk(cursor, NULL, nBytes, 0);
+}
+
+/* copy nBytes out of the iovecs into outBuffer */
+gsize iovcursor_gather(IOVecCursor* cursor, gpointer outBuffer, gsize nBytes) {
+    return _iovcursor_walk(cursor, (guchar*)outBuffer, nBytes, -1);
+}
+
+/* copy nBytes from inBuffer into the iovecs. a NULL inBuffer writes zeros,
+ * which is what the plug-in sees when reading synthetic payloads. */
+gsize iovcursor_scatter(IOVecCursor* cursor, gconstpointer inBuffer, gsize nBytes) {
+    return _iovcursor_walk(cursor, (guchar*)inBuffer, nBytes, 1);
+}
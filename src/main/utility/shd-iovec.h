@@ -0,0 +1,36 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_IOVEC_H_
+#define SHD_IOVEC_H_
+
+#include <glib.h>
+#include <sys/uio.h>
+
+/**
+ * A read/write position inside of a caller-owned iovec array. The cursor lets
+ * the transport layer copy data directly between the plug-in's scattered
+ * buffers and packet payloads without first gathering them into a temporary
+ * contiguous buffer. Cursors are small and meant to live on the stack.
+ */
+
+typedef struct _IOVecCursor IOVecCursor;
+struct _IOVecCursor {
+    const struct iovec* iov;
+    gint iovcnt;
+    /* the iovec we are currently in, and our offset into it */
+    gint index;
+    gsize offset;
+};
+
+gsize iovec_getLength(const struct iovec* iov, gint iovcnt);
+
+void iovcursor_init(IOVecCursor* cursor, const struct iovec* iov, gint iovcnt);
+gsize iovcursor_getRemaining(IOVecCursor* cursor);
+gsize iovcursor_skip(IOVecCursor* cursor, gsize nBytes);
+gsize iovcursor_gather(IOVecCursor* cursor, gpointer outBuffer, gsize nBytes);
+gsize iovcursor_scatter(IOVecCursor* cursor, gconstpointer inBuffer, gsize nBytes);
+
+#endif /* SHD_IOVEC_H_ */
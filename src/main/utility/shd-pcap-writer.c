@@ -53,7 +53,8 @@ void pcapwriter_writePacket(PCapWriter* pcap, PCapPacket* packet) {
     /* get the header and payload lengths */
     guint headerSize = packet->headerSize;
     guint payloadLength = packet->payloadLength;
-    incl_len = headerSize + payloadLength;
+    /* packets without payload bytes are stored as if truncated by the snaplen */
+    incl_len = headerSize + (packet->payload ? payloadLength : 0);
     orig_len = headerSize + payloadLength;
 
     /* write the PCAP packet header to the pcap file */
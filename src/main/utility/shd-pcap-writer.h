@@ -41,7 +41,8 @@ struct _PCapPacket {
     guint32 win;
     guint headerSize;
     guint payloadLength;
-    gpointer payload;
+    /* if NULL, only the headers are captured */
+    gconstpointer payload;
 };
 
 PCapWriter* pcapwriter_new(gchar* pcapDirectory, gchar* pcapFilename);
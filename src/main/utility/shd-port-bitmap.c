@@ -0,0 +1,167 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "shadow.h"
+
+/* 65536 ports / 64 bits per word */
+#define PORTBITMAP_NUM_WORDS 1024
+/* words are allocated in chunks of 64 words (4096 ports) */
+#define PORTBITMAP_CHUNK_WORDS 64
+#define PORTBITMAP_NUM_CHUNKS (PORTBITMAP_NUM_WORDS / PORTBITMAP_CHUNK_WORDS)
+
+struct _PortBitmap {
+    /* bit i of fullWords[s] is set when word (s*64)+i is completely used */
+    guint64 fullWords[PORTBITMAP_NUM_WORDS / 64];
+    /* a chunk is NULL until one of its ports is set */
+    guint64* chunks[PORTBITMAP_NUM_CHUNKS];
+    guint count;
+    MAGIC_DECLARE;
+};
+
+PortBitmap* portbitmap_new() {
+    PortBitmap* bitmap = g_new0(PortBitmap, 1);
+    MAGIC_INIT(bitmap);
+    return bitmap;
+}
+
+void portbitmap_free(PortBitmap* bitmap) {
+    MAGIC_ASSERT(bitmap);
+
+    for(guint i = 0; i < PORTBITMAP_NUM_CHUNKS; i++) {
+        if(bitmap->chunks[i]) {
+            g_free(bitmap->chunks[i]);
+        }
+    }
+
+    MAGIC_CLEAR(bitmap);
+    g_free(bitmap);
+}
+
+static inline guint64 _portbitmap_getWord(PortBitmap* bitmap, guint wordIndex) {
+    guint64* chunk = bitmap->chunks[wordIndex / PORTBITMAP_CHUNK_WORDS];
+    return chunk ? chunk[wordIndex % PORTBITMAP_CHUNK_WORDS] : 0;
+}
+
+void portbitmap_set(PortBitmap* bitmap, guint16 port) {
+    MAGIC_ASSERT(bitmap);
+
+    guint wordIndex = port / 64;
+    guint64 bit = ((guint64)1) << (port % 64);
+
+    guint64** chunk = &bitmap->chunks[wordIndex / PORTBITMAP_CHUNK_WORDS];
+    if(*chunk == NULL) {
+        *chunk = g_new0(guint64, PORTBITMAP_CHUNK_WORDS);
+    }
+
+    guint64* word = &(*chunk)[wordIndex % PORTBITMAP_CHUNK_WORDS];
+    if(!(*word & bit)) {
+        *word |= bit;
+        bitmap->count++;
+        if(*word == G_MAXUINT64) {
+            bitmap->fullWords[wordIndex / 64] |= ((guint64)1) << (wordIndex % 64);
+        }
+    }
+}
+
+void portbitmap_clear(PortBitmap* bitmap, guint16 port) {
+    MAGIC_ASSERT(bitmap);
+
+    guint wordIndex = port / 64;
+    guint64 bit = ((guint64)1) << (port % 64);
+
+    guint64* chunk = bitmap->chunks[wordIndex / PORTBITMAP_CHUNK_WORDS];
+    if(chunk == NULL) {
+        return;
+    }
+
+    guint64* word = &chunk[wordIndex % PORTBITMAP_CHUNK_WORDS];
+    if(*word & bit) {
+        *word &= ~bit;
+        bitmap->count--;
+        bitmap->fullWords[wordIndex / 64] &= ~(((guint64)1) << (wordIndex % 64));
+    }
+}
+
+gboolean portbitmap_isSet(PortBitmap* bitmap, guint16 port) {
+    MAGIC_ASSERT(bitmap);
+    return (_portbitmap_getWord(bitmap, port / 64) & (((guint64)1) << (port % 64))) ? TRUE : FALSE;
+}
+
+guint portbitmap_getCount(PortBitmap* bitmap) {
+    MAGIC_ASSERT(bitmap);
+    return bitmap->count;
+}
+
+/* returns a mask of the bits in a word at or above lowBit and at or below highBit */
+static inline guint64 _portbitmap_rangeMask(guint lowBit, guint highBit) {
+    guint64 low = G_MAXUINT64 << lowBit;
+    guint64 high = (highBit >= 63) ? G_MAXUINT64 : ((((guint64)1) << (highBit + 1)) - 1);
+    return low & high;
+}
+
+static guint16 _portbitmap_findUnsetInRange(PortBitmap** bitmaps, guint numBitmaps,
+        guint lowPort, guint highPort) {
+    if(lowPort > highPort) {
+        return 0;
+    }
+
+    guint firstWord = lowPort / 64;
+    guint lastWord = highPort / 64;
+    guint wordIndex = firstWord;
+
+    while(wordIndex <= lastWord) {
+        /* a word can only have a free port if it is not full in any bitmap */
+        guint summaryIndex = wordIndex / 64;
+        guint64 fullMask = 0;
+        for(guint i = 0; i < numBitmaps; i++) {
+            if(bitmaps[i]) {
+                fullMask |= bitmaps[i]->fullWords[summaryIndex];
+            }
+        }
+
+        guint summaryLast = MIN(lastWord, (summaryIndex * 64) + 63);
+        guint64 candidates = ~fullMask & _portbitmap_rangeMask(wordIndex % 64, summaryLast % 64);
+
+        while(candidates) {
+            guint candidate = (summaryIndex * 64) + (guint)__builtin_ctzll(candidates);
+
+            /* a port is only free if it is free in all of the bitmaps */
+            guint64 used = 0;
+            for(guint i = 0; i < numBitmaps; i++) {
+                if(bitmaps[i]) {
+                    used |= _portbitmap_getWord(bitmaps[i], candidate);
+                }
+            }
+
+            guint64 free = ~used & _portbitmap_rangeMask(
+                    candidate == firstWord ? lowPort % 64 : 0,
+                    candidate == lastWord ? highPort % 64 : 63);
+            if(free) {
+                return (guint16)((candidate * 64) + (guint)__builtin_ctzll(free));
+            }
+
+            /* drop the lowest candidate */
+            candidates &= candidates - 1;
+        }
+
+        wordIndex = summaryLast + 1;
+    }
+
+    return 0;
+}
+
+guint16 portbitmap_findUnset(PortBitmap** bitmaps, guint numBitmaps,
+        guint16 minPort, guint16 maxPort, guint16 startPort) {
+    utility_assert(minPort > 0 && minPort <= maxPort);
+
+    startPort = CLAMP(startPort, minPort, maxPort);
+
+    guint16 port = _portbitmap_findUnsetInRange(bitmaps, numBitmaps, startPort, maxPort);
+    if(!port && startPort > minPort) {
+        port = _portbitmap_findUnsetInRange(bitmaps, numBitmaps, minPort, startPort - 1);
+    }
+
+    return port;
+}
@@ -0,0 +1,36 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_PORT_BITMAP_H_
+#define SHD_PORT_BITMAP_H_
+
+#include <glib.h>
+
+/**
+ * A set of 16 bit port numbers (in host byte order) stored as a 64k-bit
+ * occupancy bitmap. The bitmap is split into chunks that are only allocated
+ * once a port inside them is used, and a summary of which 64-bit words are
+ * completely full lets searches skip over busy regions a word at a time. This
+ * keeps finding a free port bounded by the size of the port space rather than
+ * by the number of ports in use.
+ */
+
+typedef struct _PortBitmap PortBitmap;
+
+PortBitmap* portbitmap_new();
+void portbitmap_free(PortBitmap* bitmap);
+
+void portbitmap_set(PortBitmap* bitmap, guint16 port);
+void portbitmap_clear(PortBitmap* bitmap, guint16 port);
+gboolean portbitmap_isSet(PortBitmap* bitmap, guint16 port);
+guint portbitmap_getCount(PortBitmap* bitmap);
+
+/* returns the first port in [minPort, maxPort] at or after startPort, wrapping
+ * around to minPort, that is unset in every one of the bitmaps (NULL bitmaps
+ * are treated as empty). returns 0 if every port in the range is taken. */
+guint16 portbitmap_findUnset(PortBitmap** bitmaps, guint numBitmaps,
+        guint16 minPort, guint16 maxPort, guint16 startPort);
+
+#endif /* SHD_PORT_BITMAP_H_ */
@@ -6,55 +6,340 @@
 
 #include <glib.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 #include "shd-utility.h"
 #include "shd-random.h"
 
+/* we use the ChaCha stream cipher with 8 rounds as a counter-based generator.
+ * block n of a stream only depends on the key, stream id, and n, so the
+ * vectorized kernels below can compute several blocks at once and still
+ * produce exactly the same bytes as the scalar code. */
+#define RANDOM_CHACHA_DOUBLE_ROUNDS 4
+#define RANDOM_BLOCK_SIZE 64
+/* keystream we generate ahead for small requests like random_nextUInt */
+#define RANDOM_BUFFER_BLOCKS 8
+#define RANDOM_BUFFER_SIZE (RANDOM_BUFFER_BLOCKS * RANDOM_BLOCK_SIZE)
+
 struct _Random {
-    guint seedState;
+    /* chacha input: constants, 256 bit key, 64 bit block counter, 64 bit stream id */
+    guint32 state[16];
+    /* keystream that was generated but not yet handed out */
+    guchar buffer[RANDOM_BUFFER_SIZE];
+    gsize bufferOffset;
     guint initialSeed;
 };
 
-Random* random_new(guint seed) {
+/* splitmix64, only used to spread the seed over the key */
+static guint64 _random_mixSeed(guint64* x) {
+    guint64 z = (*x += G_GUINT64_CONSTANT(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * G_GUINT64_CONSTANT(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * G_GUINT64_CONSTANT(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+Random* random_newStream(guint seed, guint64 stream) {
     Random* random = g_new0(Random, 1);
     random->initialSeed = seed;
-    random->seedState = seed;
+
+    /* "expand 32-byte k" */
+    random->state[0] = 0x61707865;
+    random->state[1] = 0x3320646e;
+    random->state[2] = 0x79622d32;
+    random->state[3] = 0x6b206574;
+
+    guint64 x = (guint64)seed;
+    for(gint i = 4; i < 12; i += 2) {
+        guint64 k = _random_mixSeed(&x);
+        random->state[i] = (guint32)k;
+        random->state[i+1] = (guint32)(k >> 32);
+    }
+
+    random->state[12] = 0;
+    random->state[13] = 0;
+    random->state[14] = (guint32)stream;
+    random->state[15] = (guint32)(stream >> 32);
+
+    /* the buffer starts out empty */
+    random->bufferOffset = RANDOM_BUFFER_SIZE;
+
     return random;
 }
 
+Random* random_new(guint seed) {
+    return random_newStream(seed, 0);
+}
+
 void random_free(Random* random) {
     utility_assert(random);
     g_free(random);
 }
 
-gint random_rand(Random* random) {
-    utility_assert(random);
-    /* returns 0 to RAND_MAX, which is only 31 bits */
-    gint randomValue = rand_r(&(random->seedState));
-    return randomValue;
+static inline guint64 _random_getCounter(const guint32* state) {
+    return ((guint64)state[12]) | (((guint64)state[13]) << 32);
 }
 
-gdouble random_nextDouble(Random* random) {
-    utility_assert(random);
-    gint randomValue = random_rand(random);
-    return (gdouble)(((gdouble)randomValue) / ((gdouble)RAND_MAX));
+static inline void _random_setCounter(guint32* state, guint64 counter) {
+    state[12] = (guint32)counter;
+    state[13] = (guint32)(counter >> 32);
 }
 
-guint random_nextUInt(Random* random) {
-    utility_assert(random);
-    gdouble randomFraction = random_nextDouble(random);
-    gdouble maxUint = (gdouble)UINT_MAX;
-    uint randomUint = (uint)(randomFraction * maxUint);
-    return (guint)randomUint;
+#define RANDOM_ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define RANDOM_QUARTERROUND(x, a, b, c, d) \
+    x[a] += x[b]; x[d] ^= x[a]; x[d] = RANDOM_ROTL32(x[d], 16); \
+    x[c] += x[d]; x[b] ^= x[c]; x[b] = RANDOM_ROTL32(x[b], 12); \
+    x[a] += x[b]; x[d] ^= x[a]; x[d] = RANDOM_ROTL32(x[d], 8); \
+    x[c] += x[d]; x[b] ^= x[c]; x[b] = RANDOM_ROTL32(x[b], 7);
+
+static void _random_generateScalar(const guint32* state, guint64 counter, guchar* out, gsize nBlocks) {
+    for(gsize n = 0; n < nBlocks; n++) {
+        guint32 input[16], x[16];
+        memcpy(input, state, sizeof(input));
+        _random_setCounter(input, counter + n);
+        memcpy(x, input, sizeof(x));
+
+        for(gint i = 0; i < RANDOM_CHACHA_DOUBLE_ROUNDS; i++) {
+            RANDOM_QUARTERROUND(x, 0, 4, 8, 12);
+            RANDOM_QUARTERROUND(x, 1, 5, 9, 13);
+            RANDOM_QUARTERROUND(x, 2, 6, 10, 14);
+            RANDOM_QUARTERROUND(x, 3, 7, 11, 15);
+            RANDOM_QUARTERROUND(x, 0, 5, 10, 15);
+            RANDOM_QUARTERROUND(x, 1, 6, 11, 12);
+            RANDOM_QUARTERROUND(x, 2, 7, 8, 13);
+            RANDOM_QUARTERROUND(x, 3, 4, 9, 14);
+        }
+
+        for(gint i = 0; i < 16; i++) {
+            guint32 word = GUINT32_TO_LE(x[i] + input[i]);
+            memcpy(&out[(n * RANDOM_BLOCK_SIZE) + (i * 4)], &word, 4);
+        }
+    }
+}
+
+#if defined(__x86_64__)
+
+/* the vector kernels keep word i of several consecutive blocks in the lanes
+ * of vector i, and transpose back into block order when storing */
+
+#define RANDOM_SSE_ROTL32(v, n) _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - (n)))
+
+#define RANDOM_SSE_QUARTERROUND(x, a, b, c, d) \
+    x[a] = _mm_add_epi32(x[a], x[b]); x[d] = RANDOM_SSE_ROTL32(_mm_xor_si128(x[d], x[a]), 16); \
+    x[c] = _mm_add_epi32(x[c], x[d]); x[b] = RANDOM_SSE_ROTL32(_mm_xor_si128(x[b], x[c]), 12); \
+    x[a] = _mm_add_epi32(x[a], x[b]); x[d] = RANDOM_SSE_ROTL32(_mm_xor_si128(x[d], x[a]), 8); \
+    x[c] = _mm_add_epi32(x[c], x[d]); x[b] = RANDOM_SSE_ROTL32(_mm_xor_si128(x[b], x[c]), 7);
+
+/* computes 4 blocks at a time; sse2 is part of the x86_64 baseline */
+static void _random_generateSSE2(const guint32* state, guint64 counter, guchar* out, gsize nBlocks) {
+    for(gsize n = 0; n + 4 <= nBlocks; n += 4) {
+        __m128i input[16], x[16];
+
+        for(gint i = 0; i < 16; i++) {
+            input[i] = _mm_set1_epi32((gint)state[i]);
+        }
+        guint32 low[4], high[4];
+        for(gint lane = 0; lane < 4; lane++) {
+            guint64 c = counter + n + lane;
+            low[lane] = (guint32)c;
+            high[lane] = (guint32)(c >> 32);
+        }
+        input[12] = _mm_loadu_si128((const __m128i*)low);
+        input[13] = _mm_loadu_si128((const __m128i*)high);
+        memcpy(x, input, sizeof(x));
+
+        for(gint i = 0; i < RANDOM_CHACHA_DOUBLE_ROUNDS; i++) {
+            RANDOM_SSE_QUARTERROUND(x, 0, 4, 8, 12);
+            RANDOM_SSE_QUARTERROUND(x, 1, 5, 9, 13);
+            RANDOM_SSE_QUARTERROUND(x, 2, 6, 10, 14);
+            RANDOM_SSE_QUARTERROUND(x, 3, 7, 11, 15);
+            RANDOM_SSE_QUARTERROUND(x, 0, 5, 10, 15);
+            RANDOM_SSE_QUARTERROUND(x, 1, 6, 11, 12);
+            RANDOM_SSE_QUARTERROUND(x, 2, 7, 8, 13);
+            RANDOM_SSE_QUARTERROUND(x, 3, 4, 9, 14);
+        }
+
+        guchar* blockOut = &out[n * RANDOM_BLOCK_SIZE];
+        for(gint g = 0; g < 16; g += 4) {
+            __m128i a = _mm_add_epi32(x[g], input[g]);
+            __m128i b = _mm_add_epi32(x[g+1], input[g+1]);
+            __m128i c = _mm_add_epi32(x[g+2], input[g+2]);
+            __m128i d = _mm_add_epi32(x[g+3], input[g+3]);
+
+            __m128i ab0 = _mm_unpacklo_epi32(a, b);
+            __m128i ab1 = _mm_unpackhi_epi32(a, b);
+            __m128i cd0 = _mm_unpacklo_epi32(c, d);
+            __m128i cd1 = _mm_unpackhi_epi32(c, d);
+
+            _mm_storeu_si128((__m128i*)&blockOut[(0 * RANDOM_BLOCK_SIZE) + (g * 4)], _mm_unpacklo_epi64(ab0, cd0));
+            _mm_storeu_si128((__m128i*)&blockOut[(1 * RANDOM_BLOCK_SIZE) + (g * 4)], _mm_unpackhi_epi64(ab0, cd0));
+            _mm_storeu_si128((__m128i*)&blockOut[(2 * RANDOM_BLOCK_SIZE) + (g * 4)], _mm_unpacklo_epi64(ab1, cd1));
+            _mm_storeu_si128((__m128i*)&blockOut[(3 * RANDOM_BLOCK_SIZE) + (g * 4)], _mm_unpackhi_epi64(ab1, cd1));
+        }
+    }
+}
+
+#define RANDOM_AVX2_ROTL32(v, n) _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - (n)))
+
+#define RANDOM_AVX2_QUARTERROUND(x, a, b, c, d) \
+    x[a] = _mm256_add_epi32(x[a], x[b]); x[d] = RANDOM_AVX2_ROTL32(_mm256_xor_si256(x[d], x[a]), 16); \
+    x[c] = _mm256_add_epi32(x[c], x[d]); x[b] = RANDOM_AVX2_ROTL32(_mm256_xor_si256(x[b], x[c]), 12); \
+    x[a] = _mm256_add_epi32(x[a], x[b]); x[d] = RANDOM_AVX2_ROTL32(_mm256_xor_si256(x[d], x[a]), 8); \
+    x[c] = _mm256_add_epi32(x[c], x[d]); x[b] = RANDOM_AVX2_ROTL32(_mm256_xor_si256(x[b], x[c]), 7);
+
+/* computes 8 blocks at a time, only called if the cpu supports avx2 */
+__attribute__((target("avx2")))
+static void _random_generateAVX2(const guint32* state, guint64 counter, guchar* out, gsize nBlocks) {
+    for(gsize n = 0; n + 8 <= nBlocks; n += 8) {
+        __m256i input[16], x[16];
+
+        for(gint i = 0; i < 16; i++) {
+            input[i] = _mm256_set1_epi32((gint)state[i]);
+        }
+        guint32 low[8], high[8];
+        for(gint lane = 0; lane < 8; lane++) {
+            guint64 c = counter + n + lane;
+            low[lane] = (guint32)c;
+            high[lane] = (guint32)(c >> 32);
+        }
+        input[12] = _mm256_loadu_si256((const __m256i*)low);
+        input[13] = _mm256_loadu_si256((const __m256i*)high);
+        memcpy(x, input, sizeof(x));
+
+        for(gint i = 0; i < RANDOM_CHACHA_DOUBLE_ROUNDS; i++) {
+            RANDOM_AVX2_QUARTERROUND(x, 0, 4, 8, 12);
+            RANDOM_AVX2_QUARTERROUND(x, 1, 5, 9, 13);
+            RANDOM_AVX2_QUARTERROUND(x, 2, 6, 10, 14);
+            RANDOM_AVX2_QUARTERROUND(x, 3, 7, 11, 15);
+            RANDOM_AVX2_QUARTERROUND(x, 0, 5, 10, 15);
+            RANDOM_AVX2_QUARTERROUND(x, 1, 6, 11, 12);
+            RANDOM_AVX2_QUARTERROUND(x, 2, 7, 8, 13);
+            RANDOM_AVX2_QUARTERROUND(x, 3, 4, 9, 14);
+        }
+
+        /* the unpacks work within 128 bit halves, so the low half of each
+         * result belongs to blocks 0-3 and the high half to blocks 4-7 */
+        guchar* blockOut = &out[n * RANDOM_BLOCK_SIZE];
+        for(gint g = 0; g < 16; g += 4) {
+            __m256i a = _mm256_add_epi32(x[g], input[g]);
+            __m256i b = _mm256_add_epi32(x[g+1], input[g+1]);
+            __m256i c = _mm256_add_epi32(x[g+2], input[g+2]);
+            __m256i d = _mm256_add_epi32(x[g+3], input[g+3]);
+
+            __m256i ab0 = _mm256_unpacklo_epi32(a, b);
+            __m256i ab1 = _mm256_unpackhi_epi32(a, b);
+            __m256i cd0 = _mm256_unpacklo_epi32(c, d);
+            __m256i cd1 = _mm256_unpackhi_epi32(c, d);
+
+            __m256i t[4];
+            t[0] = _mm256_unpacklo_epi64(ab0, cd0);
+            t[1] = _mm256_unpackhi_epi64(ab0, cd0);
+            t[2] = _mm256_unpacklo_epi64(ab1, cd1);
+            t[3] = _mm256_unpackhi_epi64(ab1, cd1);
+
+            for(gint j = 0; j < 4; j++) {
+                _mm_storeu_si128((__m128i*)&blockOut[(j * RANDOM_BLOCK_SIZE) + (g * 4)],
+                        _mm256_castsi256_si128(t[j]));
+                _mm_storeu_si128((__m128i*)&blockOut[((j + 4) * RANDOM_BLOCK_SIZE) + (g * 4)],
+                        _mm256_extracti128_si256(t[j], 1));
+            }
+        }
+    }
+}
+
+static gboolean _random_haveAVX2() {
+    /* 0 is unknown, racing threads all come to the same answer */
+    static volatile gint haveAVX2 = 0;
+    if(haveAVX2 == 0) {
+        __builtin_cpu_init();
+        haveAVX2 = __builtin_cpu_supports("avx2") ? 1 : -1;
+    }
+    return haveAVX2 > 0 ? TRUE : FALSE;
+}
+
+#endif /* defined(__x86_64__) */
+
+/* writes the next nBlocks blocks of keystream to out and advances the counter */
+static void _random_generate(Random* random, guchar* out, gsize nBlocks) {
+    guint64 counter = _random_getCounter(random->state);
+    gsize done = 0;
+
+#if defined(__x86_64__)
+    if(nBlocks - done >= 8 && _random_haveAVX2()) {
+        gsize n = (nBlocks - done) & ~((gsize)7);
+        _random_generateAVX2(random->state, counter + done, &out[done * RANDOM_BLOCK_SIZE], n);
+        done += n;
+    }
+    if(nBlocks - done >= 4) {
+        gsize n = (nBlocks - done) & ~((gsize)3);
+        _random_generateSSE2(random->state, counter + done, &out[done * RANDOM_BLOCK_SIZE], n);
+        done += n;
+    }
+#endif
+
+    if(nBlocks - done > 0) {
+        _random_generateScalar(random->state, counter + done, &out[done * RANDOM_BLOCK_SIZE], nBlocks - done);
+    }
+
+    _random_setCounter(random->state, counter + nBlocks);
 }
 
 void random_nextNBytes(Random* random, guchar* buffer, gsize nbytes) {
     utility_assert(random);
     gsize offset = 0;
+
     while(offset < nbytes) {
-        guint randUInt = random_nextUInt(random);
-        gsize n = MIN((nbytes - offset), sizeof(guint));
-        memmove(&buffer[offset], &randUInt, n);
-        offset += n;
+        gsize remaining = nbytes - offset;
+
+        if(random->bufferOffset < RANDOM_BUFFER_SIZE) {
+            /* use up what we generated before, to keep the stream in order */
+            gsize n = MIN(remaining, RANDOM_BUFFER_SIZE - random->bufferOffset);
+            memcpy(&buffer[offset], &random->buffer[random->bufferOffset], n);
+            random->bufferOffset += n;
+            offset += n;
+        } else if(remaining >= RANDOM_BLOCK_SIZE) {
+            /* bulk requests get whole blocks written straight to the caller */
+            gsize nBlocks = remaining / RANDOM_BLOCK_SIZE;
+            _random_generate(random, &buffer[offset], nBlocks);
+            offset += nBlocks * RANDOM_BLOCK_SIZE;
+        } else {
+            _random_generate(random, random->buffer, RANDOM_BUFFER_BLOCKS);
+            random->bufferOffset = 0;
+        }
+    }
+}
+
+static inline guint32 _random_next32(Random* random) {
+    guint32 value;
+    if(RANDOM_BUFFER_SIZE - random->bufferOffset >= sizeof(guint32)) {
+        memcpy(&value, &random->buffer[random->bufferOffset], sizeof(guint32));
+        random->bufferOffset += sizeof(guint32);
+    } else {
+        random_nextNBytes(random, (guchar*)&value, sizeof(guint32));
     }
+    return GUINT32_FROM_LE(value);
+}
+
+gint random_rand(Random* random) {
+    utility_assert(random);
+    /* returns 0 to RAND_MAX, which is only 31 bits */
+    return (gint)(_random_next32(random) % (((guint)RAND_MAX) + 1));
+}
+
+gdouble random_nextDouble(Random* random) {
+    utility_assert(random);
+    /* use 53 random bits, the full precision of a double */
+    guint64 high = (guint64)_random_next32(random);
+    guint64 low = (guint64)_random_next32(random);
+    guint64 bits = ((high << 32) | low) >> 11;
+    return ((gdouble)bits) / ((gdouble)(G_GUINT64_CONSTANT(1) << 53));
+}
+
+guint random_nextUInt(Random* random) {
+    utility_assert(random);
+    return (guint)_random_next32(random);
 }
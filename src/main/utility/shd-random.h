@@ -8,17 +8,30 @@
 #define SHD_RANDOM_H_
 
 /**
- * An opaque structure representing a random source.
+ * An opaque structure representing a random source. Sources generate a ChaCha8
+ * keystream, so the sequence of values only depends on the seed and stream id
+ * and not on the machine, the cpu features we use to compute it, or how the
+ * requests for random values were split up.
  */
 typedef struct _Random Random;
 
 /**
- * Create a new thread-safe random source using seed as the initial state.
+ * Create a new random source using seed as the initial state. The source
+ * is not thread-safe.
  * @param seed
  * @return a pointer to the new random source
  */
 Random* random_new(guint seed);
 
+/**
+ * Create a new random source that generates stream number stream of seed.
+ * Different streams of the same seed are independent of each other.
+ * @param seed
+ * @param stream the stream id
+ * @return a pointer to the new random source
+ */
+Random* random_newStream(guint seed, guint64 stream);
+
 /**
  * Frees the memory allocated for the random source.
  * @param random the random source
@@ -33,16 +46,18 @@ void random_free(Random* random);
 gint random_rand(Random* random);
 
 /**
- * Gets the next double in the range [0,1] from the random source.
+ * Gets the next double in the range [0,1) from the random source.
  * @param random the random source
- * @return the next double in the range [0,1]
+ * @return the next double in the range [0,1)
  */
 gdouble random_nextDouble(Random* random);
 
 guint random_nextUInt(Random* random);
 
 /**
- * Gets the next nbytes in the range [0, RAND_MAX] from the random source.
+ * Gets the next nbytes random bytes from the random source. Large requests are
+ * filled several keystream blocks at a time using the widest vector unit the
+ * cpu supports.
  * @param random the random source
  * @param buffer the buffer to copy the random bytes to
  * @param nbytes number of bytes to copy to the buffer
@@ -0,0 +1,195 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <glib.h>
+
+#include "shd-utility.h"
+#include "shd-sequence-ring.h"
+
+static const guint INITIAL_CAPACITY = 64;
+
+struct _SequenceRing {
+    /* the slots, indexed by (sequence & (capacity-1)) */
+    gpointer* slots;
+    /* always a power of two, and no more than needed for maxSpan */
+    guint capacity;
+    /* high - low never exceeds this */
+    guint maxSpan;
+    /* all stored sequences are in the window [low, high) */
+    guint low;
+    guint high;
+    /* number of non-NULL slots */
+    guint length;
+    GDestroyNotify valueDestroyFunc;
+};
+
+SequenceRing* sequencering_new(guint maxSpan, GDestroyNotify valueDestroyFunc) {
+    utility_assert(maxSpan > 0);
+
+    SequenceRing* ring = g_new0(SequenceRing, 1);
+    ring->capacity = INITIAL_CAPACITY;
+    ring->maxSpan = maxSpan;
+    ring->slots = g_new0(gpointer, ring->capacity);
+    ring->valueDestroyFunc = valueDestroyFunc;
+    return ring;
+}
+
+static inline gpointer* _sequencering_getSlot(SequenceRing* ring, guint sequence) {
+    return &(ring->slots[sequence & (ring->capacity - 1)]);
+}
+
+/* shrink the window so that its first and last slots are occupied */
+static void _sequencering_trim(SequenceRing* ring) {
+    if(ring->length == 0) {
+        ring->high = ring->low;
+        return;
+    }
+    while(*_sequencering_getSlot(ring, ring->low) == NULL) {
+        ring->low++;
+    }
+    while(*_sequencering_getSlot(ring, ring->high - 1) == NULL) {
+        ring->high--;
+    }
+}
+
+static void _sequencering_grow(SequenceRing* ring, guint span) {
+    utility_assert(span <= ring->maxSpan);
+
+    guint newCapacity = ring->capacity;
+    while(newCapacity < span) {
+        newCapacity *= 2;
+    }
+    if(newCapacity == ring->capacity) {
+        return;
+    }
+
+    gpointer* newSlots = g_new0(gpointer, newCapacity);
+    for(guint sequence = ring->low; sequence != ring->high; sequence++) {
+        newSlots[sequence & (newCapacity - 1)] = *_sequencering_getSlot(ring, sequence);
+    }
+
+    g_free(ring->slots);
+    ring->slots = newSlots;
+    ring->capacity = newCapacity;
+}
+
+void sequencering_clear(SequenceRing* ring) {
+    utility_assert(ring);
+
+    for(guint sequence = ring->low; sequence != ring->high; sequence++) {
+        gpointer* slot = _sequencering_getSlot(ring, sequence);
+        if(*slot != NULL && ring->valueDestroyFunc) {
+            ring->valueDestroyFunc(*slot);
+        }
+        *slot = NULL;
+    }
+
+    ring->length = 0;
+    ring->high = ring->low;
+}
+
+void sequencering_free(SequenceRing* ring) {
+    utility_assert(ring);
+    sequencering_clear(ring);
+    g_free(ring->slots);
+    g_free(ring);
+}
+
+guint sequencering_getLength(SequenceRing* ring) {
+    utility_assert(ring);
+    return ring->length;
+}
+
+gboolean sequencering_isEmpty(SequenceRing* ring) {
+    utility_assert(ring);
+    return ring->length == 0 ? TRUE : FALSE;
+}
+
+/* returns FALSE without taking ownership of value if sequence is already stored,
+ * or if storing it would make the window wider than the maximum span */
+gboolean sequencering_insert(SequenceRing* ring, guint sequence, gpointer value) {
+    utility_assert(ring);
+    utility_assert(value != NULL);
+
+    if(ring->length == 0) {
+        ring->low = sequence;
+        ring->high = sequence + 1;
+    } else {
+        guint newLow = MIN(ring->low, sequence);
+        guint newHigh = MAX(ring->high, sequence + 1);
+        if(newHigh - newLow > ring->maxSpan) {
+            return FALSE;
+        }
+        /* grow before moving the window, since growing rehashes the old window */
+        _sequencering_grow(ring, newHigh - newLow);
+        ring->low = newLow;
+        ring->high = newHigh;
+    }
+
+    gpointer* slot = _sequencering_getSlot(ring, sequence);
+    if(*slot != NULL) {
+        return FALSE;
+    }
+
+    *slot = value;
+    ring->length++;
+    return TRUE;
+}
+
+gpointer sequencering_lookup(SequenceRing* ring, guint sequence) {
+    utility_assert(ring);
+
+    if(ring->length == 0 || sequence < ring->low || sequence >= ring->high) {
+        return NULL;
+    }
+    return *_sequencering_getSlot(ring, sequence);
+}
+
+/* removes and returns the value without calling the destroy func */
+gpointer sequencering_steal(SequenceRing* ring, guint sequence) {
+    utility_assert(ring);
+
+    gpointer value = sequencering_lookup(ring, sequence);
+    if(value != NULL) {
+        *_sequencering_getSlot(ring, sequence) = NULL;
+        ring->length--;
+        _sequencering_trim(ring);
+    }
+    return value;
+}
+
+/* steals the value with the lowest sequence if that sequence is less than the
+ * given sequence, so that draining everything below an ACK costs O(drained) */
+gpointer sequencering_stealLowestBefore(SequenceRing* ring, guint sequence) {
+    utility_assert(ring);
+
+    if(ring->length == 0 || ring->low >= sequence) {
+        return NULL;
+    }
+    return sequencering_steal(ring, ring->low);
+}
+
+gpointer sequencering_peekLowest(SequenceRing* ring) {
+    utility_assert(ring);
+    return ring->length > 0 ? *_sequencering_getSlot(ring, ring->low) : NULL;
+}
+
+gpointer sequencering_peekHighest(SequenceRing* ring) {
+    utility_assert(ring);
+    return ring->length > 0 ? *_sequencering_getSlot(ring, ring->high - 1) : NULL;
+}
+
+/* calls func on each value in increasing sequence order; func must not modify the ring */
+void sequencering_foreach(SequenceRing* ring, GFunc func, gpointer userData) {
+    utility_assert(ring);
+    utility_assert(func);
+
+    for(guint sequence = ring->low; sequence != ring->high; sequence++) {
+        gpointer value = *_sequencering_getSlot(ring, sequence);
+        if(value != NULL) {
+            func(value, userData);
+        }
+    }
+}
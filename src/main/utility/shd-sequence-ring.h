@@ -0,0 +1,39 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_SEQUENCE_RING_H_
+#define SHD_SEQUENCE_RING_H_
+
+#include <glib.h>
+
+/**
+ * A map from sequence numbers to (non-NULL) values that is optimized for keys
+ * which are dense and mostly increasing, such as TCP sequence numbers. Values
+ * are stored in a power-of-two ring indexed directly by the sequence, so that
+ * insert, lookup, and steal are O(1) and the lowest entries can be drained in
+ * order in O(drained). The ring grows as needed to span the window of stored
+ * sequences, up to the maximum span it was created with. Sequences that would
+ * widen the window beyond that are rejected, so that a stray sequence can not
+ * make us allocate and walk the whole gap.
+ */
+
+typedef struct _SequenceRing SequenceRing;
+
+SequenceRing* sequencering_new(guint maxSpan, GDestroyNotify valueDestroyFunc);
+void sequencering_clear(SequenceRing* ring);
+void sequencering_free(SequenceRing* ring);
+
+guint sequencering_getLength(SequenceRing* ring);
+gboolean sequencering_isEmpty(SequenceRing* ring);
+
+gboolean sequencering_insert(SequenceRing* ring, guint sequence, gpointer value);
+gpointer sequencering_lookup(SequenceRing* ring, guint sequence);
+gpointer sequencering_steal(SequenceRing* ring, guint sequence);
+gpointer sequencering_stealLowestBefore(SequenceRing* ring, guint sequence);
+gpointer sequencering_peekLowest(SequenceRing* ring);
+gpointer sequencering_peekHighest(SequenceRing* ring);
+void sequencering_foreach(SequenceRing* ring, GFunc func, gpointer userData);
+
+#endif /* SHD_SEQUENCE_RING_H_ */
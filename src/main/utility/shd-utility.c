@@ -112,7 +112,8 @@ static GString* _utility_formatBacktrace() {
 void utility_handleError(const gchar* file, gint line, const gchar* function, const gchar* message) {
     GString* errorString = _utility_formatError(file, line, function, message);
     GString* backtraceString = _utility_formatBacktrace();
-    if(!isatty(fileno(stdout))) {
+    /* stdout holds the compressed log when compressing, so leave it alone */
+    if(!isatty(fileno(stdout)) && !compressor_getDefault()) {
         g_print("%s%s**ABORTING**\n", errorString->str, backtraceString->str);
     }
     g_printerr("%s%s**ABORTING**\n", errorString->str, backtraceString->str);
@@ -85,16 +85,21 @@ static FuncDirector director;
 static int directorIsInitialized;
 
 /* track if we are in a recursive loop to avoid infinite recursion.
- * threads MUST access this via &isRecursive to ensure each has its own copy
- * http://gcc.gnu.org/onlinedocs/gcc-4.3.6/gcc/Thread_002dLocal.html */
+ * these are thread-local, so no other thread can race with us and plain
+ * increments are sufficient. */
 static __thread unsigned long isRecursive = 0;
 
 /* provide a way to disable and enable interposition */
-static __thread unsigned long disableCount = 0;
+static __thread long disableCount = 0;
 
-/* we must use the & operator to get the current thread's version */
-void interposer_enable() {__sync_fetch_and_sub(&disableCount, 1);}
-void interposer_disable() {__sync_fetch_and_add(&disableCount, 1);}
+void interposer_enable() {disableCount--;}
+void interposer_disable() {disableCount++;}
+
+/* published by the shadow worker on every context change, see shd-worker.h.
+ * the variable lives in the shadow executable, so it is always in the static
+ * TLS block and we can use the cheaper initial-exec access model. */
+extern __thread Process* workerEmulatedProcess __attribute__((tls_model("initial-exec")));
+extern __thread EmulatedTime workerEmulatedTime __attribute__((tls_model("initial-exec")));
 
 static void* dummy_malloc(size_t size) {
     if (director.dummy.pos + size >= sizeof(director.dummy.buf)) {
@@ -157,10 +162,10 @@ static void _interposer_globalInitializeHelper() {
 
 static void _interposer_globalInitialize() {
     /* ensure we recursively intercept during initialization */
-    if(!__sync_fetch_and_add(&isRecursive, 1)){
+    if(!(isRecursive++)){
         _interposer_globalInitializeHelper();
     }
-    __sync_fetch_and_sub(&isRecursive, 1);
+    isRecursive--;
 }
 
 /* this function is called when the library is loaded,
@@ -183,21 +188,15 @@ static inline Process* _doEmulate() {
     if(!directorIsInitialized) {
         _interposer_globalInitialize();
     }
-    Process* proc = NULL;
-    /* recursive calls always go to libc */
-    if(!__sync_fetch_and_add(&isRecursive, 1)) {
-        proc = director.shadowIsLoaded && (*(&disableCount)) <= 0 && worker_isAlive() ? worker_getActiveProcess() : NULL;
-        /* check if the shadow intercept library is loaded yet, but dont fail if its not */
-        if(proc) {
-            /* ask shadow if this call is a plug-in that should be intercepted */
-            proc = process_shouldEmulate(proc) ? proc : NULL;
-        } else {
-            /* intercept library is not yet loaded, don't redirect */
-            proc = NULL;
-        }
+    /* recursive calls always go to libc, as do calls made before shadow is
+     * loaded or while interposition is disabled */
+    if(isRecursive || disableCount > 0 || !director.shadowIsLoaded) {
+        return NULL;
     }
-    __sync_fetch_and_sub(&isRecursive, 1);
-    return proc;
+    /* the worker only publishes a process here while that process is active on
+     * this thread and executing in plugin context, i.e., exactly when
+     * process_shouldEmulate would be true. threads without a worker see NULL. */
+    return workerEmulatedProcess;
 }
 
 /****************************************************************************
@@ -404,6 +403,56 @@ int syscall(int number, ...) {
     return result;
 }
 
+/* time family */
+
+/* event loops ask for the time constantly, so whenever we would emulate these
+ * we compute the answer from the published time right here. it only changes
+ * between events, never while the plugin is running. */
+
+time_t time(time_t *t) {
+    if(_doEmulate() != NULL) {
+        time_t secs = (time_t)(workerEmulatedTime / SIMTIME_ONE_SECOND);
+        if(t != NULL) {
+            *t = secs;
+        }
+        return secs;
+    } else {
+        ENSURE(time);
+        return director.next.time(t);
+    }
+}
+
+int clock_gettime(clockid_t clk_id, struct timespec *tp) {
+    Process* proc = NULL;
+    if((proc = _doEmulate()) != NULL) {
+        if(tp == NULL) {
+            /* let shadow set the plugin's errno */
+            return process_emu_clock_gettime(proc, clk_id, tp);
+        }
+        EmulatedTime now = workerEmulatedTime;
+        tp->tv_sec = (time_t)(now / SIMTIME_ONE_SECOND);
+        tp->tv_nsec = (long)(now % SIMTIME_ONE_SECOND);
+        return 0;
+    } else {
+        ENSURE(clock_gettime);
+        return director.next.clock_gettime(clk_id, tp);
+    }
+}
+
+int gettimeofday(struct timeval* tv, struct timezone* tz) {
+    if(_doEmulate() != NULL) {
+        if(tv != NULL) {
+            EmulatedTime now = workerEmulatedTime;
+            tv->tv_sec = (time_t)(now / SIMTIME_ONE_SECOND);
+            tv->tv_usec = (suseconds_t)((now % SIMTIME_ONE_SECOND) / SIMTIME_ONE_MICROSECOND);
+        }
+        return 0;
+    } else {
+        ENSURE(gettimeofday);
+        return director.next.gettimeofday(tv, tz);
+    }
+}
+
 /* exit family */
 
 void exit(int a) {
@@ -37,6 +37,11 @@ PRELOADDEF(      , void, abort, (void));
 
 PRELOADDEF(return, int, syscall, (int a, ...), a);
 
+/* these read the time the worker publishes without calling into shadow */
+PRELOADDEF(return, time_t, time, (time_t *a), a);
+PRELOADDEF(return, int, clock_gettime, (clockid_t a, struct timespec *b), a, b);
+PRELOADDEF(return, int, gettimeofday, (struct timeval* a, struct timezone* b), a, b);
+
 /* intercepting these functions causes glib errors, because keys that were created from
  * internal shadow functions then get used in the plugin and get forwarded to pth, which
  * of course does not have the same registered keys. */
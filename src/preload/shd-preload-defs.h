@@ -34,9 +34,11 @@ PRELOADDEF(return, int, getpeername, (int a, struct sockaddr* b, socklen_t* c),
 PRELOADDEF(return, ssize_t, send, (int a, const void *b, size_t c, int d), a, b, c, d);
 PRELOADDEF(return, ssize_t, sendto, (int a, const void *b, size_t c, int d, const struct sockaddr* e, socklen_t f), a, b, c, d, e, f);
 PRELOADDEF(return, ssize_t, sendmsg, (int a, const struct msghdr *b, int c), a, b, c);
+PRELOADDEF(return, int, sendmmsg, (int a, struct mmsghdr *b, unsigned int c, int d), a, b, c, d);
 PRELOADDEF(return, ssize_t, recv, (int a, void *b, size_t c, int d), a, b, c, d);
 PRELOADDEF(return, ssize_t, recvfrom, (int a, void *b, size_t c, int d, struct sockaddr* e, socklen_t *f), a, b, c, d, e, f);
 PRELOADDEF(return, ssize_t, recvmsg, (int a, struct msghdr *b, int c), a, b, c);
+PRELOADDEF(return, int, recvmmsg, (int a, struct mmsghdr *b, unsigned int c, int d, struct timespec *e), a, b, c, d, e);
 PRELOADDEF(return, int, getsockopt, (int a, int b, int c, void* d, socklen_t* e), a, b, c, d, e);
 PRELOADDEF(return, int, setsockopt, (int a, int b, int c, const void *d, socklen_t e), a, b, c, d, e);
 PRELOADDEF(return, int, listen, (int a, int b), a, b);
@@ -128,9 +130,6 @@ PRELOADDEF(return, int, fflush, (FILE *a), a);
 
 /* time family */
 
-PRELOADDEF(return, time_t, time, (time_t *a), a);
-PRELOADDEF(return, int, clock_gettime, (clockid_t a, struct timespec *b), a, b);
-PRELOADDEF(return, int, gettimeofday, (struct timeval* a, struct timezone* b), a, b);
 PRELOADDEF(return, struct tm *, localtime, (const time_t *a), a);
 PRELOADDEF(return, struct tm *, localtime_r, (const time_t *a, struct tm *b), a, b);
 PRELOADDEF(return, int, pthread_getcpuclockid, (pthread_t a, clockid_t *b), a, b);
@@ -0,0 +1,226 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+/* Checks that intercepted calls are emulated inside of shadow and go to libc
+ * outside of it, and measures the per-call overhead of the preload interposer.
+ *
+ * Pass "shadow" as the only argument when running as a shadow plugin. The
+ * emulated clock starts in the year 2000 and does not advance while a plugin
+ * runs, which tells the two apart.
+ *
+ * Simulated time does not advance while a plugin runs, so we measure with the
+ * cycle counter, which shadow does not intercept. Run it natively for a libc baseline and under shadow to
+ * see what interposition adds; compare runs across builds to evaluate changes
+ * to the dispatch path. The timings are informational only. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define BENCH_ITERATIONS 100000
+#define BENCH_PORT 12345
+
+/* shadow's emulated time starts at 2000-01-01, the real clock is well past 2020 */
+#define EMULATED_EPOCH ((time_t)946684800)
+#define EMULATED_EPOCH_LIMIT (EMULATED_EPOCH + (time_t)86400)
+#define REAL_EPOCH_LIMIT ((time_t)1577836800)
+
+static inline uint64_t _bench_now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return (uint64_t)__builtin_ia32_rdtsc();
+#else
+    /* without a cycle counter, this is only meaningful outside of shadow */
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000UL) + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static const char* _bench_unit() {
+#if defined(__x86_64__) || defined(__i386__)
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+static void _bench_report(const char* name, uint64_t start, uint64_t end) {
+    double perCall = ((double)(end - start)) / ((double)BENCH_ITERATIONS);
+    fprintf(stdout, "interpose-bench: %s %.1f %s/call over %i calls\n",
+            name, perCall, _bench_unit(), BENCH_ITERATIONS);
+}
+
+static int _check_time(int isShadow) {
+    time_t t = time(NULL);
+
+    if(isShadow && (t < EMULATED_EPOCH || t >= EMULATED_EPOCH_LIMIT)) {
+        fprintf(stdout, "error: time() returned %ld inside of shadow, not the emulated time\n", (long)t);
+        return EXIT_FAILURE;
+    } else if(!isShadow && t < REAL_EPOCH_LIMIT) {
+        fprintf(stdout, "error: time() returned %ld outside of shadow, not the real time\n", (long)t);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* the emulated clock stands still while we run, the real one does not */
+static int _check_clock(int isShadow, const struct timespec* before, const struct timespec* after) {
+    int isSame = (before->tv_sec == after->tv_sec && before->tv_nsec == after->tv_nsec) ? 1 : 0;
+
+    if(isShadow && !isSame) {
+        fprintf(stdout, "error: the monotonic clock advanced while the plugin was running inside of shadow\n");
+        return EXIT_FAILURE;
+    } else if(!isShadow && isSame) {
+        fprintf(stdout, "error: the monotonic clock did not advance outside of shadow\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static int _bench_malloc() {
+    char* volatile ptr = NULL;
+
+    uint64_t start = _bench_now();
+    for(int i = 0; i < BENCH_ITERATIONS; i++) {
+        ptr = malloc(64);
+        if(ptr == NULL) {
+            fprintf(stdout, "error: malloc() failed\n");
+            return EXIT_FAILURE;
+        }
+        ptr[63] = (char)i;
+        free(ptr);
+    }
+    uint64_t end = _bench_now();
+
+    _bench_report("malloc+free", start, end);
+    return EXIT_SUCCESS;
+}
+
+static int _bench_time(int isShadow) {
+    volatile time_t t = 0;
+
+    uint64_t start = _bench_now();
+    for(int i = 0; i < BENCH_ITERATIONS; i++) {
+        t = time(NULL);
+    }
+    uint64_t end = _bench_now();
+
+    if(t == (time_t)-1) {
+        fprintf(stdout, "error: time() failed: %s\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    _bench_report("time", start, end);
+    return _check_time(isShadow);
+}
+
+static int _bench_send() {
+    /* a udp socket connected to itself, so every send has a real destination */
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(fd < 0) {
+        fprintf(stdout, "error: socket() failed: %s\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(struct sockaddr_in));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(BENCH_PORT);
+
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(struct sockaddr_in)) < 0 ||
+            connect(fd, (struct sockaddr*)&addr, sizeof(struct sockaddr_in)) < 0) {
+        fprintf(stdout, "error: unable to set up udp socket: %s\n", strerror(errno));
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    char buf[64];
+    memset(buf, 'a', sizeof(buf));
+
+    /* the socket buffer will fill up; EAGAIN still goes through the full dispatch path */
+    int numSent = 0, numFailed = 0;
+    uint64_t start = _bench_now();
+    for(int i = 0; i < BENCH_ITERATIONS; i++) {
+        ssize_t n = send(fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if(n == (ssize_t)sizeof(buf)) {
+            numSent++;
+        } else if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            numFailed++;
+        } else {
+            fprintf(stdout, "error: send() returned %li: %s\n", (long)n, strerror(errno));
+            close(fd);
+            return EXIT_FAILURE;
+        }
+    }
+    uint64_t end = _bench_now();
+
+    close(fd);
+
+    _bench_report("send", start, end);
+
+    if(numSent == 0) {
+        fprintf(stdout, "error: none of the %i sends succeeded, %i would have blocked\n",
+                BENCH_ITERATIONS, numFailed);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[]) {
+    fprintf(stdout, "########## interpose-bench test starting ##########\n");
+
+    int isShadow = (argc > 1 && strcmp(argv[1], "shadow") == 0) ? 1 : 0;
+    fprintf(stdout, "interpose-bench: expecting calls to be %s\n",
+            isShadow ? "emulated inside of shadow" : "passed to libc outside of shadow");
+
+    if(_check_time(isShadow) != EXIT_SUCCESS) {
+        fprintf(stdout, "########## _check_time() failed\n");
+        return EXIT_FAILURE;
+    }
+
+    struct timespec before, after;
+    if(clock_gettime(CLOCK_MONOTONIC, &before) < 0) {
+        fprintf(stdout, "########## clock_gettime() failed: %s\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    if(_bench_malloc() != EXIT_SUCCESS) {
+        fprintf(stdout, "########## _bench_malloc() failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if(_bench_time(isShadow) != EXIT_SUCCESS) {
+        fprintf(stdout, "########## _bench_time() failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if(_bench_send() != EXIT_SUCCESS) {
+        fprintf(stdout, "########## _bench_send() failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if(clock_gettime(CLOCK_MONOTONIC, &after) < 0) {
+        fprintf(stdout, "########## clock_gettime() failed: %s\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    if(_check_clock(isShadow, &before, &after) != EXIT_SUCCESS) {
+        fprintf(stdout, "########## _check_clock() failed\n");
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stdout, "########## interpose-bench test passed! ##########\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,220 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+/* we include the generator itself to reach its kernels. its utility header
+ * needs all of shadow, and the generator only uses it for asserts. */
+#define SHD_UTILITY_H_
+#define utility_assert(expr) g_assert(expr)
+#include "utility/shd-random.c"
+
+#define NUM_TRIALS 64
+#define NUM_BLOCKS 40
+#define STREAM_LENGTH 100000
+
+/* ChaCha8 with a 64 bit counter and nonce, from the test vectors in
+ * draft-strombergson-chacha-test-vectors: all zero key and nonce, blocks 0 and 1 */
+static const gchar* kat0Key = "0000000000000000000000000000000000000000000000000000000000000000";
+static const gchar* kat0Nonce = "0000000000000000";
+static const guint64 kat0Counter = 0;
+static const gchar* kat0Keystream =
+        "3e00ef2f895f40d67f5bb8e81f09a5a12c840ec3ce9a7f3b181be188ef711a1e"
+        "984ce172b9216f419f445367456d5619314a42a3da86b001387bfdb80e0cfe42"
+        "d2aefa0deaa5c151bf0adb6c01f2a5adc0fd581259f9a2aadcf20f8fd566a26b"
+        "5032ec38bbc5da98ee0c6f568b872a65a08abf251deb21bb4b56e5d8821e68aa";
+
+/* key bytes 0 to 31 and nonce bytes 0 to 7, with the counter crossing 2^32 */
+static const gchar* kat1Key = "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f";
+static const gchar* kat1Nonce = "0001020304050607";
+static const guint64 kat1Counter = G_GUINT64_CONSTANT(0xFFFFFFFF);
+static const gchar* kat1Keystream =
+        "badb1507b0845fad5f4b13986991bd52e66777ec992868acbd0b9c6f888cf1d2"
+        "af43c1b42b885c7360ae57aa12e02b7491142791a42b63fbf56cb121482fb300"
+        "4d6d1e554a670ca85bf2c61803e0dd8712bc7214ca94331554d2951dc3bfdb6f"
+        "f0d1871760fd355033e0fe0e8cad9ea1270e7233ba6073e2f548c804eab56944";
+
+static void _test_decodeHex(const gchar* hex, guchar* out) {
+    gsize length = strlen(hex) / 2;
+    for(gsize i = 0; i < length; i++) {
+        out[i] = (guchar)((g_ascii_xdigit_value(hex[2*i]) << 4) | g_ascii_xdigit_value(hex[2*i+1]));
+    }
+}
+
+static void _test_setState(guint32* state, const gchar* keyHex, const gchar* nonceHex, guint64 counter) {
+    guchar key[32], nonce[8];
+    _test_decodeHex(keyHex, key);
+    _test_decodeHex(nonceHex, nonce);
+
+    state[0] = 0x61707865;
+    state[1] = 0x3320646e;
+    state[2] = 0x79622d32;
+    state[3] = 0x6b206574;
+    for(gint i = 0; i < 8; i++) {
+        guint32 word;
+        memcpy(&word, &key[i*4], 4);
+        state[4+i] = GUINT32_FROM_LE(word);
+    }
+    _random_setCounter(state, counter);
+    for(gint i = 0; i < 2; i++) {
+        guint32 word;
+        memcpy(&word, &nonce[i*4], 4);
+        state[14+i] = GUINT32_FROM_LE(word);
+    }
+}
+
+static int _test_knownAnswer(const gchar* keyHex, const gchar* nonceHex, guint64 counter, const gchar* keystreamHex) {
+    guint32 state[16];
+    _test_setState(state, keyHex, nonceHex, counter);
+
+    gsize nBlocks = strlen(keystreamHex) / (2 * RANDOM_BLOCK_SIZE);
+    guchar expected[nBlocks * RANDOM_BLOCK_SIZE];
+    guchar actual[nBlocks * RANDOM_BLOCK_SIZE];
+    _test_decodeHex(keystreamHex, expected);
+
+    _random_generateScalar(state, counter, actual, nBlocks);
+    if(memcmp(expected, actual, sizeof(actual)) != 0) {
+        fprintf(stdout, "scalar keystream does not match the test vector for key %s counter %"G_GUINT64_FORMAT"\n",
+                keyHex, counter);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* a deterministic source of test inputs, independent of the code under test */
+static guint64 _test_nextInput(guint64* x) {
+    guint64 z = (*x += G_GUINT64_CONSTANT(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * G_GUINT64_CONSTANT(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * G_GUINT64_CONSTANT(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+static int _test_kernels() {
+    /* include counters where the low word and the whole counter wrap mid-batch */
+    guint64 counters[] = {0, 1, G_GUINT64_CONSTANT(0xFFFFFFFA), G_GUINT64_CONSTANT(0xFFFFFFFFFFFFFFFC)};
+    guint64 x = 1;
+
+#if defined(__x86_64__)
+    if(!_random_haveAVX2()) {
+        fprintf(stdout, "cpu does not support avx2, only comparing the sse2 and scalar kernels\n");
+    }
+#else
+    fprintf(stdout, "not on x86_64, there are no vector kernels to compare\n");
+#endif
+
+    for(gint trial = 0; trial < NUM_TRIALS; trial++) {
+        guint32 state[16];
+        for(gint i = 0; i < 16; i++) {
+            state[i] = (guint32)_test_nextInput(&x);
+        }
+        guint64 counter = ((guint)trial < G_N_ELEMENTS(counters)) ? counters[trial] : _test_nextInput(&x);
+
+        guchar scalar[NUM_BLOCKS * RANDOM_BLOCK_SIZE];
+        _random_generateScalar(state, counter, scalar, NUM_BLOCKS);
+
+#if defined(__x86_64__)
+        guchar vector[NUM_BLOCKS * RANDOM_BLOCK_SIZE];
+
+        memset(vector, 0, sizeof(vector));
+        _random_generateSSE2(state, counter, vector, NUM_BLOCKS);
+        if(memcmp(scalar, vector, sizeof(vector)) != 0) {
+            fprintf(stdout, "sse2 and scalar keystreams differ in trial %i\n", trial);
+            return EXIT_FAILURE;
+        }
+
+        if(_random_haveAVX2()) {
+            memset(vector, 0, sizeof(vector));
+            _random_generateAVX2(state, counter, vector, NUM_BLOCKS);
+            if(memcmp(scalar, vector, sizeof(vector)) != 0) {
+                fprintf(stdout, "avx2 and scalar keystreams differ in trial %i\n", trial);
+                return EXIT_FAILURE;
+            }
+        }
+#endif
+
+        /* the dispatcher mixes all kernels for odd block counts */
+        Random* random = random_newStream((guint)trial, (guint64)trial);
+        memcpy(random->state, state, sizeof(state));
+        _random_setCounter(random->state, counter);
+        for(gsize done = 0, n = 1; done < NUM_BLOCKS; done += n, n++) {
+            n = MIN(n, NUM_BLOCKS - done);
+            guchar mixed[NUM_BLOCKS * RANDOM_BLOCK_SIZE];
+            _random_generate(random, mixed, n);
+            if(memcmp(&scalar[done * RANDOM_BLOCK_SIZE], mixed, n * RANDOM_BLOCK_SIZE) != 0) {
+                fprintf(stdout, "dispatched keystream differs in trial %i at block %zu\n", trial, done);
+                random_free(random);
+                return EXIT_FAILURE;
+            }
+        }
+        random_free(random);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* one bulk request must give the same bytes as the same stream consumed in
+ * many small requests, including the values handed out by random_nextUInt */
+static int _test_splits() {
+    guchar* bulk = g_malloc(STREAM_LENGTH);
+    guchar* split = g_malloc(STREAM_LENGTH);
+    guint64 x = 2;
+
+    Random* bulkRandom = random_newStream(12345, 6);
+    random_nextNBytes(bulkRandom, bulk, STREAM_LENGTH);
+    random_free(bulkRandom);
+
+    Random* splitRandom = random_newStream(12345, 6);
+    gsize offset = 0;
+    while(offset < STREAM_LENGTH) {
+        guint64 choice = _test_nextInput(&x);
+
+        if((choice % 4) == 0 && STREAM_LENGTH - offset >= sizeof(guint32)) {
+            guint32 value = GUINT32_TO_LE(random_nextUInt(splitRandom));
+            memcpy(&split[offset], &value, sizeof(guint32));
+            offset += sizeof(guint32);
+        } else {
+            /* up to a few blocks, so requests land on and across buffer boundaries */
+            gsize n = MIN((gsize)((choice >> 8) % (3 * RANDOM_BUFFER_SIZE)) + 1, STREAM_LENGTH - offset);
+            random_nextNBytes(splitRandom, &split[offset], n);
+            offset += n;
+        }
+    }
+    random_free(splitRandom);
+
+    int result = (memcmp(bulk, split, STREAM_LENGTH) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    if(result != EXIT_SUCCESS) {
+        fprintf(stdout, "bulk and split requests produced different bytes\n");
+    }
+
+    g_free(bulk);
+    g_free(split);
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    fprintf(stdout, "########## random keystream test starting ##########\n");
+
+    if (_test_knownAnswer(kat0Key, kat0Nonce, kat0Counter, kat0Keystream) != EXIT_SUCCESS ||
+            _test_knownAnswer(kat1Key, kat1Nonce, kat1Counter, kat1Keystream) != EXIT_SUCCESS) {
+        fprintf(stdout, "########## _test_knownAnswer() failed\n");
+        return EXIT_FAILURE;
+    }
+    if (_test_kernels() != EXIT_SUCCESS) {
+        fprintf(stdout, "########## _test_kernels() failed\n");
+        return EXIT_FAILURE;
+    }
+    if (_test_splits() != EXIT_SUCCESS) {
+        fprintf(stdout, "########## _test_splits() failed\n");
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stdout, "########## random keystream test passed! ##########\n");
+    return EXIT_SUCCESS;
+}
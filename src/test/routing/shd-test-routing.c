@@ -0,0 +1,197 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+/* every host sends this many probes to every other host */
+#define NUM_PROBES 200
+#define PROBE_PORT 11111
+/* stop receiving once no probe arrived for this long */
+#define QUIET_MILLIS 5000
+
+/* prints what each host saw of the paths from the other hosts, i.e. how many
+ * probes survived the path's loss and the shortest delay. the test runs
+ * shadow with paths computed on first use, precomputed, and loaded from the
+ * path cache, and expects the same output for each host in every run. */
+
+typedef struct _Probe Probe;
+struct _Probe {
+    uint32_t senderIndex;
+    uint32_t sequence;
+    uint64_t sendTime;
+};
+
+static uint64_t _now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000UL) + (uint64_t)ts.tv_nsec;
+}
+
+static int _resolve(const char* name, struct sockaddr_in* addr) {
+    struct addrinfo* info = NULL;
+    int result = getaddrinfo(name, NULL, NULL, &info);
+    if(result != 0 || info == NULL) {
+        printf("getaddrinfo() for %s returned %i\n", name, result);
+        return -1;
+    }
+
+    memset(addr, 0, sizeof(struct sockaddr_in));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = ((struct sockaddr_in*)(info->ai_addr))->sin_addr.s_addr;
+    addr->sin_port = htons(PROBE_PORT);
+
+    freeaddrinfo(info);
+    return 0;
+}
+
+static int _send_probes(int fd, int selfIndex, int numHosts, char** hostNames) {
+    struct sockaddr_in* peers = calloc((size_t)numHosts, sizeof(struct sockaddr_in));
+    int result = -1;
+
+    for(int i = 0; i < numHosts; i++) {
+        if(i != selfIndex && _resolve(hostNames[i], &peers[i]) < 0) {
+            goto done;
+        }
+    }
+
+    for(uint32_t sequence = 0; sequence < NUM_PROBES; sequence++) {
+        for(int i = 0; i < numHosts; i++) {
+            if(i == selfIndex) {
+                continue;
+            }
+
+            Probe probe;
+            probe.senderIndex = (uint32_t)selfIndex;
+            probe.sequence = sequence;
+            probe.sendTime = _now();
+
+            if(sendto(fd, &probe, sizeof(Probe), 0, (struct sockaddr*)&peers[i], sizeof(struct sockaddr_in)) != sizeof(Probe)) {
+                printf("sendto() error was: %s\n", strerror(errno));
+                goto done;
+            }
+        }
+
+        /* spread the probes out so they do not queue behind each other */
+        usleep(10000);
+    }
+
+    result = 0;
+
+done:
+    free(peers);
+    return result;
+}
+
+static int _receive_probes(int fd, int numHosts, int* counts, uint64_t* minDelays) {
+    while(1) {
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        int ready = poll(&pfd, 1, QUIET_MILLIS);
+        if(ready < 0) {
+            printf("poll() error was: %s\n", strerror(errno));
+            return -1;
+        } else if(ready == 0) {
+            return 0;
+        }
+
+        Probe probe;
+        ssize_t n = recv(fd, &probe, sizeof(Probe), 0);
+        if(n != sizeof(Probe) || probe.senderIndex >= (uint32_t)numHosts) {
+            printf("recv() returned %li, error was: %s\n", (long)n, strerror(errno));
+            return -1;
+        }
+
+        uint64_t delay = _now() - probe.sendTime;
+        if(counts[probe.senderIndex] == 0 || delay < minDelays[probe.senderIndex]) {
+            minDelays[probe.senderIndex] = delay;
+        }
+        counts[probe.senderIndex]++;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    printf("########## routing test starting ##########\n");
+
+    if(argc < 3) {
+        printf("usage: %s selfname hostname...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char* selfName = argv[1];
+    char** hostNames = &argv[2];
+    int numHosts = argc - 2;
+
+    int selfIndex = -1;
+    for(int i = 0; i < numHosts; i++) {
+        if(strcmp(hostNames[i], selfName) == 0) {
+            selfIndex = i;
+        }
+    }
+    if(selfIndex < 0) {
+        printf("%s is not in the list of hosts\n", selfName);
+        return EXIT_FAILURE;
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(fd < 0) {
+        printf("socket() error was: %s\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(struct sockaddr_in));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(PROBE_PORT);
+
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(struct sockaddr_in)) < 0) {
+        printf("bind() error was: %s\n", strerror(errno));
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    /* give every host time to bind before probing it */
+    sleep(1);
+
+    int* counts = calloc((size_t)numHosts, sizeof(int));
+    uint64_t* minDelays = calloc((size_t)numHosts, sizeof(uint64_t));
+
+    int result = EXIT_FAILURE;
+    if(_send_probes(fd, selfIndex, numHosts, hostNames) == 0 &&
+            _receive_probes(fd, numHosts, counts, minDelays) == 0) {
+        for(int i = 0; i < numHosts; i++) {
+            if(i != selfIndex) {
+                printf("from %s: received %i of %i probes, minimum delay %lu us\n",
+                        hostNames[i], counts[i], NUM_PROBES, (unsigned long)(minDelays[i] / 1000));
+            }
+        }
+        result = EXIT_SUCCESS;
+    }
+
+    free(counts);
+    free(minDelays);
+    close(fd);
+
+    if(result == EXIT_SUCCESS) {
+        printf("########## routing test passed! ##########\n");
+    } else {
+        printf("########## routing test failed! ##########\n");
+    }
+    return result;
+}
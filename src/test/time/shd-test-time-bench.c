@@ -0,0 +1,242 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/time.h>
+
+/* stands in for shadow so we can time how the preload library answers time
+ * queries for an emulated process, without the noise of a full simulation.
+ * each call is measured twice: through the preload library, which reads the
+ * clock the worker publishes, and through a copy of the path shadow took
+ * before it published the clock, i.e. two context changes and a thread
+ * private lookup of the worker. both must return the same times. */
+
+/* number of calls to time in each benchmark */
+#define NUM_CALLS 1000000
+
+#define ONE_SECOND UINT64_C(1000000000)
+#define ONE_MICROSECOND UINT64_C(1000)
+/* 2000-01-01 plus some, as shadow's emulated time would be */
+#define EMULATED_NOW ((UINT64_C(946684800) * ONE_SECOND) + UINT64_C(123456789012))
+
+typedef enum {
+    CONTEXT_NONE, CONTEXT_SHADOW, CONTEXT_PLUGIN,
+} BenchContext;
+
+typedef struct _BenchProcess BenchProcess;
+struct _BenchProcess {
+    BenchContext activeContext;
+};
+
+typedef struct _BenchWorker BenchWorker;
+struct _BenchWorker {
+    uint64_t now;
+    BenchProcess* activeProcess;
+};
+
+/* what the preload library reads from the shadow executable, see shd-worker.h */
+__thread void* workerEmulatedProcess __attribute__((tls_model("initial-exec"))) = NULL;
+__thread uint64_t workerEmulatedTime __attribute__((tls_model("initial-exec"))) = 0;
+
+/* in the preload library */
+int interposer_setShadowIsLoaded(int isLoaded);
+
+static pthread_key_t workerKey;
+
+/* the worker and process functions the old path called, kept out of line
+ * like they were in shadow */
+
+__attribute__((noinline)) static BenchWorker* _bench_getWorker() {
+    return pthread_getspecific(workerKey);
+}
+
+__attribute__((noinline)) static uint64_t _bench_getEmulatedTime() {
+    return _bench_getWorker()->now;
+}
+
+__attribute__((noinline)) static void _bench_setEmulatedProcess(BenchProcess* proc) {
+    workerEmulatedProcess = (proc != NULL && proc == _bench_getWorker()->activeProcess) ? proc : NULL;
+}
+
+static BenchContext _bench_changeContext(BenchProcess* proc, BenchContext to) {
+    BenchContext prevContext = proc->activeContext;
+    proc->activeContext = to;
+    _bench_setEmulatedProcess(to == CONTEXT_SHADOW ? NULL : proc);
+    return prevContext;
+}
+
+__attribute__((noinline)) static time_t _bench_oldTime(BenchProcess* proc, time_t* t) {
+    BenchContext prevContext = _bench_changeContext(proc, CONTEXT_SHADOW);
+    time_t secs = (time_t)(_bench_getEmulatedTime() / ONE_SECOND);
+    if(t != NULL) {
+        *t = secs;
+    }
+    _bench_changeContext(proc, prevContext);
+    return secs;
+}
+
+__attribute__((noinline)) static int _bench_oldClockGettime(BenchProcess* proc, clockid_t clk_id, struct timespec* tp) {
+    if(tp == NULL) {
+        errno = EFAULT;
+        return -1;
+    }
+    BenchContext prevContext = _bench_changeContext(proc, CONTEXT_SHADOW);
+    uint64_t now = _bench_getEmulatedTime();
+    tp->tv_sec = (time_t)(now / ONE_SECOND);
+    tp->tv_nsec = (long)(now % ONE_SECOND);
+    _bench_changeContext(proc, prevContext);
+    return 0;
+}
+
+__attribute__((noinline)) static int _bench_oldGettimeofday(BenchProcess* proc, struct timeval* tv, void* tz) {
+    if(tv != NULL) {
+        BenchContext prevContext = _bench_changeContext(proc, CONTEXT_SHADOW);
+        uint64_t now = _bench_getEmulatedTime();
+        tv->tv_sec = (time_t)(now / ONE_SECOND);
+        tv->tv_usec = (suseconds_t)((now % ONE_SECOND) / ONE_MICROSECOND);
+        _bench_changeContext(proc, prevContext);
+    }
+    return 0;
+}
+
+/* the preload library still hands a NULL timespec to shadow to set errno */
+int process_emu_clock_gettime(void* proc, clockid_t clk_id, struct timespec* tp) {
+    return _bench_oldClockGettime(proc, clk_id, tp);
+}
+
+/* printing is not emulated, so the process is only published while we time calls */
+static void _bench_enterPlugin(BenchProcess* proc) {
+    proc->activeContext = CONTEXT_PLUGIN;
+    workerEmulatedProcess = proc;
+}
+
+static void _bench_exitPlugin(BenchProcess* proc) {
+    proc->activeContext = CONTEXT_SHADOW;
+    workerEmulatedProcess = NULL;
+}
+
+/* clock() measures our cpu time, which the interposer does not touch */
+static double _bench_getCallsPerSecond(clock_t start, clock_t end) {
+    double secs = ((double)(end - start)) / CLOCKS_PER_SEC;
+    return secs > 0 ? NUM_CALLS / secs : 0;
+}
+
+static int _bench_report(const char* name, clock_t startNew, clock_t endNew, long sinkNew,
+        clock_t startOld, clock_t endOld, long sinkOld) {
+    double newRate = _bench_getCallsPerSecond(startNew, endNew);
+    double oldRate = _bench_getCallsPerSecond(startOld, endOld);
+
+    fprintf(stdout, "%s: %.0f calls per second from the published clock, "
+            "%.0f calls per second through shadow", name, newRate, oldRate);
+    if(newRate > 0 && oldRate > 0) {
+        fprintf(stdout, " (%.1fx)", newRate / oldRate);
+    }
+    fprintf(stdout, "\n");
+
+    if(sinkNew != sinkOld) {
+        fprintf(stdout, "error: %s returned different times, sink %ld and %ld\n", name, sinkNew, sinkOld);
+        return -1;
+    }
+    return 0;
+}
+
+static int _bench_time(BenchProcess* proc) {
+    long sinkNew = 0, sinkOld = 0;
+
+    _bench_enterPlugin(proc);
+    clock_t startNew = clock();
+    for(int i = 0; i < NUM_CALLS; i++) {
+        sinkNew += (long)time(NULL);
+    }
+    clock_t endNew = clock();
+    clock_t startOld = clock();
+    for(int i = 0; i < NUM_CALLS; i++) {
+        sinkOld += (long)_bench_oldTime(proc, NULL);
+    }
+    clock_t endOld = clock();
+    _bench_exitPlugin(proc);
+
+    return _bench_report("time", startNew, endNew, sinkNew, startOld, endOld, sinkOld);
+}
+
+static int _bench_clockGettime(BenchProcess* proc) {
+    struct timespec ts;
+    long sinkNew = 0, sinkOld = 0;
+
+    _bench_enterPlugin(proc);
+    clock_t startNew = clock();
+    for(int i = 0; i < NUM_CALLS; i++) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        sinkNew += ts.tv_sec + ts.tv_nsec;
+    }
+    clock_t endNew = clock();
+    clock_t startOld = clock();
+    for(int i = 0; i < NUM_CALLS; i++) {
+        _bench_oldClockGettime(proc, CLOCK_MONOTONIC, &ts);
+        sinkOld += ts.tv_sec + ts.tv_nsec;
+    }
+    clock_t endOld = clock();
+    _bench_exitPlugin(proc);
+
+    return _bench_report("clock_gettime", startNew, endNew, sinkNew, startOld, endOld, sinkOld);
+}
+
+static int _bench_gettimeofday(BenchProcess* proc) {
+    struct timeval tv;
+    long sinkNew = 0, sinkOld = 0;
+
+    _bench_enterPlugin(proc);
+    clock_t startNew = clock();
+    for(int i = 0; i < NUM_CALLS; i++) {
+        gettimeofday(&tv, NULL);
+        sinkNew += tv.tv_sec + tv.tv_usec;
+    }
+    clock_t endNew = clock();
+    clock_t startOld = clock();
+    for(int i = 0; i < NUM_CALLS; i++) {
+        _bench_oldGettimeofday(proc, &tv, NULL);
+        sinkOld += tv.tv_sec + tv.tv_usec;
+    }
+    clock_t endOld = clock();
+    _bench_exitPlugin(proc);
+
+    return _bench_report("gettimeofday", startNew, endNew, sinkNew, startOld, endOld, sinkOld);
+}
+
+int main(int argc, char* argv[]) {
+    fprintf(stdout, "########## time benchmark starting ##########\n");
+
+    static BenchProcess proc = {CONTEXT_SHADOW};
+    static BenchWorker worker = {EMULATED_NOW, &proc};
+
+    pthread_key_create(&workerKey, NULL);
+    pthread_setspecific(workerKey, &worker);
+    workerEmulatedTime = worker.now;
+    interposer_setShadowIsLoaded(1);
+
+    /* make sure the interposer answers from the published clock at all */
+    _bench_enterPlugin(&proc);
+    time_t now = time(NULL);
+    _bench_exitPlugin(&proc);
+    if(now != (time_t)(EMULATED_NOW / ONE_SECOND)) {
+        fprintf(stdout, "error: time returned %ld instead of the emulated %ld\n",
+                (long)now, (long)(EMULATED_NOW / ONE_SECOND));
+        fprintf(stdout, "########## time benchmark failed! ##########\n");
+        return EXIT_FAILURE;
+    }
+
+    if(_bench_time(&proc) < 0 || _bench_clockGettime(&proc) < 0 || _bench_gettimeofday(&proc) < 0) {
+        fprintf(stdout, "########## time benchmark failed! ##########\n");
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stdout, "########## time benchmark passed! ##########\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+
+/* number of calls to time in each benchmark */
+#define NUM_CALLS 1000000
+
+/* the three ways of getting the time should agree with each other */
+static int _test_consistent() {
+    struct timespec ts;
+    struct timeval tv;
+
+    time_t t = time(NULL);
+    if(clock_gettime(CLOCK_REALTIME, &ts) < 0) {
+        fprintf(stdout, "error: clock_gettime failed\n");
+        return -1;
+    }
+    if(gettimeofday(&tv, NULL) < 0) {
+        fprintf(stdout, "error: gettimeofday failed\n");
+        return -1;
+    }
+
+    if(ts.tv_nsec < 0 || ts.tv_nsec >= 1000000000L || tv.tv_usec < 0 || tv.tv_usec >= 1000000L) {
+        fprintf(stdout, "error: sub-second parts out of range: %ld ns, %ld us\n",
+                (long)ts.tv_nsec, (long)tv.tv_usec);
+        return -1;
+    }
+
+    /* allow for a second boundary between the calls */
+    if(ts.tv_sec < t || ts.tv_sec > t + 1 || tv.tv_sec < ts.tv_sec || tv.tv_sec > ts.tv_sec + 1) {
+        fprintf(stdout, "error: time %ld, clock_gettime %ld, and gettimeofday %ld disagree\n",
+                (long)t, (long)ts.tv_sec, (long)tv.tv_sec);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int _test_monotonic() {
+    struct timespec last, now;
+    clock_gettime(CLOCK_MONOTONIC, &last);
+
+    for(int i = 0; i < 1000; i++) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if(now.tv_sec < last.tv_sec || (now.tv_sec == last.tv_sec && now.tv_nsec < last.tv_nsec)) {
+            fprintf(stdout, "error: clock_gettime went backwards\n");
+            return -1;
+        }
+        last = now;
+    }
+
+    return 0;
+}
+
+/* clock() measures our cpu time, which is real even inside of shadow where the
+ * functions we are measuring return the simulated time */
+static void _report(const char* name, clock_t start, clock_t end, long sink) {
+    double secs = ((double)(end - start)) / CLOCKS_PER_SEC;
+    if(secs > 0) {
+        fprintf(stdout, "%s: %.0f calls per second (sink %ld)\n", name, NUM_CALLS / secs, sink);
+    } else {
+        fprintf(stdout, "%s: too fast to measure (sink %ld)\n", name, sink);
+    }
+}
+
+static void _benchmark() {
+    long sink = 0;
+    clock_t start = clock();
+    for(int i = 0; i < NUM_CALLS; i++) {
+        sink += (long)time(NULL);
+    }
+    _report("time", start, clock(), sink);
+
+    struct timespec ts;
+    sink = 0;
+    start = clock();
+    for(int i = 0; i < NUM_CALLS; i++) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        sink += ts.tv_nsec;
+    }
+    _report("clock_gettime", start, clock(), sink);
+
+    struct timeval tv;
+    sink = 0;
+    start = clock();
+    for(int i = 0; i < NUM_CALLS; i++) {
+        gettimeofday(&tv, NULL);
+        sink += tv.tv_usec;
+    }
+    _report("gettimeofday", start, clock(), sink);
+}
+
+int main(int argc, char* argv[]) {
+    fprintf(stdout, "########## time test starting ##########\n");
+
+    if(_test_consistent() < 0) {
+        fprintf(stdout, "########## _test_consistent() failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if(_test_monotonic() < 0) {
+        fprintf(stdout, "########## _test_monotonic() failed\n");
+        return EXIT_FAILURE;
+    }
+
+    _benchmark();
+
+    fprintf(stdout, "########## time test passed! ##########\n");
+    return EXIT_SUCCESS;
+}
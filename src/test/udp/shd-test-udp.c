@@ -0,0 +1,347 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define NUM_DATAGRAMS 4
+#define HEADER_SIZE 8
+#define BODY_SIZE 100
+
+static int _make_bound_socket(in_port_t port) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(fd < 0) {
+        printf("socket() error was: %s\n", strerror(errno));
+        return -1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(struct sockaddr_in));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = port;
+
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(struct sockaddr_in)) < 0) {
+        printf("bind() error was: %s\n", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static void _fill_datagram(int index, char* header, char* body) {
+    memset(header, 'a' + index, HEADER_SIZE);
+    memset(body, 'A' + index, BODY_SIZE);
+}
+
+static int _check_datagram(int index, const char* header, const char* body, size_t length) {
+    char expectedHeader[HEADER_SIZE], expectedBody[BODY_SIZE];
+    _fill_datagram(index, expectedHeader, expectedBody);
+
+    if(length != HEADER_SIZE + BODY_SIZE) {
+        printf("datagram %i has length %zu, expected %i\n", index, length, HEADER_SIZE + BODY_SIZE);
+        return -1;
+    }
+    if(memcmp(header, expectedHeader, HEADER_SIZE) != 0 || memcmp(body, expectedBody, BODY_SIZE) != 0) {
+        printf("datagram %i was not scattered into the right buffers\n", index);
+        return -1;
+    }
+    return 0;
+}
+
+/* sends each datagram from two iovecs and receives it into two differently
+ * sized iovecs, so the bytes have to cross a buffer boundary on the way in */
+static int test_sendmsg_recvmsg() {
+    int result = -1;
+    int recvfd = _make_bound_socket(htons(40001));
+    int sendfd = _make_bound_socket(htons(40002));
+    if(recvfd < 0 || sendfd < 0) {
+        goto done;
+    }
+
+    struct sockaddr_in dest;
+    memset(&dest, 0, sizeof(struct sockaddr_in));
+    dest.sin_family = AF_INET;
+    dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    dest.sin_port = htons(40001);
+
+    char header[HEADER_SIZE], body[BODY_SIZE];
+    _fill_datagram(0, header, body);
+    struct iovec sendvec[2] = {{header, HEADER_SIZE}, {body, BODY_SIZE}};
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(struct msghdr));
+    message.msg_name = &dest;
+    message.msg_namelen = sizeof(struct sockaddr_in);
+    message.msg_iov = sendvec;
+    message.msg_iovlen = 2;
+
+    ssize_t n = sendmsg(sendfd, &message, 0);
+    if(n != HEADER_SIZE + BODY_SIZE) {
+        printf("sendmsg() returned %li, error was: %s\n", (long)n, strerror(errno));
+        goto done;
+    }
+
+    char in[HEADER_SIZE + BODY_SIZE];
+    struct iovec recvvec[2] = {{in, 3}, {in + 3, sizeof(in) - 3}};
+    struct sockaddr_in source;
+    memset(&source, 0, sizeof(struct sockaddr_in));
+    memset(&message, 0, sizeof(struct msghdr));
+    message.msg_name = &source;
+    message.msg_namelen = sizeof(struct sockaddr_in);
+    message.msg_iov = recvvec;
+    message.msg_iovlen = 2;
+
+    n = recvmsg(recvfd, &message, 0);
+    if(n < 0) {
+        printf("recvmsg() error was: %s\n", strerror(errno));
+        goto done;
+    }
+    if(_check_datagram(0, in, in + HEADER_SIZE, (size_t)n) < 0) {
+        goto done;
+    }
+    if(source.sin_port != htons(40002)) {
+        printf("recvmsg() reported source port %u, expected 40002\n", ntohs(source.sin_port));
+        goto done;
+    }
+    if(message.msg_flags & MSG_TRUNC) {
+        printf("recvmsg() reported a truncated datagram that fit\n");
+        goto done;
+    }
+
+    result = 0;
+
+done:
+    if(recvfd >= 0) {
+        close(recvfd);
+    }
+    if(sendfd >= 0) {
+        close(sendfd);
+    }
+    return result;
+}
+
+static int test_sendmmsg_recvmmsg() {
+    int result = -1;
+    int recvfd = _make_bound_socket(htons(40003));
+    int sendfd = _make_bound_socket(htons(40004));
+    if(recvfd < 0 || sendfd < 0) {
+        goto done;
+    }
+
+    struct sockaddr_in dest;
+    memset(&dest, 0, sizeof(struct sockaddr_in));
+    dest.sin_family = AF_INET;
+    dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    dest.sin_port = htons(40003);
+
+    char headers[NUM_DATAGRAMS][HEADER_SIZE], bodies[NUM_DATAGRAMS][BODY_SIZE];
+    struct iovec sendvecs[NUM_DATAGRAMS][2];
+    struct mmsghdr sendmsgs[NUM_DATAGRAMS];
+    memset(sendmsgs, 0, sizeof(sendmsgs));
+
+    for(int i = 0; i < NUM_DATAGRAMS; i++) {
+        _fill_datagram(i, headers[i], bodies[i]);
+        sendvecs[i][0].iov_base = headers[i];
+        sendvecs[i][0].iov_len = HEADER_SIZE;
+        sendvecs[i][1].iov_base = bodies[i];
+        sendvecs[i][1].iov_len = BODY_SIZE;
+        sendmsgs[i].msg_hdr.msg_name = &dest;
+        sendmsgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        sendmsgs[i].msg_hdr.msg_iov = sendvecs[i];
+        sendmsgs[i].msg_hdr.msg_iovlen = 2;
+    }
+
+    int n = sendmmsg(sendfd, sendmsgs, NUM_DATAGRAMS, 0);
+    if(n != NUM_DATAGRAMS) {
+        printf("sendmmsg() returned %i, error was: %s\n", n, strerror(errno));
+        goto done;
+    }
+    for(int i = 0; i < NUM_DATAGRAMS; i++) {
+        if(sendmsgs[i].msg_len != HEADER_SIZE + BODY_SIZE) {
+            printf("sendmmsg() reported %u bytes for datagram %i\n", sendmsgs[i].msg_len, i);
+            goto done;
+        }
+    }
+
+    char inHeaders[NUM_DATAGRAMS][HEADER_SIZE], inBodies[NUM_DATAGRAMS][BODY_SIZE];
+    struct iovec recvvecs[NUM_DATAGRAMS][2];
+    struct mmsghdr recvmsgs[NUM_DATAGRAMS];
+    memset(recvmsgs, 0, sizeof(recvmsgs));
+
+    for(int i = 0; i < NUM_DATAGRAMS; i++) {
+        recvvecs[i][0].iov_base = inHeaders[i];
+        recvvecs[i][0].iov_len = HEADER_SIZE;
+        recvvecs[i][1].iov_base = inBodies[i];
+        recvvecs[i][1].iov_len = BODY_SIZE;
+        recvmsgs[i].msg_hdr.msg_iov = recvvecs[i];
+        recvmsgs[i].msg_hdr.msg_iovlen = 2;
+    }
+
+    /* the datagrams may not all be buffered by the time the first one wakes us */
+    int received = 0;
+    while(received < NUM_DATAGRAMS) {
+        n = recvmmsg(recvfd, &recvmsgs[received], NUM_DATAGRAMS - received, MSG_WAITFORONE, NULL);
+        if(n <= 0) {
+            printf("recvmmsg() returned %i, error was: %s\n", n, strerror(errno));
+            goto done;
+        }
+        received += n;
+    }
+
+    for(int i = 0; i < NUM_DATAGRAMS; i++) {
+        if(_check_datagram(i, inHeaders[i], inBodies[i], recvmsgs[i].msg_len) < 0) {
+            goto done;
+        }
+    }
+
+    result = 0;
+
+done:
+    if(recvfd >= 0) {
+        close(recvfd);
+    }
+    if(sendfd >= 0) {
+        close(sendfd);
+    }
+    return result;
+}
+
+/* receives datagrams into buffers that are too short for them, so the rest
+ * of each is dropped and the message has to be marked as truncated */
+static int test_recvmsg_truncated() {
+    int result = -1;
+    int recvfd = _make_bound_socket(htons(40005));
+    int sendfd = _make_bound_socket(htons(40006));
+    if(recvfd < 0 || sendfd < 0) {
+        goto done;
+    }
+
+    struct sockaddr_in dest;
+    memset(&dest, 0, sizeof(struct sockaddr_in));
+    dest.sin_family = AF_INET;
+    dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    dest.sin_port = htons(40005);
+
+    char header[HEADER_SIZE], body[BODY_SIZE];
+    for(int i = 0; i < 2; i++) {
+        _fill_datagram(i, header, body);
+        struct iovec sendvec[2] = {{header, HEADER_SIZE}, {body, BODY_SIZE}};
+
+        struct msghdr message;
+        memset(&message, 0, sizeof(struct msghdr));
+        message.msg_name = &dest;
+        message.msg_namelen = sizeof(struct sockaddr_in);
+        message.msg_iov = sendvec;
+        message.msg_iovlen = 2;
+
+        ssize_t n = sendmsg(sendfd, &message, 0);
+        if(n != HEADER_SIZE + BODY_SIZE) {
+            printf("sendmsg() returned %li, error was: %s\n", (long)n, strerror(errno));
+            goto done;
+        }
+    }
+
+    /* the first one with recvmsg, into the header and a bit of the body */
+    char inHeader[HEADER_SIZE], inBody[3];
+    struct iovec recvvec[2] = {{inHeader, HEADER_SIZE}, {inBody, sizeof(inBody)}};
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(struct msghdr));
+    message.msg_iov = recvvec;
+    message.msg_iovlen = 2;
+
+    ssize_t n = recvmsg(recvfd, &message, 0);
+    if(n != HEADER_SIZE + sizeof(inBody)) {
+        printf("recvmsg() returned %li, expected %zu, error was: %s\n",
+                (long)n, HEADER_SIZE + sizeof(inBody), strerror(errno));
+        goto done;
+    }
+    _fill_datagram(0, header, body);
+    if(memcmp(inHeader, header, HEADER_SIZE) != 0 || memcmp(inBody, body, sizeof(inBody)) != 0) {
+        printf("recvmsg() did not return the start of the truncated datagram\n");
+        goto done;
+    }
+    if(!(message.msg_flags & MSG_TRUNC)) {
+        printf("recvmsg() did not set MSG_TRUNC for a datagram that did not fit\n");
+        goto done;
+    }
+
+    /* the second one with recvmmsg, into the header only */
+    struct iovec mrecvvec = {inHeader, HEADER_SIZE};
+    struct mmsghdr mmessage;
+    memset(&mmessage, 0, sizeof(struct mmsghdr));
+    mmessage.msg_hdr.msg_iov = &mrecvvec;
+    mmessage.msg_hdr.msg_iovlen = 1;
+
+    int count = recvmmsg(recvfd, &mmessage, 1, 0, NULL);
+    if(count != 1 || mmessage.msg_len != HEADER_SIZE) {
+        printf("recvmmsg() returned %i with %u bytes, error was: %s\n",
+                count, mmessage.msg_len, strerror(errno));
+        goto done;
+    }
+    _fill_datagram(1, header, body);
+    if(memcmp(inHeader, header, HEADER_SIZE) != 0) {
+        printf("recvmmsg() did not return the start of the truncated datagram\n");
+        goto done;
+    }
+    if(!(mmessage.msg_hdr.msg_flags & MSG_TRUNC)) {
+        printf("recvmmsg() did not set MSG_TRUNC for a datagram that did not fit\n");
+        goto done;
+    }
+
+    result = 0;
+
+done:
+    if(recvfd >= 0) {
+        close(recvfd);
+    }
+    if(sendfd >= 0) {
+        close(sendfd);
+    }
+    return result;
+}
+
+int run() {
+    printf("########## running test_sendmsg_recvmsg\n");
+    if(test_sendmsg_recvmsg() < 0) {
+        return EXIT_FAILURE;
+    }
+
+    printf("########## running test_sendmmsg_recvmmsg\n");
+    if(test_sendmmsg_recvmmsg() < 0) {
+        return EXIT_FAILURE;
+    }
+
+    printf("########## running test_recvmsg_truncated\n");
+    if(test_recvmsg_truncated() < 0) {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int main() {
+    printf("########## udp test starting ##########\n");
+
+    if(run() == EXIT_SUCCESS) {
+        printf("########## udp test passed ##########\n");
+        return EXIT_SUCCESS;
+    } else {
+        printf("########## udp test failed ##########\n");
+        return EXIT_FAILURE;
+    }
+}
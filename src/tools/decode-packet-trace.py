@@ -0,0 +1,88 @@
+#!/usr/bin/python
+
+'''
+Print a packet trace, written when running Shadow with '--packet-trace', as text.
+
+USAGE: decode-packet-trace.py shadow.data/packet-trace.bin [packet-trace.txt]
+
+The trace is read from STDIN when the input is '-' and the text is written to
+STDOUT when no output file is given. Each line holds the simulation time, the
+host on which the status of the packet changed, the packet as the host that
+created it and its sequence number on that host, and the new status. The trace
+must be decoded on a machine with the same byte order as the one that ran
+Shadow.
+'''
+
+import sys, struct
+
+MAGIC = b"shadow-packet-trace-1\n"
+RECORD = struct.Struct("<QQII")
+
+SIMTIME_INVALID = 0xFFFFFFFFFFFFFFFF
+SIMTIME_ONE_SECOND = 1000000000
+
+# the bit positions of the PacketDeliveryStatusFlags in shd-packet.h
+STATUSES = ["NONE", "SND_CREATED", "SND_TCP_ENQUEUE_THROTTLED", "SND_TCP_ENQUEUE_RETRANSMIT",
+    "SND_TCP_DEQUEUE_RETRANSMIT", "SND_TCP_RETRANSMITTED", "SND_SOCKET_BUFFERED",
+    "SND_INTERFACE_SENT", "INET_SENT", "INET_DROPPED", "RCV_INTERFACE_BUFFERED",
+    "RCV_INTERFACE_RECEIVED", "RCV_INTERFACE_DROPPED", "RCV_SOCKET_PROCESSED",
+    "RCV_SOCKET_DROPPED", "RCV_TCP_ENQUEUE_UNORDERED", "RCV_SOCKET_BUFFERED",
+    "RCV_SOCKET_DELIVERED", "DESTROYED"]
+
+def format_sim_time(nanos):
+    # changes made while no event was running, such as during shutdown
+    if nanos == SIMTIME_INVALID:
+        return "n/a"
+    seconds, nanos = nanos // SIMTIME_ONE_SECOND, nanos % SIMTIME_ONE_SECOND
+    return "%02d:%02d:%02d.%09d" % (seconds // 3600, (seconds % 3600) // 60, seconds % 60, nanos)
+
+def format_status(status):
+    names = [STATUSES[bit] for bit in range(1, len(STATUSES)) if status & (1 << bit)]
+    return ",".join(names) if names else "NONE"
+
+def decode(inf, outf):
+    if inf.read(len(MAGIC)) != MAGIC:
+        sys.stderr.write("** input is not a shadow packet trace\n")
+        return None
+
+    hosts = {0: "n/a"}
+    numhosts, = struct.unpack("<I", inf.read(4))
+    for i in range(numhosts):
+        host, length = struct.unpack("<II", inf.read(8))
+        hosts[host] = inf.read(length).decode('latin-1')
+
+    n = 0
+    while True:
+        data = inf.read(RECORD.size)
+        if len(data) < RECORD.size:
+            break
+        simtime, packet, host, status = RECORD.unpack(data)
+        line = "{0} {1} {2}-{3} {4}\n".format(format_sim_time(simtime), hosts.get(host, "n/a"),
+            hosts.get(packet >> 32, "n/a"), packet & 0xFFFFFFFF, format_status(status))
+        outf.write(line.encode('latin-1'))
+        n += 1
+
+    return n
+
+def main():
+    if len(sys.argv) < 2:
+        sys.stderr.write("USAGE: {0} packet-trace.bin [packet-trace.txt]\n".format(sys.argv[0]))
+        exit(1)
+
+    stdin = getattr(sys.stdin, 'buffer', sys.stdin)
+    stdout = getattr(sys.stdout, 'buffer', sys.stdout)
+
+    inf = stdin if sys.argv[1] == '-' else open(sys.argv[1], 'rb')
+    outf = open(sys.argv[2], 'wb') if len(sys.argv) > 2 else stdout
+
+    n = decode(inf, outf)
+
+    if inf is not stdin: inf.close()
+    if outf is not stdout: outf.close()
+
+    if n is None:
+        exit(1)
+    sys.stderr.write("Done! Decoded {0} packet status changes.\n".format(n))
+
+if __name__ == '__main__':
+    main()
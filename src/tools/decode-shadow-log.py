@@ -0,0 +1,186 @@
+#!/usr/bin/python
+
+'''
+Turn a binary Shadow log, written when running Shadow with '--log-format=binary',
+back into the usual text log.
+
+USAGE: decode-shadow-log.py shadow.log.bin [shadow.log]
+
+The binary log is read from STDIN when the input is '-' and the text log is
+written to STDOUT when no output file is given. The binary log must be decoded
+on a machine with the same byte order as the one that ran Shadow.
+'''
+
+import sys, re, struct
+
+MAGIC = b"shadow-binary-log-1\n"
+
+LOGENTRY_CALLSITE, LOGENTRY_HOST, LOGENTRY_RECORD = 1, 2, 3
+LEVELS = {1: "error", 2: "critical", 3: "warning", 4: "message", 5: "info", 6: "debug"}
+
+NULL_STRING = 0xFFFFFFFF
+SIMTIME_INVALID = 0xFFFFFFFFFFFFFFFF
+SIMTIME_ONE_SECOND = 1000000000
+
+# the same conversion specs that shadow captures arguments for
+SPEC = re.compile(r"%(?P<flags>[-+ #0'I]*)(?P<width>\*|\d*)(?:\.(?P<precision>\*|\d*))?(?P<length>hh|h|ll|l|L|q|j|z|Z|t)?(?P<conversion>[%diouxXceEfFgGspm])")
+
+class Reader(object):
+    def __init__(self, data, offset=0):
+        self.data = data
+        self.offset = offset
+
+    def read(self, fmt):
+        values = struct.unpack_from(fmt, self.data, self.offset)
+        self.offset += struct.calcsize(fmt)
+        return values[0]
+
+    def string(self):
+        length = self.read("<I")
+        if length == NULL_STRING:
+            return None
+        value = self.data[self.offset:self.offset+length].decode('latin-1')
+        self.offset += length
+        return value
+
+    def argument(self):
+        tag = self.read("<c")
+        if tag == b'i': return self.read("<i")
+        elif tag == b'l': return self.read("<q")
+        elif tag == b'd': return self.read("<d")
+        elif tag == b'p': return ('p', self.read("<Q"))
+        elif tag == b's': return self.string()
+        raise ValueError("unknown argument tag {0}".format(tag))
+
+def format_argument(flags, width, precision, length, conversion, value):
+    # python does not know about these flags
+    flags = flags.replace("'", "").replace("I", "")
+    spec = "%" + flags + width + ("." + precision if precision is not None else "")
+
+    if conversion in "diouxXc":
+        # values were captured as signed ints of the size their length gave
+        bits = 64 if length in ("l", "ll", "L", "q", "j", "z", "Z", "t") else 32
+        if length == "h": bits = 16
+        elif length == "hh": bits = 8
+        value &= (1 << bits) - 1
+        if conversion in "di" and value >= (1 << (bits - 1)):
+            value -= (1 << bits)
+        if conversion == "c":
+            return (spec + "s") % chr(value & 0xFF)
+        if conversion in "uoxX":
+            # signs are never printed for unsigned conversions
+            spec = spec.replace("+", "").replace(" ", "")
+            if value == 0:
+                # nor are prefixes for zero
+                spec = spec.replace("#", "")
+        if conversion == "u":
+            conversion = "d"
+        if conversion == "o" and "#" in flags:
+            # python writes '0o' as the prefix of octal values
+            spec = spec.replace("#", "")
+            digits = "0" + ("%o" % value) if value else "0"
+            return (spec + "s") % digits
+        return (spec + conversion) % value
+    elif conversion in "eEfFgG":
+        return (spec + conversion) % value
+    elif conversion == "p":
+        address = value[1] if isinstance(value, tuple) else value
+        return (spec.replace("#", "") + "s") % ("0x%x" % address if address else "(nil)")
+    else:
+        # strings, including the %m error string
+        return (spec + "s") % ("(null)" if value is None else value)
+
+def format_message(fmt, reader):
+    parts, last = [], 0
+    for match in SPEC.finditer(fmt):
+        parts.append(fmt[last:match.start()])
+        last = match.end()
+        flags, width, precision, length, conversion = match.group("flags", "width", "precision", "length", "conversion")
+        if conversion == "%":
+            parts.append("%")
+            continue
+        if width == "*":
+            star = reader.argument()
+            width = str(star)
+        if precision == "*":
+            star = reader.argument()
+            precision = str(star) if star >= 0 else None
+        elif precision == "":
+            precision = "0"
+        parts.append(format_argument(flags, width, precision, length, conversion, reader.argument()))
+    parts.append(fmt[last:])
+    return "".join(parts)
+
+def format_wall_time(seconds):
+    remainder = int(seconds)
+    fraction = seconds - float(remainder)
+    hours, remainder = remainder // 3600, remainder % 3600
+    minutes, remainder = remainder // 60, remainder % 60
+    return "%02d:%02d:%02d.%06d" % (hours, minutes, remainder, int(fraction * 1000000.0))
+
+def format_sim_time(nanos):
+    if nanos == SIMTIME_INVALID:
+        return "n/a"
+    seconds, nanos = nanos // SIMTIME_ONE_SECOND, nanos % SIMTIME_ONE_SECOND
+    return "%02d:%02d:%02d.%09d" % (seconds // 3600, (seconds % 3600) // 60, seconds % 60, nanos)
+
+def decode(inf, outf):
+    if inf.read(len(MAGIC)) != MAGIC:
+        sys.stderr.write("** input is not a binary shadow log\n")
+        return None
+
+    callsites, hosts = {}, {}
+    n = 0
+
+    while True:
+        # every entry starts with its type and its total length
+        header = inf.read(5)
+        if len(header) < 5:
+            break
+        entrytype, length = struct.unpack("<BI", header)
+        data = inf.read(length - 5)
+        if len(data) < length - 5:
+            break
+        reader = Reader(data)
+
+        if entrytype == LOGENTRY_CALLSITE:
+            callsite = reader.read("<I")
+            callsites[callsite] = (reader.string(), reader.string())
+        elif entrytype == LOGENTRY_HOST:
+            host = reader.read("<I")
+            hosts[host] = reader.string()
+        elif entrytype == LOGENTRY_RECORD:
+            wall, simtime, host, thread, level, callsite = struct.unpack_from("<dQIiBI", data, reader.offset)
+            reader.offset += struct.calcsize("<dQIiBI")
+            callinfo, fmt = callsites.get(callsite, ("n/a", None))
+            message = format_message(fmt, reader) if fmt is not None else "NOMESSAGE"
+            line = "{0} [thread-{1}] {2} [{3}] [{4}] {5} {6}\n".format(format_wall_time(wall), thread,
+                format_sim_time(simtime), LEVELS.get(level, "unset"), hosts.get(host, "n/a") if host else "n/a",
+                callinfo, message)
+            outf.write(line.encode('latin-1'))
+            n += 1
+
+    return n
+
+def main():
+    if len(sys.argv) < 2:
+        sys.stderr.write("USAGE: {0} shadow.log.bin [shadow.log]\n".format(sys.argv[0]))
+        exit(1)
+
+    stdin = getattr(sys.stdin, 'buffer', sys.stdin)
+    stdout = getattr(sys.stdout, 'buffer', sys.stdout)
+
+    inf = stdin if sys.argv[1] == '-' else open(sys.argv[1], 'rb')
+    outf = open(sys.argv[2], 'wb') if len(sys.argv) > 2 else stdout
+
+    n = decode(inf, outf)
+
+    if inf is not stdin: inf.close()
+    if outf is not stdout: outf.close()
+
+    if n is None:
+        exit(1)
+    sys.stderr.write("Done! Decoded {0} records.\n".format(n))
+
+if __name__ == '__main__':
+    main()
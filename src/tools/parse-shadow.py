@@ -20,6 +20,7 @@ The standard way to run the script is to give the shadow.log file as
 a positional argument:
 $ python parse-shadow.py shadow.log
 $ python parse-shadow.py shadow.log.xz
+$ python parse-shadow.py shadow.log.zst
 
 The log data can also be passed on STDIN with the special '-' filename:
 $ cat shadow.log | python parse-shadow.py -
@@ -45,8 +46,8 @@ def main():
 
     parser.add_argument(
         help="""The PATH to the shadow.log file, which may be '-'
-for STDIN, or may end in '.xz' to enable inline
-xz decompression""",
+for STDIN, or may end in '.xz' or '.zst' to enable
+inline xz or zstd decompression""",
         metavar="PATH",
         action="store", dest="logpath")
 
@@ -254,6 +255,10 @@ def source_prepare(filename):
     elif filename.endswith(".xz"):
         xzproc = Popen(["xz", "--decompress", "--stdout", filename], stdout=PIPE)
         source = xzproc.stdout
+    elif filename.endswith(".zst"):
+        # written by shadow when run with '--compress-logs'
+        xzproc = Popen(["zstd", "--decompress", "--stdout", "--quiet", filename], stdout=PIPE)
+        source = xzproc.stdout
     else:
         source = open(filename, 'r')
     return source, xzproc
@@ -43,8 +43,8 @@ def main():
 
     parser.add_argument(
         help="""The PATH to search for tgen log files, which may be '-'
-for STDIN; each log file may end in '.xz' to enable
-inline xz decompression""", 
+for STDIN; each log file may end in '.xz' or '.zst'
+to enable inline xz or zstd decompression""", 
         metavar="PATH",
         action="store", dest="searchpath")
 
@@ -195,6 +195,10 @@ def source_prepare(filename):
     elif filename.endswith(".xz"):
         xzproc = Popen(["xz", "--decompress", "--stdout", filename], stdout=PIPE)
         source = xzproc.stdout
+    elif filename.endswith(".zst"):
+        # written by shadow when run with '--compress-logs'
+        xzproc = Popen(["zstd", "--decompress", "--stdout", "--quiet", filename], stdout=PIPE)
+        source = xzproc.stdout
     else:
         source = open(filename, 'r')
     return source, xzproc